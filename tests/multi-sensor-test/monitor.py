@@ -2,6 +2,9 @@
 """
 ESP32 Multi-Sensor Monitor
 Displays BH1750, DS18B20, and DHT11 sensor data in real-time
+
+Sensor values arrive as binary telemetry records; the decoder is shared with
+the Zigbee firmware (zigbee-multi-sensor/telemetry_decode.py).
 """
 
 import tkinter as tk
@@ -9,9 +12,13 @@ from tkinter import ttk, messagebox
 import serial
 import serial.tools.list_ports
 import threading
-import re
+import os
 import sys
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                "..", "..", "zigbee-multi-sensor"))
+import telemetry_decode as telem
+
 class SensorMonitor:
     def __init__(self, root):
         self.root = root
@@ -21,6 +28,7 @@ class SensorMonitor:
 
         self.serial_port = None
         self.running = False
+        self.decoder = telem.StreamDecoder()
 
         # Sensor data
         self.light_lux = tk.StringVar(value="-- lux")
@@ -155,14 +163,17 @@ class SensorMonitor:
         self.disconnect_btn.config(state=tk.DISABLED)
 
     def read_serial(self):
-        """Read and parse serial data in background thread"""
+        """Read and decode serial data in background thread"""
         while self.running:
             try:
                 if self.serial_port and self.serial_port.is_open:
-                    line = self.serial_port.readline().decode('utf-8', errors='ignore').strip()
+                    data = self.serial_port.read(self.serial_port.in_waiting or 1)
 
-                    if line:
-                        self.parse_line(line)
+                    for item in self.decoder.feed(data):
+                        if isinstance(item, telem.Record):
+                            self.root.after(0, self.handle_record, item)
+                        else:
+                            print(item)
 
             except serial.SerialException:
                 self.running = False
@@ -171,39 +182,23 @@ class SensorMonitor:
             except Exception as e:
                 print(f"Error reading serial: {e}")
 
-    def parse_line(self, line):
-        """Parse sensor data from ESP32 output"""
-        try:
-            # BH1750: Light:    91.7 lux
-            if "BH1750" in line and "Light:" in line:
-                match = re.search(r'Light:\s+([\d.]+)\s+lux', line)
-                if match:
-                    self.light_lux.set(f"{match.group(1)} lux")
-
-            # DS18B20: Temp:   21.38 °C  (70.47 °F)  [Outdoor]
-            elif "DS18B20" in line and "Temp:" in line:
-                match = re.search(r'Temp:\s+([\d.]+)\s+°C', line)
-                if match:
-                    temp = float(match.group(1))
-                    temp_f = (temp * 9.0/5.0) + 32.0
-                    self.outdoor_temp.set(f"{temp:.1f} °C ({temp_f:.1f} °F)")
-
-            # DHT11: Temp:    30.0 °C  (86.0 °F)  [Indoor]
-            elif "DHT11" in line and "Temp:" in line:
-                match = re.search(r'Temp:\s+([\d.]+)\s+°C', line)
-                if match:
-                    temp = float(match.group(1))
-                    temp_f = (temp * 9.0/5.0) + 32.0
-                    self.indoor_temp.set(f"{temp:.1f} °C ({temp_f:.1f} °F)")
-
-            # DHT11: Humid:   32.0 %
-            elif "DHT11" in line and "Humid:" in line:
-                match = re.search(r'Humid:\s+([\d.]+)\s+%', line)
-                if match:
-                    self.humidity.set(f"{match.group(1)} %")
-
-        except Exception as e:
-            print(f"Error parsing line: {e}")
+    def handle_record(self, record):
+        """Update the display from one telemetry record (Tk thread)"""
+        f = record.fields
+
+        if record.type == telem.REC_LIGHT:
+            self.light_lux.set(f"{f['lux']:.1f} lux")
+
+        elif record.type == telem.REC_TEMPERATURE:
+            temp_f = (f['celsius'] * 9.0/5.0) + 32.0
+            text = f"{f['celsius']:.1f} °C ({temp_f:.1f} °F)"
+            if f['sensor'] == "DS18B20":
+                self.outdoor_temp.set(text)
+            elif f['sensor'] == "DHT11":
+                self.indoor_temp.set(text)
+
+        elif record.type == telem.REC_HUMIDITY:
+            self.humidity.set(f"{f['percent']:.1f} %")
 
     def on_closing(self):
         self.disconnect()
@@ -6,6 +6,7 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "rom/ets_sys.h"
+#include "telemetry.h"
 
 // ========================================
 // BH1750 I2C Configuration
@@ -393,6 +394,9 @@ static const char* get_light_description(float lux)
 
 void app_main(void)
 {
+    // Binary telemetry records for monitor.py, alongside the log lines below
+    telemetry_init();
+
     ESP_LOGI("MAIN", "========================================");
     ESP_LOGI("MAIN", "Multi-Sensor Test: BH1750 + DS18B20 + DHT11");
     ESP_LOGI("MAIN", "Waveshare ESP32-C6-Zero");
@@ -469,6 +473,7 @@ void app_main(void)
 
                 ESP_LOGI(TAG_BH1750, "Light: %7.1f lux | %s | %-20s",
                          lux, get_light_description(lux), bar);
+                telemetry_send_light((uint32_t)(lux * 10.0f + 0.5f), 0);  // No ZCL encoding here
             }
         }
 
@@ -484,6 +489,7 @@ void app_main(void)
                 float temp_f = (calibrated_temp * 9.0/5.0) + 32.0;
                 ESP_LOGI(TAG_DS18B20, "Temp:  %6.2f °C  (%.2f °F)  [Outdoor]",
                          calibrated_temp, temp_f);
+                telemetry_send_temperature(TELEM_SENSOR_DS18B20, (int16_t)(calibrated_temp * 100));
             } else {
                 ESP_LOGE(TAG_DS18B20, "Failed to read temperature");
             }
@@ -500,6 +506,8 @@ void app_main(void)
                 ESP_LOGI(TAG_DHT11, "Temp:  %6.1f °C  (%.1f °F)  [Indoor]",
                          calibrated_temp, temp_f);
                 ESP_LOGI(TAG_DHT11, "Humid: %6.1f %%", dht_hum);
+                telemetry_send_temperature(TELEM_SENSOR_DHT11, (int16_t)(calibrated_temp * 100));
+                telemetry_send_humidity(TELEM_SENSOR_DHT11, (uint16_t)(dht_hum * 100));
             } else {
                 ESP_LOGE(TAG_DHT11, "Failed to read DHT11");
             }
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""
+Microbenchmark recorder and regression check (src/bench.h)
+
+Record runs the `bench` console command on a device and collects its
+TELEM_REC_BENCH telemetry records into JSON; the host simulator writes the
+same JSON directly (SIM_BENCH=all). Compare checks one result file against
+a baseline and exits non-zero if any case's median got slower by more
+than the threshold (and by more than a few cycles, so the nanosecond
+cases do not flap).
+
+    python3 bench.py record /dev/ttyACM0 -o bench-target.json
+    SIM_BENCH=all host_sim/build/host_sim.elf > bench-host.json
+    python3 bench.py compare baseline.json bench-target.json --threshold 10
+
+Cycle counts are only comparable between runs on the same target and
+clock; compare refuses to mix targets.
+"""
+
+import argparse
+import json
+import sys
+import time
+
+import telemetry_decode as telem
+
+RECORD_TIMEOUT_S = 30
+
+
+def record(args):
+    import serial
+
+    decoder = telem.StreamDecoder()
+    results = {}
+    ticks_per_us = None
+    expected = None
+
+    with serial.Serial(args.port, args.baud, timeout=0.2) as ser:
+        command = "bench" + (f" {args.filter}" if args.filter else "")
+        ser.write(command.encode("ascii") + b"\n")
+        deadline = time.monotonic() + RECORD_TIMEOUT_S
+
+        while expected is None or len(results) < expected:
+            if time.monotonic() > deadline:
+                sys.exit(f"bench: timed out after {len(results)} of {expected or '?'} results")
+            for item in decoder.feed(ser.read(256)):
+                if isinstance(item, telem.Record) and item.type == telem.REC_BENCH:
+                    fields = item.fields
+                    expected = fields["count"]
+                    ticks_per_us = fields["ticks_per_us"]
+                    results[fields["index"]] = fields
+                elif isinstance(item, str) and args.verbose:
+                    print(item, file=sys.stderr)
+
+    out = {
+        "target": args.target,
+        "ticks_per_us": ticks_per_us,
+        "results": [],
+    }
+    for index in sorted(results):
+        r = results[index]
+        out["results"].append({
+            "name": r["name"], "calls": r["calls"], "cycles_min": r["cycles_min"],
+            "cycles_median": r["cycles_median"], "cycles_max": r["cycles_max"],
+            "ns_median": round(r["cycles_median"] * 1000 / ticks_per_us),
+        })
+
+    with open(args.output, "w") if args.output else sys.stdout as f:
+        json.dump(out, f, indent=2)
+        f.write("\n")
+
+
+def compare(args):
+    with open(args.baseline) as f:
+        base = json.load(f)
+    with open(args.current) as f:
+        cur = json.load(f)
+
+    if base.get("target") != cur.get("target"):
+        sys.exit(f"bench: cannot compare {base.get('target')} against {cur.get('target')}")
+
+    base_by_name = {r["name"]: r for r in base["results"]}
+    regressions = 0
+
+    print(f"{'case':<16} {'baseline':>10} {'current':>10} {'change':>8}")
+    for r in cur["results"]:
+        old = base_by_name.get(r["name"])
+        if old is None:
+            print(f"{r['name']:<16} {'-':>10} {r['cycles_median']:>10} {'new':>8}")
+            continue
+        change = (r["cycles_median"] - old["cycles_median"]) * 100.0 / max(old["cycles_median"], 1)
+        flag = ""
+        if change > args.threshold and r["cycles_median"] - old["cycles_median"] > args.slack:
+            regressions += 1
+            flag = "  REGRESSION"
+        print(f"{r['name']:<16} {old['cycles_median']:>10} {r['cycles_median']:>10} {change:>+7.1f}%{flag}")
+
+    if regressions:
+        print(f"{regressions} case(s) slower than baseline by more than {args.threshold}%")
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    rec = sub.add_parser("record", help="run the suite on a device and save JSON")
+    rec.add_argument("port", nargs="?", default="/dev/ttyACM0", help="serial port")
+    rec.add_argument("--baud", type=int, default=115200)
+    rec.add_argument("--filter", help="only cases whose name contains this")
+    rec.add_argument("--target", default="esp32c6", help="target name stored in the JSON")
+    rec.add_argument("-o", "--output", help="output file (default: stdout)")
+    rec.add_argument("-v", "--verbose", action="store_true", help="echo log lines to stderr")
+    rec.set_defaults(func=record)
+
+    cmp = sub.add_parser("compare", help="check results against a baseline")
+    cmp.add_argument("baseline")
+    cmp.add_argument("current")
+    cmp.add_argument("--threshold", type=float, default=10.0,
+                     help="allowed median slowdown in percent (default: %(default)s)")
+    cmp.add_argument("--slack", type=int, default=8,
+                     help="ignore slowdowns of at most this many cycles (default: %(default)s)")
+    cmp.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
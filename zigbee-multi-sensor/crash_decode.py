@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""
+Host-side decoder for crash records (src/crash_dump.h)
+
+The record comes from the `crash` console command or from manufacturer
+attribute 0xF013 on the EP 15 Diagnostics cluster (read it with your
+coordinator's attribute-read tool and paste the hex). This tool decodes it
+and symbolises the addresses against the firmware ELF:
+
+    python3 crash_decode.py --elf .pio/build/esp32-c6-devkitc-1/firmware.elf 0104d2...
+    python3 crash_decode.py --elf build/firmware.elf --port /dev/ttyACM0
+
+The stack walk on the device keeps every stack word that points into code;
+here only the ones that follow a call instruction (jal/jalr/c.jal/c.jalr)
+are kept as return addresses. With riscv32-esp-elf-addr2line on PATH, lines
+get file:line too.
+
+The ELF must be the image that crashed; its SHA-256 prefix is checked
+against the record.
+"""
+
+import argparse
+import bisect
+import hashlib
+import shutil
+import struct
+import subprocess
+import sys
+
+from detokenize import DEFAULT_ELF, ElfImage
+
+FORMAT_VERSION = 1
+HEADER_SIZE = 34
+TASK_ENTRY_SIZE = 7
+
+EXCEPTIONS = {0: "debug", 1: "interrupt WDT", 2: "task WDT", 3: "abort", 4: "fault", 5: "cache error"}
+
+# mcause exception codes (RISC-V privileged spec)
+MCAUSES = {
+    0: "instruction address misaligned", 1: "instruction access fault", 2: "illegal instruction",
+    3: "breakpoint", 4: "load address misaligned", 5: "load access fault",
+    6: "store address misaligned", 7: "store access fault", 11: "ecall from M-mode",
+}
+
+SHT_SYMTAB = 2
+STT_FUNC = 2
+ADDR2LINE = "riscv32-esp-elf-addr2line"
+
+
+class Symbols:
+    """Function symbols and code bytes of a 32-bit little-endian ELF."""
+
+    def __init__(self, path):
+        self.image = ElfImage(path)
+        data = self.image.data
+        self.sha256 = hashlib.sha256(data).digest()
+
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+        headers = [struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize) for i in range(shnum)]
+
+        funcs = {}
+        for _name, sh_type, _flags, _addr, offset, size, link, _info, _align, entsize in headers:
+            if sh_type != SHT_SYMTAB:
+                continue
+            str_offset = headers[link][4]
+            for pos in range(offset, offset + size, entsize):
+                st_name, value, sym_size, info, _other, _shndx = struct.unpack_from("<IIIBBH", data, pos)
+                if info & 0xF != STT_FUNC or value == 0:
+                    continue
+                end = data.find(b"\0", str_offset + st_name)
+                funcs[value & ~1] = (sym_size, data[str_offset + st_name:end].decode("utf-8", "replace"))
+
+        self.starts = sorted(funcs)
+        self.funcs = funcs
+
+    def function(self, addr):
+        i = bisect.bisect_right(self.starts, addr) - 1
+        if i < 0:
+            return None
+        start = self.starts[i]
+        size, name = self.funcs[start]
+        if addr >= start + max(size, 1):
+            return None
+        return f"{name}+0x{addr - start:x}"
+
+    def read(self, addr, length):
+        for base, offset, size in self.image.sections:
+            if base <= addr and addr + length <= base + size:
+                start = offset + (addr - base)
+                return self.image.data[start:start + length]
+        return None
+
+    def follows_call(self, addr):
+        """True if the instruction before `addr` is a call that links ra."""
+        word = self.read(addr - 4, 4)
+        if word:
+            insn, = struct.unpack("<I", word)
+            opcode, rd = insn & 0x7F, (insn >> 7) & 0x1F
+            if opcode in (0x6F, 0x67) and rd == 1:         # jal / jalr ra
+                return True
+        half = self.read(addr - 2, 2)
+        if half:
+            h, = struct.unpack("<H", half)
+            if (h & 0xF07F) == 0x9002 and (h >> 7) & 0x1F:  # c.jalr
+                return True
+            if (h & 0xE003) == 0x2001:                      # c.jal (RV32)
+                return True
+        return False
+
+
+def u32(data, pos):
+    return struct.unpack_from("<I", data, pos)[0]
+
+
+def decode(record):
+    if len(record) < HEADER_SIZE + 1 or record[0] != FORMAT_VERSION:
+        raise ValueError(f"not a version {FORMAT_VERSION} crash record ({len(record)} bytes)")
+
+    crash = {
+        "exception": record[1],
+        "uptime_ms": u32(record, 2),
+        "elf_sha256": record[6:14],
+        "mepc": u32(record, 14),
+        "ra": u32(record, 18),
+        "sp": u32(record, 22),
+        "mcause": u32(record, 26),
+        "mtval": u32(record, 30),
+    }
+
+    pos = HEADER_SIZE
+    count = record[pos]
+    crash["backtrace"] = [u32(record, pos + 1 + 4 * i) for i in range(count)]
+    pos += 1 + 4 * count
+
+    count = record[pos]
+    crash["tokens"] = [u32(record, pos + 1 + 4 * i) for i in range(count)]
+    pos += 1 + 4 * count
+
+    count = record[pos]
+    crash["tasks"] = []
+    for i in range(count):
+        entry = record[pos + 1 + TASK_ENTRY_SIZE * i:pos + 1 + TASK_ENTRY_SIZE * (i + 1)]
+        name = entry[:4].rstrip(b"\0").decode("ascii", "replace")
+        crash["tasks"].append((name, bool(entry[4] & 0x01), struct.unpack_from("<H", entry, 5)[0]))
+    return crash
+
+
+def addr2line(elf_path, addrs):
+    tool = shutil.which(ADDR2LINE)
+    if not tool or not addrs:
+        return {}
+    out = subprocess.run([tool, "-e", elf_path] + [f"0x{a:08x}" for a in addrs],
+                         capture_output=True, text=True, check=False).stdout.splitlines()
+    return {a: line for a, line in zip(addrs, out) if not line.startswith("??")}
+
+
+def print_crash(crash, symbols, elf_path):
+    if crash["elf_sha256"] != symbols.sha256[:8]:
+        print("WARNING: ELF does not match the image that crashed; symbols may be wrong", file=sys.stderr)
+
+    # Return addresses point after the call; look up the call itself
+    frames = [("PC", crash["mepc"], crash["mepc"]), ("RA", crash["ra"], crash["ra"] - 2)]
+    for addr in crash["backtrace"]:
+        if symbols.follows_call(addr):
+            frames.append(("  ", addr, addr - 2))
+    lines = addr2line(elf_path, [lookup for _, _, lookup in frames])
+
+    cause = crash["mcause"] & 0x7FFFFFFF
+    print(f"Exception: {EXCEPTIONS.get(crash['exception'], crash['exception'])}, "
+          f"{crash['uptime_ms'] / 1000:.1f} s after boot")
+    print(f"mcause 0x{crash['mcause']:08x} ({MCAUSES.get(cause, 'interrupt' if crash['mcause'] >> 31 else '?')}), "
+          f"mtval 0x{crash['mtval']:08x}, sp 0x{crash['sp']:08x}")
+
+    print("\nBacktrace:")
+    for label, addr, lookup in frames:
+        where = lines.get(lookup) or symbols.function(lookup) or "?"
+        print(f"  {label} 0x{addr:08x}  {where}")
+
+    if crash["tokens"]:
+        print("\nLast log lines (format only):")
+        for token in crash["tokens"]:
+            fmt = symbols.image.read_cstring(token)
+            print(f"  {fmt if fmt is not None else f'<unknown token 0x{token:08x}>'}")
+
+    print("\nTasks (free stack at the crash):")
+    for name, crashed, free in crash["tasks"]:
+        print(f"  {'*' if crashed else ' '} {name:<4}  {free:5d} B")
+
+
+def read_from_port(port, baud):
+    import serial
+
+    with serial.Serial(port, baud, timeout=2) as ser:
+        ser.write(b"crash\n")
+        for _ in range(50):
+            line = ser.readline().decode("ascii", "replace").strip()
+            if line.startswith("crash: "):
+                return line[len("crash: "):]
+    raise SystemExit("no answer to the crash command")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("record", nargs="?", help="record as hex (the `crash` command output or attribute 0xF013)")
+    parser.add_argument("--elf", default=DEFAULT_ELF, help="firmware ELF (default: %(default)s)")
+    parser.add_argument("--port", help="read the record with the `crash` console command")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    text = read_from_port(args.port, args.baud) if args.port else args.record
+    if not text:
+        parser.error("give the record as hex or --port")
+    if text.strip() == "none stored":
+        print("No crash stored")
+        return
+
+    record = bytes.fromhex(text.replace("crash:", "").replace(" ", ""))
+    print_crash(decode(record), Symbols(args.elf), args.elf)
+
+
+if __name__ == "__main__":
+    main()
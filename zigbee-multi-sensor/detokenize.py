@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+Host-side detokeniser for tokenised logs (src/tlog.h)
+
+TLOGx entries arrive as TELEM_REC_LOG telemetry records carrying the flash
+address of the format string, the tag pointer and raw 32-bit arguments. This
+tool resolves the addresses against the firmware ELF and formats the line
+the way ESP_LOGx would have.
+
+    python3 detokenize.py --elf .pio/build/esp32-c6-devkitc-1/firmware.elf /dev/ttyACM0
+    python3 detokenize.py --elf build/firmware.elf --file capture.bin
+
+The ELF must be the exact image running on the device.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+import telemetry_decode as telem
+
+DEFAULT_ELF = ".pio/build/esp32-c6-devkitc-1/firmware.elf"
+
+LEVEL_CHARS = {1: "E", 2: "W", 3: "I", 4: "D", 5: "V"}
+
+# %[flags][width][.precision][length]conversion
+FORMAT_SPEC = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|z|j|t|L)?([diouxXcsfFeEgGpa%])")
+
+SHT_NOBITS = 8
+
+
+class ElfImage:
+    """Minimal ELF32 little-endian reader: enough to fetch strings by address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError(f"{path}: not a 32-bit little-endian ELF")
+
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+
+        self.sections = []
+        for i in range(shnum):
+            (_name, sh_type, _flags, addr, offset, size,
+             *_rest) = struct.unpack_from("<IIIIII", self.data, shoff + i * shentsize)
+            if addr and size and sh_type != SHT_NOBITS:
+                self.sections.append((addr, offset, size))
+
+    def read_cstring(self, addr):
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + (addr - base)
+                end = self.data.find(b"\0", start, offset + size)
+                if end < 0:
+                    end = offset + size
+                return self.data[start:end].decode("utf-8", errors="replace")
+        return None
+
+
+class Detokenizer:
+    def __init__(self, elf_path):
+        self.elf = ElfImage(elf_path)
+        self.cache = {}
+
+    def string(self, addr):
+        if addr not in self.cache:
+            self.cache[addr] = self.elf.read_cstring(addr)
+        return self.cache[addr]
+
+    def format_args(self, fmt, args):
+        args = list(args)
+
+        def convert(match):
+            flags, width, precision, _length, conv = match.groups()
+            if conv == "%":
+                return "%"
+            if width == "*":
+                width = str(_signed(args.pop(0))) if args else ""
+            if precision == "*":
+                precision = str(_signed(args.pop(0))) if args else ""
+            if not args:
+                return match.group(0)
+            raw = args.pop(0)
+
+            spec = "%" + flags + (width or "") + ("." + precision if precision is not None else "")
+            if conv in "di":
+                return (spec + "d") % _signed(raw)
+            if conv in "ouxX":
+                return (spec + conv) % raw
+            if conv == "c":
+                return (spec + "c") % chr(raw & 0xFF)
+            if conv in "fFeEgGa":
+                value = struct.unpack("<f", struct.pack("<I", raw))[0]
+                return (spec + ("f" if conv == "a" else conv)) % value
+            if conv == "p":
+                return f"0x{raw:08x}"
+            # %s: pointer into flash
+            text = self.string(raw)
+            return (spec + "s") % (text if text is not None else f"<0x{raw:08x}>")
+
+        return FORMAT_SPEC.sub(convert, fmt)
+
+    def format_record(self, record):
+        """Render a TELEM_REC_LOG record as an ESP_LOGx-style line."""
+        f = record.fields
+        fmt = self.string(f["fmt"])
+        tag = self.string(f["tag"]) or f"<0x{f['tag']:08x}>"
+        level = LEVEL_CHARS.get(f["level"], "?")
+
+        if fmt is None:
+            text = f"<unknown token 0x{f['fmt']:08x}> " + " ".join(f"{a:08x}" for a in f["args"])
+        else:
+            text = self.format_args(fmt, f["args"])
+        return f"{level} ({f['timestamp_ms']}) {tag}: {text}"
+
+
+def _signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?", default="/dev/ttyACM0", help="serial port")
+    parser.add_argument("--elf", default=DEFAULT_ELF, help="firmware ELF (default: %(default)s)")
+    parser.add_argument("--file", help="decode a raw capture instead of a serial port")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    detok = Detokenizer(args.elf)
+    decoder = telem.StreamDecoder()
+
+    def emit(items):
+        for item in items:
+            if not isinstance(item, telem.Record):
+                print(item)
+            elif item.type == telem.REC_LOG:
+                print(detok.format_record(item))
+            elif item.type == telem.REC_LOG_DROPPED:
+                print(f"W tlog: {item.fields['dropped']} entries dropped (ring full)", file=sys.stderr)
+
+    if args.file:
+        with open(args.file, "rb") as f:
+            emit(decoder.feed(f.read()))
+        return
+
+    import serial
+    with serial.Serial(args.port, args.baud, timeout=0.2) as ser:
+        while True:
+            emit(decoder.feed(ser.read(256)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for ESP-IDF esp_err.h
+ *
+ * The firmware headers shared with the host tools (sensors.h,
+ * zb_commissioning.h, calibration_table.h) only need the type and a few
+ * codes.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_NO_MEM          0x101
+#define ESP_ERR_INVALID_ARG     0x102
@@ -0,0 +1,494 @@
+/*
+ * 802.15.4 Channel Model
+ *
+ * Transmissions live in a slot pool; the slots currently on air are kept in
+ * a short active list. Every slot remembers which senders overlapped it, and
+ * reception is decided per receiver when the slot ends.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fleet_channel.h"
+#include "fleet_node.h"
+
+// 2.4 GHz O-QPSK PHY: 62.5 ksymbol/s, 2 symbols per octet
+#define US_PER_OCTET            32
+#define PHY_OVERHEAD_OCTETS     6       // Preamble, SFD, PHR
+
+// IEEE 802.15.4-2006 MAC constants
+#define UNIT_BACKOFF_US         320     // aUnitBackoffPeriod (20 symbols)
+#define CCA_US                  128     // 8 symbols
+#define TURNAROUND_US           192     // aTurnaroundTime (12 symbols)
+#define ACK_WAIT_US             864     // macAckWaitDuration (54 symbols)
+#define MAC_MIN_BE              3
+#define MAC_MAX_BE              5
+#define MAC_MAX_CSMA_BACKOFFS   4
+#define MAC_MAX_FRAME_RETRIES   3
+
+#define MAX_OVERLAPS            8
+
+typedef struct {
+    fleet_frame_t queue[FLEET_MAX_MAC_QUEUE];
+    uint8_t head;
+    uint8_t len;
+    bool awake;
+    bool busy;                  // Head frame is in CSMA, on air or awaiting its ACK
+    bool waiting_ack;
+    uint8_t nb, be;             // CSMA backoff count and exponent
+    uint8_t retries;
+    uint32_t generation;        // Invalidates stale ACK timeouts
+    des_time_t ack_until;       // Sending an ACK: CSMA waits for it
+} radio_t;
+
+typedef struct {
+    bool used;
+    bool is_ack;
+    uint16_t sender;
+    uint16_t receiver;          // FLEET_BROADCAST for broadcasts
+    uint32_t generation;        // ACK: generation of the frame it acknowledges
+    des_time_t start;
+    uint16_t overlap[MAX_OVERLAPS];
+    uint8_t overlap_count;
+    bool overlap_overflow;
+    fleet_frame_t frame;
+} tx_slot_t;
+
+// PSDU octets: MAC header + FCS, NWK header with security (aux header + MIC),
+// APS header, payload
+static const uint8_t psdu_octets[FRAME_KIND_COUNT] = {
+    [FRAME_REPORT]       = 53,  // 11 MAC + 26 NWK + 8 APS + 8 ZCL report (one attribute)
+    [FRAME_DEFAULT_RESP] = 50,  // 11 MAC + 26 NWK + 8 APS + 5 ZCL
+    [FRAME_ACK]          = 5,
+    [FRAME_ANNCE]        = 57,  // 11 MAC + 26 NWK + 8 APS + 12 ZDO
+    [FRAME_BEACON_REQ]   = 10,
+    [FRAME_BEACON]       = 28,  // Superframe spec + 15-octet Zigbee beacon payload
+    [FRAME_ASSOC_REQ]    = 21,
+    [FRAME_ASSOC_RESP]   = 27,
+};
+
+static radio_t *radios = NULL;
+static uint16_t radio_count = 0;
+static tx_slot_t *slots = NULL;
+static uint16_t slot_count = 0;
+static uint16_t *active = NULL;
+static uint16_t active_count = 0;
+static des_rng_t rng;
+
+static des_time_t busy_since = 0;
+static uint32_t *minute_busy_us = NULL;
+static uint32_t minute_count = 0;
+
+// ========================================
+// Internal Helpers
+// ========================================
+
+uint32_t channel_airtime_us(fleet_frame_kind_t kind)
+{
+    return (PHY_OVERHEAD_OCTETS + psdu_octets[kind]) * US_PER_OCTET;
+}
+
+bool channel_audible(uint16_t from, uint16_t to)
+{
+    if (from == FLEET_COORDINATOR || to == FLEET_COORDINATOR || fleet_config.hidden_permille == 0) {
+        return true;
+    }
+
+    // Fixed per pair for the whole run (hash of the unordered pair)
+    uint32_t a = from < to ? from : to;
+    uint32_t b = from < to ? to : from;
+    uint32_t h = (a * 0x9E3779B1u) ^ (b * 0x85EBCA77u) ^ fleet_config.seed;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h % 1000 >= fleet_config.hidden_permille;
+}
+
+static void add_busy(des_time_t from, des_time_t to)
+{
+    fleet_stats.busy_us += to - from;
+
+    // Split across minute buckets for the peak-minute figure
+    while (from < to) {
+        uint32_t minute = (uint32_t)(from / (60 * US_PER_S));
+        des_time_t minute_end = (des_time_t)(minute + 1) * 60 * US_PER_S;
+        des_time_t end = to < minute_end ? to : minute_end;
+        if (minute < minute_count) {
+            minute_busy_us[minute] += (uint32_t)(end - from);
+        }
+        from = end;
+    }
+}
+
+static bool channel_busy_for(uint16_t radio)
+{
+    for (uint16_t i = 0; i < active_count; i++) {
+        if (channel_audible(slots[active[i]].sender, radio)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void note_overlap(tx_slot_t *slot, uint16_t sender)
+{
+    if (slot->overlap_count < MAX_OVERLAPS) {
+        slot->overlap[slot->overlap_count++] = sender;
+    } else {
+        slot->overlap_overflow = true;
+    }
+}
+
+static int start_slot(uint16_t sender, uint16_t receiver, const fleet_frame_t *frame, bool is_ack)
+{
+    int index = -1;
+    for (uint16_t i = 0; i < slot_count; i++) {
+        if (!slots[i].used) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        fprintf(stderr, "fleet_sim: transmission slots exhausted\n");
+        exit(1);
+    }
+
+    tx_slot_t *slot = &slots[index];
+    memset(slot, 0, sizeof(*slot));
+    slot->used = true;
+    slot->is_ack = is_ack;
+    slot->sender = sender;
+    slot->receiver = receiver;
+    slot->start = des_now();
+    slot->frame = *frame;
+
+    // Everything on air now and this frame corrupt each other where audible
+    for (uint16_t i = 0; i < active_count; i++) {
+        tx_slot_t *other = &slots[active[i]];
+        note_overlap(other, sender);
+        note_overlap(slot, other->sender);
+    }
+    if (active_count == 0) {
+        busy_since = des_now();
+    }
+    active[active_count++] = (uint16_t)index;
+
+    fleet_frame_kind_t kind = is_ack ? FRAME_ACK : frame->kind;
+    uint32_t airtime = channel_airtime_us(kind);
+    fleet_stats.tx_frames[kind]++;
+    fleet_stats.airtime_us[kind] += airtime;
+    des_schedule(airtime, EV_MAC_TX_END, sender, (uint32_t)index);
+    return index;
+}
+
+/**
+ * Reception of `slot` at radio `to`. Sets *interfered when an overlapping
+ * transmission (rather than noise or deafness) destroyed it.
+ */
+static bool received(const tx_slot_t *slot, uint16_t to, bool *interfered)
+{
+    *interfered = false;
+    if (to == slot->sender || !radios[to].awake || !channel_audible(slot->sender, to)) {
+        return false;
+    }
+    if (slot->overlap_overflow) {
+        *interfered = true;
+        return false;
+    }
+    for (uint8_t i = 0; i < slot->overlap_count; i++) {
+        uint16_t other = slot->overlap[i];
+        if (other == to) {
+            return false;       // Half duplex: the receiver was on air itself
+        }
+        if (channel_audible(other, to)) {
+            *interfered = true;
+            return false;
+        }
+    }
+    return !des_rng_chance(&rng, fleet_config.per_permille);
+}
+
+// ========================================
+// MAC State Machine
+// ========================================
+
+static void schedule_backoff(uint16_t radio)
+{
+    radio_t *r = &radios[radio];
+    uint32_t periods = des_rng_below(&rng, 1u << r->be);
+    des_time_t from = r->ack_until > des_now() ? r->ack_until : des_now();
+    des_schedule_at(from + periods * UNIT_BACKOFF_US + CCA_US, EV_MAC_BACKOFF, radio, 0);
+}
+
+static void start_head(uint16_t radio)
+{
+    radio_t *r = &radios[radio];
+    if (r->busy || r->len == 0 || !r->awake) {
+        return;
+    }
+    r->busy = true;
+    r->retries = 0;
+    r->nb = 0;
+    r->be = MAC_MIN_BE;
+    schedule_backoff(radio);
+}
+
+static void restart_csma(uint16_t radio)
+{
+    radio_t *r = &radios[radio];
+    r->nb = 0;
+    r->be = MAC_MIN_BE;
+    schedule_backoff(radio);
+}
+
+static void complete_head(uint16_t radio, bool ok)
+{
+    radio_t *r = &radios[radio];
+    fleet_frame_t frame = r->queue[r->head];
+
+    r->head = (uint8_t)((r->head + 1) % FLEET_MAX_MAC_QUEUE);
+    r->len--;
+    r->busy = false;
+    r->waiting_ack = false;
+    r->generation++;
+
+    node_sent(radio, &frame, ok);
+    start_head(radio);
+}
+
+static void on_backoff(uint16_t radio)
+{
+    radio_t *r = &radios[radio];
+    if (!r->busy) {
+        return;
+    }
+    if (r->ack_until > des_now()) {
+        // An ACK became due while backing off; it goes first
+        schedule_backoff(radio);
+        return;
+    }
+
+    if (!channel_busy_for(radio)) {
+        des_schedule(TURNAROUND_US, EV_MAC_TX_START, radio, 0);
+        return;
+    }
+
+    fleet_stats.cca_busy++;
+    r->nb++;
+    r->be = r->be < MAC_MAX_BE ? r->be + 1 : MAC_MAX_BE;
+    if (r->nb > MAC_MAX_CSMA_BACKOFFS) {
+        fleet_stats.access_failures++;
+        complete_head(radio, false);
+        return;
+    }
+    schedule_backoff(radio);
+}
+
+static void on_tx_start(uint16_t radio)
+{
+    radio_t *r = &radios[radio];
+    if (r->ack_until > des_now()) {
+        schedule_backoff(radio);
+        return;
+    }
+
+    const fleet_frame_t *frame = &r->queue[r->head];
+    uint16_t receiver = frame->dst == FLEET_BROADCAST ? FLEET_BROADCAST : node_next_hop(radio, frame->dst);
+
+    start_slot(radio, receiver, frame, false);
+}
+
+static void on_data_end(tx_slot_t *slot)
+{
+    uint16_t sender = slot->sender;
+    radio_t *r = &radios[sender];
+    bool interfered;
+
+    if (slot->receiver == FLEET_BROADCAST) {
+        bool any_interfered = false;
+        for (uint16_t to = 0; to < radio_count; to++) {
+            if (received(slot, to, &interfered)) {
+                node_receive(to, sender, &slot->frame);
+            }
+            any_interfered |= interfered;
+        }
+        if (any_interfered) {
+            fleet_stats.collisions++;
+        }
+        complete_head(sender, true);
+        return;
+    }
+
+    if (received(slot, slot->receiver, &interfered)) {
+        // Retransmissions of a frame the receiver already has are only ACKed
+        fleet_frame_t *head = &r->queue[r->head];
+        if (!head->delivered) {
+            head->delivered = true;
+            slot->frame.delivered = true;
+            node_receive(slot->receiver, sender, &slot->frame);
+        }
+        radios[slot->receiver].ack_until = des_now() + TURNAROUND_US + channel_airtime_us(FRAME_ACK);
+        des_schedule(TURNAROUND_US, EV_MAC_ACK_START, slot->receiver, sender | ((r->generation & 0xFFFF) << 16));
+    } else if (interfered) {
+        fleet_stats.collisions++;
+    }
+
+    r->waiting_ack = true;
+    des_schedule(ACK_WAIT_US, EV_MAC_ACK_TIMEOUT, sender, r->generation);
+}
+
+static void on_ack_end(tx_slot_t *slot)
+{
+    radio_t *r = &radios[slot->receiver];
+    bool interfered;
+
+    if (received(slot, slot->receiver, &interfered)) {
+        if (r->waiting_ack && (r->generation & 0xFFFF) == slot->generation) {
+            complete_head(slot->receiver, true);
+        }
+    } else if (interfered) {
+        fleet_stats.collisions++;
+    }
+}
+
+static void on_ack_timeout(uint16_t radio, uint32_t generation)
+{
+    radio_t *r = &radios[radio];
+    if (!r->waiting_ack || r->generation != generation) {
+        return;
+    }
+
+    r->waiting_ack = false;
+    r->generation++;
+    if (r->retries >= MAC_MAX_FRAME_RETRIES) {
+        fleet_stats.mac_failures++;
+        complete_head(radio, false);
+        return;
+    }
+    r->retries++;
+    fleet_stats.mac_retries++;
+    restart_csma(radio);
+}
+
+static void on_tx_end(uint16_t index)
+{
+    tx_slot_t *slot = &slots[index];
+
+    for (uint16_t i = 0; i < active_count; i++) {
+        if (active[i] == index) {
+            active[i] = active[--active_count];
+            break;
+        }
+    }
+    if (active_count == 0) {
+        add_busy(busy_since, des_now());
+    }
+
+    if (slot->is_ack) {
+        on_ack_end(slot);
+    } else {
+        on_data_end(slot);
+    }
+    slot->used = false;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+void channel_init(void)
+{
+    radio_count = fleet_config.nodes + 1;
+    slot_count = radio_count * 2 + 8;   // One data frame and one ACK per radio at most
+
+    radios = calloc(radio_count, sizeof(*radios));
+    slots = calloc(slot_count, sizeof(*slots));
+    active = calloc(slot_count, sizeof(*active));
+    minute_count = fleet_config.duration_s / 60 + 1;
+    minute_busy_us = calloc(minute_count, sizeof(*minute_busy_us));
+    if (!radios || !slots || !active || !minute_busy_us) {
+        fprintf(stderr, "fleet_sim: out of memory (channel)\n");
+        exit(1);
+    }
+
+    active_count = 0;
+    des_rng_seed(&rng, fleet_config.seed, 0xC4A7);
+}
+
+void channel_free(void)
+{
+    free(radios);
+    free(slots);
+    free(active);
+    free(minute_busy_us);
+    radios = NULL;
+    slots = NULL;
+    active = NULL;
+    minute_busy_us = NULL;
+}
+
+bool channel_send(uint16_t radio, const fleet_frame_t *frame)
+{
+    radio_t *r = &radios[radio];
+    if (r->len >= fleet_config.mac_queue) {
+        fleet_stats.queue_drops++;
+        return false;
+    }
+
+    r->queue[(r->head + r->len) % FLEET_MAX_MAC_QUEUE] = *frame;
+    r->queue[(r->head + r->len) % FLEET_MAX_MAC_QUEUE].delivered = false;
+    r->len++;
+    start_head(radio);
+    return true;
+}
+
+void channel_set_awake(uint16_t radio, bool awake)
+{
+    radios[radio].awake = awake;
+    if (awake) {
+        start_head(radio);
+    }
+}
+
+void channel_handle(const des_event_t *ev)
+{
+    switch (ev->type) {
+    case EV_MAC_BACKOFF:
+        on_backoff(ev->radio);
+        break;
+    case EV_MAC_TX_START:
+        on_tx_start(ev->radio);
+        break;
+    case EV_MAC_TX_END:
+        on_tx_end((uint16_t)ev->arg);
+        break;
+    case EV_MAC_ACK_START: {
+        fleet_frame_t ack = { .kind = FRAME_ACK, .origin = ev->radio };
+        uint16_t to = (uint16_t)(ev->arg & 0xFFFF);
+        int index = start_slot(ev->radio, to, &ack, true);
+        slots[index].generation = ev->arg >> 16;
+        break;
+    }
+    case EV_MAC_ACK_TIMEOUT:
+        on_ack_timeout(ev->radio, ev->arg);
+        break;
+    default:
+        break;
+    }
+}
+
+void channel_finish(void)
+{
+    if (active_count > 0) {
+        add_busy(busy_since, des_now());
+        active_count = 0;
+    }
+
+    uint32_t peak_us = 0;
+    for (uint32_t i = 0; i < minute_count; i++) {
+        if (minute_busy_us[i] > peak_us) {
+            peak_us = minute_busy_us[i];
+        }
+    }
+    fleet_stats.peak_minute_permille = (uint32_t)((uint64_t)peak_us * 1000 / (60 * US_PER_S));
+}
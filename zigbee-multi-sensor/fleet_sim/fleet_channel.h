@@ -0,0 +1,54 @@
+/*
+ * 802.15.4 Channel Model
+ *
+ * One 250 kbit/s channel shared by every radio. Each radio has a FIFO MAC
+ * queue served with unslotted CSMA-CA (macMinBE 3, macMaxBE 5,
+ * macMaxCSMABackoffs 4), acknowledged unicast with macMaxFrameRetries 3,
+ * and unacknowledged broadcast. A reception fails when the receiver was
+ * transmitting itself, when another transmission it can hear overlaps the
+ * frame, or at random with the configured packet error rate. "Hidden"
+ * router pairs cannot hear each other, so their CCA does not see the other
+ * transmission; the coordinator hears everyone.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fleet_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void channel_init(void);
+void channel_free(void);
+
+/**
+ * Queue a frame for transmission. Returns false (and counts a queue drop)
+ * when the radio's MAC queue is full.
+ */
+bool channel_send(uint16_t radio, const fleet_frame_t *frame);
+
+/**
+ * Powered radios transmit and receive; others are deaf.
+ */
+void channel_set_awake(uint16_t radio, bool awake);
+
+bool channel_audible(uint16_t from, uint16_t to);
+
+/**
+ * Airtime of one frame of the given kind, µs (PHY header included).
+ */
+uint32_t channel_airtime_us(fleet_frame_kind_t kind);
+
+void channel_handle(const des_event_t *ev);
+
+/**
+ * Close the busy-time accounting at the end of the run.
+ */
+void channel_finish(void);
+
+#ifdef __cplusplus
+}
+#endif
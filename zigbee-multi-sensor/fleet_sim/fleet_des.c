@@ -0,0 +1,156 @@
+/*
+ * Discrete-Event Core
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "fleet_des.h"
+
+#define HEAP_INITIAL    4096
+
+static des_event_t *heap = NULL;
+static size_t heap_len = 0;
+static size_t heap_cap = 0;
+static uint64_t next_seq = 0;
+static des_time_t now = 0;
+
+// ========================================
+// Event Heap
+// ========================================
+
+static bool before(const des_event_t *a, const des_event_t *b)
+{
+    return a->at < b->at || (a->at == b->at && a->seq < b->seq);
+}
+
+static void swap(size_t i, size_t j)
+{
+    des_event_t tmp = heap[i];
+    heap[i] = heap[j];
+    heap[j] = tmp;
+}
+
+void des_init(void)
+{
+    heap_len = 0;
+    next_seq = 0;
+    now = 0;
+}
+
+void des_free(void)
+{
+    free(heap);
+    heap = NULL;
+    heap_len = heap_cap = 0;
+}
+
+des_time_t des_now(void)
+{
+    return now;
+}
+
+void des_schedule_at(des_time_t at, uint16_t type, uint16_t radio, uint32_t arg)
+{
+    if (heap_len == heap_cap) {
+        heap_cap = heap_cap ? heap_cap * 2 : HEAP_INITIAL;
+        heap = realloc(heap, heap_cap * sizeof(*heap));
+        if (!heap) {
+            fprintf(stderr, "fleet_sim: out of memory (event queue)\n");
+            exit(1);
+        }
+    }
+
+    size_t i = heap_len++;
+    heap[i] = (des_event_t){
+        .at = at < now ? now : at,
+        .seq = next_seq++,
+        .type = type,
+        .radio = radio,
+        .arg = arg,
+    };
+    while (i > 0 && before(&heap[i], &heap[(i - 1) / 2])) {
+        swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+void des_schedule(des_time_t delay, uint16_t type, uint16_t radio, uint32_t arg)
+{
+    des_schedule_at(now + delay, type, radio, arg);
+}
+
+bool des_next(des_time_t until, des_event_t *ev)
+{
+    if (heap_len == 0 || heap[0].at > until) {
+        return false;
+    }
+
+    *ev = heap[0];
+    now = ev->at;
+    heap[0] = heap[--heap_len];
+
+    size_t i = 0;
+    while (1) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        if (l < heap_len && before(&heap[l], &heap[m])) {
+            m = l;
+        }
+        if (r < heap_len && before(&heap[r], &heap[m])) {
+            m = r;
+        }
+        if (m == i) {
+            break;
+        }
+        swap(i, m);
+        i = m;
+    }
+    return true;
+}
+
+// ========================================
+// PRNG
+// ========================================
+
+void des_rng_seed(des_rng_t *rng, uint32_t seed, uint32_t stream)
+{
+    // splitmix64 of (seed, stream) so neighbouring streams are unrelated
+    uint64_t z = ((uint64_t)seed << 32 | stream) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    rng->state = z ? z : 1;
+}
+
+uint32_t des_rng_u32(des_rng_t *rng)
+{
+    uint64_t x = rng->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng->state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+uint32_t des_rng_below(des_rng_t *rng, uint32_t n)
+{
+    return n ? (uint32_t)(((uint64_t)des_rng_u32(rng) * n) >> 32) : 0;
+}
+
+double des_rng_uniform(des_rng_t *rng)
+{
+    return des_rng_u32(rng) / 4294967296.0;
+}
+
+double des_rng_gauss(des_rng_t *rng)
+{
+    // Box-Muller; u in (0, 1] keeps log() finite
+    double u = 1.0 - des_rng_uniform(rng);
+    double v = des_rng_uniform(rng);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+bool des_rng_chance(des_rng_t *rng, uint16_t permille)
+{
+    return permille && des_rng_below(rng, 1000) < permille;
+}
@@ -0,0 +1,62 @@
+/*
+ * Discrete-Event Core
+ *
+ * Virtual time in microseconds and a binary min-heap of pending events.
+ * Events due at the same time run in the order they were scheduled, so a
+ * run is fully determined by its seed.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define US_PER_MS       1000ULL
+#define US_PER_S        1000000ULL
+
+typedef uint64_t des_time_t;
+
+typedef struct {
+    des_time_t at;
+    uint64_t seq;
+    uint16_t type;
+    uint16_t radio;             // Radio / node index the event belongs to
+    uint32_t arg;
+} des_event_t;
+
+void des_init(void);
+void des_free(void);
+
+des_time_t des_now(void);
+
+void des_schedule(des_time_t delay, uint16_t type, uint16_t radio, uint32_t arg);
+void des_schedule_at(des_time_t at, uint16_t type, uint16_t radio, uint32_t arg);
+
+/**
+ * Pop the next event and advance time to it. Returns false when the queue
+ * is empty or the next event is after `until`.
+ */
+bool des_next(des_time_t until, des_event_t *ev);
+
+// ========================================
+// PRNG (xorshift64*, one stream per user)
+// ========================================
+
+typedef struct {
+    uint64_t state;
+} des_rng_t;
+
+void des_rng_seed(des_rng_t *rng, uint32_t seed, uint32_t stream);
+uint32_t des_rng_u32(des_rng_t *rng);
+uint32_t des_rng_below(des_rng_t *rng, uint32_t n);    // [0, n)
+double des_rng_uniform(des_rng_t *rng);                // [0, 1)
+double des_rng_gauss(des_rng_t *rng);                  // mean 0, sd 1
+bool des_rng_chance(des_rng_t *rng, uint16_t permille);
+
+#ifdef __cplusplus
+}
+#endif
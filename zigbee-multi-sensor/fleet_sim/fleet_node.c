@@ -0,0 +1,703 @@
+/*
+ * Sensor Node and Coordinator Models
+ *
+ * Constants marked (main.c) / (sensors.c) restate firmware task timing that
+ * is spent in LED flashes and driver delays rather than named constants;
+ * everything policy-related comes from the firmware headers.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "report_policy.h"
+#include "sensors.h"
+#include "oversample.h"
+#include "zb_commissioning.h"
+#include "fleet_channel.h"
+#include "fleet_node.h"
+
+// Sensor task timing (main.c, sensors.c)
+#define LED_INIT_MS             150     // led_sensor_init()
+#define LED_CYCLE_MS            250     // led_sensor_ok() + 50 ms + led_zigbee_tx()
+#define LED_OK_MS               100
+#define BH1750_INIT_MS          140
+#define DS18B20_READ_MS         10
+#define DHT11_READ_MS           22
+#define CRYSTAL_PPM             20      // +/- per node
+
+// Stack timing
+#define STACK_START_MS          1000    // Boot to first ZDO signal
+#define SCAN_DWELL_US           138240  // (2^3 + 1) x aBaseSuperframeDuration per channel
+#define ASSOC_TIMEOUT_MS        500     // macResponseWaitTime
+#define BROADCAST_JITTER_MS     64      // nwkcMaxBroadcastJitter
+
+#define ALL_CHANNELS_MASK       0x07FFF800UL
+#define SCAN_DONE               0xFF
+
+// ZCL encodings (main.c)
+#define ZB_TEMP_MIN             -5000
+#define ZB_TEMP_MAX             12500
+#define ZB_HUMIDITY_MAX         10000
+#define ZB_ILLUM_MIN            1
+#define ZB_ILLUM_MAX            0xFFFE
+
+#define DAY_S                   86400.0
+
+typedef enum {
+    TASK_BH1750,
+    TASK_DS18B20,
+    TASK_DHT11,
+} sensor_task_t;
+
+typedef struct {
+    int32_t value;
+    int32_t reported;
+    des_time_t last_report;
+    bool has_value;
+    bool reported_once;
+    bool pending;               // Changed enough, waiting for min interval
+    uint8_t generation;         // Invalidates stale report timers
+} attr_state_t;
+
+typedef struct {
+    des_rng_t rng;
+    double drift;               // Crystal: 1 +/- CRYSTAL_PPM
+    uint16_t parent;
+    uint8_t depth;
+    bool joined;
+
+    // Sensor environment
+    double light_gain;
+    double cloud;
+    double outdoor_offset;
+    double indoor_offset;
+
+    attr_state_t attrs[FLEET_ATTR_COUNT];
+
+    // zb_commissioning state
+    zb_commissioning_stage_t stage;
+    uint8_t stage_attempts;
+    uint8_t last_known_channel;
+    uint32_t steer_attempt;
+    bool steering;
+    bool scanning_network;      // Dwelling on the network channel
+    bool parent_beacon;
+
+    uint8_t *annce_seen;        // Per origin: Device_annce already relayed
+} node_t;
+
+typedef struct {
+    uint16_t origin;
+    des_time_t created;
+} ingest_entry_t;
+
+static node_t *nodes = NULL;
+static ingest_entry_t *ingest = NULL;
+static uint16_t ingest_head = 0;
+static uint16_t ingest_len = 0;
+static bool ingest_busy = false;
+static uint16_t depth_count[16];
+
+// ========================================
+// Sensor Environment
+// ========================================
+
+static double time_of_day_s(void)
+{
+    return fmod(des_now() / (double)US_PER_S + fleet_config.start_tod_s, DAY_S);
+}
+
+static double daily_sine(double mean, double amp, double peak_s)
+{
+    return mean + amp * cos(2.0 * M_PI * (time_of_day_s() - peak_s) / DAY_S);
+}
+
+static int32_t read_illuminance(node_t *n)
+{
+    double tod = time_of_day_s();
+    double lux = 0.5;
+    if (tod > 6 * 3600.0 && tod < 20 * 3600.0) {
+        lux += 20000.0 * n->light_gain * sin(M_PI * (tod - 6 * 3600.0) / (14 * 3600.0));
+    }
+
+    // Passing clouds: slow multiplicative random walk
+    n->cloud *= exp(0.05 * des_rng_gauss(&n->rng));
+    n->cloud = n->cloud < 0.2 ? 0.2 : (n->cloud > 1.0 ? 1.0 : n->cloud);
+    lux *= n->cloud;
+
+    if (lux < 1.0) {
+        return ZB_ILLUM_MIN;
+    }
+    int32_t value = (int32_t)(10000.0 * log10(lux) + 1.0);
+    return value < ZB_ILLUM_MIN ? ZB_ILLUM_MIN : (value > ZB_ILLUM_MAX ? ZB_ILLUM_MAX : value);
+}
+
+static int32_t read_outdoor(node_t *n)
+{
+    double t = daily_sine(12.0, 5.0, 15 * 3600.0) + n->outdoor_offset + 0.05 * des_rng_gauss(&n->rng);
+    t = round(t * 16.0) / 16.0;     // DS18B20 12-bit resolution
+    int32_t value = (int32_t)(t * 100);
+    return value < ZB_TEMP_MIN ? ZB_TEMP_MIN : (value > ZB_TEMP_MAX ? ZB_TEMP_MAX : value);
+}
+
+static void read_indoor(node_t *n, int32_t *temperature, int32_t *humidity)
+{
+    // DHT11: 0.1 °C and whole percent, DHT11_OVERSAMPLE reads averaged as in main.c
+    oversample_t temp_acc, humidity_acc;
+    oversample_reset(&temp_acc);
+    oversample_reset(&humidity_acc);
+    for (int k = 0; k < DHT11_OVERSAMPLE; k++) {
+        double t = round(10.0 * (daily_sine(21.0, 1.0, 18 * 3600.0) + n->indoor_offset +
+                                 0.3 * des_rng_gauss(&n->rng))) / 10.0;
+        double h = round(daily_sine(45.0, 5.0, 6 * 3600.0) + 0.5 * des_rng_gauss(&n->rng));
+        oversample_add(&temp_acc, (int32_t)lround(t * 100));
+        oversample_add(&humidity_acc, h < 0 ? 0 : (h > 100 ? ZB_HUMIDITY_MAX : (int32_t)(h * 100)));
+    }
+    oversample_mean(&temp_acc, temperature);
+    oversample_mean(&humidity_acc, humidity);
+}
+
+// ========================================
+// Reporting
+// ========================================
+
+static void send_report(uint16_t id, fleet_attr_t attr)
+{
+    fleet_frame_t frame = {
+        .kind = FRAME_REPORT,
+        .attr = attr,
+        .origin = id,
+        .dst = FLEET_COORDINATOR,
+        .created = des_now(),
+    };
+    fleet_stats.reports_generated++;
+    channel_send(id, &frame);
+}
+
+/**
+ * ZBOSS reporting engine for one attribute: report at once on the first
+ * value, when max elapses, or on a reportable change once min has elapsed
+ * (deferred until then otherwise).
+ */
+static void automatic_report(uint16_t id, fleet_attr_t attr)
+{
+    node_t *n = &nodes[id];
+    attr_state_t *a = &n->attrs[attr];
+    const fleet_reporting_t *cfg = &fleet_config.reporting[attr];
+
+    a->reported = a->value;
+    a->last_report = des_now();
+    a->reported_once = true;
+    a->pending = false;
+    a->generation++;
+    if (cfg->max_s) {
+        des_schedule(cfg->max_s * US_PER_S, EV_NODE_REPORT_CHECK, id, attr | a->generation << 8);
+    }
+    send_report(id, attr);
+}
+
+static void automatic_check(uint16_t id, fleet_attr_t attr)
+{
+    node_t *n = &nodes[id];
+    attr_state_t *a = &n->attrs[attr];
+    const fleet_reporting_t *cfg = &fleet_config.reporting[attr];
+
+    if (!n->joined || !a->has_value) {
+        return;
+    }
+    if (!a->reported_once) {
+        automatic_report(id, attr);
+        return;
+    }
+
+    uint32_t delta = (uint32_t)abs(a->value - a->reported);
+    if (delta == 0 || delta < cfg->change || a->pending) {
+        return;
+    }
+    des_time_t since = des_now() - a->last_report;
+    if (since >= cfg->min_s * US_PER_S) {
+        automatic_report(id, attr);
+    } else {
+        a->pending = true;
+        des_schedule_at(a->last_report + cfg->min_s * US_PER_S, EV_NODE_REPORT_CHECK, id,
+                        attr | a->generation << 8);
+    }
+}
+
+// report_attribute() in main.c
+static void report_attribute(uint16_t id, fleet_attr_t attr, int32_t value)
+{
+    node_t *n = &nodes[id];
+    n->attrs[attr].value = value;
+    n->attrs[attr].has_value = true;
+
+    if (fleet_config.explicit_mode) {
+        if (n->joined) {
+            send_report(id, attr);
+        } else {
+            fleet_stats.reports_unjoined++;
+        }
+    } else {
+        automatic_check(id, attr);
+    }
+}
+
+// ========================================
+// Sensor Tasks
+// ========================================
+
+static des_time_t task_delay_us(const node_t *n, uint32_t ms)
+{
+    return (des_time_t)(ms * n->drift * US_PER_MS);
+}
+
+static void on_sensor(uint16_t id, sensor_task_t task)
+{
+    node_t *n = &nodes[id];
+    uint32_t cycle_ms = 0;
+
+    switch (task) {
+    case TASK_BH1750:
+        report_attribute(id, FLEET_ATTR_ILLUMINANCE, read_illuminance(n));
+        // Burst spacing comes out of the interval; the wake-up measurement does not
+        cycle_ms = LED_CYCLE_MS + fleet_config.light_interval_ms + BH1750_MEASUREMENT_MS;
+        break;
+    case TASK_DS18B20:
+        report_attribute(id, FLEET_ATTR_OUTDOOR_TEMP, read_outdoor(n));
+        cycle_ms = LED_CYCLE_MS + fleet_config.outdoor_interval_ms + DS18B20_CONVERSION_MS + DS18B20_READ_MS;
+        break;
+    case TASK_DHT11: {
+        int32_t temperature, humidity;
+        read_indoor(n, &temperature, &humidity);
+        report_attribute(id, FLEET_ATTR_INDOOR_TEMP, temperature);
+        report_attribute(id, FLEET_ATTR_INDOOR_HUM, humidity);
+        cycle_ms = LED_CYCLE_MS + fleet_config.indoor_interval_ms + DHT11_OVERSAMPLE * DHT11_READ_MS;
+        break;
+    }
+    }
+    des_schedule(task_delay_us(n, cycle_ms), EV_NODE_SENSOR, id, task);
+}
+
+// ========================================
+// Joining (zb_commissioning.c)
+// ========================================
+
+static void announce(uint16_t id)
+{
+    fleet_frame_t frame = {
+        .kind = FRAME_ANNCE,
+        .origin = id,
+        .dst = FLEET_BROADCAST,
+        .created = des_now(),
+    };
+    nodes[id].annce_seen[id] = 1;
+    channel_send(id, &frame);
+}
+
+static void joined(uint16_t id)
+{
+    node_t *n = &nodes[id];
+    n->joined = true;
+    fleet_stats.joined++;
+    fleet_stats.last_join_us = des_now();
+    announce(id);
+
+    // ZBOSS starts reporting configured attributes once on the network
+    if (!fleet_config.explicit_mode) {
+        for (int attr = 0; attr < FLEET_ATTR_COUNT; attr++) {
+            automatic_check(id, (fleet_attr_t)attr);
+        }
+    }
+}
+
+static uint32_t stage_mask(const node_t *n, zb_commissioning_stage_t stage)
+{
+    switch (stage) {
+    case ZB_COMMISSIONING_STAGE_LAST_KNOWN:
+        return n->last_known_channel ? 1UL << n->last_known_channel : 0;
+    case ZB_COMMISSIONING_STAGE_PREFERRED:
+        return fleet_config.preferred_mask;
+    default:
+        return ALL_CHANNELS_MASK;
+    }
+}
+
+static void reset_to_first_stage(node_t *n)
+{
+    n->stage = n->last_known_channel ? ZB_COMMISSIONING_STAGE_LAST_KNOWN : ZB_COMMISSIONING_STAGE_PREFERRED;
+    n->stage_attempts = 0;
+}
+
+static void advance_stage(node_t *n)
+{
+    for (int i = 0; i < ZB_COMMISSIONING_STAGE_COUNT; i++) {
+        n->stage = (n->stage + 1) % ZB_COMMISSIONING_STAGE_COUNT;
+        if (stage_mask(n, n->stage) != 0) {
+            break;
+        }
+    }
+    n->stage_attempts = 0;
+}
+
+static uint8_t next_channel(uint32_t mask, uint8_t after)
+{
+    for (uint8_t ch = after + 1; ch <= ZB_COMMISSIONING_LAST_CHANNEL; ch++) {
+        if (mask & (1UL << ch)) {
+            return ch;
+        }
+    }
+    return SCAN_DONE;
+}
+
+static void steering_done(uint16_t id, bool success)
+{
+    node_t *n = &nodes[id];
+    n->steering = false;
+    n->scanning_network = false;
+
+    if (success) {
+        n->last_known_channel = fleet_config.channel;
+        reset_to_first_stage(n);
+        joined(id);
+        return;
+    }
+
+    fleet_stats.steering_failures++;
+    if (++n->stage_attempts >= ZB_COMMISSIONING_ATTEMPTS_PER_STAGE) {
+        advance_stage(n);
+    }
+    des_schedule(fleet_config.steering_retry_ms * US_PER_MS, EV_NODE_STEER, id, 0);
+}
+
+static void on_steer(uint16_t id)
+{
+    node_t *n = &nodes[id];
+    n->steering = true;
+    n->parent_beacon = false;
+    n->steer_attempt++;
+    fleet_stats.steering_attempts++;
+
+    uint8_t first = next_channel(stage_mask(n, n->stage), ZB_COMMISSIONING_FIRST_CHANNEL - 1);
+    des_schedule(0, EV_NODE_SCAN_CHANNEL, id, first | (n->steer_attempt & 0xFFFFFF) << 8);
+}
+
+static void on_scan_channel(uint16_t id, uint32_t arg)
+{
+    node_t *n = &nodes[id];
+    uint8_t channel = arg & 0xFF;
+    if (!n->steering || (arg >> 8) != (n->steer_attempt & 0xFFFFFF)) {
+        return;
+    }
+
+    n->scanning_network = false;
+    if (channel == SCAN_DONE) {
+        if (!n->parent_beacon) {
+            steering_done(id, false);
+            return;
+        }
+        fleet_frame_t request = {
+            .kind = FRAME_ASSOC_REQ,
+            .origin = id,
+            .dst = n->parent,
+            .created = des_now(),
+        };
+        channel_send(id, &request);
+        des_schedule(ASSOC_TIMEOUT_MS * US_PER_MS, EV_NODE_ASSOC_TIMEOUT, id, n->steer_attempt);
+        return;
+    }
+
+    // Only the network channel carries traffic; others just cost dwell time
+    if (channel == fleet_config.channel) {
+        n->scanning_network = true;
+        fleet_frame_t request = {
+            .kind = FRAME_BEACON_REQ,
+            .origin = id,
+            .dst = FLEET_BROADCAST,
+            .created = des_now(),
+        };
+        channel_send(id, &request);
+    }
+    uint8_t next = next_channel(stage_mask(n, n->stage), channel);
+    des_schedule(SCAN_DWELL_US, EV_NODE_SCAN_CHANNEL, id, next | (n->steer_attempt & 0xFFFFFF) << 8);
+}
+
+// ========================================
+// Coordinator Host Link
+// ========================================
+
+static void ingest_start(void)
+{
+    if (ingest_busy || ingest_len == 0) {
+        return;
+    }
+    ingest_busy = true;
+    des_schedule(US_PER_S / fleet_config.ingest_per_s, EV_COORD_INGEST_DONE, FLEET_COORDINATOR, 0);
+}
+
+static void ingest_done(void)
+{
+    ingest_entry_t entry = ingest[ingest_head];
+    ingest_head = (uint16_t)((ingest_head + 1) % fleet_config.ingest_queue);
+    ingest_len--;
+    ingest_busy = false;
+
+    uint64_t latency_ms = (des_now() - entry.created) / US_PER_MS;
+    log_histogram_add(&fleet_stats.latency_ms, (uint32_t)(latency_ms > UINT32_MAX ? UINT32_MAX : latency_ms));
+    fleet_stats.latency_sum_ms += latency_ms;
+    fleet_stats.reports_delivered++;
+
+    if (fleet_config.default_response) {
+        fleet_frame_t response = {
+            .kind = FRAME_DEFAULT_RESP,
+            .origin = FLEET_COORDINATOR,
+            .dst = entry.origin,
+            .created = des_now(),
+        };
+        channel_send(FLEET_COORDINATOR, &response);
+    }
+    ingest_start();
+}
+
+static void ingest_report(const fleet_frame_t *frame)
+{
+    if (ingest_len >= fleet_config.ingest_queue) {
+        fleet_stats.ingest_drops++;
+        return;
+    }
+    ingest[(ingest_head + ingest_len) % fleet_config.ingest_queue] = (ingest_entry_t){
+        .origin = frame->origin,
+        .created = frame->created,
+    };
+    ingest_len++;
+    ingest_start();
+}
+
+// ========================================
+// Channel Upcalls
+// ========================================
+
+uint16_t node_next_hop(uint16_t radio, uint16_t dst)
+{
+    // Walk up from the destination; if we pass through `radio`, the step
+    // below it is the next hop, otherwise go up the tree
+    uint16_t x = dst;
+    while (x != FLEET_COORDINATOR && nodes[x].parent != radio) {
+        x = nodes[x].parent;
+    }
+    if (x != FLEET_COORDINATOR) {
+        return x;
+    }
+    return radio == FLEET_COORDINATOR ? dst : nodes[radio].parent;
+}
+
+void node_receive(uint16_t radio, uint16_t from, const fleet_frame_t *frame)
+{
+    node_t *n = &nodes[radio];
+
+    switch (frame->kind) {
+    case FRAME_ANNCE:
+        if (n->joined && !n->annce_seen[frame->origin]) {
+            n->annce_seen[frame->origin] = 1;
+            des_schedule(des_rng_below(&n->rng, BROADCAST_JITTER_MS * US_PER_MS), EV_NODE_REBROADCAST,
+                         radio, frame->origin);
+        }
+        return;
+
+    case FRAME_BEACON_REQ:
+        if (n->joined) {
+            fleet_frame_t beacon = {
+                .kind = FRAME_BEACON,
+                .origin = radio,
+                .dst = FLEET_BROADCAST,
+                .created = des_now(),
+            };
+            channel_send(radio, &beacon);
+        }
+        return;
+
+    case FRAME_BEACON:
+        if (n->scanning_network && from == n->parent) {
+            n->parent_beacon = true;
+        }
+        return;
+
+    default:
+        break;
+    }
+
+    if (frame->dst != radio) {
+        // Relay towards the destination
+        channel_send(radio, frame);
+        return;
+    }
+
+    switch (frame->kind) {
+    case FRAME_REPORT:
+        ingest_report(frame);
+        break;
+    case FRAME_ASSOC_REQ: {
+        fleet_frame_t response = {
+            .kind = FRAME_ASSOC_RESP,
+            .origin = radio,
+            .dst = frame->origin,
+            .created = des_now(),
+        };
+        channel_send(radio, &response);
+        break;
+    }
+    case FRAME_ASSOC_RESP:
+        if (n->steering) {
+            steering_done(radio, true);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void node_sent(uint16_t radio, const fleet_frame_t *frame, bool ok)
+{
+    node_t *n = &nodes[radio];
+    if (!ok && frame->kind == FRAME_ASSOC_REQ && n->steering) {
+        steering_done(radio, false);
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+void node_init(void)
+{
+    uint16_t count = fleet_config.nodes + 1;
+    des_rng_t topo;
+
+    nodes = calloc(count, sizeof(*nodes));
+    ingest = calloc(fleet_config.ingest_queue, sizeof(*ingest));
+    if (!nodes || !ingest) {
+        fprintf(stderr, "fleet_sim: out of memory (nodes)\n");
+        exit(1);
+    }
+    ingest_head = ingest_len = 0;
+    ingest_busy = false;
+    memset(depth_count, 0, sizeof(depth_count));
+
+    des_rng_seed(&topo, fleet_config.seed, 0x7090);
+    for (uint16_t id = 0; id < count; id++) {
+        node_t *n = &nodes[id];
+        n->annce_seen = calloc(count, 1);
+        if (!n->annce_seen) {
+            fprintf(stderr, "fleet_sim: out of memory (nodes)\n");
+            exit(1);
+        }
+        des_rng_seed(&n->rng, fleet_config.seed, id);
+        if (id == FLEET_COORDINATOR) {
+            n->joined = true;
+            continue;
+        }
+
+        // Random tree: some routers hear the coordinator, the rest attach
+        // to an earlier router that is not yet at the maximum depth
+        n->parent = FLEET_COORDINATOR;
+        n->depth = 1;
+        if (id > 1 && fleet_config.max_depth > 1 && !des_rng_chance(&topo, fleet_config.direct_permille)) {
+            for (int tries = 0; tries < 16; tries++) {
+                uint16_t candidate = (uint16_t)(1 + des_rng_below(&topo, id - 1));
+                if (nodes[candidate].depth < fleet_config.max_depth) {
+                    n->parent = candidate;
+                    n->depth = nodes[candidate].depth + 1;
+                    break;
+                }
+            }
+        }
+        depth_count[n->depth]++;
+
+        n->drift = 1.0 + (des_rng_uniform(&n->rng) * 2.0 - 1.0) * CRYSTAL_PPM * 1e-6;
+        n->light_gain = 0.25 + 1.25 * des_rng_uniform(&n->rng);
+        n->cloud = 1.0;
+        n->outdoor_offset = des_rng_gauss(&n->rng);
+        n->indoor_offset = des_rng_gauss(&n->rng);
+        reset_to_first_stage(n);
+
+        uint32_t boot_ms = fleet_config.boot_spread_ms ? des_rng_below(&n->rng, fleet_config.boot_spread_ms) : 0;
+        des_schedule(boot_ms * US_PER_MS, EV_NODE_BOOT, id, 0);
+    }
+    channel_set_awake(FLEET_COORDINATOR, true);
+}
+
+void node_free(void)
+{
+    if (nodes) {
+        for (uint16_t id = 0; id <= fleet_config.nodes; id++) {
+            free(nodes[id].annce_seen);
+        }
+    }
+    free(nodes);
+    free(ingest);
+    nodes = NULL;
+    ingest = NULL;
+}
+
+void node_handle(const des_event_t *ev)
+{
+    uint16_t id = ev->radio;
+    node_t *n = &nodes[id];
+
+    switch (ev->type) {
+    case EV_NODE_BOOT:
+        channel_set_awake(id, true);
+        des_schedule(task_delay_us(n, LED_INIT_MS + BH1750_INIT_MS + LED_OK_MS), EV_NODE_SENSOR, id, TASK_BH1750);
+        des_schedule(task_delay_us(n, LED_INIT_MS + LED_OK_MS + DS18B20_CONVERSION_MS + DS18B20_READ_MS),
+                     EV_NODE_SENSOR, id, TASK_DS18B20);
+        des_schedule(task_delay_us(n, LED_INIT_MS + LED_OK_MS + DHT11_STARTUP_DELAY_MS + DHT11_READ_MS),
+                     EV_NODE_SENSOR, id, TASK_DHT11);
+        des_schedule(STACK_START_MS * US_PER_MS,
+                     fleet_config.join == FLEET_JOIN_REBOOT ? EV_NODE_JOINED : EV_NODE_STEER, id, 0);
+        break;
+    case EV_NODE_SENSOR:
+        on_sensor(id, (sensor_task_t)ev->arg);
+        break;
+    case EV_NODE_REPORT_CHECK: {
+        attr_state_t *a = &n->attrs[ev->arg & 0xFF];
+        if ((uint8_t)(ev->arg >> 8) == a->generation && n->joined) {
+            automatic_report(id, (fleet_attr_t)(ev->arg & 0xFF));
+        }
+        break;
+    }
+    case EV_NODE_JOINED:
+        joined(id);
+        break;
+    case EV_NODE_STEER:
+        on_steer(id);
+        break;
+    case EV_NODE_SCAN_CHANNEL:
+        on_scan_channel(id, ev->arg);
+        break;
+    case EV_NODE_ASSOC_TIMEOUT:
+        if (n->steering && ev->arg == n->steer_attempt) {
+            steering_done(id, false);
+        }
+        break;
+    case EV_NODE_REBROADCAST: {
+        fleet_frame_t frame = {
+            .kind = FRAME_ANNCE,
+            .origin = (uint16_t)ev->arg,
+            .dst = FLEET_BROADCAST,
+            .created = des_now(),
+        };
+        channel_send(id, &frame);
+        break;
+    }
+    case EV_COORD_INGEST_DONE:
+        ingest_done();
+        break;
+    default:
+        break;
+    }
+}
+
+uint16_t node_depth_count(uint8_t depth)
+{
+    return depth < 16 ? depth_count[depth] : 0;
+}
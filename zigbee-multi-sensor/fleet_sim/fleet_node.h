@@ -0,0 +1,46 @@
+/*
+ * Sensor Node and Coordinator Models
+ *
+ * Per router: the three sensor tasks of main.c with their real periods
+ * (interval plus the task's own read and LED time, scaled by crystal
+ * drift), report_attribute() in EXPLICIT or AUTOMATIC mode, the ZBOSS
+ * reporting engine for AUTOMATIC, and zb_commissioning's staged steering
+ * with the firmware retry delay. The coordinator forwards received reports
+ * to its host at a fixed ingest rate and answers with Default Responses.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fleet_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void node_init(void);
+void node_free(void);
+
+void node_handle(const des_event_t *ev);
+
+/**
+ * Tree routing: next radio on the way from `radio` to `dst`.
+ */
+uint16_t node_next_hop(uint16_t radio, uint16_t dst);
+
+/**
+ * Channel upcalls: `frame` reached `radio` from neighbour `from`, and the
+ * head frame of `radio` finished (acknowledged, or given up on).
+ */
+void node_receive(uint16_t radio, uint16_t from, const fleet_frame_t *frame);
+void node_sent(uint16_t radio, const fleet_frame_t *frame, bool ok);
+
+/**
+ * Depth histogram of the generated topology (index = hops).
+ */
+uint16_t node_depth_count(uint8_t depth);
+
+#ifdef __cplusplus
+}
+#endif
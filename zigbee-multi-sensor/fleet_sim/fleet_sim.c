@@ -0,0 +1,558 @@
+/*
+ * Fleet Simulator
+ *
+ * Deterministic discrete-event simulation of N sensor routers sharing one
+ * coordinator and one 802.15.4 channel. Runs the firmware's reporting
+ * policy in EXPLICIT and AUTOMATIC mode from the same seed and prints the
+ * airtime, collision, loss and latency figures side by side, so a change
+ * to ZIGBEE_REPORTING_MODE or the sensor intervals can be sized before it
+ * reaches a fleet.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "report_policy.h"
+#include "fleet_channel.h"
+#include "fleet_node.h"
+#include "fleet_sim.h"
+
+fleet_config_t fleet_config;
+fleet_stats_t fleet_stats;
+
+static const char *attr_names[FLEET_ATTR_COUNT] = {
+    "illuminance",
+    "outdoor",
+    "indoor_temp",
+    "humidity",
+};
+
+static const char *frame_names[FRAME_KIND_COUNT] = {
+    "reports",
+    "default responses",
+    "MAC ACKs",
+    "device announces",
+    "beacon requests",
+    "beacons",
+    "association requests",
+    "association responses",
+};
+
+// ========================================
+// Configuration
+// ========================================
+
+static void set_defaults(fleet_config_t *c)
+{
+    memset(c, 0, sizeof(*c));
+    c->nodes = 100;
+    c->duration_s = 6 * 3600;
+    c->seed = 1;
+    c->start_tod_s = 8 * 3600;
+    c->explicit_mode = ZIGBEE_REPORTING_MODE == REPORTING_MODE_EXPLICIT;
+
+    c->light_interval_ms = BH1750_UPDATE_INTERVAL;
+    c->outdoor_interval_ms = DS18B20_UPDATE_INTERVAL;
+    c->indoor_interval_ms = DHT11_UPDATE_INTERVAL;
+    c->steering_retry_ms = ZB_STEERING_RETRY_MS;
+
+    // Zigbee2MQTT defaults for these clusters
+    c->reporting[FLEET_ATTR_ILLUMINANCE] = (fleet_reporting_t){ 10, 3600, 5 };
+    c->reporting[FLEET_ATTR_OUTDOOR_TEMP] = (fleet_reporting_t){ 10, 3600, 100 };
+    c->reporting[FLEET_ATTR_INDOOR_TEMP] = (fleet_reporting_t){ 10, 3600, 100 };
+    c->reporting[FLEET_ATTR_INDOOR_HUM] = (fleet_reporting_t){ 10, 3600, 100 };
+
+    c->join = FLEET_JOIN_REBOOT;
+    c->boot_spread_ms = 10000;
+    c->channel = 11;
+    c->preferred_mask = 1UL << 11;
+
+    c->max_depth = 3;
+    c->direct_permille = 400;
+    c->hidden_permille = 100;
+    c->per_permille = 10;
+    c->mac_queue = 16;
+
+    c->ingest_per_s = 50;
+    c->ingest_queue = 64;
+    c->default_response = true;
+}
+
+static bool parse_u32(const char *s, uint32_t *out, uint32_t max)
+{
+    char *end;
+    errno = 0;
+    unsigned long v = strtoul(s, &end, 10);
+    if (errno || end == s || *end || v > max) {
+        return false;
+    }
+    *out = (uint32_t)v;
+    return true;
+}
+
+// Seconds with optional s/m/h suffix
+static bool parse_duration(const char *s, uint32_t *out)
+{
+    char *end;
+    double v = strtod(s, &end);
+    double scale = 1.0;
+    if (end == s || v < 0) {
+        return false;
+    }
+    if (*end == 'h') {
+        scale = 3600.0;
+        end++;
+    } else if (*end == 'm') {
+        scale = 60.0;
+        end++;
+    } else if (*end == 's') {
+        end++;
+    }
+    if (*end) {
+        return false;
+    }
+    *out = (uint32_t)(v * scale);
+    return true;
+}
+
+// Percent (may be fractional) to per-mille
+static bool parse_percent(const char *s, uint16_t *out)
+{
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || (*end && strcmp(end, "%") != 0) || v < 0 || v > 100) {
+        return false;
+    }
+    *out = (uint16_t)(v * 10.0 + 0.5);
+    return true;
+}
+
+// ATTR=MIN,MAX,CHANGE; "temperature" sets both temperature attributes
+static bool parse_reporting(const char *s, fleet_config_t *c)
+{
+    char name[16];
+    unsigned min_s, max_s, change;
+    if (sscanf(s, "%15[a-z_]=%u,%u,%u", name, &min_s, &max_s, &change) != 4 || (max_s && max_s < min_s)) {
+        return false;
+    }
+
+    fleet_reporting_t r = { min_s, max_s, change };
+    if (strcmp(name, "temperature") == 0) {
+        c->reporting[FLEET_ATTR_OUTDOOR_TEMP] = r;
+        c->reporting[FLEET_ATTR_INDOOR_TEMP] = r;
+        return true;
+    }
+    for (int i = 0; i < FLEET_ATTR_COUNT; i++) {
+        if (strcmp(name, attr_names[i]) == 0) {
+            c->reporting[i] = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void usage(FILE *out)
+{
+    fprintf(out,
+            "usage: fleet_sim [options]\n"
+            "\n"
+            "Run:\n"
+            "  --nodes N                 sensor routers (default 100, max %d)\n"
+            "  --duration T              simulated time, s/m/h suffix (default 6h)\n"
+            "  --start T                 time of day at t=0 (default 8h)\n"
+            "  --seed N                  PRNG seed (default 1)\n"
+            "  --mode M                  explicit, automatic or both (default both)\n"
+            "  --csv PATH                append one row per mode to PATH\n"
+            "\n"
+            "Firmware (defaults from report_policy.h):\n"
+            "  --light-interval MS       BH1750_UPDATE_INTERVAL\n"
+            "  --outdoor-interval MS     DS18B20_UPDATE_INTERVAL\n"
+            "  --indoor-interval MS      DHT11_UPDATE_INTERVAL\n"
+            "  --steering-retry MS       ZB_STEERING_RETRY_MS\n"
+            "  --reporting A=MIN,MAX,CH  coordinator reporting config for AUTOMATIC;\n"
+            "                            A: illuminance, outdoor, indoor_temp, humidity,\n"
+            "                            temperature (both temperatures)\n"
+            "\n"
+            "Power-up:\n"
+            "  --join MODE               reboot (commissioned, default) or steer (factory new)\n"
+            "  --boot-spread T           nodes power up uniformly over T (default 10s)\n"
+            "  --channel N               network channel (default 11)\n"
+            "  --preferred N             firmware preferred channel (default 11)\n"
+            "\n"
+            "Network:\n"
+            "  --depth N                 maximum hops to the coordinator (default 3)\n"
+            "  --direct PCT              routers that are coordinator children (default 40)\n"
+            "  --hidden PCT              router pairs out of earshot (default 10)\n"
+            "  --per PCT                 random frame loss per reception (default 1)\n"
+            "  --mac-queue N             frames a radio queues (default 16)\n"
+            "  --ingest N                coordinator host frames/s (default 50)\n"
+            "  --ingest-queue N          coordinator host queue (default 64)\n"
+            "  --no-default-response     coordinator does not answer reports\n",
+            FLEET_MAX_NODES);
+}
+
+enum {
+    OPT_NODES = 256, OPT_DURATION, OPT_START, OPT_SEED, OPT_MODE, OPT_CSV,
+    OPT_LIGHT, OPT_OUTDOOR, OPT_INDOOR, OPT_RETRY, OPT_REPORTING,
+    OPT_JOIN, OPT_BOOT_SPREAD, OPT_CHANNEL, OPT_PREFERRED,
+    OPT_DEPTH, OPT_DIRECT, OPT_HIDDEN, OPT_PER, OPT_MAC_QUEUE, OPT_INGEST, OPT_INGEST_QUEUE, OPT_NO_DR,
+    OPT_HELP,
+};
+
+static const struct option options[] = {
+    { "nodes", required_argument, NULL, OPT_NODES },
+    { "duration", required_argument, NULL, OPT_DURATION },
+    { "start", required_argument, NULL, OPT_START },
+    { "seed", required_argument, NULL, OPT_SEED },
+    { "mode", required_argument, NULL, OPT_MODE },
+    { "csv", required_argument, NULL, OPT_CSV },
+    { "light-interval", required_argument, NULL, OPT_LIGHT },
+    { "outdoor-interval", required_argument, NULL, OPT_OUTDOOR },
+    { "indoor-interval", required_argument, NULL, OPT_INDOOR },
+    { "steering-retry", required_argument, NULL, OPT_RETRY },
+    { "reporting", required_argument, NULL, OPT_REPORTING },
+    { "join", required_argument, NULL, OPT_JOIN },
+    { "boot-spread", required_argument, NULL, OPT_BOOT_SPREAD },
+    { "channel", required_argument, NULL, OPT_CHANNEL },
+    { "preferred", required_argument, NULL, OPT_PREFERRED },
+    { "depth", required_argument, NULL, OPT_DEPTH },
+    { "direct", required_argument, NULL, OPT_DIRECT },
+    { "hidden", required_argument, NULL, OPT_HIDDEN },
+    { "per", required_argument, NULL, OPT_PER },
+    { "mac-queue", required_argument, NULL, OPT_MAC_QUEUE },
+    { "ingest", required_argument, NULL, OPT_INGEST },
+    { "ingest-queue", required_argument, NULL, OPT_INGEST_QUEUE },
+    { "no-default-response", no_argument, NULL, OPT_NO_DR },
+    { "help", no_argument, NULL, OPT_HELP },
+    { NULL, 0, NULL, 0 },
+};
+
+// ========================================
+// Simulation Run
+// ========================================
+
+static fleet_stats_t run(const fleet_config_t *config)
+{
+    des_event_t ev;
+
+    fleet_config = *config;
+    memset(&fleet_stats, 0, sizeof(fleet_stats));
+    log_histogram_reset(&fleet_stats.latency_ms);
+
+    des_init();
+    channel_init();
+    node_init();
+
+    while (des_next((des_time_t)config->duration_s * US_PER_S, &ev)) {
+        if (ev.type < EV_NODE_BOOT) {
+            channel_handle(&ev);
+        } else {
+            node_handle(&ev);
+        }
+    }
+
+    channel_finish();
+    node_free();
+    channel_free();
+    return fleet_stats;
+}
+
+// ========================================
+// Output
+// ========================================
+
+typedef struct {
+    const char *name;
+    fleet_stats_t stats;
+} result_t;
+
+static double pct(uint64_t part, uint64_t whole)
+{
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+static void print_row(const result_t *results, int count, const char *label, const char *fmt,
+                      double (*value)(const fleet_stats_t *))
+{
+    printf("  %-30s", label);
+    for (int i = 0; i < count; i++) {
+        char cell[32];
+        snprintf(cell, sizeof(cell), fmt, value(&results[i].stats));
+        printf(" %14s", cell);
+    }
+    printf("\n");
+}
+
+static uint64_t total_frames(const fleet_stats_t *s)
+{
+    uint64_t total = 0;
+    for (int k = 0; k < FRAME_KIND_COUNT; k++) {
+        total += s->tx_frames[k];
+    }
+    return total;
+}
+
+static double duration_s(void)
+{
+    return (double)fleet_config.duration_s;
+}
+
+static double v_reports(const fleet_stats_t *s) { return (double)s->reports_generated; }
+static double v_report_rate(const fleet_stats_t *s) { return s->reports_generated / duration_s(); }
+static double v_per_node_hour(const fleet_stats_t *s)
+{
+    return s->reports_generated * 3600.0 / duration_s() / fleet_config.nodes;
+}
+static double v_frames(const fleet_stats_t *s) { return (double)total_frames(s); }
+static double v_frame_rate(const fleet_stats_t *s) { return total_frames(s) / duration_s(); }
+static double v_airtime(const fleet_stats_t *s) { return 100.0 * s->busy_us / (duration_s() * US_PER_S); }
+static double v_peak(const fleet_stats_t *s) { return s->peak_minute_permille / 10.0; }
+static double v_collisions(const fleet_stats_t *s) { return (double)s->collisions; }
+static double v_collision_pct(const fleet_stats_t *s) { return pct(s->collisions, total_frames(s)); }
+static double v_cca_busy(const fleet_stats_t *s) { return (double)s->cca_busy; }
+static double v_access(const fleet_stats_t *s) { return (double)s->access_failures; }
+static double v_retries(const fleet_stats_t *s) { return (double)s->mac_retries; }
+static double v_mac_fail(const fleet_stats_t *s) { return (double)s->mac_failures; }
+static double v_queue(const fleet_stats_t *s) { return (double)s->queue_drops; }
+static double v_ingest(const fleet_stats_t *s) { return (double)s->ingest_drops; }
+static double v_delivered(const fleet_stats_t *s) { return (double)s->reports_delivered; }
+static double v_delivered_pct(const fleet_stats_t *s) { return pct(s->reports_delivered, s->reports_generated); }
+static double v_mean(const fleet_stats_t *s)
+{
+    return s->reports_delivered ? (double)s->latency_sum_ms / s->reports_delivered : 0.0;
+}
+static double v_p50(const fleet_stats_t *s) { return log_histogram_percentile(&s->latency_ms, 50); }
+static double v_p90(const fleet_stats_t *s) { return log_histogram_percentile(&s->latency_ms, 90); }
+static double v_p99(const fleet_stats_t *s) { return log_histogram_percentile(&s->latency_ms, 99); }
+static double v_max(const fleet_stats_t *s) { return s->latency_ms.max; }
+static double v_joined(const fleet_stats_t *s) { return s->joined; }
+static double v_last_join(const fleet_stats_t *s) { return s->last_join_us / (double)US_PER_S; }
+static double v_steering(const fleet_stats_t *s) { return s->steering_attempts; }
+static double v_steer_fail(const fleet_stats_t *s) { return s->steering_failures; }
+
+static void print_results(const result_t *results, int count)
+{
+    printf("\nfleet_sim: %u routers, %u s, seed %lu, join=%s, boot spread %u ms\n",
+           fleet_config.nodes, fleet_config.duration_s, (unsigned long)fleet_config.seed,
+           fleet_config.join == FLEET_JOIN_REBOOT ? "reboot" : "steer", fleet_config.boot_spread_ms);
+    printf("  intervals: light %u ms, outdoor %u ms, indoor %u ms\n",
+           fleet_config.light_interval_ms, fleet_config.outdoor_interval_ms, fleet_config.indoor_interval_ms);
+    printf("  topology:");
+    for (uint8_t d = 1; d <= fleet_config.max_depth; d++) {
+        printf(" %u-hop %u", d, node_depth_count(d));
+    }
+    printf("; hidden pairs %.1f%%, PER %.1f%%, ingest %u frames/s\n\n",
+           fleet_config.hidden_permille / 10.0, fleet_config.per_permille / 10.0, fleet_config.ingest_per_s);
+
+    printf("  %-30s", "");
+    for (int i = 0; i < count; i++) {
+        printf(" %14s", results[i].name);
+    }
+    printf("\n");
+
+    print_row(results, count, "reports generated", "%.0f", v_reports);
+    print_row(results, count, "  per second (fleet)", "%.2f", v_report_rate);
+    print_row(results, count, "  per node per hour", "%.1f", v_per_node_hour);
+    print_row(results, count, "frames on air", "%.0f", v_frames);
+    print_row(results, count, "  per second", "%.2f", v_frame_rate);
+    for (int k = 0; k < FRAME_KIND_COUNT; k++) {
+        bool any = false;
+        for (int i = 0; i < count; i++) {
+            any |= results[i].stats.tx_frames[k] != 0;
+        }
+        if (!any) {
+            continue;
+        }
+        printf("    %-28s", frame_names[k]);
+        for (int i = 0; i < count; i++) {
+            printf(" %14llu", (unsigned long long)results[i].stats.tx_frames[k]);
+        }
+        printf("\n");
+    }
+    print_row(results, count, "airtime (%)", "%.2f", v_airtime);
+    print_row(results, count, "  busiest minute (%)", "%.1f", v_peak);
+    print_row(results, count, "collisions", "%.0f", v_collisions);
+    print_row(results, count, "  of frames (%)", "%.2f", v_collision_pct);
+    print_row(results, count, "CCA busy", "%.0f", v_cca_busy);
+    print_row(results, count, "channel access failures", "%.0f", v_access);
+    print_row(results, count, "MAC retries", "%.0f", v_retries);
+    print_row(results, count, "MAC failures (no ACK)", "%.0f", v_mac_fail);
+    print_row(results, count, "MAC queue drops", "%.0f", v_queue);
+    print_row(results, count, "coordinator ingest drops", "%.0f", v_ingest);
+    print_row(results, count, "reports delivered", "%.0f", v_delivered);
+    print_row(results, count, "  of generated (%)", "%.2f", v_delivered_pct);
+    print_row(results, count, "latency mean (ms)", "%.1f", v_mean);
+    print_row(results, count, "latency p50 (ms)", "%.0f", v_p50);
+    print_row(results, count, "latency p90 (ms)", "%.0f", v_p90);
+    print_row(results, count, "latency p99 (ms)", "%.0f", v_p99);
+    print_row(results, count, "latency max (ms)", "%.0f", v_max);
+    print_row(results, count, "routers joined", "%.0f", v_joined);
+    print_row(results, count, "  last join at (s)", "%.1f", v_last_join);
+    if (fleet_config.join == FLEET_JOIN_STEER) {
+        print_row(results, count, "steering attempts", "%.0f", v_steering);
+        print_row(results, count, "  failed", "%.0f", v_steer_fail);
+    }
+}
+
+static void write_csv(const char *path, const result_t *results, int count)
+{
+    bool header = access(path, F_OK) != 0;
+    FILE *f = fopen(path, "a");
+    if (!f) {
+        perror(path);
+        return;
+    }
+
+    if (header) {
+        fprintf(f, "mode,nodes,duration_s,seed,join,light_ms,outdoor_ms,indoor_ms,depth,hidden_pct,per_pct,"
+                   "ingest_per_s,reports,frames,airtime_pct,peak_minute_pct,collisions,cca_busy,access_failures,"
+                   "mac_retries,mac_failures,queue_drops,ingest_drops,delivered,delivered_pct,"
+                   "latency_mean_ms,latency_p50_ms,latency_p90_ms,latency_p99_ms,latency_max_ms,joined,last_join_s\n");
+    }
+    for (int i = 0; i < count; i++) {
+        const fleet_stats_t *s = &results[i].stats;
+        fprintf(f, "%s,%u,%u,%lu,%s,%u,%u,%u,%u,%.1f,%.1f,%u,%llu,%llu,%.3f,%.1f,%llu,%llu,%llu,%llu,%llu,"
+                   "%llu,%llu,%llu,%.3f,%.1f,%.0f,%.0f,%.0f,%.0f,%u,%.1f\n",
+                results[i].name, fleet_config.nodes, fleet_config.duration_s, (unsigned long)fleet_config.seed,
+                fleet_config.join == FLEET_JOIN_REBOOT ? "reboot" : "steer",
+                fleet_config.light_interval_ms, fleet_config.outdoor_interval_ms, fleet_config.indoor_interval_ms,
+                fleet_config.max_depth, fleet_config.hidden_permille / 10.0, fleet_config.per_permille / 10.0,
+                fleet_config.ingest_per_s, (unsigned long long)s->reports_generated,
+                (unsigned long long)total_frames(s), v_airtime(s), v_peak(s),
+                (unsigned long long)s->collisions, (unsigned long long)s->cca_busy,
+                (unsigned long long)s->access_failures, (unsigned long long)s->mac_retries,
+                (unsigned long long)s->mac_failures, (unsigned long long)s->queue_drops,
+                (unsigned long long)s->ingest_drops, (unsigned long long)s->reports_delivered,
+                v_delivered_pct(s), v_mean(s), v_p50(s), v_p90(s), v_p99(s), v_max(s),
+                s->joined, v_last_join(s));
+    }
+    fclose(f);
+}
+
+// ========================================
+// Entry Point
+// ========================================
+
+int main(int argc, char **argv)
+{
+    fleet_config_t config;
+    const char *csv_path = NULL;
+    bool run_explicit = true;
+    bool run_automatic = true;
+    uint32_t n;
+    bool ok = true;
+    int opt;
+
+    set_defaults(&config);
+    while (ok && (opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+        case OPT_NODES:
+            ok = parse_u32(optarg, &n, FLEET_MAX_NODES) && n > 0 && ((config.nodes = (uint16_t)n), true);
+            break;
+        case OPT_DURATION:
+            ok = parse_duration(optarg, &config.duration_s) && config.duration_s > 0;
+            break;
+        case OPT_START:
+            ok = parse_duration(optarg, &n) && ((config.start_tod_s = n % 86400), true);
+            break;
+        case OPT_SEED:
+            ok = parse_u32(optarg, &config.seed, UINT32_MAX);
+            break;
+        case OPT_MODE:
+            run_explicit = strcmp(optarg, "explicit") == 0 || strcmp(optarg, "both") == 0;
+            run_automatic = strcmp(optarg, "automatic") == 0 || strcmp(optarg, "both") == 0;
+            ok = run_explicit || run_automatic;
+            break;
+        case OPT_CSV:
+            csv_path = optarg;
+            break;
+        case OPT_LIGHT:
+            ok = parse_u32(optarg, &config.light_interval_ms, 86400000);
+            break;
+        case OPT_OUTDOOR:
+            ok = parse_u32(optarg, &config.outdoor_interval_ms, 86400000);
+            break;
+        case OPT_INDOOR:
+            ok = parse_u32(optarg, &config.indoor_interval_ms, 86400000);
+            break;
+        case OPT_RETRY:
+            ok = parse_u32(optarg, &config.steering_retry_ms, 3600000);
+            break;
+        case OPT_REPORTING:
+            ok = parse_reporting(optarg, &config);
+            break;
+        case OPT_JOIN:
+            config.join = strcmp(optarg, "steer") == 0 ? FLEET_JOIN_STEER : FLEET_JOIN_REBOOT;
+            ok = config.join == FLEET_JOIN_STEER || strcmp(optarg, "reboot") == 0;
+            break;
+        case OPT_BOOT_SPREAD:
+            ok = parse_duration(optarg, &n) && ((config.boot_spread_ms = n * 1000), true);
+            break;
+        case OPT_CHANNEL:
+            ok = parse_u32(optarg, &n, 26) && n >= 11 && ((config.channel = (uint8_t)n), true);
+            break;
+        case OPT_PREFERRED:
+            ok = parse_u32(optarg, &n, 26) && n >= 11 && ((config.preferred_mask = 1UL << n), true);
+            break;
+        case OPT_DEPTH:
+            ok = parse_u32(optarg, &n, 15) && n > 0 && ((config.max_depth = (uint8_t)n), true);
+            break;
+        case OPT_DIRECT:
+            ok = parse_percent(optarg, &config.direct_permille);
+            break;
+        case OPT_HIDDEN:
+            ok = parse_percent(optarg, &config.hidden_permille);
+            break;
+        case OPT_PER:
+            ok = parse_percent(optarg, &config.per_permille);
+            break;
+        case OPT_MAC_QUEUE:
+            ok = parse_u32(optarg, &n, FLEET_MAX_MAC_QUEUE) && n > 0 && ((config.mac_queue = (uint8_t)n), true);
+            break;
+        case OPT_INGEST:
+            ok = parse_u32(optarg, &config.ingest_per_s, 100000) && config.ingest_per_s > 0;
+            break;
+        case OPT_INGEST_QUEUE:
+            ok = parse_u32(optarg, &n, 65535) && n > 0 && ((config.ingest_queue = (uint16_t)n), true);
+            break;
+        case OPT_NO_DR:
+            config.default_response = false;
+            break;
+        case 'h':
+        case OPT_HELP:
+            usage(stdout);
+            return 0;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok && opt != '?') {
+            fprintf(stderr, "fleet_sim: invalid value for --%s: %s\n", options[opt - OPT_NODES].name, optarg);
+        }
+    }
+    if (!ok || optind != argc) {
+        usage(stderr);
+        return 2;
+    }
+
+    result_t results[2];
+    int count = 0;
+    if (run_explicit) {
+        config.explicit_mode = true;
+        results[count++] = (result_t){ "EXPLICIT", run(&config) };
+    }
+    if (run_automatic) {
+        config.explicit_mode = false;
+        results[count++] = (result_t){ "AUTOMATIC", run(&config) };
+    }
+
+    print_results(results, count);
+    if (csv_path) {
+        write_csv(csv_path, results, count);
+    }
+    des_free();
+    return 0;
+}
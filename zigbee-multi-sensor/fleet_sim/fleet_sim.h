@@ -0,0 +1,153 @@
+/*
+ * Fleet Simulator: Shared Definitions
+ *
+ * Radio 0 is the coordinator, radios 1..N are the sensor routers. Each
+ * router runs the firmware's sensor schedule, reporting policy and steering
+ * retry/escalation (report_policy.h, zb_commissioning.h) against one shared
+ * 2.4 GHz channel (fleet_channel.c) and a coordinator whose host link
+ * ingests a bounded number of frames per second (fleet_node.c).
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fleet_des.h"
+#include "log_histogram.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FLEET_MAX_NODES         1000
+#define FLEET_COORDINATOR       0
+#define FLEET_BROADCAST         0xFFFF
+#define FLEET_MAX_MAC_QUEUE     64
+
+typedef enum {
+    FLEET_JOIN_REBOOT,          // Already commissioned: rejoin from NVS at boot
+    FLEET_JOIN_STEER,           // Factory new: BDB network steering
+} fleet_join_t;
+
+typedef struct {
+    uint32_t min_s, max_s;
+    uint32_t change;            // Reportable change, ZCL units
+} fleet_reporting_t;
+
+// Reported attributes per node
+typedef enum {
+    FLEET_ATTR_ILLUMINANCE,     // EP12
+    FLEET_ATTR_OUTDOOR_TEMP,    // EP11
+    FLEET_ATTR_INDOOR_TEMP,     // EP10
+    FLEET_ATTR_INDOOR_HUM,      // EP10
+    FLEET_ATTR_COUNT,
+} fleet_attr_t;
+
+typedef struct {
+    uint16_t nodes;
+    uint32_t duration_s;
+    uint32_t seed;
+    uint32_t start_tod_s;       // Time of day at t = 0 (diurnal waveforms)
+    bool explicit_mode;
+
+    // Firmware constants (defaults from report_policy.h)
+    uint32_t light_interval_ms;
+    uint32_t outdoor_interval_ms;
+    uint32_t indoor_interval_ms;
+    uint32_t steering_retry_ms;
+    fleet_reporting_t reporting[FLEET_ATTR_COUNT];
+
+    // Power-up and commissioning
+    fleet_join_t join;
+    uint32_t boot_spread_ms;    // Nodes boot uniformly over this window
+    uint8_t channel;            // Network channel
+    uint32_t preferred_mask;    // Firmware preferred channel set
+
+    // Topology and channel
+    uint8_t max_depth;          // Hops to the coordinator, 1..max_depth
+    uint16_t direct_permille;   // Share of routers that are coordinator children
+    uint16_t hidden_permille;   // Router pairs that cannot hear each other
+    uint16_t per_permille;      // Frame loss from noise/fading, per reception
+    uint8_t mac_queue;          // Frames a radio holds before dropping
+
+    // Coordinator host link
+    uint32_t ingest_per_s;
+    uint16_t ingest_queue;
+    bool default_response;      // Coordinator answers each report
+} fleet_config_t;
+
+typedef enum {
+    FRAME_REPORT,
+    FRAME_DEFAULT_RESP,
+    FRAME_ACK,
+    FRAME_ANNCE,                // ZDO Device_annce (broadcast, relayed by every router)
+    FRAME_BEACON_REQ,
+    FRAME_BEACON,
+    FRAME_ASSOC_REQ,
+    FRAME_ASSOC_RESP,
+    FRAME_KIND_COUNT,
+} fleet_frame_kind_t;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t attr;               // FRAME_REPORT: fleet_attr_t
+    bool delivered;             // Reached the next hop (MAC duplicate filter)
+    uint16_t origin;            // Radio that created the frame
+    uint16_t dst;               // Final destination or FLEET_BROADCAST
+    des_time_t created;
+} fleet_frame_t;
+
+typedef struct {
+    // Offered load
+    uint64_t reports_generated;
+    uint64_t reports_unjoined;          // Explicit reports while not on a network
+    uint64_t tx_frames[FRAME_KIND_COUNT];
+    uint64_t airtime_us[FRAME_KIND_COUNT];
+
+    // Channel
+    uint64_t busy_us;                   // Union of all transmissions
+    uint32_t peak_minute_permille;
+    uint64_t collisions;                // Transmissions lost to overlap at the receiver
+    uint64_t cca_busy;
+    uint64_t access_failures;           // macMaxCSMABackoffs exceeded
+    uint64_t mac_retries;
+    uint64_t mac_failures;              // No ACK after macMaxFrameRetries
+    uint64_t queue_drops;               // MAC queue full
+
+    // Coordinator
+    uint64_t ingest_drops;
+    uint64_t reports_delivered;
+    log_histogram_t latency_ms;         // Report generation to coordinator host
+    uint64_t latency_sum_ms;
+
+    // Commissioning
+    uint32_t steering_attempts;
+    uint32_t steering_failures;
+    uint16_t joined;
+    des_time_t last_join_us;
+} fleet_stats_t;
+
+// Event types (des_event_t.type)
+enum {
+    EV_MAC_BACKOFF,             // radio: backoff + CCA elapsed
+    EV_MAC_TX_START,            // radio: RX-to-TX turnaround elapsed
+    EV_MAC_TX_END,              // arg: transmission slot
+    EV_MAC_ACK_START,           // radio: sends ACK, arg: destination radio
+    EV_MAC_ACK_TIMEOUT,         // radio, arg: attempt generation
+    EV_NODE_BOOT,
+    EV_NODE_SENSOR,             // arg: sensor task
+    EV_NODE_REPORT_CHECK,       // arg: attr | generation << 8
+    EV_NODE_JOINED,
+    EV_NODE_STEER,
+    EV_NODE_SCAN_CHANNEL,       // arg: channel
+    EV_NODE_ASSOC_TIMEOUT,      // arg: steering attempt
+    EV_NODE_REBROADCAST,        // arg: announce origin
+    EV_COORD_INGEST_DONE,
+};
+
+extern fleet_config_t fleet_config;
+extern fleet_stats_t fleet_stats;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,19 @@
+/*
+ * ROM delay stand-in for the linux target
+ *
+ * Only the busy-wait used by onewire.c; see sim_hal.c.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void ets_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,105 @@
+/*
+ * Simulated Board
+ *
+ * GPIO, LED strip and ROM delay calls from the firmware land here. They keep
+ * the pin levels so the status LED can be inspected from a debugger, and
+ * otherwise do nothing: busy-wait delays return at once, so host benchmarks
+ * of bit-banged code measure its software overhead only.
+ */
+
+#include <stdlib.h>
+#include "driver/gpio.h"
+#include "led_strip.h"
+#include "rom/ets_sys.h"
+
+#define SIM_GPIO_COUNT  32
+
+struct led_strip_t {
+    uint32_t max_leds;
+    uint8_t rgb[3];
+};
+
+static uint8_t gpio_levels[SIM_GPIO_COUNT];
+
+// ========================================
+// driver/gpio.h
+// ========================================
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_levels[gpio_num] = 0;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    return gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_levels[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT ? 0 : gpio_levels[gpio_num];
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull)
+{
+    return gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+// ========================================
+// rom/ets_sys.h
+// ========================================
+
+void ets_delay_us(uint32_t us)
+{
+}
+
+// ========================================
+// led_strip.h
+// ========================================
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                   led_strip_handle_t *ret_strip)
+{
+    struct led_strip_t *strip = calloc(1, sizeof(*strip));
+    if (!strip) {
+        return ESP_ERR_NO_MEM;
+    }
+    strip->max_leds = led_config->max_leds;
+    *ret_strip = strip;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    if (index >= strip->max_leds) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    strip->rgb[0] = red;
+    strip->rgb[1] = green;
+    strip->rgb[2] = blue;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_refresh(led_strip_handle_t strip)
+{
+    return ESP_OK;
+}
+
+esp_err_t led_strip_clear(led_strip_handle_t strip)
+{
+    strip->rgb[0] = strip->rgb[1] = strip->rgb[2] = 0;
+    return ESP_OK;
+}
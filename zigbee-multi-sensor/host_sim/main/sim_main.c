@@ -0,0 +1,246 @@
+/*
+ * Host Simulator Entry Point
+ *
+ * Runs before the firmware's app_main() (linked with --wrap=app_main):
+ * loads the scenario, starts simulated time and the mock stack, redirects
+ * stdout (ESP logs and telemetry frames, exactly as the UART would carry
+ * them) to a capture file, then hands over to the firmware. A control task
+ * plays the scenario timeline and ends the run with a summary on stderr.
+ *
+ * Environment:
+ *   SIM_SCENARIO   scenario file            (default scenarios/day.sim)
+ *   SIM_SPEED      override scenario speed
+ *   SIM_CAPTURE    stdout capture           (default sim_capture.bin, "-" keeps stdout)
+ *   SIM_EVENTS     CSV event log            (default sim_events.csv, "" disables)
+ *   SIM_SUMMARY    JSON summary             (unset disables)
+ *   SIM_BENCH      run the benchmark suite instead ("all" or a case-name
+ *                  filter) and print its JSON results on stdout
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "app_console.h"
+#include "bench.h"
+#include "crash_dump.h"
+#include "power.h"
+#include "sim_scenario.h"
+#include "sim_stats.h"
+#include "sim_time.h"
+#include "sim_zigbee.h"
+#include "status_led.h"
+#include "supervisor.h"
+#include "sys_profiler.h"
+#include "zb_nwk_monitor.h"
+#include "zb_ota.h"
+
+#define SIM_CTL_STEP_MS         1000
+
+void __real_app_main(void);
+
+static const char *scenario_path;
+static const char *summary_path;
+
+static const char *env_or(const char *name, const char *fallback)
+{
+    const char *value = getenv(name);
+    return value ? value : fallback;
+}
+
+// ========================================
+// Scenario Timeline
+// ========================================
+
+static void apply_event(const sim_event_t *ev)
+{
+    char detail[32];
+
+    switch (ev->type) {
+    case SIM_EVENT_MODE:
+        snprintf(detail, sizeof(detail), "%s", ev->arg ? "explicit" : "automatic");
+        sim_stats_note("scenario_mode", detail);
+        sim_zigbee_remote_mode_switch(ev->arg != 0);
+        break;
+    case SIM_EVENT_LINK_DOWN:
+        snprintf(detail, sizeof(detail), "%lus", (unsigned long)ev->arg);
+        sim_stats_note("scenario_link_down", detail);
+        sim_zigbee_link_down(ev->arg);
+        break;
+    }
+}
+
+static void sim_ctl_task(void *pvParameters)
+{
+    uint8_t next_event = 0;
+
+    while (1) {
+        uint32_t now_s = (uint32_t)(sim_time_us() / 1000000);
+
+        while (next_event < sim_scenario.event_count && sim_scenario.events[next_event].at_s <= now_s) {
+            apply_event(&sim_scenario.events[next_event++]);
+        }
+
+        if (now_s >= sim_scenario.duration_s) {
+            fflush(stdout);
+            sim_stats_print(stderr, scenario_path);
+            fprintf(stderr, "\n%lu s simulated in %.1f s host time\n",
+                    (unsigned long)now_s, sim_time_host_elapsed());
+            sim_stats_write_json(summary_path);
+            exit(0);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(SIM_CTL_STEP_MS));
+    }
+}
+
+// ========================================
+// Benchmark Mode
+// ========================================
+
+static void run_bench(const char *filter)
+{
+    bench_result_t results[BENCH_MAX_CASES];
+
+    // Keep stdout clean for the JSON; the LED dispatch case needs the strip
+    esp_log_level_set("*", ESP_LOG_WARN);
+    sim_time_init(1);
+    status_led_init();
+
+    size_t count = bench_run(strcmp(filter, "all") == 0 ? NULL : filter, results, BENCH_MAX_CASES);
+    if (count == 0) {
+        fprintf(stderr, "sim: no benchmark matches '%s'\n", filter);
+        exit(2);
+    }
+    bench_write_json(stdout, results, count);
+    exit(0);
+}
+
+// ========================================
+// Firmware Hooks
+// ========================================
+
+void __wrap_app_main(void)
+{
+    const char *bench = getenv("SIM_BENCH");
+    if (bench) {
+        run_bench(bench);
+    }
+
+    scenario_path = env_or("SIM_SCENARIO", "scenarios/day.sim");
+    summary_path = getenv("SIM_SUMMARY");
+    const char *capture_path = env_or("SIM_CAPTURE", "sim_capture.bin");
+
+    if (sim_scenario_load(scenario_path) != ESP_OK) {
+        exit(2);
+    }
+    const char *speed = getenv("SIM_SPEED");
+    if (speed && atoi(speed) > 0) {
+        sim_scenario.speed = (uint32_t)atoi(speed);
+    }
+
+    fprintf(stderr, "sim: %s, %lu s at %lux, seed %lu\n", scenario_path,
+            (unsigned long)sim_scenario.duration_s, (unsigned long)sim_scenario.speed,
+            (unsigned long)sim_scenario.seed);
+
+    if (strcmp(capture_path, "-") != 0 && !freopen(capture_path, "wb", stdout)) {
+        perror(capture_path);
+        exit(2);
+    }
+
+    sim_time_init(sim_scenario.speed);
+    sim_stats_init(sim_scenario.duration_s);
+    sim_stats_open_events(env_or("SIM_EVENTS", "sim_events.csv"));
+    sim_zigbee_configure();
+
+    xTaskCreate(sim_ctl_task, "sim_ctl", 4096, NULL, configMAX_PRIORITIES - 1, NULL);
+    __real_app_main();
+}
+
+esp_reset_reason_t __wrap_esp_reset_reason(void)
+{
+    return ESP_RST_POWERON;
+}
+
+// Network monitor walks ZBOSS tables, profiler reads target counters
+void zb_nwk_monitor_start(void)
+{
+}
+
+void zb_nwk_monitor_stop(void)
+{
+}
+
+esp_err_t sys_profiler_start(void)
+{
+    return ESP_OK;
+}
+
+// No console on the host; SIM_BENCH covers the bench command
+esp_err_t app_console_start(void)
+{
+    return ESP_OK;
+}
+
+// No task watchdog on the host: clients register but nothing is supervised
+int supervisor_register(const char *name, supervisor_cause_t cause, uint8_t detail, uint32_t first_within_ms)
+{
+    return -1;
+}
+
+void supervisor_checkin(int client, uint32_t next_within_ms)
+{
+}
+
+esp_err_t supervisor_start(void)
+{
+    return ESP_OK;
+}
+
+void supervisor_restart(supervisor_cause_t cause, uint8_t detail)
+{
+    fprintf(stderr, "sim: supervisor restart (cause %d, detail %u)\n", cause, detail);
+    exit(3);
+}
+
+supervisor_cause_t supervisor_last_cause(uint8_t *detail)
+{
+    if (detail) {
+        *detail = 0;
+    }
+    return SUPERVISOR_CAUSE_NONE;
+}
+
+const char *supervisor_cause_name(supervisor_cause_t cause)
+{
+    return "none";
+}
+
+// No panic handler or crashlog partition on the host
+esp_err_t crash_dump_init(void)
+{
+    return ESP_OK;
+}
+
+void crash_dump_publish(void)
+{
+}
+
+// No OTA slots or OTA server on the host
+void zb_ota_add_client_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+}
+
+esp_err_t zb_ota_handle_upgrade(const esp_zb_zcl_ota_upgrade_value_message_t *message)
+{
+    return ESP_OK;
+}
+
+// No esp_pm on the host; simulated time does not model sleep
+esp_err_t power_init(void)
+{
+    return ESP_OK;
+}
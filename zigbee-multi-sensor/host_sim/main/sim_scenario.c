@@ -0,0 +1,538 @@
+/*
+ * Simulation Scenario
+ *
+ * Parser, waveform evaluation and PRNG. See sim_scenario.h for the file
+ * format.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_scenario.h"
+
+#define LINE_MAX_LEN            256
+#define MAX_TOKENS              16
+#define DAY_S                   86400.0
+
+sim_scenario_t sim_scenario;
+
+static const char *sensor_names[SIM_SENSOR_COUNT] = {
+    "light",
+    "outdoor",
+    "indoor_temp",
+    "indoor_hum",
+    "pressure",
+};
+
+static const char *wave_names[] = {
+    [SIM_WAVE_CONST]   = "const",
+    [SIM_WAVE_SINE]    = "sine",
+    [SIM_WAVE_DIURNAL] = "diurnal",
+    [SIM_WAVE_RAMP]    = "ramp",
+    [SIM_WAVE_STEP]    = "step",
+};
+
+// ========================================
+// Defaults
+// ========================================
+
+static void set_defaults(sim_scenario_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->duration_s = 24 * 3600;
+    s->speed = 1000;
+    s->seed = 1;
+
+    // A mild spring day
+    s->sensors[SIM_SENSOR_LIGHT] = (sim_waveform_t){
+        .type = SIM_WAVE_DIURNAL, .min = 0, .max = 20000, .peak_s = 13 * 3600, .width_s = 12 * 3600, .noise = 50,
+    };
+    s->sensors[SIM_SENSOR_OUTDOOR] = (sim_waveform_t){
+        .type = SIM_WAVE_SINE, .mean = 12, .amp = 5, .period_s = DAY_S, .peak_s = 15 * 3600, .noise = 0.1,
+    };
+    s->sensors[SIM_SENSOR_INDOOR_TEMP] = (sim_waveform_t){
+        .type = SIM_WAVE_SINE, .mean = 21, .amp = 1, .period_s = DAY_S, .peak_s = 18 * 3600, .noise = 0.3,
+    };
+    s->sensors[SIM_SENSOR_INDOOR_HUM] = (sim_waveform_t){
+        .type = SIM_WAVE_SINE, .mean = 45, .amp = 5, .period_s = DAY_S, .peak_s = 6 * 3600, .noise = 1,
+    };
+    s->sensors[SIM_SENSOR_PRESSURE] = (sim_waveform_t){
+        .type = SIM_WAVE_SINE, .mean = 1013, .amp = 1, .period_s = DAY_S / 2, .peak_s = 10 * 3600, .noise = 0.02,
+    };
+
+    s->link = (sim_link_t){
+        .latency_ms = 12, .jitter_ms = 20, .loss_permille = 10, .retries = 3, .queue_len = 16,
+    };
+
+    s->join_delay_ms = 3000;
+    s->channel = 11;
+
+    // Zigbee2MQTT defaults for these clusters
+    s->temperature = (sim_reporting_t){ .enabled = true, .min_s = 10, .max_s = 3600, .change = 100 };
+    s->humidity    = (sim_reporting_t){ .enabled = true, .min_s = 10, .max_s = 3600, .change = 100 };
+    s->illuminance = (sim_reporting_t){ .enabled = true, .min_s = 10, .max_s = 3600, .change = 5 };
+}
+
+// ========================================
+// Value Parsing
+// ========================================
+
+static bool parse_number(const char *text, double *out, const char **suffix)
+{
+    char *end;
+    *out = strtod(text, &end);
+    if (end == text) {
+        return false;
+    }
+    *suffix = end;
+    return true;
+}
+
+// Seconds; bare numbers are seconds
+static bool parse_time(const char *text, double *seconds)
+{
+    const char *unit;
+    double value;
+    if (!parse_number(text, &value, &unit)) {
+        return false;
+    }
+    if (*unit == '\0' || strcmp(unit, "s") == 0) {
+        *seconds = value;
+    } else if (strcmp(unit, "ms") == 0) {
+        *seconds = value / 1000.0;
+    } else if (strcmp(unit, "m") == 0) {
+        *seconds = value * 60.0;
+    } else if (strcmp(unit, "h") == 0) {
+        *seconds = value * 3600.0;
+    } else if (strcmp(unit, "d") == 0) {
+        *seconds = value * DAY_S;
+    } else {
+        return false;
+    }
+    return *seconds >= 0;
+}
+
+static bool parse_permille(const char *text, uint16_t *permille)
+{
+    const char *unit;
+    double value;
+    if (!parse_number(text, &value, &unit) || strcmp(unit, "%") != 0 || value < 0 || value > 100) {
+        return false;
+    }
+    *permille = (uint16_t)lround(value * 10.0);
+    return true;
+}
+
+static bool parse_plain(const char *text, double *value)
+{
+    const char *unit;
+    return parse_number(text, value, &unit) && *unit == '\0';
+}
+
+static bool parse_u32(const char *text, uint32_t *value, uint32_t max)
+{
+    double v;
+    if (!parse_plain(text, &v) || v < 0 || v > max || v != floor(v)) {
+        return false;
+    }
+    *value = (uint32_t)v;
+    return true;
+}
+
+static bool parse_ms(const char *text, uint32_t *ms)
+{
+    double s;
+    if (!parse_time(text, &s)) {
+        return false;
+    }
+    *ms = (uint32_t)lround(s * 1000.0);
+    return true;
+}
+
+static bool parse_s(const char *text, uint32_t *out)
+{
+    double s;
+    if (!parse_time(text, &s)) {
+        return false;
+    }
+    *out = (uint32_t)lround(s);
+    return true;
+}
+
+// ========================================
+// Directives
+// ========================================
+
+// Splits "key=value" in place; returns false for a bare word
+static bool split_kv(char *token, char **key, char **value)
+{
+    char *eq = strchr(token, '=');
+    if (!eq) {
+        return false;
+    }
+    *eq = '\0';
+    *key = token;
+    *value = eq + 1;
+    return true;
+}
+
+static bool parse_sensor(char **tok, int ntok, sim_scenario_t *s)
+{
+    if (ntok < 3) {
+        return false;
+    }
+
+    int sensor = -1;
+    for (int i = 0; i < SIM_SENSOR_COUNT; i++) {
+        if (strcmp(tok[1], sensor_names[i]) == 0) {
+            sensor = i;
+        }
+    }
+    int wave = -1;
+    for (int i = 0; i < (int)(sizeof(wave_names) / sizeof(wave_names[0])); i++) {
+        if (strcmp(tok[2], wave_names[i]) == 0) {
+            wave = i;
+        }
+    }
+    if (sensor < 0 || wave < 0) {
+        return false;
+    }
+
+    sim_waveform_t w = { .type = (sim_wave_type_t)wave, .period_s = DAY_S };
+    for (int i = 3; i < ntok; i++) {
+        char *key, *value;
+        if (!split_kv(tok[i], &key, &value)) {
+            if (strcmp(tok[i], "missing") != 0) {
+                return false;
+            }
+            w.missing = true;
+            continue;
+        }
+
+        bool ok;
+        if (strcmp(key, "mean") == 0)         ok = parse_plain(value, &w.mean);
+        else if (strcmp(key, "amp") == 0)     ok = parse_plain(value, &w.amp);
+        else if (strcmp(key, "min") == 0)     ok = parse_plain(value, &w.min);
+        else if (strcmp(key, "max") == 0)     ok = parse_plain(value, &w.max);
+        else if (strcmp(key, "from") == 0)    ok = parse_plain(value, &w.from);
+        else if (strcmp(key, "to") == 0)      ok = parse_plain(value, &w.to);
+        else if (strcmp(key, "noise") == 0)   ok = parse_plain(value, &w.noise);
+        else if (strcmp(key, "period") == 0)  ok = parse_time(value, &w.period_s) && w.period_s > 0;
+        else if (strcmp(key, "peak") == 0)    ok = parse_time(value, &w.peak_s);
+        else if (strcmp(key, "width") == 0)   ok = parse_time(value, &w.width_s) && w.width_s > 0;
+        else if (strcmp(key, "at") == 0)      ok = parse_time(value, &w.at_s);
+        else if (strcmp(key, "dropout") == 0) ok = parse_permille(value, &w.dropout_permille);
+        else if (strcmp(key, "glitch") == 0)  ok = parse_permille(value, &w.glitch_permille);
+        else                                  ok = false;
+        if (!ok) {
+            return false;
+        }
+    }
+
+    s->sensors[sensor] = w;
+    return true;
+}
+
+static bool parse_fitted(char **tok, int ntok, sim_scenario_t *s)
+{
+    for (int i = 1; i < ntok; i++) {
+        if (strcmp(tok[i], "sht4x") == 0) {
+            s->sht4x_fitted = true;
+        } else if (strcmp(tok[i], "bme280") == 0) {
+            s->bme280_fitted = true;
+        } else {
+            return false;
+        }
+    }
+    return ntok > 1;
+}
+
+static bool parse_link(char **tok, int ntok, sim_scenario_t *s)
+{
+    for (int i = 1; i < ntok; i++) {
+        char *key, *value;
+        uint32_t n;
+        if (!split_kv(tok[i], &key, &value)) {
+            return false;
+        }
+
+        bool ok;
+        if (strcmp(key, "latency") == 0)      ok = parse_ms(value, &s->link.latency_ms);
+        else if (strcmp(key, "jitter") == 0)  ok = parse_ms(value, &s->link.jitter_ms);
+        else if (strcmp(key, "loss") == 0)    ok = parse_permille(value, &s->link.loss_permille);
+        else if (strcmp(key, "reject") == 0)  ok = parse_permille(value, &s->link.reject_permille);
+        else if (strcmp(key, "retries") == 0) ok = parse_u32(value, &n, 7) && ((s->link.retries = n), true);
+        else if (strcmp(key, "queue") == 0)   ok = parse_u32(value, &n, 255) && n > 0 && ((s->link.queue_len = n), true);
+        else                                  ok = false;
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parse_join(char **tok, int ntok, sim_scenario_t *s)
+{
+    for (int i = 1; i < ntok; i++) {
+        char *key, *value;
+        uint32_t n;
+        if (!split_kv(tok[i], &key, &value)) {
+            return false;
+        }
+
+        bool ok;
+        if (strcmp(key, "delay") == 0)         ok = parse_ms(value, &s->join_delay_ms);
+        else if (strcmp(key, "failures") == 0) ok = parse_u32(value, &n, 255) && ((s->join_failures = n), true);
+        else if (strcmp(key, "channel") == 0)  ok = parse_u32(value, &n, 26) && n >= 11 && ((s->channel = n), true);
+        else                                   ok = false;
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parse_reporting(char **tok, int ntok, sim_scenario_t *s)
+{
+    if (ntok < 2) {
+        return false;
+    }
+    if (strcmp(tok[1], "none") == 0) {
+        s->temperature.enabled = s->humidity.enabled = s->illuminance.enabled = false;
+        return ntok == 2;
+    }
+
+    sim_reporting_t *r;
+    if (strcmp(tok[1], "temperature") == 0)      r = &s->temperature;
+    else if (strcmp(tok[1], "humidity") == 0)    r = &s->humidity;
+    else if (strcmp(tok[1], "illuminance") == 0) r = &s->illuminance;
+    else                                         return false;
+
+    r->enabled = true;
+    for (int i = 2; i < ntok; i++) {
+        char *key, *value;
+        if (!split_kv(tok[i], &key, &value)) {
+            return false;
+        }
+
+        bool ok;
+        if (strcmp(key, "min") == 0)         ok = parse_s(value, &r->min_s);
+        else if (strcmp(key, "max") == 0)    ok = parse_s(value, &r->max_s);
+        else if (strcmp(key, "change") == 0) ok = parse_u32(value, &r->change, 0xFFFF);
+        else                                 ok = false;
+        if (!ok) {
+            return false;
+        }
+    }
+    return r->max_s == 0 || r->max_s >= r->min_s;
+}
+
+static bool parse_at(char **tok, int ntok, sim_scenario_t *s)
+{
+    if (ntok != 4 || s->event_count >= SIM_MAX_EVENTS) {
+        return false;
+    }
+
+    sim_event_t e;
+    if (!parse_s(tok[1], &e.at_s)) {
+        return false;
+    }
+
+    if (strcmp(tok[2], "mode") == 0) {
+        e.type = SIM_EVENT_MODE;
+        if (strcmp(tok[3], "explicit") == 0) {
+            e.arg = 1;
+        } else if (strcmp(tok[3], "automatic") == 0) {
+            e.arg = 0;
+        } else {
+            return false;
+        }
+    } else if (strcmp(tok[2], "link_down") == 0) {
+        e.type = SIM_EVENT_LINK_DOWN;
+        if (!parse_s(tok[3], &e.arg)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    // Keep the timeline sorted so the control task can walk it in order
+    int pos = s->event_count;
+    while (pos > 0 && s->events[pos - 1].at_s > e.at_s) {
+        s->events[pos] = s->events[pos - 1];
+        pos--;
+    }
+    s->events[pos] = e;
+    s->event_count++;
+    return true;
+}
+
+static bool parse_line(char **tok, int ntok, sim_scenario_t *s)
+{
+    uint32_t n;
+
+    if (strcmp(tok[0], "duration") == 0) {
+        return ntok == 2 && parse_s(tok[1], &s->duration_s) && s->duration_s > 0;
+    }
+    if (strcmp(tok[0], "speed") == 0) {
+        return ntok == 2 && parse_u32(tok[1], &s->speed, 1000000) && s->speed > 0;
+    }
+    if (strcmp(tok[0], "seed") == 0) {
+        return ntok == 2 && parse_u32(tok[1], &s->seed, UINT32_MAX);
+    }
+    if (strcmp(tok[0], "start") == 0) {
+        return ntok == 2 && parse_s(tok[1], &n) && ((s->start_tod_s = n % (uint32_t)DAY_S), true);
+    }
+    if (strcmp(tok[0], "sensor") == 0) {
+        return parse_sensor(tok, ntok, s);
+    }
+    if (strcmp(tok[0], "fitted") == 0) {
+        return parse_fitted(tok, ntok, s);
+    }
+    if (strcmp(tok[0], "link") == 0) {
+        return parse_link(tok, ntok, s);
+    }
+    if (strcmp(tok[0], "join") == 0) {
+        return parse_join(tok, ntok, s);
+    }
+    if (strcmp(tok[0], "reporting") == 0) {
+        return parse_reporting(tok, ntok, s);
+    }
+    if (strcmp(tok[0], "at") == 0) {
+        return parse_at(tok, ntok, s);
+    }
+    return false;
+}
+
+// ========================================
+// Waveforms
+// ========================================
+
+double sim_waveform_eval(const sim_waveform_t *w, double t_s)
+{
+    double tod = fmod(t_s + sim_scenario.start_tod_s, DAY_S);
+
+    switch (w->type) {
+    case SIM_WAVE_SINE:
+        return w->mean + w->amp * cos(2.0 * M_PI * (tod - w->peak_s) / w->period_s);
+
+    case SIM_WAVE_DIURNAL: {
+        // Raised cosine over `width` centred on `peak`, `min` outside it
+        double offset = fmod(tod - w->peak_s + 1.5 * DAY_S, DAY_S) - 0.5 * DAY_S;
+        double x = offset / w->width_s * M_PI;
+        if (fabs(x) >= M_PI / 2) {
+            return w->min;
+        }
+        return w->min + (w->max - w->min) * cos(x);
+    }
+
+    case SIM_WAVE_RAMP:
+        if (t_s <= w->at_s) {
+            return w->from;
+        }
+        if (t_s >= w->at_s + w->period_s) {
+            return w->to;
+        }
+        return w->from + (w->to - w->from) * (t_s - w->at_s) / w->period_s;
+
+    case SIM_WAVE_STEP:
+        return t_s < w->at_s ? w->from : w->to;
+
+    case SIM_WAVE_CONST:
+    default:
+        return w->mean;
+    }
+}
+
+const char *sim_sensor_name(sim_sensor_t sensor)
+{
+    return sensor < SIM_SENSOR_COUNT ? sensor_names[sensor] : "?";
+}
+
+// ========================================
+// PRNG
+// ========================================
+
+void sim_rng_seed(sim_rng_t *rng, uint32_t seed, uint32_t stream)
+{
+    // splitmix64 of (seed, stream) so neighbouring seeds give unrelated streams
+    uint64_t z = ((uint64_t)seed << 32 | stream) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    rng->state = z ? z : 1;
+}
+
+uint32_t sim_rng_u32(sim_rng_t *rng)
+{
+    uint64_t x = rng->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng->state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+double sim_rng_uniform(sim_rng_t *rng)
+{
+    return sim_rng_u32(rng) / 4294967296.0;
+}
+
+double sim_rng_gauss(sim_rng_t *rng)
+{
+    // Box-Muller; 1 - u keeps log() away from zero
+    double u = 1.0 - sim_rng_uniform(rng);
+    double v = sim_rng_uniform(rng);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+bool sim_rng_chance(sim_rng_t *rng, uint16_t permille)
+{
+    return permille && sim_rng_u32(rng) % 1000 < permille;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t sim_scenario_load(const char *path)
+{
+    set_defaults(&sim_scenario);
+
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "sim: cannot open scenario %s\n", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    char line[LINE_MAX_LEN];
+    int lineno = 0;
+    esp_err_t ret = ESP_OK;
+
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+
+        char *tok[MAX_TOKENS];
+        int ntok = 0;
+        for (char *p = strtok(line, " \t\r\n"); p && ntok < MAX_TOKENS; p = strtok(NULL, " \t\r\n")) {
+            tok[ntok++] = p;
+        }
+        if (ntok == 0) {
+            continue;
+        }
+
+        if (!parse_line(tok, ntok, &sim_scenario)) {
+            fprintf(stderr, "sim: %s:%d: invalid '%s' directive\n", path, lineno, tok[0]);
+            ret = ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    fclose(f);
+    return ret;
+}
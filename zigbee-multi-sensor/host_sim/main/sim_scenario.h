@@ -0,0 +1,153 @@
+/*
+ * Simulation Scenario
+ *
+ * Plain-text scenario file, one directive per line, '#' starts a comment.
+ * Times take ms/s/m/h suffixes (default seconds), rates take '%'.
+ *
+ *   duration 24h                  simulated run length
+ *   speed 1000                    device ms per host ms (SIM_SPEED overrides)
+ *   seed 42                       PRNG seed for noise, dropouts and the link
+ *   start 6h                      time of day at boot (for diurnal waveforms)
+ *
+ *   sensor <name> <wave> [key=value ...] [missing]
+ *       name:  light (lux), outdoor (°C), indoor_temp (°C), indoor_hum (%RH),
+ *              pressure (hPa)
+ *       wave:  const   mean=
+ *              sine    mean= amp= period= peak=          (peak: time of day)
+ *              diurnal min= max= peak= width=            (daylight window)
+ *              ramp    from= to= at= period=             (linear over period)
+ *              step    from= to= at=
+ *       all:   noise= (Gaussian sd)  dropout=% (read failures)
+ *              glitch=% (checksum-valid garbage: 85 °C power-on value for
+ *              outdoor, a random in-range value for the others)
+ *       missing: the sensor fails to initialise
+ *
+ *   fitted <sht4x|bme280> ...     optional I2C parts on the board (default
+ *                                 none); both read indoor_temp/indoor_hum,
+ *                                 the BME280 also pressure
+ *
+ *   link latency= jitter= loss=% retries= queue= reject=%
+ *   join delay= failures= channel=
+ *   reporting <temperature|humidity|illuminance|none> min= max= change=
+ *
+ *   at <time> mode <explicit|automatic>     HA toggles the EP14 switch
+ *   at <time> link_down <duration>          every frame fails meanwhile
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_MAX_EVENTS          32
+
+typedef enum {
+    SIM_SENSOR_LIGHT,
+    SIM_SENSOR_OUTDOOR,
+    SIM_SENSOR_INDOOR_TEMP,
+    SIM_SENSOR_INDOOR_HUM,
+    SIM_SENSOR_PRESSURE,
+    SIM_SENSOR_COUNT,
+} sim_sensor_t;
+
+typedef enum {
+    SIM_WAVE_CONST,
+    SIM_WAVE_SINE,
+    SIM_WAVE_DIURNAL,
+    SIM_WAVE_RAMP,
+    SIM_WAVE_STEP,
+} sim_wave_type_t;
+
+typedef struct {
+    sim_wave_type_t type;
+    double mean, amp;
+    double min, max;
+    double from, to;
+    double period_s, peak_s, width_s, at_s;
+    double noise;
+    uint16_t dropout_permille;
+    uint16_t glitch_permille;
+    bool missing;
+} sim_waveform_t;
+
+typedef struct {
+    uint32_t latency_ms;        // Per attempt (MAC + APS ack)
+    uint32_t jitter_ms;         // Uniform 0..jitter added per attempt
+    uint16_t loss_permille;     // Per attempt
+    uint8_t retries;            // APS retries after the first attempt
+    uint8_t queue_len;          // Frames in flight before new ones are dropped
+    uint16_t reject_permille;   // Default Response with a failure status
+} sim_link_t;
+
+typedef struct {
+    bool enabled;
+    uint32_t min_s, max_s;
+    uint32_t change;            // Reportable change, ZCL units
+} sim_reporting_t;
+
+typedef enum {
+    SIM_EVENT_MODE,
+    SIM_EVENT_LINK_DOWN,
+} sim_event_type_t;
+
+typedef struct {
+    uint32_t at_s;
+    sim_event_type_t type;
+    uint32_t arg;               // MODE: 1 = explicit; LINK_DOWN: duration, s
+} sim_event_t;
+
+typedef struct {
+    uint32_t duration_s;
+    uint32_t speed;
+    uint32_t seed;
+    uint32_t start_tod_s;
+
+    sim_waveform_t sensors[SIM_SENSOR_COUNT];
+    bool sht4x_fitted, bme280_fitted;
+    sim_link_t link;
+
+    uint32_t join_delay_ms;
+    uint8_t join_failures;
+    uint8_t channel;
+
+    sim_reporting_t temperature, humidity, illuminance;
+
+    sim_event_t events[SIM_MAX_EVENTS];
+    uint8_t event_count;
+} sim_scenario_t;
+
+extern sim_scenario_t sim_scenario;
+
+/**
+ * Reset sim_scenario to defaults, then apply the file. Errors name the
+ * offending line on stderr.
+ */
+esp_err_t sim_scenario_load(const char *path);
+
+/**
+ * Noise-free waveform value at `t_s` seconds since start.
+ */
+double sim_waveform_eval(const sim_waveform_t *w, double t_s);
+
+const char *sim_sensor_name(sim_sensor_t sensor);
+
+// Independent PRNG streams (xorshift64*), so one consumer's draws do not
+// shift another's when task interleaving changes between runs
+typedef struct {
+    uint64_t state;
+} sim_rng_t;
+
+void sim_rng_seed(sim_rng_t *rng, uint32_t seed, uint32_t stream);
+uint32_t sim_rng_u32(sim_rng_t *rng);
+double sim_rng_uniform(sim_rng_t *rng);             // [0, 1)
+double sim_rng_gauss(sim_rng_t *rng);               // mean 0, sd 1
+bool sim_rng_chance(sim_rng_t *rng, uint16_t permille);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,202 @@
+/*
+ * Simulated Sensors
+ *
+ * Implements sensors.h with the scenario waveforms. Readings go through the
+ * same quantisation as the real parts (BH1750 counts of 1/1.2 lux, DS18B20
+ * 1/16 °C, DHT11 0.1 °C and whole %RH, SHT4x and BME280 0.01 units) so
+ * reportable-change thresholds behave as on hardware. Glitches stand in for reads that pass the checksum but carry
+ * nonsense, which only the firmware's sensor filter can catch.
+ */
+
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sensors.h"
+#include "i2c_bus.h"
+#include "sim_scenario.h"
+#include "sim_stats.h"
+#include "sim_time.h"
+
+static sim_rng_t rng[SIM_SENSOR_COUNT];
+static bool rng_ready[SIM_SENSOR_COUNT];
+
+// ========================================
+// Internal Helpers
+// ========================================
+
+static double glitch_value(sim_sensor_t sensor)
+{
+    double u = sim_rng_uniform(&rng[sensor]);
+
+    switch (sensor) {
+    case SIM_SENSOR_LIGHT:       return u * 54612.5;
+    case SIM_SENSOR_OUTDOOR:     return 85.0;           // DS18B20 power-on scratchpad
+    case SIM_SENSOR_INDOOR_TEMP: return u * 50.0;
+    case SIM_SENSOR_INDOOR_HUM:  return u * 99.0;
+    case SIM_SENSOR_PRESSURE:    return 300.0 + u * 800.0;
+    default:                     return 0.0;
+    }
+}
+
+static bool sample(sim_sensor_t sensor, double *value)
+{
+    const sim_waveform_t *w = &sim_scenario.sensors[sensor];
+
+    if (!rng_ready[sensor]) {
+        sim_rng_seed(&rng[sensor], sim_scenario.seed, sensor);
+        rng_ready[sensor] = true;
+    }
+
+    if (sim_rng_chance(&rng[sensor], w->dropout_permille)) {
+        sim_stats_sensor_read(sensor, false);
+        return false;
+    }
+
+    if (sim_rng_chance(&rng[sensor], w->glitch_permille)) {
+        *value = glitch_value(sensor);
+        sim_stats_sensor_read(sensor, true);
+        return true;
+    }
+
+    *value = sim_waveform_eval(w, sim_time_us() / 1e6);
+    if (w->noise > 0) {
+        *value += w->noise * sim_rng_gauss(&rng[sensor]);
+    }
+    sim_stats_sensor_read(sensor, true);
+    return true;
+}
+
+static double clamp(double value, double lo, double hi)
+{
+    return value < lo ? lo : (value > hi ? hi : value);
+}
+
+/**
+ * Indoor temperature and humidity for the I2C parts: same room as the
+ * DHT11, finer quantisation.
+ */
+static bool sample_indoor(float *temperature, float *humidity)
+{
+    double t, h;
+    if (!sample(SIM_SENSOR_INDOOR_TEMP, &t) || !sample(SIM_SENSOR_INDOOR_HUM, &h)) {
+        return false;
+    }
+    *temperature = round(t * 100.0) / 100.0;
+    *humidity = clamp(round(h * 100.0) / 100.0, 0, 100);
+    return true;
+}
+
+// ========================================
+// sensors.h
+// ========================================
+
+esp_err_t sensors_i2c_scan(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t bh1750_init(void)
+{
+    return sim_scenario.sensors[SIM_SENSOR_LIGHT].missing ? ESP_ERR_TIMEOUT : ESP_OK;
+}
+
+esp_err_t bh1750_read_light(float *lux)
+{
+    double value;
+    if (!sample(SIM_SENSOR_LIGHT, &value)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    double raw = clamp(round(value * 1.2), 0, 65535);
+    *lux = raw / 1.2;
+    return ESP_OK;
+}
+
+esp_err_t bh1750_wake(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(BH1750_MEASUREMENT_MS));
+    return ESP_OK;
+}
+
+esp_err_t bh1750_sleep(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_init(void)
+{
+    return sim_scenario.sensors[SIM_SENSOR_OUTDOOR].missing ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t ds18b20_start_conversion(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_read_temperature(float *temperature)
+{
+    double value;
+    if (!sample(SIM_SENSOR_OUTDOOR, &value)) {
+        return ESP_FAIL;
+    }
+    double raw = clamp(round(value * 16.0), -55 * 16, 125 * 16);
+    *temperature = raw / 16.0;
+    return ESP_OK;
+}
+
+esp_err_t dht11_init(void)
+{
+    bool missing = sim_scenario.sensors[SIM_SENSOR_INDOOR_TEMP].missing ||
+                   sim_scenario.sensors[SIM_SENSOR_INDOOR_HUM].missing;
+    return missing ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t dht11_read_data(float *temperature, float *humidity)
+{
+    double t, h;
+    // One transaction on the real part: either both values arrive or neither
+    if (!sample(SIM_SENSOR_INDOOR_TEMP, &t) || !sample(SIM_SENSOR_INDOOR_HUM, &h)) {
+        return ESP_FAIL;
+    }
+    *temperature = clamp(round(t * 10.0) / 10.0, 0, 50);
+    *humidity = clamp(round(h), 0, 99);
+    return ESP_OK;
+}
+
+esp_err_t sht4x_init(void)
+{
+    return sim_scenario.sht4x_fitted ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t sht4x_read(float *temperature, float *humidity)
+{
+    vTaskDelay(pdMS_TO_TICKS(SHT4X_MEASUREMENT_MS));
+    return sample_indoor(temperature, humidity) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t bme280_init(void)
+{
+    bool missing = !sim_scenario.bme280_fitted || sim_scenario.sensors[SIM_SENSOR_PRESSURE].missing;
+    return missing ? ESP_ERR_NOT_FOUND : ESP_OK;
+}
+
+esp_err_t bme280_read(float *temperature, float *humidity, float *pressure_pa)
+{
+    vTaskDelay(pdMS_TO_TICKS(BME280_MEASUREMENT_MS));
+
+    double p;
+    if (!sample_indoor(temperature, humidity) || !sample(SIM_SENSOR_PRESSURE, &p)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *pressure_pa = round(p * 100.0);
+    return ESP_OK;
+}
+
+// ========================================
+// i2c_bus.h
+// ========================================
+
+bool i2c_bus_refused(esp_err_t ret)
+{
+    // The simulated bus never recovers or backs off
+    return false;
+}
@@ -0,0 +1,366 @@
+/*
+ * Simulation Statistics
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_zigbee_core.h"
+#include "log_histogram.h"
+#include "report_tracker.h"
+#include "zb_diagnostics.h"
+#include "sim_time.h"
+#include "sim_stats.h"
+
+#define HOUR_MS                 3600000U
+#define MAX_QUEUE_DEPTH         256
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint32_t writes;
+    uint32_t explicit_reports;
+    uint32_t automatic_reports;
+    uint32_t delivered;
+    uint32_t failed;
+    uint32_t dropped;
+    uint32_t *hourly;           // Reports queued per simulated hour
+    log_histogram_t latency_ms;
+} source_stats_t;
+
+static SemaphoreHandle_t lock;
+static source_stats_t sources[SIM_STATS_MAX_SOURCES];
+static uint8_t source_count = 0;
+static uint32_t hours = 1;
+
+static uint32_t depth_samples[MAX_QUEUE_DEPTH + 1];
+static uint32_t depth_max = 0;
+
+static uint32_t sensor_ok[SIM_SENSOR_COUNT];
+static uint32_t sensor_fail[SIM_SENSOR_COUNT];
+
+static FILE *events = NULL;
+
+// ========================================
+// Internal Helpers (lock held)
+// ========================================
+
+static const char *cluster_name(uint16_t cluster_id)
+{
+    switch (cluster_id) {
+    case ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT:         return "temperature";
+    case ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT: return "humidity";
+    case ESP_ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT:  return "illuminance";
+    case ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT:     return "pressure";
+    case ESP_ZB_ZCL_CLUSTER_ID_ON_OFF:                   return "on_off";
+    case ZB_ZCL_CLUSTER_ID_DIAGNOSTICS_SRV:              return "diagnostics";
+    default:                                             return "other";
+    }
+}
+
+static source_stats_t *source_for(uint8_t endpoint, uint16_t cluster_id)
+{
+    for (int i = 0; i < source_count; i++) {
+        if (sources[i].endpoint == endpoint && sources[i].cluster_id == cluster_id) {
+            return &sources[i];
+        }
+    }
+    if (source_count >= SIM_STATS_MAX_SOURCES) {
+        return NULL;
+    }
+
+    source_stats_t *s = &sources[source_count++];
+    memset(s, 0, sizeof(*s));
+    s->endpoint = endpoint;
+    s->cluster_id = cluster_id;
+    s->hourly = calloc(hours, sizeof(uint32_t));
+    return s;
+}
+
+static uint32_t current_hour(void)
+{
+    uint32_t hour = sim_time_ms() / HOUR_MS;
+    return hour < hours ? hour : hours - 1;
+}
+
+static void event_row(const char *event, int endpoint, uint16_t cluster_id, int attr_id,
+                      const char *value, const char *detail)
+{
+    if (!events) {
+        return;
+    }
+    fprintf(events, "%lu,%s,", (unsigned long)sim_time_ms(), event);
+    if (endpoint >= 0) {
+        fprintf(events, "%d,0x%04x,", endpoint, cluster_id);
+    } else {
+        fputs(",,", events);
+    }
+    if (attr_id >= 0) {
+        fprintf(events, "0x%04x,", attr_id);
+    } else {
+        fputc(',', events);
+    }
+    fprintf(events, "%s,%s\n", value ? value : "", detail ? detail : "");
+}
+
+// ========================================
+// Recording
+// ========================================
+
+void sim_stats_init(uint32_t duration_s)
+{
+    lock = xSemaphoreCreateMutex();
+    hours = (duration_s + 3599) / 3600;
+    if (hours == 0) {
+        hours = 1;
+    }
+}
+
+void sim_stats_open_events(const char *path)
+{
+    if (!path || !*path) {
+        return;
+    }
+    events = fopen(path, "w");
+    if (!events) {
+        fprintf(stderr, "sim: cannot write %s\n", path);
+        return;
+    }
+    fputs("time_ms,event,endpoint,cluster,attribute,value,detail\n", events);
+}
+
+void sim_stats_attr_write(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, int32_t value)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%ld", (long)value);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    source_stats_t *s = source_for(endpoint, cluster_id);
+    if (s) {
+        s->writes++;
+    }
+    event_row("write", endpoint, cluster_id, attr_id, text, NULL);
+    xSemaphoreGive(lock);
+}
+
+void sim_stats_report_queued(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, int32_t value,
+                             bool automatic, uint8_t queue_depth)
+{
+    char text[16], detail[24];
+    snprintf(text, sizeof(text), "%ld", (long)value);
+    snprintf(detail, sizeof(detail), "%s depth=%u", automatic ? "automatic" : "explicit", queue_depth);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    source_stats_t *s = source_for(endpoint, cluster_id);
+    if (s) {
+        if (automatic) {
+            s->automatic_reports++;
+        } else {
+            s->explicit_reports++;
+        }
+        s->hourly[current_hour()]++;
+    }
+    depth_samples[queue_depth]++;
+    if (queue_depth > depth_max) {
+        depth_max = queue_depth;
+    }
+    event_row("report", endpoint, cluster_id, attr_id, text, detail);
+    xSemaphoreGive(lock);
+}
+
+void sim_stats_report_done(uint8_t endpoint, uint16_t cluster_id, uint8_t tsn,
+                           sim_report_result_t result, uint32_t latency_ms)
+{
+    static const char *names[] = { "delivered", "failed", "dropped" };
+    char text[16], detail[24];
+    snprintf(text, sizeof(text), "%lu", (unsigned long)latency_ms);
+    snprintf(detail, sizeof(detail), "%s tsn=%u", names[result], tsn);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    source_stats_t *s = source_for(endpoint, cluster_id);
+    if (s) {
+        switch (result) {
+        case SIM_REPORT_DELIVERED:
+            s->delivered++;
+            log_histogram_add(&s->latency_ms, latency_ms);
+            break;
+        case SIM_REPORT_FAILED:
+            s->failed++;
+            break;
+        case SIM_REPORT_DROPPED:
+            s->dropped++;
+            break;
+        }
+    }
+    event_row(result == SIM_REPORT_DROPPED ? "drop" : "confirm", endpoint, cluster_id, -1, text, detail);
+    xSemaphoreGive(lock);
+}
+
+void sim_stats_sensor_read(sim_sensor_t sensor, bool ok)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (ok) {
+        sensor_ok[sensor]++;
+    } else {
+        sensor_fail[sensor]++;
+        event_row("sensor_fail", -1, 0, -1, NULL, sim_sensor_name(sensor));
+    }
+    xSemaphoreGive(lock);
+}
+
+void sim_stats_note(const char *event, const char *detail)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    event_row(event, -1, 0, -1, NULL, detail);
+    xSemaphoreGive(lock);
+}
+
+// ========================================
+// Summary
+// ========================================
+
+static bool is_report_source(const source_stats_t *s)
+{
+    return s->explicit_reports || s->automatic_reports;
+}
+
+void sim_stats_print(FILE *out, const char *scenario_path)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (events) {
+        fflush(events);
+    }
+
+    uint32_t elapsed_ms = sim_time_ms();
+    double sim_hours = elapsed_ms / (double)HOUR_MS;
+
+    fprintf(out, "\n======== Simulation summary ========\n");
+    fprintf(out, "Scenario %s: %.1f h simulated in %.1f s (speed %lux, seed %lu)\n\n",
+            scenario_path, sim_hours, sim_time_host_elapsed(),
+            (unsigned long)sim_time_speed(), (unsigned long)sim_scenario.seed);
+
+    fprintf(out, "%-20s %8s %8s %8s %8s %8s %8s %6s %6s %6s %6s\n",
+            "Source", "writes", "explicit", "auto", "rep/h", "deliver", "fail", "p50", "p95", "p99", "max");
+    for (int i = 0; i < source_count; i++) {
+        const source_stats_t *s = &sources[i];
+        char name[24];
+        snprintf(name, sizeof(name), "EP%u %s", s->endpoint, cluster_name(s->cluster_id));
+        uint32_t reports = s->explicit_reports + s->automatic_reports;
+
+        fprintf(out, "%-20s %8lu %8lu %8lu %8.1f %8lu %8lu %6lu %6lu %6lu %6lu",
+                name, (unsigned long)s->writes, (unsigned long)s->explicit_reports,
+                (unsigned long)s->automatic_reports, sim_hours > 0 ? reports / sim_hours : 0.0,
+                (unsigned long)s->delivered, (unsigned long)(s->failed + s->dropped),
+                (unsigned long)log_histogram_percentile(&s->latency_ms, 50),
+                (unsigned long)log_histogram_percentile(&s->latency_ms, 95),
+                (unsigned long)log_histogram_percentile(&s->latency_ms, 99),
+                (unsigned long)s->latency_ms.max);
+        if (s->dropped) {
+            fprintf(out, "  (%lu dropped, queue full)", (unsigned long)s->dropped);
+        }
+        fputc('\n', out);
+    }
+
+    uint64_t depth_sum = 0, depth_count = 0;
+    for (int d = 0; d <= MAX_QUEUE_DEPTH; d++) {
+        depth_sum += (uint64_t)d * depth_samples[d];
+        depth_count += depth_samples[d];
+    }
+    fprintf(out, "\nAPS queue depth at enqueue: max %lu, mean %.2f (%llu reports)\n",
+            (unsigned long)depth_max, depth_count ? (double)depth_sum / depth_count : 0.0,
+            (unsigned long long)depth_count);
+
+    fprintf(out, "\nReports per hour:\n  hour");
+    for (int i = 0; i < source_count; i++) {
+        if (is_report_source(&sources[i])) {
+            fprintf(out, "  EP%u/%04x", sources[i].endpoint, sources[i].cluster_id);
+        }
+    }
+    fprintf(out, "   total\n");
+    uint32_t last_hour = elapsed_ms / HOUR_MS;
+    for (uint32_t h = 0; h < hours && h <= last_hour; h++) {
+        uint32_t total = 0;
+        fprintf(out, "  %4lu", (unsigned long)h);
+        for (int i = 0; i < source_count; i++) {
+            if (is_report_source(&sources[i])) {
+                fprintf(out, "  %9lu", (unsigned long)sources[i].hourly[h]);
+                total += sources[i].hourly[h];
+            }
+        }
+        fprintf(out, "  %6lu\n", (unsigned long)total);
+    }
+
+    fprintf(out, "\nSensor reads (ok/failed):");
+    for (int i = 0; i < SIM_SENSOR_COUNT; i++) {
+        fprintf(out, "  %s %lu/%lu", sim_sensor_name(i), (unsigned long)sensor_ok[i],
+                (unsigned long)sensor_fail[i]);
+    }
+    fputc('\n', out);
+
+    // The firmware's own view, for cross-checking report_tracker.c
+    fprintf(out, "\nFirmware report tracker (explicit reports):\n");
+    for (int i = 0; i < source_count; i++) {
+        uint8_t ep = sources[i].endpoint;
+        bool seen = false;
+        for (int j = 0; j < i; j++) {
+            seen |= sources[j].endpoint == ep;
+        }
+        report_tracker_stats_t stats;
+        if (seen || !report_tracker_get_stats(ep, &stats)) {
+            continue;
+        }
+        const report_tracker_stats_t *t = &stats;
+        fprintf(out, "  EP%-3u sent %lu  acked %lu  failed %lu  lost %lu  rejected %lu  "
+                "p50/p95/p99 %lu/%lu/%lu ms\n",
+                ep, (unsigned long)t->sent, (unsigned long)t->acked, (unsigned long)t->failed,
+                (unsigned long)t->lost, (unsigned long)t->rejected,
+                (unsigned long)log_histogram_percentile(&t->latency_ms, 50),
+                (unsigned long)log_histogram_percentile(&t->latency_ms, 95),
+                (unsigned long)log_histogram_percentile(&t->latency_ms, 99));
+    }
+    xSemaphoreGive(lock);
+}
+
+void sim_stats_write_json(const char *path)
+{
+    if (!path || !*path) {
+        return;
+    }
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "sim: cannot write %s\n", path);
+        return;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    double sim_hours = sim_time_ms() / (double)HOUR_MS;
+
+    fprintf(f, "{\n  \"simulated_hours\": %.3f,\n  \"seed\": %lu,\n  \"queue_depth_max\": %lu,\n",
+            sim_hours, (unsigned long)sim_scenario.seed, (unsigned long)depth_max);
+    fprintf(f, "  \"sources\": [");
+    for (int i = 0; i < source_count; i++) {
+        const source_stats_t *s = &sources[i];
+        uint32_t reports = s->explicit_reports + s->automatic_reports;
+        fprintf(f, "%s\n    {\"endpoint\": %u, \"cluster\": %u, \"writes\": %lu, \"explicit\": %lu, "
+                "\"automatic\": %lu, \"reports_per_hour\": %.2f, \"delivered\": %lu, \"failed\": %lu, "
+                "\"dropped\": %lu, \"latency_ms\": {\"p50\": %lu, \"p95\": %lu, \"p99\": %lu, \"max\": %lu}}",
+                i ? "," : "", s->endpoint, s->cluster_id, (unsigned long)s->writes,
+                (unsigned long)s->explicit_reports, (unsigned long)s->automatic_reports,
+                sim_hours > 0 ? reports / sim_hours : 0.0, (unsigned long)s->delivered,
+                (unsigned long)s->failed, (unsigned long)s->dropped,
+                (unsigned long)log_histogram_percentile(&s->latency_ms, 50),
+                (unsigned long)log_histogram_percentile(&s->latency_ms, 95),
+                (unsigned long)log_histogram_percentile(&s->latency_ms, 99),
+                (unsigned long)s->latency_ms.max);
+    }
+    fprintf(f, "\n  ],\n  \"sensor_reads\": {");
+    for (int i = 0; i < SIM_SENSOR_COUNT; i++) {
+        fprintf(f, "%s\"%s\": {\"ok\": %lu, \"failed\": %lu}", i ? ", " : "", sim_sensor_name(i),
+                (unsigned long)sensor_ok[i], (unsigned long)sensor_fail[i]);
+    }
+    fprintf(f, "}\n}\n");
+    xSemaphoreGive(lock);
+
+    fclose(f);
+}
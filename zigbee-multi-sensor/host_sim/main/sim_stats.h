@@ -0,0 +1,56 @@
+/*
+ * Simulation Statistics
+ *
+ * Everything the mock stack and the simulated sensors observe, bucketed per
+ * source (endpoint, cluster) and per simulated hour, plus an optional CSV
+ * event log (one row per attribute write, report, confirm and drop).
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "sim_scenario.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_STATS_MAX_SOURCES   8
+
+typedef enum {
+    SIM_REPORT_DELIVERED,
+    SIM_REPORT_FAILED,          // No APS ack after all retries, or link down
+    SIM_REPORT_DROPPED,         // APS queue full, never transmitted
+} sim_report_result_t;
+
+void sim_stats_init(uint32_t duration_s);
+
+/**
+ * Write the CSV event log to `path` (NULL or "" disables it).
+ */
+void sim_stats_open_events(const char *path);
+
+void sim_stats_attr_write(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, int32_t value);
+void sim_stats_report_queued(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, int32_t value,
+                             bool automatic, uint8_t queue_depth);
+void sim_stats_report_done(uint8_t endpoint, uint16_t cluster_id, uint8_t tsn,
+                           sim_report_result_t result, uint32_t latency_ms);
+void sim_stats_sensor_read(sim_sensor_t sensor, bool ok);
+
+/**
+ * Free-form event row (signals, scenario events).
+ */
+void sim_stats_note(const char *event, const char *detail);
+
+void sim_stats_print(FILE *out, const char *scenario_path);
+
+/**
+ * Machine-readable summary for comparing firmware revisions.
+ */
+void sim_stats_write_json(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
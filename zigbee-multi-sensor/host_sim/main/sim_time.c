@@ -0,0 +1,77 @@
+/*
+ * Simulated Time
+ */
+
+#include <stdatomic.h>
+#include <time.h>
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "sim_time.h"
+
+static uint32_t speed = 1;
+static struct timespec start;
+
+// Pinned device time + 1 (0 = not pinned)
+static _Atomic int64_t pinned = 0;
+
+// ========================================
+// Public API
+// ========================================
+
+void sim_time_init(uint32_t sim_speed)
+{
+    speed = sim_speed ? sim_speed : 1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+}
+
+uint32_t sim_time_speed(void)
+{
+    return speed;
+}
+
+double sim_time_host_elapsed(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start.tv_sec) + (double)(now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int64_t sim_time_us(void)
+{
+    int64_t pin = atomic_load(&pinned);
+    if (pin) {
+        return pin - 1;
+    }
+    return (int64_t)(sim_time_host_elapsed() * 1e6 * speed);
+}
+
+void sim_time_pin(int64_t us)
+{
+    atomic_store(&pinned, us + 1);
+}
+
+void sim_time_unpin(void)
+{
+    atomic_store(&pinned, 0);
+}
+
+TickType_t sim_ms_to_ticks(uint64_t ms)
+{
+    // Round to nearest: per-tick rounding errors cancel over a periodic loop
+    uint64_t scaled = 1000ULL * speed;
+    return (TickType_t)((ms * configTICK_RATE_HZ + scaled / 2) / scaled);
+}
+
+// ========================================
+// Link-time Wrappers (-Wl,--wrap)
+// ========================================
+
+int64_t __wrap_esp_timer_get_time(void)
+{
+    return sim_time_us();
+}
+
+uint32_t __wrap_esp_log_timestamp(void)
+{
+    return sim_time_ms();
+}
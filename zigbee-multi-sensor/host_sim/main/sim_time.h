@@ -0,0 +1,60 @@
+/*
+ * Simulated Time
+ *
+ * Force-included into every source of the host build (see CMakeLists.txt).
+ *
+ * The FreeRTOS POSIX port ticks at CONFIG_FREERTOS_HZ of host time. Every
+ * pdMS_TO_TICKS() is divided by the simulation speed, so one tick stands
+ * for `speed` ms of device time and a 30 s sensor period at speed 1000 is
+ * 30 host milliseconds. Delays shorter than half a tick round down to a
+ * plain yield (LED flashes, the 50 ms tlog drain).
+ *
+ * esp_timer_get_time() and esp_log_timestamp() are wrapped at link time to
+ * return device time: host time since start x speed, or, while the mock
+ * stack dispatches an event, that event's due time (sim_time_pin()). The
+ * latencies modelled in sim_zigbee.c are therefore measured exactly by the
+ * firmware's own code, independent of tick granularity.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void sim_time_init(uint32_t speed);
+uint32_t sim_time_speed(void);
+
+/**
+ * Device time since start, µs.
+ */
+int64_t sim_time_us(void);
+
+static inline uint32_t sim_time_ms(void)
+{
+    return (uint32_t)(sim_time_us() / 1000);
+}
+
+/**
+ * Host seconds since sim_time_init().
+ */
+double sim_time_host_elapsed(void);
+
+/**
+ * Freeze device time at `us` until sim_time_unpin(). Used by the mock stack
+ * around callbacks for events that fell due between two of its iterations.
+ */
+void sim_time_pin(int64_t us);
+void sim_time_unpin(void);
+
+TickType_t sim_ms_to_ticks(uint64_t ms);
+
+#undef pdMS_TO_TICKS
+#define pdMS_TO_TICKS(ms) sim_ms_to_ticks(ms)
+
+#ifdef __cplusplus
+}
+#endif
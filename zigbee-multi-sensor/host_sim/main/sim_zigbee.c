@@ -0,0 +1,785 @@
+/*
+ * Mock Zigbee Stack
+ *
+ * One event table ordered by due time holds everything the stack would do
+ * later: scheduler alarms, app signals, APS confirms, Default Responses and
+ * remote attribute writes. Producers (any task) insert under `lock`; the
+ * Zigbee task pops due events and dispatches them without the lock held,
+ * so callbacks can call back into the mock.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_zigbee_core.h"
+#include "zboss_api.h"
+#include "zb_diagnostics.h"
+#include "sim_scenario.h"
+#include "sim_stats.h"
+#include "sim_time.h"
+#include "sim_zigbee.h"
+
+#define MAX_EVENTS              640
+#define MAX_ATTRS               32
+#define SIM_EP_MODE_SWITCH      14      // EP_REPORTING_MODE_SWITCH in main.c
+#define SIM_SHORT_ADDR          0x3A7C
+#define COORDINATOR_EP          1
+#define ZCL_CMD_REPORT_ATTRIB   0x0A
+
+static const char *TAG = "SIM_ZB";
+
+typedef enum {
+    EV_ALARM,
+    EV_SIGNAL,
+    EV_CONFIRM,
+    EV_DEFAULT_RESP,
+    EV_REMOTE_WRITE,
+} event_kind_t;
+
+typedef struct {
+    bool used;
+    event_kind_t kind;
+    int64_t due_us;
+    uint32_t order;             // FIFO among events due at the same time
+    union {
+        struct {
+            esp_zb_callback_t cb;
+            uint8_t param;
+        } alarm;
+        struct {
+            esp_zb_app_signal_type_t type;
+            esp_err_t status;
+        } signal;
+        struct {
+            uint8_t endpoint;
+            uint16_t cluster_id;
+            uint8_t tsn;
+            esp_err_t status;
+            int64_t enqueued_us;
+        } frame;
+        bool on_off;
+    };
+} event_t;
+
+typedef struct {
+    bool used;
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    int32_t value;
+
+    // Automatic reporting (ZBOSS reporting engine)
+    const sim_reporting_t *reporting;
+    bool reported_once;
+    int32_t reported_value;
+    int64_t last_report_us;
+} attr_state_t;
+
+typedef struct {
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t type;
+} attr_type_t;
+
+static SemaphoreHandle_t lock;
+static event_t events[MAX_EVENTS];
+static uint32_t event_order = 0;
+static uint32_t events_overflowed = 0;
+
+static attr_state_t attrs[MAX_ATTRS];
+static attr_type_t custom_types[MAX_ATTRS];
+static uint8_t custom_type_count = 0;
+
+static esp_zb_core_action_callback_t action_handler = NULL;
+static esp_zb_zcl_command_send_status_callback_t send_status_handler = NULL;
+
+static sim_rng_t link_rng;
+static int64_t radio_free_us = 0;
+static int64_t link_down_until_us = 0;
+static uint16_t in_flight = 0;
+static zb_zcl_globals_t zcl_ctx;      // Only seq_number: the TSN of the next frame
+
+static bool joined = false;
+static uint32_t primary_mask = 0;
+static uint8_t steering_attempts = 0;
+
+// ========================================
+// Event Table
+// ========================================
+
+static void post_locked(const event_t *ev)
+{
+    for (int i = 0; i < MAX_EVENTS; i++) {
+        if (!events[i].used) {
+            events[i] = *ev;
+            events[i].used = true;
+            events[i].order = event_order++;
+            return;
+        }
+    }
+    events_overflowed++;
+}
+
+static void post(const event_t *ev)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    post_locked(ev);
+    xSemaphoreGive(lock);
+}
+
+static bool pop_due(int64_t now_us, event_t *out)
+{
+    event_t *next = NULL;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < MAX_EVENTS; i++) {
+        event_t *e = &events[i];
+        if (e->used && e->due_us <= now_us &&
+            (!next || e->due_us < next->due_us || (e->due_us == next->due_us && e->order < next->order))) {
+            next = e;
+        }
+    }
+    if (next) {
+        *out = *next;
+        next->used = false;
+    }
+    xSemaphoreGive(lock);
+    return next != NULL;
+}
+
+static void post_signal(esp_zb_app_signal_type_t type, esp_err_t status, uint32_t delay_ms)
+{
+    event_t ev = {
+        .kind = EV_SIGNAL,
+        .due_us = sim_time_us() + delay_ms * 1000LL,
+        .signal = { .type = type, .status = status },
+    };
+    post(&ev);
+}
+
+// ========================================
+// Attribute Store
+// ========================================
+
+static uint8_t attr_type(uint16_t cluster_id, uint16_t attr_id)
+{
+    switch (cluster_id) {
+    case ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT:
+    case ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT:
+        return ESP_ZB_ZCL_ATTR_TYPE_S16;
+    case ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT:
+    case ESP_ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT:
+        return ESP_ZB_ZCL_ATTR_TYPE_U16;
+    case ESP_ZB_ZCL_CLUSTER_ID_ON_OFF:
+        return ESP_ZB_ZCL_ATTR_TYPE_BOOL;
+    default:
+        break;
+    }
+    for (int i = 0; i < custom_type_count; i++) {
+        if (custom_types[i].cluster_id == cluster_id && custom_types[i].attr_id == attr_id) {
+            return custom_types[i].type;
+        }
+    }
+    return ESP_ZB_ZCL_ATTR_TYPE_NULL;
+}
+
+// Integer view of a value (strings: their length)
+static int32_t decode_value(uint8_t type, const void *value)
+{
+    const uint8_t *p = value;
+    switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_BOOL:
+    case ESP_ZB_ZCL_ATTR_TYPE_U8:
+    case ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING:
+    case ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING:
+        return p[0];
+    case ESP_ZB_ZCL_ATTR_TYPE_S8:
+        return (int8_t)p[0];
+    case ESP_ZB_ZCL_ATTR_TYPE_U16:
+        return (uint16_t)(p[0] | p[1] << 8);
+    case ESP_ZB_ZCL_ATTR_TYPE_S16:
+        return (int16_t)(p[0] | p[1] << 8);
+    case ESP_ZB_ZCL_ATTR_TYPE_U32:
+    case ESP_ZB_ZCL_ATTR_TYPE_S32:
+        return (int32_t)(p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24);
+    default:
+        return 0;
+    }
+}
+
+static const sim_reporting_t *reporting_for(uint16_t cluster_id, uint16_t attr_id)
+{
+    const sim_reporting_t *r = NULL;
+    if (cluster_id == ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT &&
+        attr_id == ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID) {
+        r = &sim_scenario.temperature;
+    } else if (cluster_id == ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT &&
+               attr_id == ESP_ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID) {
+        r = &sim_scenario.humidity;
+    } else if (cluster_id == ESP_ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT &&
+               attr_id == ESP_ZB_ZCL_ATTR_ILLUMINANCE_MEASUREMENT_MEASURED_VALUE_ID) {
+        r = &sim_scenario.illuminance;
+    }
+    return r && r->enabled ? r : NULL;
+}
+
+static attr_state_t *attr_find_locked(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, bool create)
+{
+    attr_state_t *free_slot = NULL;
+    for (int i = 0; i < MAX_ATTRS; i++) {
+        attr_state_t *a = &attrs[i];
+        if (a->used && a->endpoint == endpoint && a->cluster_id == cluster_id && a->attr_id == attr_id) {
+            return a;
+        }
+        if (!a->used && !free_slot) {
+            free_slot = a;
+        }
+    }
+    if (!create || !free_slot) {
+        return NULL;
+    }
+
+    memset(free_slot, 0, sizeof(*free_slot));
+    free_slot->used = true;
+    free_slot->endpoint = endpoint;
+    free_slot->cluster_id = cluster_id;
+    free_slot->attr_id = attr_id;
+    free_slot->reporting = reporting_for(cluster_id, attr_id);
+    return free_slot;
+}
+
+// ========================================
+// Link Model
+// ========================================
+
+static void transmit(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, int32_t value, bool automatic)
+{
+    const sim_link_t *link = &sim_scenario.link;
+    int64_t now_us = sim_time_us();
+    sim_report_result_t result = SIM_REPORT_DELIVERED;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint8_t depth = in_flight > 255 ? 255 : (uint8_t)in_flight;
+    event_t ev = {
+        .kind = EV_CONFIRM,
+        .due_us = now_us,
+        .frame = { .endpoint = endpoint, .cluster_id = cluster_id, .tsn = zcl_ctx.seq_number++, .enqueued_us = now_us },
+    };
+
+    if (!joined) {
+        ev.frame.status = ESP_ERR_INVALID_STATE;
+        result = SIM_REPORT_FAILED;
+    } else if (in_flight >= link->queue_len) {
+        // No free APS buffer: refused at once, never on air
+        ev.frame.status = ESP_ERR_NO_MEM;
+        result = SIM_REPORT_DROPPED;
+    } else {
+        // One radio: frames go out in order, each with its APS retries
+        int64_t t = now_us > radio_free_us ? now_us : radio_free_us;
+        bool acked = false;
+        for (int attempt = 0; attempt <= link->retries && !acked; attempt++) {
+            bool link_down = t < link_down_until_us;
+            t += (link->latency_ms + (link->jitter_ms ? sim_rng_u32(&link_rng) % (link->jitter_ms + 1) : 0)) * 1000LL;
+            acked = !link_down && !sim_rng_chance(&link_rng, link->loss_permille);
+        }
+        radio_free_us = t;
+        in_flight++;
+
+        ev.due_us = t;
+        ev.frame.status = acked ? ESP_OK : ESP_FAIL;
+        if (acked) {
+            // The coordinator answers every report (Default Response enabled)
+            event_t resp = ev;
+            resp.kind = EV_DEFAULT_RESP;
+            resp.due_us = t + link->latency_ms * 1000LL;
+            resp.frame.status = sim_rng_chance(&link_rng, link->reject_permille) ? ESP_FAIL : ESP_OK;
+            post_locked(&resp);
+        }
+    }
+    post_locked(&ev);
+    xSemaphoreGive(lock);
+
+    sim_stats_report_queued(endpoint, cluster_id, attr_id, value, automatic, depth);
+    if (result == SIM_REPORT_DROPPED) {
+        // Counted here; the confirm still reaches the firmware as a failure
+        sim_stats_report_done(endpoint, cluster_id, ev.frame.tsn, SIM_REPORT_DROPPED, 0);
+    }
+}
+
+// ========================================
+// Automatic Reporting
+// ========================================
+
+static void check_reporting(void)
+{
+    typedef struct {
+        uint8_t endpoint;
+        uint16_t cluster_id;
+        uint16_t attr_id;
+        int32_t value;
+    } due_report_t;
+
+    due_report_t due[MAX_ATTRS];
+    int due_count = 0;
+    int64_t now_us = sim_time_us();
+
+    if (!joined) {
+        return;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < MAX_ATTRS; i++) {
+        attr_state_t *a = &attrs[i];
+        if (!a->used || !a->reporting) {
+            continue;
+        }
+        const sim_reporting_t *r = a->reporting;
+        int64_t elapsed_s = (now_us - a->last_report_us) / 1000000;
+        int32_t delta = a->value - a->reported_value;
+        if (delta < 0) {
+            delta = -delta;
+        }
+
+        bool report = !a->reported_once ||
+                      (r->max_s && elapsed_s >= r->max_s) ||
+                      (elapsed_s >= r->min_s && delta != 0 && (uint32_t)delta >= r->change);
+        if (report) {
+            a->reported_once = true;
+            a->reported_value = a->value;
+            a->last_report_us = now_us;
+            due[due_count++] = (due_report_t){ a->endpoint, a->cluster_id, a->attr_id, a->value };
+        }
+    }
+    xSemaphoreGive(lock);
+
+    for (int i = 0; i < due_count; i++) {
+        transmit(due[i].endpoint, due[i].cluster_id, due[i].attr_id, due[i].value, true);
+    }
+}
+
+// ========================================
+// Dispatch (Zigbee task)
+// ========================================
+
+static void dispatch_signal(esp_zb_app_signal_type_t type, esp_err_t status)
+{
+    // p_app_signal points at the signal type, followed by signal parameters
+    uint32_t signal[4] = { type };
+    esp_zb_app_signal_t app_signal = {
+        .p_app_signal = signal,
+        .esp_err_status = status,
+    };
+
+    if (type == ESP_ZB_BDB_SIGNAL_STEERING && status == ESP_OK) {
+        joined = true;
+    }
+    sim_stats_note("signal", esp_zb_zdo_signal_to_string(type));
+    esp_zb_app_signal_handler(&app_signal);
+}
+
+static void dispatch(const event_t *ev)
+{
+    switch (ev->kind) {
+    case EV_ALARM:
+        ev->alarm.cb(ev->alarm.param);
+        break;
+
+    case EV_SIGNAL:
+        dispatch_signal(ev->signal.type, ev->signal.status);
+        break;
+
+    case EV_CONFIRM: {
+        bool dropped = ev->frame.status == ESP_ERR_NO_MEM;
+        if (!dropped && ev->frame.status != ESP_ERR_INVALID_STATE) {
+            xSemaphoreTake(lock, portMAX_DELAY);
+            in_flight--;
+            xSemaphoreGive(lock);
+        }
+        if (!dropped) {
+            sim_stats_report_done(ev->frame.endpoint, ev->frame.cluster_id, ev->frame.tsn,
+                                  ev->frame.status == ESP_OK ? SIM_REPORT_DELIVERED : SIM_REPORT_FAILED,
+                                  (uint32_t)((ev->due_us - ev->frame.enqueued_us) / 1000));
+        }
+        if (send_status_handler) {
+            esp_zb_zcl_command_send_status_message_t msg = {
+                .status = ev->frame.status,
+                .tsn = ev->frame.tsn,
+                .dst_endpoint = COORDINATOR_EP,
+                .src_endpoint = ev->frame.endpoint,
+            };
+            send_status_handler(msg);
+        }
+        break;
+    }
+
+    case EV_DEFAULT_RESP:
+        if (action_handler) {
+            esp_zb_zcl_cmd_default_resp_message_t msg = {
+                .info = {
+                    .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+                    .header = { .tsn = ev->frame.tsn },
+                    .src_endpoint = COORDINATOR_EP,
+                    .dst_endpoint = ev->frame.endpoint,
+                    .cluster = ev->frame.cluster_id,
+                    .profile = ESP_ZB_AF_HA_PROFILE_ID,
+                },
+                .resp_to_cmd = ZCL_CMD_REPORT_ATTRIB,
+                .status_code = ev->frame.status == ESP_OK ? ESP_ZB_ZCL_STATUS_SUCCESS : ESP_ZB_ZCL_STATUS_FAIL,
+            };
+            action_handler(ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID, &msg);
+        }
+        break;
+
+    case EV_REMOTE_WRITE: {
+        bool value = ev->on_off;
+        esp_zb_zcl_set_attribute_val(SIM_EP_MODE_SWITCH, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,
+                                     &value, false);
+        if (action_handler) {
+            esp_zb_zcl_set_attr_value_message_t msg = {
+                .info = {
+                    .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+                    .dst_endpoint = SIM_EP_MODE_SWITCH,
+                    .cluster = ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+                },
+                .attribute = {
+                    .id = ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,
+                    .data = { .type = ESP_ZB_ZCL_ATTR_TYPE_BOOL, .size = 1, .value = &value },
+                },
+            };
+            action_handler(ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID, &msg);
+        }
+        break;
+    }
+    }
+}
+
+// ========================================
+// Simulation Control
+// ========================================
+
+void sim_zigbee_configure(void)
+{
+    lock = xSemaphoreCreateMutex();
+    sim_rng_seed(&link_rng, sim_scenario.seed, SIM_SENSOR_COUNT);
+}
+
+void sim_zigbee_remote_mode_switch(bool explicit_mode)
+{
+    event_t ev = {
+        .kind = EV_REMOTE_WRITE,
+        .due_us = sim_time_us(),
+        .on_off = explicit_mode,
+    };
+    post(&ev);
+}
+
+void sim_zigbee_link_down(uint32_t duration_s)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    link_down_until_us = sim_time_us() + duration_s * 1000000LL;
+    xSemaphoreGive(lock);
+}
+
+// ========================================
+// esp_zigbee_core.h: Stack Lifecycle
+// ========================================
+
+void esp_zb_init(esp_zb_cfg_t *nwk_cfg)
+{
+    ESP_LOGI(TAG, "Mock stack: role %d, link %lu+%lu ms, loss %u.%u%%, queue %u",
+             nwk_cfg->esp_zb_role, (unsigned long)sim_scenario.link.latency_ms,
+             (unsigned long)sim_scenario.link.jitter_ms, sim_scenario.link.loss_permille / 10,
+             sim_scenario.link.loss_permille % 10, sim_scenario.link.queue_len);
+}
+
+esp_err_t esp_zb_start(bool autostart)
+{
+    post_signal(ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP, ESP_OK, 0);
+    return ESP_OK;
+}
+
+void esp_zb_main_loop_iteration(void)
+{
+    while (1) {
+        event_t ev;
+        while (pop_due(sim_time_us(), &ev)) {
+            // Confirms are measured by the firmware: let it see their exact due time
+            bool pin = ev.kind == EV_CONFIRM || ev.kind == EV_DEFAULT_RESP;
+            if (pin) {
+                sim_time_pin(ev.due_us);
+            }
+            dispatch(&ev);
+            if (pin) {
+                sim_time_unpin();
+            }
+        }
+        check_reporting();
+
+        if (events_overflowed) {
+            fprintf(stderr, "sim: event table full, %lu events lost\n", (unsigned long)events_overflowed);
+            events_overflowed = 0;
+        }
+        vTaskDelay(1);
+    }
+}
+
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask)
+{
+    if (mode_mask == ESP_ZB_BDB_MODE_INITIALIZATION) {
+        post_signal(ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START, ESP_OK, 100);
+    } else if (mode_mask == ESP_ZB_BDB_MODE_NETWORK_STEERING) {
+        // The network is only found if the scan includes its channel
+        bool found = (primary_mask & (1UL << sim_scenario.channel)) &&
+                     steering_attempts++ >= sim_scenario.join_failures;
+        post_signal(ESP_ZB_BDB_SIGNAL_STEERING, found ? ESP_OK : ESP_FAIL, sim_scenario.join_delay_ms);
+    }
+    return ESP_OK;
+}
+
+void esp_zb_core_action_handler_register(esp_zb_core_action_callback_t cb)
+{
+    action_handler = cb;
+}
+
+void esp_zb_zcl_command_send_status_handler_register(esp_zb_zcl_command_send_status_callback_t cb)
+{
+    send_status_handler = cb;
+}
+
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time)
+{
+    event_t ev = {
+        .kind = EV_ALARM,
+        .due_us = sim_time_us() + time * 1000LL,
+        .alarm = { .cb = cb, .param = param },
+    };
+    post(&ev);
+}
+
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < MAX_EVENTS; i++) {
+        if (events[i].used && events[i].kind == EV_ALARM &&
+            events[i].alarm.cb == cb && events[i].alarm.param == param) {
+            events[i].used = false;
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+// ========================================
+// esp_zigbee_core.h: Network Information
+// ========================================
+
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask)
+{
+    primary_mask = channel_mask;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_set_secondary_network_channel_set(uint32_t channel_mask)
+{
+    return ESP_OK;
+}
+
+uint16_t esp_zb_get_short_address(void)
+{
+    return joined ? SIM_SHORT_ADDR : 0xFFFF;
+}
+
+void esp_zb_get_extended_pan_id(esp_zb_ieee_addr_t ext_pan_id)
+{
+    memset(ext_pan_id, joined ? 0xDD : 0x00, sizeof(esp_zb_ieee_addr_t));
+}
+
+uint8_t esp_zb_get_current_channel(void)
+{
+    return joined ? sim_scenario.channel : 0;
+}
+
+const char *esp_zb_zdo_signal_to_string(esp_zb_app_signal_type_t signal)
+{
+    switch (signal) {
+    case ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP:        return "ZDO_SIGNAL_SKIP_STARTUP";
+    case ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START:  return "BDB_SIGNAL_DEVICE_FIRST_START";
+    case ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT:       return "BDB_SIGNAL_DEVICE_REBOOT";
+    case ESP_ZB_BDB_SIGNAL_STEERING:            return "BDB_SIGNAL_STEERING";
+    default:                                    return "UNKNOWN";
+    }
+}
+
+// ========================================
+// ZCL: Attributes and Reports
+// ========================================
+
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role,
+                                                 uint16_t attr_id, void *value_p, bool check)
+{
+    int32_t value = decode_value(attr_type(cluster_id, attr_id), value_p);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    attr_state_t *a = attr_find_locked(endpoint, cluster_id, attr_id, true);
+    if (a) {
+        a->value = value;
+    }
+    xSemaphoreGive(lock);
+
+    sim_stats_attr_write(endpoint, cluster_id, attr_id, value);
+    return ESP_ZB_ZCL_STATUS_SUCCESS;
+}
+
+esp_err_t esp_zb_zcl_report_attr_cmd_req(esp_zb_zcl_report_attr_cmd_t *cmd_req)
+{
+    uint8_t endpoint = cmd_req->zcl_basic_cmd.src_endpoint;
+    int32_t value = 0;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    attr_state_t *a = attr_find_locked(endpoint, cmd_req->clusterID, cmd_req->attributeID, false);
+    if (a) {
+        value = a->value;
+    }
+    xSemaphoreGive(lock);
+
+    transmit(endpoint, cmd_req->clusterID, cmd_req->attributeID, value, false);
+    return ESP_OK;
+}
+
+// ========================================
+// zboss_api_zcl.h
+// ========================================
+
+zb_zcl_globals_t *zb_zcl_get_ctx(void)
+{
+    return &zcl_ctx;
+}
+
+// ========================================
+// Data Model (accepted, not modelled)
+// ========================================
+
+static esp_zb_attribute_list_t *new_attr_list(uint16_t cluster_id)
+{
+    esp_zb_attribute_list_t *list = calloc(1, sizeof(*list));
+    if (list) {
+        list->cluster_id = cluster_id;
+    }
+    return list;
+}
+
+esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id)
+{
+    return new_attr_list(cluster_id);
+}
+
+esp_zb_attribute_list_t *esp_zb_basic_cluster_create(esp_zb_basic_cluster_cfg_t *basic_cfg)
+{
+    return new_attr_list(ESP_ZB_ZCL_CLUSTER_ID_BASIC);
+}
+
+esp_zb_attribute_list_t *esp_zb_temperature_meas_cluster_create(esp_zb_temperature_meas_cluster_cfg_t *temperature_cfg)
+{
+    return new_attr_list(ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT);
+}
+
+esp_zb_attribute_list_t *esp_zb_humidity_meas_cluster_create(esp_zb_humidity_meas_cluster_cfg_t *humidity_cfg)
+{
+    return new_attr_list(ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT);
+}
+
+esp_zb_attribute_list_t *esp_zb_pressure_meas_cluster_create(esp_zb_pressure_meas_cluster_cfg_t *pressure_cfg)
+{
+    return new_attr_list(ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT);
+}
+
+esp_zb_attribute_list_t *esp_zb_illuminance_meas_cluster_create(esp_zb_illuminance_meas_cluster_cfg_t *illuminance_cfg)
+{
+    return new_attr_list(ESP_ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT);
+}
+
+esp_zb_attribute_list_t *esp_zb_on_off_cluster_create(esp_zb_on_off_cluster_cfg_t *on_off_cfg)
+{
+    return new_attr_list(ESP_ZB_ZCL_CLUSTER_ID_ON_OFF);
+}
+
+esp_err_t esp_zb_basic_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_custom_cluster_add_custom_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id,
+                                                uint8_t attr_type, uint8_t attr_access, void *value_p)
+{
+    if (custom_type_count < MAX_ATTRS) {
+        custom_types[custom_type_count++] = (attr_type_t){ attr_list->cluster_id, attr_id, attr_type };
+    }
+    return ESP_OK;
+}
+
+esp_zb_cluster_list_t *esp_zb_zcl_cluster_list_create(void)
+{
+    return calloc(1, sizeof(esp_zb_cluster_list_t));
+}
+
+esp_err_t esp_zb_cluster_list_add_basic_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_list_add_temperature_meas_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                           esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_list_add_humidity_meas_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                        esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_list_add_pressure_meas_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                        esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_list_add_illuminance_meas_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                           esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_list_add_on_off_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                 esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_list_add_custom_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                 esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return ESP_OK;
+}
+
+esp_zb_ep_list_t *esp_zb_ep_list_create(void)
+{
+    return calloc(1, sizeof(esp_zb_ep_list_t));
+}
+
+esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list,
+                                uint8_t endpoint, uint16_t profile_id, uint16_t device_id)
+{
+    ESP_LOGI(TAG, "EP%u registered (device 0x%04x)", endpoint, device_id);
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list)
+{
+    return ESP_OK;
+}
@@ -0,0 +1,49 @@
+/*
+ * Mock Zigbee Stack
+ *
+ * Implements the esp-zigbee-lib calls the firmware makes, against the real
+ * SDK headers:
+ *   - data model calls (cluster/endpoint creation) succeed and are ignored
+ *   - esp_zb_zcl_set_attribute_val() stores and records the value
+ *   - esp_zb_zcl_report_attr_cmd_req() queues the frame on a modelled link
+ *     (serial radio, per-attempt latency/jitter/loss, APS retries, bounded
+ *     queue) and confirms it through the send-status callback when due
+ *   - esp_zb_scheduler_alarm() runs callbacks on simulated time
+ *   - esp_zb_start() / commissioning raise SKIP_STARTUP, FIRST_START and
+ *     STEERING through esp_zb_app_signal_handler()
+ *   - configured reportable attributes are reported automatically, the way
+ *     ZBOSS does for any attribute whose value changes (min/max interval,
+ *     reportable change)
+ *
+ * All callbacks run in the task that called esp_zb_main_loop_iteration(),
+ * as with the real stack.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Apply sim_scenario (link, join and reporting models). Call before the
+ * firmware starts.
+ */
+void sim_zigbee_configure(void);
+
+/**
+ * Home Assistant writes the EP14 reporting-mode switch.
+ */
+void sim_zigbee_remote_mode_switch(bool explicit_mode);
+
+/**
+ * Every transmission attempt fails for the next `duration_s` seconds.
+ */
+void sim_zigbee_link_down(uint32_t duration_s);
+
+#ifdef __cplusplus
+}
+#endif
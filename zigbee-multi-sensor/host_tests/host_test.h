@@ -0,0 +1,34 @@
+/*
+ * Host Test Helpers
+ *
+ * Minimal checks for the host test programs: a failed CHECK prints where
+ * and why and counts, and the program exits non-zero if any failed, which
+ * is all ctest needs.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+static int host_test_failures;
+
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            host_test_failures++;                                           \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__, \
+                    #cond);                                                 \
+            fprintf(stderr, __VA_ARGS__);                                   \
+            fputc('\n', stderr);                                            \
+        }                                                                   \
+    } while (0)
+
+static inline int host_test_result(const char *name)
+{
+    if (host_test_failures != 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, host_test_failures);
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
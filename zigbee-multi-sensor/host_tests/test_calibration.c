@@ -0,0 +1,168 @@
+/*
+ * Calibration Table Host Test
+ *
+ * Compares calibration_eval() with a double-precision piecewise-linear
+ * reference over raw values from well below the first point to well above
+ * the last, for tables of 0, 1, 2 and 8 points, and checks that
+ * calibration_build() rejects what it must and that calibration_merge()
+ * keeps a table buildable through any sequence of captures.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "calibration_table.h"
+#include "host_test.h"
+
+#define SWEEP_MIN                       -12000
+#define SWEEP_MAX                       20000
+#define SWEEP_STEP                      7
+#define MAX_ERROR                       1.0     // 0.01 units: Q16 slope and product rounding
+
+#define COUNT_OF(a)                     (sizeof(a) / sizeof((a)[0]))
+
+/**
+ * Exact interpolation through the points, extending the end segments.
+ */
+static double reference(const calibration_point_t *p, size_t count, int32_t raw)
+{
+    if (count == 0) {
+        return raw;
+    }
+    if (count == 1) {
+        return raw + (double)(p[0].ref - p[0].raw);
+    }
+
+    size_t i = 0;
+    while (i + 2 < count && raw >= p[i + 1].raw) {
+        i++;
+    }
+    double slope = (double)(p[i + 1].ref - p[i].ref) / (p[i + 1].raw - p[i].raw);
+    return p[i].ref + slope * (raw - p[i].raw);
+}
+
+static void sweep(const char *name, const calibration_point_t *points, size_t count)
+{
+    calibration_table_t table;
+    esp_err_t ret = calibration_build(&table, points, count);
+    CHECK(ret == ESP_OK, "%s: build returned %d", name, ret);
+    if (ret != ESP_OK) {
+        return;
+    }
+
+    double worst = 0;
+    for (int32_t raw = SWEEP_MIN; raw <= SWEEP_MAX; raw += SWEEP_STEP) {
+        double expected = reference(points, count, raw);
+        int32_t got = calibration_eval(&table, raw);
+        double error = fabs(got - expected);
+        CHECK(error <= MAX_ERROR, "%s: raw %ld -> %ld, reference %.3f", name, (long)raw, (long)got, expected);
+        if (error > worst) {
+            worst = error;
+        }
+    }
+    // The points themselves are exact
+    for (size_t i = 0; i < count; i++) {
+        int32_t got = calibration_eval(&table, points[i].raw);
+        CHECK(got == points[i].ref, "%s: point %zu gives %ld, not %d", name, i, (long)got, points[i].ref);
+    }
+    printf("%-12s worst error %.3f\n", name, worst);
+}
+
+static void expect_rejected(const char *name, const calibration_point_t *points, size_t count)
+{
+    calibration_table_t table = { .count = 0xAA };
+    esp_err_t ret = calibration_build(&table, points, count);
+    CHECK(ret == ESP_ERR_INVALID_ARG, "%s: build returned %d", name, ret);
+    CHECK(table.count == 0xAA, "%s: table written on rejection", name);
+}
+
+/**
+ * Merge one capture and check the points against `expected`.
+ */
+static void merge(const char *name, calibration_point_t *points, size_t *count, int16_t raw, int16_t ref,
+                  esp_err_t expected_ret, const calibration_point_t *expected, size_t expected_count)
+{
+    esp_err_t ret = calibration_merge(points, count, raw, ref);
+    CHECK(ret == expected_ret, "%s: merge of %d returned %d", name, raw, ret);
+    CHECK(*count == expected_count, "%s: %zu points, expected %zu", name, *count, expected_count);
+    for (size_t i = 0; i < *count && i < expected_count; i++) {
+        CHECK(points[i].raw == expected[i].raw && points[i].ref == expected[i].ref,
+              "%s: point %zu is (%d, %d), expected (%d, %d)", name, i, points[i].raw, points[i].ref,
+              expected[i].raw, expected[i].ref);
+    }
+
+    calibration_table_t table;
+    CHECK(calibration_build(&table, points, *count) == ESP_OK, "%s: merged points do not build", name);
+}
+
+static void test_merge(void)
+{
+    calibration_point_t points[CALIBRATION_MAX_POINTS];
+    size_t count = 0;
+
+    merge("first", points, &count, 2000, 2100, ESP_OK, (calibration_point_t[]){ { 2000, 2100 } }, 1);
+    merge("below", points, &count, 1000, 1050, ESP_OK,
+          (calibration_point_t[]){ { 1000, 1050 }, { 2000, 2100 } }, 2);
+    merge("same spot", points, &count, 2030, 2120, ESP_OK,
+          (calibration_point_t[]){ { 1000, 1050 }, { 2030, 2120 } }, 2);
+
+    // Two points pulled within the window of each other, then a capture
+    // just above the upper one: replacing the lower (the first in its
+    // window) would leave the points unsorted
+    count = 0;
+    merge("pair a", points, &count, 1000, 1000, ESP_OK, (calibration_point_t[]){ { 1000, 1000 } }, 1);
+    merge("pair b", points, &count, 1100, 1100, ESP_OK,
+          (calibration_point_t[]){ { 1000, 1000 }, { 1100, 1100 } }, 2);
+    merge("pull b", points, &count, 1060, 1065, ESP_OK,
+          (calibration_point_t[]){ { 1000, 1000 }, { 1060, 1065 } }, 2);
+    merge("pull a", points, &count, 1030, 1035, ESP_OK,  // Tie: the lower one
+          (calibration_point_t[]){ { 1030, 1035 }, { 1060, 1065 } }, 2);
+    merge("past b", points, &count, 1070, 1072, ESP_OK,
+          (calibration_point_t[]){ { 1030, 1035 }, { 1070, 1072 } }, 2);
+    merge("nearer a", points, &count, 1049, 1050, ESP_OK,
+          (calibration_point_t[]){ { 1049, 1050 }, { 1070, 1072 } }, 2);
+
+    // Full table: a new point is refused, a replacement is not
+    count = 0;
+    for (int16_t i = 0; i < CALIBRATION_MAX_POINTS; i++) {
+        calibration_merge(points, &count, (int16_t)(i * 1000), (int16_t)(i * 1000 + 10));
+    }
+    calibration_point_t full[CALIBRATION_MAX_POINTS];
+    memcpy(full, points, sizeof(full));
+    merge("full, new", points, &count, 500, 500, ESP_ERR_NO_MEM, full, CALIBRATION_MAX_POINTS);
+    full[3] = (calibration_point_t){ 3040, 3000 };
+    merge("full, replace", points, &count, 3040, 3000, ESP_OK, full, CALIBRATION_MAX_POINTS);
+}
+
+int main(void)
+{
+    // Offset only
+    static const calibration_point_t one[] = { { 2000, 2150 } };
+    // Gain and offset
+    static const calibration_point_t two[] = { { 1000, 1100 }, { 3000, 2950 } };
+    // A full humidity table: shallow and steep segments, a steep negative one
+    // in the middle, and a falling last segment extrapolated far past its end
+    static const calibration_point_t eight[] = {
+        { -4000, -3890 }, { 1000, 1130 }, { 2500, 2480 }, { 4000, 5000 },
+        { 4010, 2000 }, { 6000, 6210 }, { 8503, 8411 }, { 9000, 8000 },
+    };
+
+    sweep("0 points", NULL, 0);
+    sweep("1 point", one, COUNT_OF(one));
+    sweep("2 points", two, COUNT_OF(two));
+    sweep("8 points", eight, COUNT_OF(eight));
+
+    static const calibration_point_t unsorted[] = { { 1000, 1000 }, { 3000, 3000 }, { 2000, 2000 } };
+    static const calibration_point_t duplicate[] = { { 1000, 1000 }, { 2000, 2000 }, { 2000, 2100 } };
+    static const calibration_point_t too_steep[] = { { 0, -20000 }, { 1, 20000 } };  // Slope 40000
+    static const calibration_point_t nine[9] = {
+        { 0, 0 }, { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 }, { 5, 5 }, { 6, 6 }, { 7, 7 }, { 8, 8 },
+    };
+    expect_rejected("unsorted", unsorted, COUNT_OF(unsorted));
+    expect_rejected("duplicate", duplicate, COUNT_OF(duplicate));
+    expect_rejected("too steep", too_steep, COUNT_OF(too_steep));
+    expect_rejected("nine points", nine, COUNT_OF(nine));
+
+    test_merge();
+
+    return host_test_result("calibration");
+}
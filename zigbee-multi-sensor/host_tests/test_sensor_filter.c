@@ -0,0 +1,137 @@
+/*
+ * Sensor Filter Host Test
+ *
+ * Plays DHT11 and DS18B20 traces through sensor_filter_push() with the
+ * drivers' filter configurations and checks every verdict and every
+ * filtered output. Samples are one update interval (60 s) apart and in
+ * the drivers' raw 0.01 units, as the sensor tasks feed them.
+ */
+
+#include <stddef.h>
+#include "host_test.h"
+#include "sensor_filter.h"
+
+#define INTERVAL_MS                     60000
+
+typedef struct {
+    int32_t value;
+    sensor_filter_verdict_t verdict;
+    int32_t out;                        // Filtered value when accepted
+} trace_sample_t;
+
+#define ACCEPT(v, o)    { (v), SENSOR_FILTER_ACCEPTED, (o) }
+#define REJECT(v, why)  { (v), SENSOR_FILTER_REJECT_##why, 0 }
+
+// Filter configurations as in sensor_dht11.c and sensor_ds18b20.c
+static const sensor_filter_config_t dht11_temp_cfg = {
+    .median_window = 3,
+    .ema_shift = 1,
+    .min = 0, .max = 5000,
+    .max_slew_per_s = 5,
+};
+
+static const sensor_filter_config_t dht11_humidity_cfg = {
+    .median_window = 3,
+    .ema_shift = 1,
+    .min = 100, .max = 9900,
+    .max_slew_per_s = 10,
+};
+
+static const sensor_filter_config_t ds18b20_temp_cfg = {
+    .median_window = 3,
+    .ema_shift = 0,
+    .min = -5500, .max = 12500,
+    .reject_sentinel = true,
+    .sentinel = 8500,
+    .max_slew_per_s = 10,
+};
+
+// Room temperature with the DHT11's failure modes, then a heater switched on
+static const trace_sample_t dht11_temp_trace[] = {
+    ACCEPT(2130, 2130),                 // First sample seeds the average
+    ACCEPT(2140, 2133),
+    ACCEPT(2150, 2136),
+    REJECT(0, SLEW),                    // All-zero frame: checksum valid, 0.0 °C
+    ACCEPT(2150, 2143),
+    REJECT(2920, SLEW),                 // Single spike, +7.7 °C
+    ACCEPT(2160, 2147),
+    REJECT(6550, RANGE),                // Checksum-valid garbage, 65.5 °C
+    ACCEPT(2170, 2153),
+    REJECT(3200, SLEW),                 // Heater on: too fast for one interval...
+    REJECT(3250, SLEW),
+    ACCEPT(3280, 3280),                 // ...but three in a row re-seed the filter
+    ACCEPT(3290, 3283),
+};
+
+static const trace_sample_t dht11_humidity_trace[] = {
+    ACCEPT(4500, 4500),
+    ACCEPT(4520, 4505),
+    REJECT(0, RANGE),                   // All-zero frame, 0 %
+    ACCEPT(4530, 4513),
+    REJECT(10000, RANGE),               // Checksum-valid 100 %
+    ACCEPT(4540, 4521),
+    REJECT(6000, SLEW),                 // +14.6 % in a minute
+    ACCEPT(4550, 4531),
+    ACCEPT(4560, 4540),
+};
+
+static const trace_sample_t ds18b20_temp_trace[] = {
+    REJECT(8500, SENTINEL),             // Scratchpad power-on value before a conversion
+    ACCEPT(2150, 2150),
+    ACCEPT(2156, 2153),                 // No averaging, median of two
+    REJECT(8500, SENTINEL),             // Brown-out reset of the probe
+    ACCEPT(2162, 2156),
+    REJECT(204794, RANGE),              // CRC-valid 0x7FFF
+    REJECT(3500, SLEW),                 // +13.4 °C in a minute
+    ACCEPT(2168, 2162),
+    ACCEPT(2175, 2168),
+};
+
+static void play(const char *name, const sensor_filter_config_t *config,
+                 const trace_sample_t *trace, size_t count,
+                 const sensor_filter_stats_t *expected)
+{
+    sensor_filter_t filter;
+    sensor_filter_init(&filter, config);
+
+    for (size_t i = 0; i < count; i++) {
+        const trace_sample_t *s = &trace[i];
+        int32_t out = INT32_MIN;
+
+        sensor_filter_verdict_t verdict = sensor_filter_push(&filter, s->value, (uint32_t)(i * INTERVAL_MS), &out);
+        CHECK(verdict == s->verdict, "%s[%zu] %ld: %s, expected %s", name, i, (long)s->value,
+              sensor_filter_verdict_name(verdict), sensor_filter_verdict_name(s->verdict));
+        if (s->verdict == SENSOR_FILTER_ACCEPTED) {
+            CHECK(out == s->out, "%s[%zu] %ld: output %ld, expected %ld", name, i, (long)s->value,
+                  (long)out, (long)s->out);
+        } else {
+            CHECK(out == INT32_MIN, "%s[%zu] %ld: output written on rejection", name, i, (long)s->value);
+        }
+    }
+
+    CHECK(filter.stats.accepted == expected->accepted, "%s: %lu accepted", name,
+          (unsigned long)filter.stats.accepted);
+    CHECK(filter.stats.rejected_range == expected->rejected_range, "%s: %lu out of range", name,
+          (unsigned long)filter.stats.rejected_range);
+    CHECK(filter.stats.rejected_sentinel == expected->rejected_sentinel, "%s: %lu sentinels", name,
+          (unsigned long)filter.stats.rejected_sentinel);
+    CHECK(filter.stats.rejected_slew == expected->rejected_slew, "%s: %lu slew rejects", name,
+          (unsigned long)filter.stats.rejected_slew);
+    CHECK(filter.stats.reseeds == expected->reseeds, "%s: %lu reseeds", name,
+          (unsigned long)filter.stats.reseeds);
+}
+
+#define PLAY(name, config, trace, ...) \
+    play(name, config, trace, sizeof(trace) / sizeof(trace[0]), &(sensor_filter_stats_t){ __VA_ARGS__ })
+
+int main(void)
+{
+    PLAY("dht11_t", &dht11_temp_cfg, dht11_temp_trace,
+         .accepted = 8, .rejected_range = 1, .rejected_slew = 4, .reseeds = 1);
+    PLAY("dht11_rh", &dht11_humidity_cfg, dht11_humidity_trace,
+         .accepted = 6, .rejected_range = 2, .rejected_slew = 1);
+    PLAY("ds18b20_t", &ds18b20_temp_cfg, ds18b20_temp_trace,
+         .accepted = 5, .rejected_range = 1, .rejected_sentinel = 2, .rejected_slew = 1);
+
+    return host_test_result("sensor_filter");
+}
@@ -2,6 +2,13 @@
 """
 ESP32 Multi-Sensor Monitor
 Displays BH1750, DS18B20, and DHT11 sensor data in real-time
+
+Sensor values and Zigbee status arrive as binary telemetry records
+(src/telemetry.h), decoded by telemetry_decode.py. Log text interleaved
+with the records is echoed to the terminal; tokenised log entries are
+expanded when the firmware ELF is available:
+
+    python3 monitor.py [path/to/firmware.elf]
 """
 
 import tkinter as tk
@@ -9,9 +16,12 @@ from tkinter import ttk, messagebox
 import serial
 import serial.tools.list_ports
 import threading
-import re
+import os
 import sys
 
+import telemetry_decode as telem
+import detokenize
+
 class SensorMonitor:
     def __init__(self, root):
         self.root = root
@@ -21,6 +31,8 @@ class SensorMonitor:
 
         self.serial_port = None
         self.running = False
+        self.decoder = telem.StreamDecoder()
+        self.detok = None
 
         # Sensor data
         self.light_lux = tk.StringVar(value="-- lux")
@@ -200,14 +212,19 @@ class SensorMonitor:
         self.disconnect_btn.config(state=tk.DISABLED)
 
     def read_serial(self):
-        """Read and parse serial data in background thread"""
+        """Read and decode serial data in background thread"""
         while self.running:
             try:
                 if self.serial_port and self.serial_port.is_open:
-                    line = self.serial_port.readline().decode('utf-8', errors='ignore').strip()
+                    data = self.serial_port.read(self.serial_port.in_waiting or 1)
 
-                    if line:
-                        self.parse_line(line)
+                    for item in self.decoder.feed(data):
+                        if not isinstance(item, telem.Record):
+                            print(item)
+                        elif item.type == telem.REC_LOG:
+                            self.print_log(item)
+                        else:
+                            self.root.after(0, self.handle_record, item)
 
             except serial.SerialException:
                 self.running = False
@@ -216,65 +233,47 @@ class SensorMonitor:
             except Exception as e:
                 print(f"Error reading serial: {e}")
 
-    def parse_line(self, line):
-        """Parse sensor data and Zigbee diagnostics from ESP32 output"""
-        try:
-            # BH1750: Light:    91.7 lux
-            if "BH1750" in line and "Light:" in line:
-                match = re.search(r'Light:\s+([\d.]+)\s+lux', line)
-                if match:
-                    self.light_lux.set(f"{match.group(1)} lux")
-
-            # DS18B20: Temp:   21.38 °C  (70.47 °F)  [Outdoor]
-            elif "DS18B20" in line and "Temp:" in line:
-                match = re.search(r'Temp:\s+([\d.]+)\s+°C', line)
-                if match:
-                    temp = float(match.group(1))
-                    temp_f = (temp * 9.0/5.0) + 32.0
-                    self.outdoor_temp.set(f"{temp:.1f} °C ({temp_f:.1f} °F)")
-
-            # DHT11: Temp:    30.0 °C  (86.0 °F)  [Indoor]
-            elif "DHT11" in line and "Temp:" in line:
-                match = re.search(r'Temp:\s+([\d.]+)\s+°C', line)
-                if match:
-                    temp = float(match.group(1))
-                    temp_f = (temp * 9.0/5.0) + 32.0
-                    self.indoor_temp.set(f"{temp:.1f} °C ({temp_f:.1f} °F)")
-
-            # DHT11: Humid:   32.0 %
-            elif "DHT11" in line and "Humid:" in line:
-                match = re.search(r'Humid:\s+([\d.]+)\s+%', line)
-                if match:
-                    self.humidity.set(f"{match.group(1)} %")
-
-            # Zigbee Diagnostics
-            # Connected:    YES or Connected:    NO
-            elif "Connected:" in line and ("YES" in line or "NO" in line):
-                if "YES" in line:
-                    self.zigbee_connected.set("✓ YES")
-                else:
-                    self.zigbee_connected.set("✗ NO (searching...)")
-
-            # Channel:      11
-            elif "Channel:" in line:
-                match = re.search(r'Channel:\s+(\d+)', line)
-                if match:
-                    self.zigbee_channel.set(match.group(1))
-
-            # Short Addr:   0x1234
-            elif "Short Addr:" in line:
-                match = re.search(r'Short Addr:\s+(0x[0-9A-Fa-f]+)', line)
-                if match:
-                    self.zigbee_short_addr.set(match.group(1))
-
-            # PAN ID:       dd:dd:dd:dd:dd:dd:dd:dd
-            elif "PAN ID:" in line:
-                match = re.search(r'PAN ID:\s+([\da-fA-F:]+)', line)
-                if match:
-                    self.zigbee_pan_id.set(match.group(1))
-
-        except Exception as e:
-            print(f"Error parsing line: {e}")
+    def print_log(self, record):
+        """Print a tokenised log entry (raw token if no ELF was loaded)"""
+        if self.detok:
+            print(self.detok.format_record(record))
+        else:
+            f = record.fields
+            print(f"[tlog 0x{f['fmt']:08x}] " + " ".join(f"{a:08x}" for a in f['args']))
+
+    def handle_record(self, record):
+        """Update the display from one telemetry record (Tk thread)"""
+        f = record.fields
+
+        if record.type == telem.REC_LIGHT:
+            self.light_lux.set(f"{f['lux']:.1f} lux")
+
+        elif record.type == telem.REC_TEMPERATURE:
+            temp_f = (f['celsius'] * 9.0/5.0) + 32.0
+            text = f"{f['celsius']:.1f} °C ({temp_f:.1f} °F)"
+            if f['sensor'] == "DS18B20":
+                self.outdoor_temp.set(text)
+            elif f['sensor'] in ("DHT11", "SHT4x", "BME280"):
+                self.indoor_temp.set(text)
+
+        elif record.type == telem.REC_HUMIDITY:
+            self.humidity.set(f"{f['percent']:.1f} %")
+
+        elif record.type == telem.REC_ZB_STATUS:
+            if f['connected']:
+                self.zigbee_connected.set("✓ YES")
+                self.zigbee_channel.set(str(f['channel']))
+                self.zigbee_short_addr.set(f"0x{f['short_addr']:04X}")
+                self.zigbee_pan_id.set(f['ext_pan_id'])
+            else:
+                self.zigbee_connected.set("✗ NO (searching...)")
+
+        elif record.type == telem.REC_BOOT:
+            print(f"Device booted (reset reason: {f['reset_reason']})")
+
+        port = self.serial_port.port if self.serial_port else "?"
+        self.status_var.set(f"Connected to {port}  |  frames {self.decoder.frames_ok}"
+                            f"  dropped {self.decoder.frames_dropped}")
 
     def on_closing(self):
         self.disconnect()
@@ -283,6 +282,12 @@ class SensorMonitor:
 def main():
     root = tk.Tk()
     app = SensorMonitor(root)
+
+    elf = sys.argv[1] if len(sys.argv) > 1 else detokenize.DEFAULT_ELF
+    if os.path.exists(elf):
+        app.detok = detokenize.Detokenizer(elf)
+    else:
+        print(f"No firmware ELF at {elf}; tokenised logs will be shown raw")
     root.protocol("WM_DELETE_WINDOW", app.on_closing)
     root.mainloop()
 
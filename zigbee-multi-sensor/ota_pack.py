@@ -0,0 +1,390 @@
+#!/usr/bin/env python3
+"""
+Zigbee OTA upgrade file packer (src/zb_ota.h)
+
+Wraps a firmware binary into the file the network's OTA server hands out:
+the 56-byte OTA header (no optional fields) and one element, either the app
+image (Upgrade Image, tag 0x0000) or, with --delta-from, a patch that
+rebuilds it from the image the nodes run now (tag 0xF000, src/ota_delta.h).
+--compress packs either one as a heatshrink LZSS stream (tags 0xF001 and
+0xF002, src/ota_lz.h).
+
+    python3 ota_pack.py --version 0x00000002
+    python3 ota_pack.py build/firmware.bin --version 0x00000002 -o multisensor-2.zigbee
+    python3 ota_pack.py --version 0x00000002 --compress
+    python3 ota_pack.py --version 0x00000003 --delta-from release-2/firmware.bin --compress
+    python3 ota_pack.py --info multisensor-2.zigbee
+
+A delta only applies to nodes running exactly the --delta-from image (they
+check its SHA-256 and refuse the download otherwise), so offer it only to
+those; nodes on other versions need the full image.
+
+The manufacturer code and image type must match zb_ota.h, and the file
+version must be higher than ZB_OTA_FILE_VERSION of the running firmware
+(build the new firmware with that define raised to the same value).
+"""
+
+import argparse
+import hashlib
+import re
+import struct
+import sys
+
+DEFAULT_BIN = ".pio/build/esp32-c6-devkitc-1/firmware.bin"
+
+# zb_ota.h
+MANUFACTURER_CODE = 0x131B
+IMAGE_TYPE = 0x0001
+FILE_HEADER_SIZE = 56
+ELEMENT_HEADER_SIZE = 6
+TAG_UPGRADE_IMAGE = 0x0000
+TAG_DELTA_IMAGE = 0xF000
+TAG_COMPRESSED_IMAGE = 0xF001
+TAG_COMPRESSED_DELTA = 0xF002
+
+FILE_ID = 0x0BEEF11E
+HEADER_VERSION = 0x0100
+STACK_ZIGBEE_PRO = 0x0002
+
+ESP_IMAGE_MAGIC = 0xE9
+ESP_IMAGE_HASH_APPENDED = 23
+
+# ota_delta.h
+DELTA_FORMAT_VERSION = 1
+DELTA_OP_END, DELTA_OP_ADD, DELTA_OP_INSERT = 0, 1, 2
+DELTA_SEED = 16             # exact match that starts an ADD
+DELTA_SEED_STEP = 2         # RISC-V instructions are 2-byte aligned
+DELTA_GIVE_UP = 64          # ADD extension stops this far past its best point
+ZERO_RUN = re.compile(b"\x00{3,}")   # shorter zero runs cost less inside a literal
+
+# ota_lz.h
+LZ_WINDOW_BITS = 11         # OTA_LZ_WINDOW_BITS_MAX; the device's window buffer
+LZ_LOOKAHEAD_BITS = 4
+LZ_MIN_MATCH = 3
+LZ_CHAIN = 48               # candidates tried per position
+
+
+def check_app_image(image):
+    """The device refuses images it cannot hash-check (zb_ota.c)."""
+    if len(image) < 64 or image[0] != ESP_IMAGE_MAGIC:
+        raise SystemExit("not an ESP-IDF app image")
+    if image[ESP_IMAGE_HASH_APPENDED] != 1:
+        raise SystemExit("app image has no appended SHA-256")
+    if hashlib.sha256(image[:-32]).digest() != image[-32:]:
+        raise SystemExit("appended SHA-256 does not match the image")
+
+
+def varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append(value & 0x7F | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def zigzag(value):
+    return value << 1 if value >= 0 else ((-value) << 1) - 1
+
+
+def extend_match(old, new, a, b):
+    """Length of the stretch from old[a]/new[b] on where most bytes match."""
+    limit = min(len(old) - a, len(new) - b)
+    score = best = best_len = 0
+    for k in range(limit):
+        score += 1 if old[a + k] == new[b + k] else -1
+        if score > best:
+            best, best_len = score, k + 1
+        elif k - best_len > DELTA_GIVE_UP:
+            break
+    return best_len
+
+
+def encode_diff(diff):
+    """(zeros, literal) runs of an ADD's difference bytes."""
+    out = bytearray()
+    zeros = pos = 0
+    for m in ZERO_RUN.finditer(diff):
+        if m.start() == pos:
+            zeros += m.end() - m.start()
+        else:
+            out += varint(zeros) + varint(m.start() - pos) + diff[pos:m.start()]
+            zeros = m.end() - m.start()
+        pos = m.end()
+    out += varint(zeros) + varint(len(diff) - pos) + diff[pos:]
+    return out
+
+
+def make_delta(old, new):
+    """Patch that rebuilds `new` from `old` (ota_delta.h)."""
+    index = {}
+    for i in range(0, len(old) - DELTA_SEED + 1, DELTA_SEED_STEP):
+        index.setdefault(old[i:i + DELTA_SEED], i)
+
+    ops = bytearray()
+    src = 0             # decoder's source position
+    offset = 0          # old - new offset of the last ADD
+    insert_from = j = 0
+    while j + DELTA_SEED <= len(new):
+        seed = new[j:j + DELTA_SEED]
+        i = j + offset
+        if not (0 <= i and old[i:i + DELTA_SEED] == seed):
+            i = index.get(seed)
+            if i is None:
+                j += 1
+                continue
+
+        # Exact bytes before the seed belong to the ADD, not the INSERT
+        while j > insert_from and i > 0 and old[i - 1] == new[j - 1]:
+            i, j = i - 1, j - 1
+        length = extend_match(old, new, i, j)
+
+        if j > insert_from:
+            ops += bytes([DELTA_OP_INSERT]) + varint(j - insert_from) + new[insert_from:j]
+        diff = bytes((n - o) & 0xFF for n, o in zip(new[j:j + length], old[i:i + length]))
+        ops += bytes([DELTA_OP_ADD]) + varint(length) + varint(zigzag(i - src)) + encode_diff(diff)
+
+        src = i + length
+        offset = i - j
+        j = insert_from = j + length
+
+    if insert_from < len(new):
+        ops += bytes([DELTA_OP_INSERT]) + varint(len(new) - insert_from) + new[insert_from:]
+    ops.append(DELTA_OP_END)
+
+    header = struct.pack("<BI32sI", DELTA_FORMAT_VERSION, len(old), old[-32:], len(new))
+    return header + ops
+
+
+def apply_delta(old, patch):
+    """Reference decoder, to check a patch before it ships."""
+    version, old_size, old_digest, new_size = struct.unpack_from("<BI32sI", patch)
+    if version != DELTA_FORMAT_VERSION or old_size != len(old) or old_digest != old[-32:]:
+        raise ValueError("patch is for another source image")
+
+    def read_varint():
+        nonlocal pos
+        value = shift = 0
+        while True:
+            byte = patch[pos]
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    out = bytearray()
+    pos = struct.calcsize("<BI32sI")
+    src = 0
+    while True:
+        op = patch[pos]
+        pos += 1
+        if op == DELTA_OP_END:
+            break
+        length = read_varint()
+        if op == DELTA_OP_INSERT:
+            out += patch[pos:pos + length]
+            pos += length
+            continue
+        seek = read_varint()
+        src += (seek >> 1) ^ -(seek & 1)
+        end = len(out) + length
+        while len(out) < end:
+            zeros = read_varint()
+            out += old[src:src + zeros]
+            src += zeros
+            n = read_varint()
+            out += bytes((o + d) & 0xFF for o, d in zip(old[src:src + n], patch[pos:pos + n]))
+            src += n
+            pos += n
+    if len(out) != new_size:
+        raise ValueError("patch produced the wrong size")
+    return bytes(out)
+
+
+def match_length(data, a, b, limit):
+    """Common prefix of data[a:] and data[b:], up to limit."""
+    lo, hi = 0, limit
+    while lo < hi:
+        mid = (lo + hi + 1) // 2
+        if data[a:a + mid] == data[b:b + mid]:
+            lo = mid
+        else:
+            hi = mid - 1
+    return lo
+
+
+def lz_compress(data, window_bits=LZ_WINDOW_BITS, lookahead_bits=LZ_LOOKAHEAD_BITS):
+    """heatshrink bitstream with the ota_lz.h header (greedy hash-chain matcher)."""
+    window = 1 << window_bits
+    max_len = 1 << lookahead_bits
+    chains = {}
+    out = bytearray()
+    acc = nbits = 0
+
+    def put(value, bits):
+        nonlocal acc, nbits
+        acc = acc << bits | value
+        nbits += bits
+        while nbits >= 8:
+            nbits -= 8
+            out.append(acc >> nbits & 0xFF)
+        acc &= (1 << nbits) - 1
+
+    pos = 0
+    while pos < len(data):
+        best = best_offset = 0
+        limit = min(max_len, len(data) - pos)
+        for c in reversed(chains.get(data[pos:pos + LZ_MIN_MATCH], [])[-LZ_CHAIN:]):
+            if pos - c > window:
+                break
+            n = match_length(data, c, pos, limit)
+            if n > best:
+                best, best_offset = n, pos - c
+                if n == limit:
+                    break
+
+        if best >= LZ_MIN_MATCH:
+            put(0, 1)
+            put(best_offset - 1, window_bits)
+            put(best - 1, lookahead_bits)
+            step = best
+        else:
+            put(0x100 | data[pos], 9)
+            step = 1
+        for p in range(pos, min(pos + step, len(data) - LZ_MIN_MATCH + 1)):
+            chains.setdefault(data[p:p + LZ_MIN_MATCH], []).append(p)
+        pos += step
+
+    if nbits:
+        put(0, 8 - nbits)
+    return struct.pack("<BBI", window_bits, lookahead_bits, len(data)) + bytes(out)
+
+
+def lz_decompress(stream):
+    """Reference decoder, to check a compressed element before it ships."""
+    window_bits, lookahead_bits, size = struct.unpack_from("<BBI", stream)
+    bitpos = 8 * struct.calcsize("<BBI")
+
+    def get(bits):
+        nonlocal bitpos
+        value = 0
+        for _ in range(bits):
+            value = value << 1 | stream[bitpos >> 3] >> (7 - (bitpos & 7)) & 1
+            bitpos += 1
+        return value
+
+    out = bytearray()
+    while len(out) < size:
+        if get(1):
+            out.append(get(8))
+        else:
+            offset = get(window_bits) + 1
+            for _ in range(get(lookahead_bits) + 1):
+                out.append(out[-offset])
+    if len(out) != size or (bitpos + 7) >> 3 != len(stream):
+        raise ValueError("compressed stream does not match its size")
+    return bytes(out)
+
+
+def pack(elements, version, manufacturer=MANUFACTURER_CODE, image_type=IMAGE_TYPE, text=""):
+    """OTA file from (tag, payload) elements."""
+    body = b"".join(struct.pack("<HI", tag, len(payload)) + payload for tag, payload in elements)
+    header = struct.pack("<IHHHHHIH32sI", FILE_ID, HEADER_VERSION, FILE_HEADER_SIZE, 0,
+                         manufacturer, image_type, version, STACK_ZIGBEE_PRO,
+                         text.encode("ascii")[:32], FILE_HEADER_SIZE + len(body))
+    assert len(header) == FILE_HEADER_SIZE
+    return header + body
+
+
+def unpack(data):
+    """Header fields and (tag, payload) elements of an OTA file."""
+    (file_id, _hv, header_len, _fc, manufacturer, image_type, version, _stack,
+     text, total) = struct.unpack_from("<IHHHHHIH32sI", data)
+    if file_id != FILE_ID or total != len(data):
+        raise SystemExit("not a Zigbee OTA file (or truncated)")
+
+    elements = []
+    pos = header_len
+    while pos < total:
+        tag, length = struct.unpack_from("<HI", data, pos)
+        elements.append((tag, data[pos + ELEMENT_HEADER_SIZE:pos + ELEMENT_HEADER_SIZE + length]))
+        pos += ELEMENT_HEADER_SIZE + length
+    header = {
+        "manufacturer": manufacturer,
+        "image_type": image_type,
+        "version": version,
+        "text": text.rstrip(b"\0").decode("ascii", "replace"),
+        "size": total,
+    }
+    return header, elements
+
+
+def print_info(path):
+    with open(path, "rb") as f:
+        header, elements = unpack(f.read())
+    print(f"{path}: file 0x{header['version']:08x}, manufacturer 0x{header['manufacturer']:04x}, "
+          f"image type 0x{header['image_type']:04x}, {header['size']} bytes \"{header['text']}\"")
+    for tag, payload in elements:
+        print(f"  element 0x{tag:04x}: {len(payload)} bytes")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("firmware", nargs="?", default=DEFAULT_BIN, help="app binary (default: %(default)s)")
+    parser.add_argument("--version", type=lambda v: int(v, 0), help="file version, higher than the running one")
+    parser.add_argument("--manufacturer", type=lambda v: int(v, 0), default=MANUFACTURER_CODE)
+    parser.add_argument("--image-type", type=lambda v: int(v, 0), default=IMAGE_TYPE)
+    parser.add_argument("--text", default="ESP32-C6-MultiSensor", help="header string (32 chars max)")
+    parser.add_argument("--delta-from", metavar="OLD_BIN", help="make a delta against the app binary nodes run now")
+    parser.add_argument("--compress", action="store_true", help="send the image or delta LZ-compressed")
+    parser.add_argument("-o", "--output", help="output file (default: <firmware>-<version>.zigbee)")
+    parser.add_argument("--info", metavar="FILE", help="print the header and elements of an OTA file")
+    args = parser.parse_args()
+
+    if args.info:
+        print_info(args.info)
+        return
+    if args.version is None:
+        parser.error("--version is required")
+
+    with open(args.firmware, "rb") as f:
+        image = f.read()
+    check_app_image(image)
+
+    element = (TAG_UPGRADE_IMAGE, image)
+    suffix = ""
+    if args.delta_from:
+        with open(args.delta_from, "rb") as f:
+            old = f.read()
+        check_app_image(old)
+        patch = make_delta(old, image)
+        if apply_delta(old, patch) != image:
+            raise SystemExit("delta does not rebuild the image (bug)")
+        print(f"delta: {len(patch)} bytes for a {len(image)}-byte image ({len(image) / len(patch):.1f}x smaller)",
+              file=sys.stderr)
+        element = (TAG_DELTA_IMAGE, patch)
+        suffix = "-delta"
+
+    if args.compress:
+        tag, payload = element
+        packed = lz_compress(payload)
+        if lz_decompress(packed) != payload:
+            raise SystemExit("compressed stream does not decompress to the input (bug)")
+        print(f"compressed: {len(packed)} bytes from {len(payload)} ({len(payload) / len(packed):.2f}x)",
+              file=sys.stderr)
+        if len(packed) < len(payload):
+            element = (TAG_COMPRESSED_DELTA if tag == TAG_DELTA_IMAGE else TAG_COMPRESSED_IMAGE, packed)
+            suffix += "-lz"
+        else:
+            print("compression does not pay off, sending the element as is", file=sys.stderr)
+
+    data = pack([element], args.version, args.manufacturer, args.image_type, args.text)
+    output = args.output or f"{args.firmware.rsplit('.', 1)[0]}-{args.version:08x}{suffix}.zigbee"
+    with open(output, "wb") as f:
+        f.write(data)
+    print(f"{output}: {len(data)} bytes, {(len(data) + 222) // 223} blocks of 223 B", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,420 @@
+/*
+ * Runtime Configuration
+ *
+ * Two copies: `active` is what the firmware uses, `staged` is active plus
+ * the writes waiting for the commit alarm. Only the Zigbee task touches
+ * `staged`; `active` is replaced as a whole under the lock, so a reader
+ * never sees half of a write command.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "report_policy.h"
+#include "sensor_registry.h"
+#include "app_config.h"
+
+#define APP_CONFIG_NVS_NAMESPACE        "app_config"
+#define APP_CONFIG_NVS_KEY              "config"
+
+typedef struct {
+    uint16_t version;
+    uint16_t size;                      // Of the config that follows
+    app_config_t config;
+} app_config_blob_t;
+
+typedef struct {
+    uint8_t endpoint;
+    bool has_temperature;
+} sensor_entry_t;
+
+static const char *TAG = "APP_CONFIG";
+
+static const sensor_entry_t sensor_entries[APP_CONFIG_SENSOR_COUNT] = {
+    [APP_CONFIG_DHT11]   = { EP_DHT11_INDOOR, true },
+    [APP_CONFIG_DS18B20] = { EP_DS18B20_OUTDOOR, true },
+    [APP_CONFIG_BH1750]  = { EP_BH1750_LIGHT, false },
+    [APP_CONFIG_SHT4X]   = { EP_SHT4X_INDOOR, true },
+    [APP_CONFIG_BME280]  = { EP_BME280_INDOOR, true },
+};
+
+static const app_config_t defaults = {
+    .reporting_mode = ZIGBEE_REPORTING_MODE,
+    .interval_s = {
+        [APP_CONFIG_DHT11]   = DHT11_UPDATE_INTERVAL / 1000,
+        [APP_CONFIG_DS18B20] = DS18B20_UPDATE_INTERVAL / 1000,
+        [APP_CONFIG_BH1750]  = BH1750_UPDATE_INTERVAL / 1000,
+        [APP_CONFIG_SHT4X]   = SHT4X_UPDATE_INTERVAL / 1000,
+        [APP_CONFIG_BME280]  = BME280_UPDATE_INTERVAL / 1000,
+    },
+    .offset_centi = {
+        [APP_CONFIG_DHT11]   = (int16_t)(DHT11_OFFSET_C * 100),
+        [APP_CONFIG_DS18B20] = (int16_t)(DS18B20_OFFSET_C * 100),
+    },
+    .threshold = {
+        [APP_CONFIG_TEMPERATURE] = APP_CONFIG_THRESHOLD_TEMPERATURE,
+        [APP_CONFIG_HUMIDITY]    = APP_CONFIG_THRESHOLD_HUMIDITY,
+        [APP_CONFIG_ILLUMINANCE] = APP_CONFIG_THRESHOLD_ILLUMINANCE,
+        [APP_CONFIG_PRESSURE]    = APP_CONFIG_THRESHOLD_PRESSURE,
+    },
+    .heartbeat_s = APP_CONFIG_HEARTBEAT_S,
+};
+
+static portMUX_TYPE config_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_config_t active;
+static app_config_t staged;
+
+// Set by app_config_add_cluster(); 0 until then
+static uint8_t cluster_endpoint = 0;
+
+// Initial attribute value (copied into the ZCL attribute table at creation)
+static uint8_t attr_version = APP_CONFIG_VERSION;
+
+// ========================================
+// Validation
+// ========================================
+
+static bool interval_valid(uint16_t s)
+{
+    return s >= APP_CONFIG_INTERVAL_MIN_S && s <= APP_CONFIG_INTERVAL_MAX_S;
+}
+
+static bool offset_valid(int16_t centi)
+{
+    return centi >= -APP_CONFIG_OFFSET_MAX && centi <= APP_CONFIG_OFFSET_MAX;
+}
+
+static bool config_valid(const app_config_t *c)
+{
+    if (c->reporting_mode != REPORTING_MODE_EXPLICIT && c->reporting_mode != REPORTING_MODE_AUTOMATIC) {
+        return false;
+    }
+    for (int i = 0; i < APP_CONFIG_SENSOR_COUNT; i++) {
+        if (!interval_valid(c->interval_s[i]) || !offset_valid(c->offset_centi[i])) {
+            return false;
+        }
+    }
+    return c->heartbeat_s >= APP_CONFIG_HEARTBEAT_MIN_S;
+}
+
+// ========================================
+// NVS Persistence
+// ========================================
+
+/**
+ * Stored blob over the defaults. Returns ESP_ERR_NOT_FOUND without one
+ * (first boot) and ESP_ERR_INVALID_STATE for one that cannot be used.
+ */
+static esp_err_t load(app_config_t *config)
+{
+    nvs_handle_t handle;
+    app_config_blob_t blob;
+    size_t len = sizeof(blob);
+    const size_t header = offsetof(app_config_blob_t, config);
+
+    *config = defaults;
+
+    if (nvs_open(APP_CONFIG_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;  // Namespace not created yet (first boot)
+    }
+    esp_err_t ret = nvs_get_blob(handle, APP_CONFIG_NVS_KEY, &blob, &len);
+    nvs_close(handle);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (ret != ESP_OK || len < header || blob.size != len - header) {
+        return ESP_ERR_INVALID_STATE;  // Includes a longer blob from newer firmware
+    }
+
+    app_config_t loaded = defaults;
+    memcpy(&loaded, &blob.config, blob.size);
+    if (!config_valid(&loaded)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *config = loaded;
+    ESP_LOGI(TAG, "Loaded configuration v%u (%u bytes)", blob.version, blob.size);
+    return ESP_OK;
+}
+
+static esp_err_t store(const app_config_t *config)
+{
+    // nvs_set_blob keeps the old blob until the new one is fully written
+    app_config_blob_t blob = {
+        .version = APP_CONFIG_VERSION,
+        .size = sizeof(app_config_t),
+        .config = *config,
+    };
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(APP_CONFIG_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = nvs_set_blob(handle, APP_CONFIG_NVS_KEY, &blob, sizeof(blob));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
+
+// ========================================
+// Commit
+// ========================================
+
+static void set_attr(uint16_t attr_id, void *value)
+{
+    if (cluster_endpoint != 0) {
+        esp_zb_zcl_set_attribute_val(cluster_endpoint, APP_CONFIG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                     attr_id, value, false);
+    }
+}
+
+/**
+ * Put the attributes back to `config` (after a rejected write or a failed
+ * store)
+ */
+static void publish(app_config_t *config)
+{
+    for (int i = 0; i < APP_CONFIG_SENSOR_COUNT; i++) {
+        set_attr(APP_CONFIG_ATTR_INTERVAL_BASE + i, &config->interval_s[i]);
+        if (sensor_entries[i].has_temperature) {
+            set_attr(APP_CONFIG_ATTR_OFFSET_BASE + i, &config->offset_centi[i]);
+        }
+    }
+    for (int q = 0; q < APP_CONFIG_QUANTITY_COUNT; q++) {
+        set_attr(APP_CONFIG_ATTR_THRESHOLD_BASE + q, &config->threshold[q]);
+    }
+    set_attr(APP_CONFIG_ATTR_HEARTBEAT, &config->heartbeat_s);
+}
+
+/**
+ * Store the staged configuration and put it in effect (Zigbee task)
+ */
+static void commit(uint8_t param)
+{
+    esp_err_t ret = store(&staged);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store configuration (%s), previous one stays", esp_err_to_name(ret));
+        staged = active;
+        publish(&staged);
+        return;
+    }
+
+    taskENTER_CRITICAL(&config_lock);
+    active = staged;
+    taskEXIT_CRITICAL(&config_lock);
+
+    ESP_LOGI(TAG, "Configuration stored and applied");
+}
+
+static int sensor_index(uint8_t endpoint)
+{
+    for (int i = 0; i < APP_CONFIG_SENSOR_COUNT; i++) {
+        if (sensor_entries[i].endpoint == endpoint) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t app_config_init(void)
+{
+    esp_err_t ret = load(&active);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        ESP_LOGI(TAG, "No stored configuration, using defaults");
+        ret = ESP_OK;
+    } else if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Stored configuration unusable, using defaults");
+    }
+    staged = active;
+    return ret;
+}
+
+void app_config_get(app_config_t *config)
+{
+    taskENTER_CRITICAL(&config_lock);
+    *config = active;
+    taskEXIT_CRITICAL(&config_lock);
+}
+
+uint32_t app_config_interval_ms(uint8_t endpoint, uint32_t default_ms)
+{
+    int i = sensor_index(endpoint);
+    if (i < 0) {
+        return default_ms;
+    }
+
+    taskENTER_CRITICAL(&config_lock);
+    uint32_t interval_s = active.interval_s[i];
+    taskEXIT_CRITICAL(&config_lock);
+
+    return interval_s * 1000UL;
+}
+
+int16_t app_config_offset_centi(uint8_t endpoint)
+{
+    int i = sensor_index(endpoint);
+    if (i < 0) {
+        return 0;
+    }
+
+    taskENTER_CRITICAL(&config_lock);
+    int16_t centi = active.offset_centi[i];
+    taskEXIT_CRITICAL(&config_lock);
+
+    return centi;
+}
+
+uint16_t app_config_threshold(uint16_t cluster_id)
+{
+    app_config_quantity_t q;
+
+    switch (cluster_id) {
+    case ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT:
+        q = APP_CONFIG_TEMPERATURE;
+        break;
+    case ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT:
+        q = APP_CONFIG_HUMIDITY;
+        break;
+    case ESP_ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT:
+        q = APP_CONFIG_ILLUMINANCE;
+        break;
+    case ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT:
+        q = APP_CONFIG_PRESSURE;
+        break;
+    default:
+        return 0;
+    }
+
+    taskENTER_CRITICAL(&config_lock);
+    uint16_t threshold = active.threshold[q];
+    taskEXIT_CRITICAL(&config_lock);
+
+    return threshold;
+}
+
+uint32_t app_config_heartbeat_ms(void)
+{
+    taskENTER_CRITICAL(&config_lock);
+    uint32_t heartbeat_s = active.heartbeat_s;
+    taskEXIT_CRITICAL(&config_lock);
+
+    return heartbeat_s * 1000UL;
+}
+
+esp_err_t app_config_set_reporting_mode(uint8_t mode)
+{
+    if (mode != REPORTING_MODE_EXPLICIT && mode != REPORTING_MODE_AUTOMATIC) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Stored right away, together with any staged writes
+    esp_zb_scheduler_alarm_cancel(commit, 0);
+    staged.reporting_mode = mode;
+    commit(0);
+    return staged.reporting_mode == mode ? ESP_OK : ESP_FAIL;
+}
+
+void app_config_add_cluster(esp_zb_cluster_list_t *cluster_list, uint8_t endpoint)
+{
+    esp_zb_attribute_list_t *attrs = esp_zb_zcl_attr_list_create(APP_CONFIG_CLUSTER_ID);
+    const uint8_t ro = ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY;
+    const uint8_t rw = ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE;
+
+    esp_zb_custom_cluster_add_custom_attr(attrs, APP_CONFIG_ATTR_VERSION, ESP_ZB_ZCL_ATTR_TYPE_U8, ro, &attr_version);
+    for (int i = 0; i < APP_CONFIG_SENSOR_COUNT; i++) {
+        esp_zb_custom_cluster_add_custom_attr(attrs, APP_CONFIG_ATTR_INTERVAL_BASE + i,
+                                              ESP_ZB_ZCL_ATTR_TYPE_U16, rw, &staged.interval_s[i]);
+        if (sensor_entries[i].has_temperature) {
+            esp_zb_custom_cluster_add_custom_attr(attrs, APP_CONFIG_ATTR_OFFSET_BASE + i,
+                                                  ESP_ZB_ZCL_ATTR_TYPE_S16, rw, &staged.offset_centi[i]);
+        }
+    }
+    for (int q = 0; q < APP_CONFIG_QUANTITY_COUNT; q++) {
+        esp_zb_custom_cluster_add_custom_attr(attrs, APP_CONFIG_ATTR_THRESHOLD_BASE + q,
+                                              ESP_ZB_ZCL_ATTR_TYPE_U16, rw, &staged.threshold[q]);
+    }
+    esp_zb_custom_cluster_add_custom_attr(attrs, APP_CONFIG_ATTR_HEARTBEAT, ESP_ZB_ZCL_ATTR_TYPE_U16, rw,
+                                          &staged.heartbeat_s);
+
+    esp_zb_cluster_list_add_custom_cluster(cluster_list, attrs, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+    cluster_endpoint = endpoint;
+}
+
+static esp_err_t stage(uint16_t attr_id, const void *value)
+{
+    uint16_t u16;
+    int16_t s16;
+    memcpy(&u16, value, sizeof(u16));
+    memcpy(&s16, value, sizeof(s16));
+
+    if (attr_id >= APP_CONFIG_ATTR_INTERVAL_BASE && attr_id < APP_CONFIG_ATTR_INTERVAL_BASE + APP_CONFIG_SENSOR_COUNT) {
+        if (!interval_valid(u16)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        staged.interval_s[attr_id - APP_CONFIG_ATTR_INTERVAL_BASE] = u16;
+    } else if (attr_id >= APP_CONFIG_ATTR_OFFSET_BASE &&
+               attr_id < APP_CONFIG_ATTR_OFFSET_BASE + APP_CONFIG_SENSOR_COUNT &&
+               sensor_entries[attr_id - APP_CONFIG_ATTR_OFFSET_BASE].has_temperature) {
+        if (!offset_valid(s16)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        staged.offset_centi[attr_id - APP_CONFIG_ATTR_OFFSET_BASE] = s16;
+    } else if (attr_id >= APP_CONFIG_ATTR_THRESHOLD_BASE &&
+               attr_id < APP_CONFIG_ATTR_THRESHOLD_BASE + APP_CONFIG_QUANTITY_COUNT) {
+        staged.threshold[attr_id - APP_CONFIG_ATTR_THRESHOLD_BASE] = u16;
+    } else if (attr_id == APP_CONFIG_ATTR_HEARTBEAT) {
+        if (u16 < APP_CONFIG_HEARTBEAT_MIN_S) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        staged.heartbeat_s = u16;
+    } else {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_config_write_attr(uint16_t attr_id, const void *value)
+{
+    esp_err_t ret = stage(attr_id, value);
+    if (ret != ESP_OK) {
+        publish(&staged);
+        return ret;
+    }
+
+    // The other writes of the same command arrive before the alarm fires
+    esp_zb_scheduler_alarm_cancel(commit, 0);
+    esp_zb_scheduler_alarm(commit, 0, APP_CONFIG_COMMIT_DELAY_MS);
+    return ESP_OK;
+}
+
+esp_err_t app_config_reset(void)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(APP_CONFIG_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = nvs_erase_key(handle, APP_CONFIG_NVS_KEY);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        ret = ESP_OK;
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
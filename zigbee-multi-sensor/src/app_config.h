@@ -0,0 +1,149 @@
+/*
+ * Runtime Configuration
+ *
+ * Sampling intervals, calibration offsets, report thresholds and the
+ * reporting mode, loaded once at boot from one versioned NVS blob into
+ * RAM. The compile-time values (report_policy.h, the defaults below) are
+ * only the defaults for a board without a stored blob.
+ *
+ * Over Zigbee the values are attributes of a manufacturer-specific cluster
+ * (APP_CONFIG_CLUSTER_ID) on EP14, next to the reporting mode switch whose
+ * state is kept here too. The writes of one Write Attributes command are
+ * validated one by one, collected for APP_CONFIG_COMMIT_DELAY_MS and then
+ * stored as a single blob and applied together; a failed store keeps the
+ * previous configuration in effect and in the attributes. A group write
+ * retunes a whole fleet without reflashing.
+ *
+ * Attributes:
+ *   0x0000          U8   blob version (read-only)
+ *   0x0010 + s      U16  update interval of sensor s, seconds
+ *                        (APP_CONFIG_INTERVAL_MIN_S .. _MAX_S)
+ *   0x0020 + s      S16  temperature offset of sensor s, 0.01 °C
+ *                        (±APP_CONFIG_OFFSET_MAX), for a channel without
+ *                        calibration points (calibration.h); not present
+ *                        for the BH1750
+ *   0x0030 + q      U16  change threshold of quantity q, in MeasuredValue
+ *                        units; smaller changes are not sent in EXPLICIT
+ *                        mode (0: every sample is sent)
+ *   0x0038          U16  heartbeat, seconds: longest time a value below
+ *                        the threshold goes unreported
+ * with s an app_config_sensor_t and q an app_config_quantity_t.
+ *
+ * Blob layout: version (u16), size (u16), app_config_t. Fields are only
+ * ever appended; a shorter blob from an older version is read over the
+ * defaults, so added fields take their default.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_CONFIG_VERSION              1
+#define APP_CONFIG_CLUSTER_ID           0xFC00
+
+#define APP_CONFIG_ATTR_VERSION         0x0000
+#define APP_CONFIG_ATTR_INTERVAL_BASE   0x0010
+#define APP_CONFIG_ATTR_OFFSET_BASE     0x0020
+#define APP_CONFIG_ATTR_THRESHOLD_BASE  0x0030
+#define APP_CONFIG_ATTR_HEARTBEAT       0x0038
+
+#define APP_CONFIG_INTERVAL_MIN_S       10      // Longer than every oversampling burst
+#define APP_CONFIG_INTERVAL_MAX_S       3600
+#define APP_CONFIG_OFFSET_MAX           1000    // ±10 °C
+#define APP_CONFIG_HEARTBEAT_MIN_S      60
+#define APP_CONFIG_COMMIT_DELAY_MS      500
+
+// Temperature calibration offsets (°C) of a board without a stored blob,
+// added to the reading: negative if the sensor reads high
+#define DHT11_OFFSET_C                  -1.0f
+#define DS18B20_OFFSET_C                -1.0f
+
+// Change thresholds of a board without a stored blob (0: report every sample)
+#define APP_CONFIG_THRESHOLD_TEMPERATURE    0       // 0.01 °C
+#define APP_CONFIG_THRESHOLD_HUMIDITY       0       // 0.01 %
+#define APP_CONFIG_THRESHOLD_ILLUMINANCE    0       // 10000·log10(lux) + 1
+#define APP_CONFIG_THRESHOLD_PRESSURE       0       // 0.1 kPa
+#define APP_CONFIG_HEARTBEAT_S              900
+
+typedef enum {
+    APP_CONFIG_DHT11 = 0,
+    APP_CONFIG_DS18B20,
+    APP_CONFIG_BH1750,
+    APP_CONFIG_SHT4X,
+    APP_CONFIG_BME280,
+    APP_CONFIG_SENSOR_COUNT,
+} app_config_sensor_t;
+
+typedef enum {
+    APP_CONFIG_TEMPERATURE = 0,
+    APP_CONFIG_HUMIDITY,
+    APP_CONFIG_ILLUMINANCE,
+    APP_CONFIG_PRESSURE,
+    APP_CONFIG_QUANTITY_COUNT,
+} app_config_quantity_t;
+
+typedef struct {
+    uint8_t reporting_mode;             // REPORTING_MODE_* (report_policy.h)
+    uint8_t reserved;
+    uint16_t interval_s[APP_CONFIG_SENSOR_COUNT];
+    int16_t offset_centi[APP_CONFIG_SENSOR_COUNT];
+    uint16_t threshold[APP_CONFIG_QUANTITY_COUNT];
+    uint16_t heartbeat_s;
+} app_config_t;
+
+/**
+ * Load the stored configuration, or the defaults. Call once in app_main(),
+ * after nvs_flash_init().
+ */
+esp_err_t app_config_init(void);
+
+/**
+ * Copy of the configuration in effect.
+ */
+void app_config_get(app_config_t *config);
+
+/**
+ * Values for the sensor on `endpoint`; `default_ms` and 0 for an endpoint
+ * without an entry. The offset is in 0.01 °C.
+ */
+uint32_t app_config_interval_ms(uint8_t endpoint, uint32_t default_ms);
+int16_t app_config_offset_centi(uint8_t endpoint);
+
+/**
+ * Change threshold for a measurement cluster's MeasuredValue (0 for other
+ * clusters), and the heartbeat.
+ */
+uint16_t app_config_threshold(uint16_t cluster_id);
+uint32_t app_config_heartbeat_ms(void);
+
+/**
+ * Store the reporting mode (EP14 switch), REPORTING_MODE_*.
+ */
+esp_err_t app_config_set_reporting_mode(uint8_t mode);
+
+/**
+ * Add the configuration cluster to the cluster list of `endpoint`.
+ */
+void app_config_add_cluster(esp_zb_cluster_list_t *cluster_list, uint8_t endpoint);
+
+/**
+ * Validate and stage one attribute write (Zigbee task). Returns
+ * ESP_ERR_INVALID_ARG for a value out of range, ESP_ERR_NOT_SUPPORTED for
+ * a read-only or unknown attribute.
+ */
+esp_err_t app_config_write_attr(uint16_t attr_id, const void *value);
+
+/**
+ * Erase the stored blob; the defaults apply from the next boot.
+ */
+esp_err_t app_config_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
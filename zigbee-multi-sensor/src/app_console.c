@@ -0,0 +1,340 @@
+/*
+ * Serial Console
+ *
+ * The REPL installs the UART driver and switches the console to CRLF output;
+ * output is put back to plain LF afterwards so telemetry frames keep passing
+ * through unmodified (see sdkconfig.defaults).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "sdkconfig.h"
+#include "driver/uart_vfs.h"
+#include "app_config.h"
+#include "bench.h"
+#include "calibration.h"
+#include "crash_dump.h"
+#include "i2c_bus.h"
+#include "power.h"
+#include "report_policy.h"
+#include "sensor_registry.h"
+#include "zb_commissioning.h"
+#include "zb_ota.h"
+#include "zb_report.h"
+#include "zb_sleep.h"
+#include "app_console.h"
+
+#define CONSOLE_PROMPT          "msensor> "
+#define CONSOLE_MAX_CMDLINE     64
+
+static const char *TAG = "CONSOLE";
+
+// ========================================
+// Commands
+// ========================================
+
+static int cmd_bench(int argc, char **argv)
+{
+    static bench_result_t results[BENCH_MAX_CASES];
+
+    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
+        for (const char *const *name = bench_case_names(); *name; name++) {
+            printf("%s\n", *name);
+        }
+        return 0;
+    }
+
+    const char *filter = argc > 1 ? argv[1] : NULL;
+    size_t count = bench_run(filter, results, BENCH_MAX_CASES);
+    if (count == 0) {
+        printf("bench: no case matches '%s' (bench -l lists them)\n", filter);
+        return 1;
+    }
+    bench_report(results, count);
+    return 0;
+}
+
+static int cmd_i2c(int argc, char **argv)
+{
+    i2c_bus_stats_t stats;
+    i2c_bus_device_t devices[I2C_BUS_MAX_DEVICES];
+    size_t count = i2c_bus_get_stats(&stats, devices, I2C_BUS_MAX_DEVICES);
+
+    printf("bus: %s\n", i2c_bus_recovering() ? "RECOVERING" : "ok");
+    printf("transfers %lu  errors %lu  skipped %lu (backoff) %lu (recovery)\n",
+           (unsigned long)stats.transfers, (unsigned long)stats.errors,
+           (unsigned long)stats.backoff_skips, (unsigned long)stats.busy_skips);
+    printf("hangs %lu  recovered %lu  failed %lu  pulses %lu\n",
+           (unsigned long)stats.hangs, (unsigned long)stats.recoveries,
+           (unsigned long)stats.recovery_failures, (unsigned long)stats.recovery_pulses);
+    for (size_t i = 0; i < count; i++) {
+        printf("  0x%02X  %u consecutive failures, backoff %lu ms\n", devices[i].addr,
+               devices[i].failures, (unsigned long)devices[i].backoff_ms);
+    }
+    return 0;
+}
+
+static int cmd_join(int argc, char **argv)
+{
+    uint32_t mask;
+    zb_commissioning_stage_t stage = zb_commissioning_get_stage(&mask);
+
+    printf("stage %s  mask 0x%08lx  last join %lu ms\n", zb_commissioning_stage_name(stage),
+           (unsigned long)mask, (unsigned long)zb_commissioning_get_last_join_ms());
+    for (uint8_t ch = ZB_COMMISSIONING_FIRST_CHANNEL; ch <= ZB_COMMISSIONING_LAST_CHANNEL; ch++) {
+        zb_channel_stats_t stats;
+        if (!zb_commissioning_get_channel_stats(ch, &stats) || stats.attempts == 0) {
+            continue;
+        }
+        printf("  ch%-2u  attempts %u  joins %u  scan %lu ms\n", ch, stats.attempts, stats.successes,
+               (unsigned long)stats.scan_ms);
+    }
+    return 0;
+}
+
+static int cmd_sensors(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "forget") == 0) {
+        esp_err_t ret = sensor_registry_forget();
+        printf("sensors: %s\n", ret == ESP_OK ? "seen set cleared, takes effect on reboot" : esp_err_to_name(ret));
+        return ret == ESP_OK ? 0 : 1;
+    }
+
+    for (size_t i = 0; i < sensor_registry_count(); i++) {
+        const sensor_driver_t *driver = sensor_registry_get(i);
+        sensor_health_t h;
+        if (!sensor_registry_health(i, &h)) {
+            continue;
+        }
+        printf("EP%-3u %-8s %-8s avail %u.%u%%  samples %lu  errors %lu  skipped %lu  failed %lu  reprobes %lu  recovered %lu",
+               driver->endpoint, driver->name, sensor_registry_state_name(h.state),
+               h.availability_permille / 10, h.availability_permille % 10,
+               (unsigned long)h.samples, (unsigned long)h.errors, (unsigned long)h.skipped, (unsigned long)h.failures,
+               (unsigned long)h.reprobes, (unsigned long)h.recoveries);
+        if (h.state == SENSOR_HEALTH_FAILED) {
+            printf("  re-probe backoff %lu ms", (unsigned long)h.backoff_ms);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+static int cmd_crash(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+        esp_err_t ret = crash_dump_clear();
+        printf("crash: %s\n", ret == ESP_OK ? "cleared" : esp_err_to_name(ret));
+        return ret == ESP_OK ? 0 : 1;
+    }
+
+    const uint8_t *record;
+    size_t len = crash_dump_get(&record);
+    if (len == 0) {
+        printf("crash: none stored\n");
+        return 0;
+    }
+
+    // One hex line for crash_decode.py
+    printf("crash: ");
+    for (size_t i = 0; i < len; i++) {
+        printf("%02x", record[i]);
+    }
+    printf("\n");
+    return 0;
+}
+
+static int cmd_ota(int argc, char **argv)
+{
+    static const char *state_names[] = { "idle", "downloading", "verifying", "verified", "failed" };
+    zb_ota_status_t s;
+    zb_ota_get_status(&s);
+
+    printf("ota: running file 0x%08lx, state %s\n", (unsigned long)ZB_OTA_FILE_VERSION, state_names[s.state]);
+    if (s.state == ZB_OTA_IDLE) {
+        return 0;
+    }
+
+    uint32_t sent = s.received - s.resumed_from;
+    const char *kind = s.delta ? (s.compressed ? " (compressed delta)" : " (delta)")
+                               : (s.compressed ? " (compressed)" : "");
+    printf("  file 0x%08lx%s: %lu/%lu received, %lu/%lu flashed, resumed from %lu\n",
+           (unsigned long)s.file_version, kind, (unsigned long)s.received,
+           (unsigned long)s.image_size, (unsigned long)s.written, (unsigned long)s.app_size,
+           (unsigned long)s.resumed_from);
+    printf("  %lu blocks of up to %u B in %lu s (%lu B/s), peak queue %u B\n",
+           (unsigned long)s.blocks, s.block_size, (unsigned long)(s.elapsed_ms / 1000),
+           (unsigned long)(s.elapsed_ms ? sent * 1000ULL / s.elapsed_ms : 0), s.peak_queued);
+    return 0;
+}
+
+static unsigned permille(uint32_t part, uint32_t whole)
+{
+    return whole ? (unsigned)((uint64_t)part * 1000 / whole) : 0;
+}
+
+static int cmd_power(int argc, char **argv)
+{
+    power_stats_t s;
+    power_get_stats(&s);
+
+    printf("power: %s, DFS %d-%d MHz, light sleep %s, up %lu s\n",
+           s.enabled ? "managed" : "off", POWER_MIN_FREQ_MHZ, POWER_MAX_FREQ_MHZ,
+           s.light_sleep ? "on" : "off", (unsigned long)(s.uptime_ms / 1000));
+    unsigned p = permille(s.sleep_ms, s.uptime_ms);
+    printf("  light sleep  %lu times  %lu ms  %u.%u%%\n", (unsigned long)s.sleeps,
+           (unsigned long)s.sleep_ms, p / 10, p % 10);
+    for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+        p = permille(s.locks[i].held_ms, s.uptime_ms);
+        printf("  %-11s  %lu times  %lu ms  %u.%u%%\n", power_lock_name(i),
+               (unsigned long)s.locks[i].acquired, (unsigned long)s.locks[i].held_ms, p / 10, p % 10);
+    }
+#if CONFIG_ZB_ZED
+    zb_sleep_stats_t zs;
+    zb_report_batch_stats_t b;
+    zb_sleep_get_stats(&zs);
+    zb_report_get_batch_stats(&b);
+    printf("  zigbee sleep %lu times  %lu ms\n", (unsigned long)zs.sleeps, (unsigned long)zs.sleep_ms);
+    printf("  report windows %lu  reports %lu  merged %lu  overflows %lu\n", (unsigned long)b.windows,
+           (unsigned long)b.reports, (unsigned long)b.merged, (unsigned long)b.overflows);
+#endif
+#if CONFIG_PM_PROFILING
+    // Time in each CPU mode and every driver's lock
+    esp_pm_dump_locks(stdout);
+#endif
+    return 0;
+}
+
+static int cmd_config(int argc, char **argv)
+{
+    static const char *const sensor_names[APP_CONFIG_SENSOR_COUNT] = {
+        "dht11", "ds18b20", "bh1750", "sht4x", "bme280",
+    };
+    static const char *const quantity_names[APP_CONFIG_QUANTITY_COUNT] = {
+        "temperature", "humidity", "illuminance", "pressure",
+    };
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        esp_err_t ret = app_config_reset();
+        printf("config: %s\n", ret == ESP_OK ? "stored configuration erased, defaults on reboot" : esp_err_to_name(ret));
+        return ret == ESP_OK ? 0 : 1;
+    }
+
+    app_config_t c;
+    app_config_get(&c);
+    printf("config: v%d, reporting %s, heartbeat %u s, suppressed %lu\n", APP_CONFIG_VERSION,
+           c.reporting_mode == REPORTING_MODE_EXPLICIT ? "explicit" : "automatic", c.heartbeat_s,
+           (unsigned long)zb_report_get_suppressed());
+    for (int i = 0; i < APP_CONFIG_SENSOR_COUNT; i++) {
+        int offset = abs(c.offset_centi[i]);
+        printf("  %-8s every %4u s  offset %c%d.%02d C\n", sensor_names[i], c.interval_s[i],
+               c.offset_centi[i] < 0 ? '-' : '+', offset / 100, offset % 100);
+    }
+    for (int q = 0; q < APP_CONFIG_QUANTITY_COUNT; q++) {
+        printf("  %-11s threshold %u\n", quantity_names[q], c.threshold[q]);
+    }
+    return 0;
+}
+
+static int cmd_cal(int argc, char **argv)
+{
+    for (int c = 0; c < CALIBRATION_CHANNEL_COUNT; c++) {
+        calibration_point_t points[CALIBRATION_MAX_POINTS];
+        size_t count = calibration_get_points(c, points);
+        printf("%-9s %u points", calibration_channel_name(c), (unsigned)count);
+        for (size_t i = 0; i < count; i++) {
+            printf("  %d->%d", points[i].raw, points[i].ref);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t app_console_start(void)
+{
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    esp_console_dev_uart_config_t uart_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+
+    repl_config.prompt = CONSOLE_PROMPT;
+    repl_config.max_cmdline_length = CONSOLE_MAX_CMDLINE;
+
+    esp_err_t ret = esp_console_new_repl_uart(&uart_config, &repl_config, &repl);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create REPL: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    uart_vfs_dev_port_set_tx_line_endings(uart_config.channel, ESP_LINE_ENDINGS_LF);
+
+    const esp_console_cmd_t bench_cmd = {
+        .command = "bench",
+        .help = "Run the microbenchmark suite: bench [-l] [filter]",
+        .func = cmd_bench,
+    };
+    esp_console_cmd_register(&bench_cmd);
+
+    const esp_console_cmd_t i2c_cmd = {
+        .command = "i2c",
+        .help = "Show I2C bus health counters and per-address backoff",
+        .func = cmd_i2c,
+    };
+    esp_console_cmd_register(&i2c_cmd);
+
+    const esp_console_cmd_t join_cmd = {
+        .command = "join",
+        .help = "Show the commissioning stage and per-channel scan time and joins",
+        .func = cmd_join,
+    };
+    esp_console_cmd_register(&join_cmd);
+
+    const esp_console_cmd_t sensors_cmd = {
+        .command = "sensors",
+        .help = "Show sensor health and availability: sensors [forget]",
+        .func = cmd_sensors,
+    };
+    esp_console_cmd_register(&sensors_cmd);
+
+    const esp_console_cmd_t crash_cmd = {
+        .command = "crash",
+        .help = "Print the stored crash record as hex (crash_decode.py), or erase it: crash [clear]",
+        .func = cmd_crash,
+    };
+    esp_console_cmd_register(&crash_cmd);
+
+    const esp_console_cmd_t ota_cmd = {
+        .command = "ota",
+        .help = "Show OTA download progress, throughput and resume point",
+        .func = cmd_ota,
+    };
+    esp_console_cmd_register(&ota_cmd);
+
+    const esp_console_cmd_t power_cmd = {
+        .command = "power",
+        .help = "Show light sleep and power lock time, and esp_pm mode statistics",
+        .func = cmd_power,
+    };
+    esp_console_cmd_register(&power_cmd);
+
+    const esp_console_cmd_t config_cmd = {
+        .command = "config",
+        .help = "Show the runtime configuration, or erase the stored one: config [reset]",
+        .func = cmd_config,
+    };
+    esp_console_cmd_register(&config_cmd);
+
+    const esp_console_cmd_t cal_cmd = {
+        .command = "cal",
+        .help = "Show every channel's calibration points (raw->reference, 0.01 units)",
+        .func = cmd_cal,
+    };
+    esp_console_cmd_register(&cal_cmd);
+    esp_console_register_help_command();
+
+    return esp_console_start_repl(repl);
+}
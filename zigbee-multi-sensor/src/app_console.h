@@ -0,0 +1,39 @@
+/*
+ * Serial Console
+ *
+ * esp_console REPL on the console UART, sharing it with log text and the
+ * binary telemetry stream. Commands:
+ *
+ *   bench [-l] [filter]    run the microbenchmark suite (bench.h), or list cases
+ *   i2c                    bus health counters and per-address backoff (i2c_bus.h)
+ *   join                   commissioning stage, and scan time and joins per
+ *                          channel (zb_commissioning.h)
+ *   sensors [forget]       per-sensor health state and availability, or clear
+ *                          the NVS set of seen parts (sensor_registry.h)
+ *   crash [clear]          stored crash record as hex, or erase it (crash_dump.h)
+ *   ota                    OTA download progress and throughput (zb_ota.h)
+ *   power                  light sleep and power lock time (power.h), plus
+ *                          esp_pm's per-mode times with CONFIG_PM_PROFILING;
+ *                          stack sleeps and report windows on an end device
+ *                          (zb_sleep.h)
+ *   config [reset]         runtime intervals, offsets and thresholds, or erase
+ *                          the stored ones (app_config.h)
+ *   cal                    calibration points per channel (calibration.h)
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Register the commands and start the REPL task.
+ */
+esp_err_t app_console_start(void);
+
+#ifdef __cplusplus
+}
+#endif
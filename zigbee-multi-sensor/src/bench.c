@@ -0,0 +1,398 @@
+/*
+ * Microbenchmark Suite
+ *
+ * Cases run on the calling task with interrupts and preemption left on, as
+ * the code runs in the firmware; the median is the number to track, the
+ * minimum is the undisturbed cost. Inputs cycle through small tables so
+ * branches see realistic data rather than one constant.
+ */
+
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "calibration.h"
+#include "derived.h"
+#include "onewire.h"
+#include "sensor_codec.h"
+#include "sensor_filter.h"
+#include "report_tracker.h"
+#include "status_led.h"
+#include "telemetry.h"
+#include "bench.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HOST_TSC      1
+#endif
+#else
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#endif
+
+#define BENCH_RECORD_SIZE   (2 + 4 * 4 + 2 + BENCH_NAME_LEN)
+#define BENCH_INPUTS        8       // Power of two; inputs are indexed with & (BENCH_INPUTS - 1)
+
+static const char *TAG = "BENCH";
+
+typedef struct {
+    const char *name;
+    uint16_t batch;                 // Calls per timed sample
+    void (*setup)(void);
+    void (*run)(uint32_t i);
+    void (*teardown)(void);
+} bench_case_t;
+
+static volatile uint32_t sink;      // Keeps results observable so calls are not elided
+
+// ========================================
+// Cycle Counter
+// ========================================
+
+#if CONFIG_IDF_TARGET_LINUX
+static uint64_t host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+static inline uint32_t ticks_now(void)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    return esp_cpu_get_cycle_count();
+#elif BENCH_HOST_TSC
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)host_ns();
+#endif
+}
+
+uint32_t bench_ticks_per_us(void)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    return esp_rom_get_cpu_ticks_per_us();
+#elif BENCH_HOST_TSC
+    static uint32_t tsc_per_us = 0;
+    if (tsc_per_us == 0) {
+        // Calibrate the TSC against the monotonic clock over ~20 ms
+        uint64_t ns0 = host_ns();
+        uint64_t tsc0 = __rdtsc();
+        while (host_ns() - ns0 < 20000000ULL) {
+        }
+        tsc_per_us = (uint32_t)((__rdtsc() - tsc0) * 1000 / (host_ns() - ns0));
+    }
+    return tsc_per_us;
+#else
+    return 1000;
+#endif
+}
+
+// ========================================
+// Cases
+// ========================================
+
+static const uint8_t dht11_frames[BENCH_INPUTS][DHT11_FRAME_SIZE] = {
+    { 45, 0, 22, 0, 67 }, { 50, 0, 21, 0, 71 }, { 38, 0, 24, 0, 62 }, { 60, 0, 19, 0, 79 },
+    { 72, 0, 18, 0, 90 }, { 30, 0, 26, 0, 56 }, { 55, 0, 20, 0, 75 }, { 41, 0, 23, 0, 64 },
+};
+
+static const uint16_t bh1750_counts[BENCH_INPUTS] = { 0, 1, 12, 120, 1200, 12000, 48000, 65535 };
+
+// 85 °C (power-on value), 25.0625, 10.125, 0.5, -0.5, -10.125, -55, 125 °C
+static const int16_t ds18b20_raws[BENCH_INPUTS] = {
+    0x0550, 0x0191, 0x00A2, 0x0008, -8, -162, -880, 0x07D0,
+};
+
+// Every gate enabled and the widest window, so the worst-case path is timed
+static const sensor_filter_config_t filter_cfg = {
+    .median_window = SENSOR_FILTER_MAX_WINDOW,
+    .ema_shift = 2,
+    .min = -5500, .max = 12500,
+    .reject_sentinel = true,
+    .sentinel = 8500,
+    .max_slew_per_s = 10,
+};
+
+// 0.01 °C around 21 °C, with one 85 °C sentinel
+static const int32_t filter_inputs[BENCH_INPUTS] = {
+    2100, 2106, 2094, 2112, 8500, 2100, 2088, 2103,
+};
+
+static sensor_filter_t filter;
+
+// A full table (longest segment search), about a DHT11's spread
+static const calibration_point_t cal_points[CALIBRATION_MAX_POINTS] = {
+    { -1000, -1130 }, { 0, -80 }, { 1000, 960 }, { 1800, 1710 },
+    { 2200, 2085 }, { 2600, 2470 }, { 3500, 3330 }, { 5000, 4790 },
+};
+
+// 0.01 °C, below, inside and beyond the points
+static const int32_t cal_inputs[BENCH_INPUTS] = {
+    -2000, -500, 950, 2100, 2350, 2999, 4800, 6000,
+};
+
+static calibration_table_t cal_table;
+
+// 0.01 °C and 0.01 %RH; the warm, damp pairs take the heat index regression
+static const int16_t derived_temps[BENCH_INPUTS] = { -1500, 500, 1800, 2150, 2600, 3000, 3400, 3900 };
+static const uint16_t derived_humidities[BENCH_INPUTS] = { 8000, 6500, 4500, 5200, 9000, 7000, 1000, 5500 };
+
+static void onewire_setup(void)
+{
+    gpio_reset_pin(BENCH_ONEWIRE_GPIO);
+    gpio_set_direction(BENCH_ONEWIRE_GPIO, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(BENCH_ONEWIRE_GPIO, GPIO_PULLUP_ONLY);
+}
+
+static void onewire_teardown(void)
+{
+    gpio_reset_pin(BENCH_ONEWIRE_GPIO);
+}
+
+static void onewire_write_case(uint32_t i)
+{
+    onewire_write_byte(BENCH_ONEWIRE_GPIO, (uint8_t)(0xA5 ^ i));
+}
+
+static void onewire_read_case(uint32_t i)
+{
+    sink = onewire_read_byte(BENCH_ONEWIRE_GPIO);
+}
+
+static void dht11_decode_case(uint32_t i)
+{
+    float temperature, humidity;
+    if (sensor_codec_dht11_decode(dht11_frames[i & (BENCH_INPUTS - 1)], &temperature, &humidity) == ESP_OK) {
+        sink = (uint32_t)(temperature + humidity);
+    }
+}
+
+static void bh1750_to_zcl_case(uint32_t i)
+{
+    sink = sensor_codec_lux_to_zcl(sensor_codec_bh1750_lux(bh1750_counts[i & (BENCH_INPUTS - 1)]));
+}
+
+static void temp_to_zcl_case(uint32_t i)
+{
+    sink = (uint16_t)sensor_codec_celsius_to_zcl(sensor_codec_ds18b20_celsius(ds18b20_raws[i & (BENCH_INPUTS - 1)]));
+}
+
+static void filter_setup(void)
+{
+    sensor_filter_init(&filter, &filter_cfg);
+}
+
+static void filter_push_case(uint32_t i)
+{
+    int32_t out = 0;
+    // One second apart, so the slew gate passes the non-sentinel inputs
+    sensor_filter_push(&filter, filter_inputs[i & (BENCH_INPUTS - 1)], i * 1000, &out);
+    sink = (uint32_t)out;
+}
+
+static void calibrate_setup(void)
+{
+    calibration_build(&cal_table, cal_points, CALIBRATION_MAX_POINTS);
+}
+
+static void calibrate_case(uint32_t i)
+{
+    sink = (uint32_t)calibration_eval(&cal_table, cal_inputs[i & (BENCH_INPUTS - 1)]);
+}
+
+static void derived_case(uint32_t i)
+{
+    int16_t temp = derived_temps[i & (BENCH_INPUTS - 1)];
+    uint16_t humidity = derived_humidities[i & (BENCH_INPUTS - 1)];
+    sink = (uint32_t)(derived_dew_point(temp, humidity) + derived_absolute_humidity(temp, humidity) +
+                      derived_heat_index(temp, humidity));
+}
+
+static void report_track_setup(void)
+{
+    report_tracker_save_tsns();
+}
+
+static void report_track_case(uint32_t i)
+{
+    report_tracker_enqueue(BENCH_ENDPOINT, 0x0402, (uint8_t)i);
+    report_tracker_confirm(BENCH_ENDPOINT, (uint8_t)i, ESP_OK);
+}
+
+static void report_track_teardown(void)
+{
+    report_tracker_forget_endpoint(BENCH_ENDPOINT);
+    report_tracker_restore_tsns();
+}
+
+static void led_dispatch_case(uint32_t i)
+{
+    status_led_set((status_led_pattern_t)(1 + i % (STATUS_LED_PATTERN_COUNT - 1)));
+}
+
+static void led_dispatch_teardown(void)
+{
+    status_led_set(STATUS_LED_OFF);
+}
+
+static void loop_overhead_case(uint32_t i)
+{
+    sink = i;
+}
+
+static const bench_case_t cases[] = {
+    { "onewire_write",  1,  onewire_setup, onewire_write_case,  onewire_teardown },
+    { "onewire_read",   1,  onewire_setup, onewire_read_case,   onewire_teardown },
+    { "dht11_decode",   64, NULL,          dht11_decode_case,   NULL },
+    { "bh1750_to_zcl",  64, NULL,          bh1750_to_zcl_case,  NULL },
+    { "temp_to_zcl",    64, NULL,          temp_to_zcl_case,    NULL },
+    { "filter_push",    64, filter_setup,  filter_push_case,    NULL },
+    { "calibrate",      64, calibrate_setup, calibrate_case,    NULL },
+    { "derived",        64, NULL,          derived_case,        NULL },
+    { "report_track",   16, report_track_setup, report_track_case,   report_track_teardown },
+    { "led_dispatch",   4,  NULL,          led_dispatch_case,   led_dispatch_teardown },
+    { "loop_overhead",  64, NULL,          loop_overhead_case,  NULL },
+};
+
+#define CASE_COUNT  (sizeof(cases) / sizeof(cases[0]))
+
+_Static_assert(CASE_COUNT <= BENCH_MAX_CASES, "raise BENCH_MAX_CASES");
+
+// ========================================
+// Measurement
+// ========================================
+
+static uint32_t time_batch(const bench_case_t *c, uint32_t *input)
+{
+    uint32_t start = ticks_now();
+    for (uint16_t n = 0; n < c->batch; n++) {
+        c->run((*input)++);
+    }
+    return (ticks_now() - start) / c->batch;
+}
+
+static void run_case(const bench_case_t *c, bench_result_t *result)
+{
+    uint32_t samples[BENCH_SAMPLES];
+    uint32_t input = 0;
+
+    if (c->setup) {
+        c->setup();
+    }
+
+    time_batch(c, &input);      // Warm caches and branch predictors
+    for (int s = 0; s < BENCH_SAMPLES; s++) {
+        uint32_t value = time_batch(c, &input);
+
+        // Insertion sort as we go; BENCH_SAMPLES is small
+        int j = s;
+        while (j > 0 && samples[j - 1] > value) {
+            samples[j] = samples[j - 1];
+            j--;
+        }
+        samples[j] = value;
+    }
+
+    if (c->teardown) {
+        c->teardown();
+    }
+
+    strncpy(result->name, c->name, BENCH_NAME_LEN - 1);
+    result->name[BENCH_NAME_LEN - 1] = '\0';
+    result->calls = (uint32_t)BENCH_SAMPLES * c->batch;
+    result->cycles_min = samples[0];
+    result->cycles_median = samples[BENCH_SAMPLES / 2];
+    result->cycles_max = samples[BENCH_SAMPLES - 1];
+}
+
+// ========================================
+// Output
+// ========================================
+
+static void put_u32(uint8_t **p, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        *(*p)++ = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+static uint32_t ticks_to_ns(uint32_t ticks, uint32_t ticks_per_us)
+{
+    return (uint32_t)(((uint64_t)ticks * 1000 + ticks_per_us / 2) / ticks_per_us);
+}
+
+// ========================================
+// Public API
+// ========================================
+
+const char *const *bench_case_names(void)
+{
+    static const char *names[CASE_COUNT + 1];
+
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        names[i] = cases[i].name;
+    }
+    names[CASE_COUNT] = NULL;
+    return names;
+}
+
+size_t bench_run(const char *filter, bench_result_t *results, size_t max_results)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < CASE_COUNT && count < max_results; i++) {
+        if (filter && filter[0] && !strstr(cases[i].name, filter)) {
+            continue;
+        }
+        run_case(&cases[i], &results[count++]);
+    }
+    return count;
+}
+
+void bench_report(const bench_result_t *results, size_t count)
+{
+    uint32_t ticks_per_us = bench_ticks_per_us();
+
+    ESP_LOGI(TAG, "%-16s %7s %9s %9s %9s %10s", "case", "calls", "min", "median", "max", "median ns");
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        uint8_t record[BENCH_RECORD_SIZE] = { 0 };
+        uint8_t *p = record;
+
+        ESP_LOGI(TAG, "%-16s %7lu %9lu %9lu %9lu %10lu", r->name, (unsigned long)r->calls,
+                 (unsigned long)r->cycles_min, (unsigned long)r->cycles_median,
+                 (unsigned long)r->cycles_max, (unsigned long)ticks_to_ns(r->cycles_median, ticks_per_us));
+
+        *p++ = (uint8_t)i;
+        *p++ = (uint8_t)count;
+        put_u32(&p, r->calls);
+        put_u32(&p, r->cycles_min);
+        put_u32(&p, r->cycles_median);
+        put_u32(&p, r->cycles_max);
+        *p++ = ticks_per_us & 0xFF;
+        *p++ = (ticks_per_us >> 8) & 0xFF;
+        strncpy((char *)p, r->name, BENCH_NAME_LEN);   // Zero-padded, not terminated
+        telemetry_send(TELEM_REC_BENCH, record, sizeof(record));
+    }
+}
+
+void bench_write_json(FILE *out, const bench_result_t *results, size_t count)
+{
+    uint32_t ticks_per_us = bench_ticks_per_us();
+
+    fprintf(out, "{\n  \"target\": \"%s\",\n  \"ticks_per_us\": %lu,\n  \"results\": [\n",
+            CONFIG_IDF_TARGET, (unsigned long)ticks_per_us);
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"calls\": %lu, \"cycles_min\": %lu, \"cycles_median\": %lu, "
+                "\"cycles_max\": %lu, \"ns_median\": %lu}%s\n",
+                r->name, (unsigned long)r->calls, (unsigned long)r->cycles_min,
+                (unsigned long)r->cycles_median, (unsigned long)r->cycles_max,
+                (unsigned long)ticks_to_ns(r->cycles_median, ticks_per_us), i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
@@ -0,0 +1,75 @@
+/*
+ * Microbenchmark Suite
+ *
+ * Times the driver and encoding hot paths with the CPU cycle counter
+ * (esp_cpu_get_cycle_count() on target; rdtsc, or clock_gettime() in ns on
+ * non-x86 hosts, in the host simulator build):
+ *
+ *   onewire_write     1-Wire byte write (on BENCH_ONEWIRE_GPIO, not the DS18B20 bus)
+ *   onewire_read      1-Wire byte read
+ *   dht11_decode      DHT11 frame checksum + decode
+ *   bh1750_to_zcl     BH1750 count → lux → ZCL log encoding
+ *   temp_to_zcl       DS18B20 fixed-point → °C → ZCL 0.01 °C
+ *   filter_push       sensor_filter gates + 7-sample median + EMA
+ *   report_track      report_tracker enqueue + APS confirm
+ *   led_dispatch      status LED pattern dispatch + strip refresh
+ *   loop_overhead     empty case; subtract from the others for tight loops
+ *
+ * Each case runs BENCH_SAMPLES timed samples of `batch` calls after a
+ * warm-up; min/median/max are per call. Results go to the log, to
+ * TELEM_REC_BENCH telemetry records (bench.py record) and, on the host, to
+ * a JSON file (bench.py compare).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BENCH_SAMPLES                   31
+#define BENCH_MAX_CASES                 12
+#define BENCH_NAME_LEN                  16
+#define BENCH_ONEWIRE_GPIO              7       // Free pin on the ESP32-C6-Zero
+#define BENCH_ENDPOINT                  0xEF    // Never registered; cleared after the run
+
+typedef struct {
+    char name[BENCH_NAME_LEN];
+    uint32_t calls;                 // Timed calls across all samples
+    uint32_t cycles_min;            // Per call
+    uint32_t cycles_median;
+    uint32_t cycles_max;
+} bench_result_t;
+
+/**
+ * Run every case whose name contains `filter` (NULL or "" runs all).
+ * Returns the number of results written.
+ */
+size_t bench_run(const char *filter, bench_result_t *results, size_t max_results);
+
+/**
+ * Counter ticks per microsecond (CPU MHz on target).
+ */
+uint32_t bench_ticks_per_us(void);
+
+/**
+ * Names of all cases, NULL-terminated.
+ */
+const char *const *bench_case_names(void);
+
+/**
+ * Log a results table and send one TELEM_REC_BENCH record per result.
+ */
+void bench_report(const bench_result_t *results, size_t count);
+
+/**
+ * Write results as JSON (the format bench.py compares).
+ */
+void bench_write_json(FILE *out, const bench_result_t *results, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
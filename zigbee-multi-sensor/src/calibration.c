@@ -0,0 +1,304 @@
+/*
+ * Multi-point Calibration
+ *
+ * Sensor tasks correct samples, the Zigbee task changes tables; a change is
+ * built and stored first and then swapped in under the lock, so a sample
+ * is corrected by either the old table or the new one.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "app_config.h"
+#include "sensor_registry.h"
+#include "calibration.h"
+
+#define CALIBRATION_NVS_NAMESPACE       "calibration"
+#define CALIBRATION_BLOB_VERSION        1
+
+typedef struct {
+    uint8_t version;
+    uint8_t count;
+    calibration_point_t points[CALIBRATION_MAX_POINTS];  // Only `count` stored
+} calibration_blob_t;
+
+typedef struct {
+    const char *name;                   // Also the NVS key
+    uint8_t endpoint;
+    bool temperature;                   // Falls back to the app_config offset
+} channel_info_t;
+
+typedef struct {
+    calibration_table_t table;
+    int32_t last_raw;
+    bool has_raw;
+} channel_state_t;
+
+static const char *TAG = "CALIBRATION";
+
+static const channel_info_t channels[CALIBRATION_CHANNEL_COUNT] = {
+    [CALIBRATION_DHT11_TEMPERATURE]   = { "dht11_t",   EP_DHT11_INDOOR,    true },
+    [CALIBRATION_DHT11_HUMIDITY]      = { "dht11_rh",  EP_DHT11_INDOOR,    false },
+    [CALIBRATION_DS18B20_TEMPERATURE] = { "ds18b20_t", EP_DS18B20_OUTDOOR, true },
+    [CALIBRATION_SHT4X_TEMPERATURE]   = { "sht4x_t",   EP_SHT4X_INDOOR,    true },
+    [CALIBRATION_SHT4X_HUMIDITY]      = { "sht4x_rh",  EP_SHT4X_INDOOR,    false },
+    [CALIBRATION_BME280_TEMPERATURE]  = { "bme280_t",  EP_BME280_INDOOR,   true },
+    [CALIBRATION_BME280_HUMIDITY]     = { "bme280_rh", EP_BME280_INDOOR,   false },
+};
+
+static portMUX_TYPE cal_lock = portMUX_INITIALIZER_UNLOCKED;
+static channel_state_t state[CALIBRATION_CHANNEL_COUNT];
+
+// Set by calibration_add_cluster(); 0 until then
+static uint8_t cluster_endpoint = 0;
+
+// Initial attribute values (copied into the ZCL attribute table at creation)
+static uint8_t attr_points[CALIBRATION_CHANNEL_COUNT];
+
+// ========================================
+// NVS Persistence
+// ========================================
+
+static esp_err_t load(calibration_channel_t channel, calibration_table_t *table)
+{
+    nvs_handle_t handle;
+    calibration_blob_t blob;
+    size_t len = sizeof(blob);
+    const size_t header = offsetof(calibration_blob_t, points);
+
+    if (nvs_open(CALIBRATION_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;  // Namespace not created yet (first boot)
+    }
+    esp_err_t ret = nvs_get_blob(handle, channels[channel].name, &blob, &len);
+    nvs_close(handle);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (ret != ESP_OK || len < header || blob.version != CALIBRATION_BLOB_VERSION ||
+        len != header + blob.count * sizeof(calibration_point_t)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return calibration_build(table, blob.points, blob.count) == ESP_OK ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t store(calibration_channel_t channel, const calibration_table_t *table)
+{
+    calibration_blob_t blob = {
+        .version = CALIBRATION_BLOB_VERSION,
+        .count = table->count,
+    };
+    memcpy(blob.points, table->points, table->count * sizeof(table->points[0]));
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(CALIBRATION_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (table->count == 0) {
+        ret = nvs_erase_key(handle, channels[channel].name);
+        if (ret == ESP_ERR_NVS_NOT_FOUND) {
+            ret = ESP_OK;
+        }
+    } else {
+        ret = nvs_set_blob(handle, channels[channel].name, &blob,
+                           offsetof(calibration_blob_t, points) + table->count * sizeof(blob.points[0]));
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
+
+/**
+ * Store `table` for `channel`, then put it in effect
+ */
+static esp_err_t install(calibration_channel_t channel, const calibration_table_t *table)
+{
+    esp_err_t ret = store(channel, table);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store %s calibration: %s", channels[channel].name, esp_err_to_name(ret));
+        return ret;
+    }
+
+    taskENTER_CRITICAL(&cal_lock);
+    state[channel].table = *table;
+    taskEXIT_CRITICAL(&cal_lock);
+
+    attr_points[channel] = table->count;
+    if (cluster_endpoint != 0) {
+        esp_zb_zcl_set_attribute_val(cluster_endpoint, CALIBRATION_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                     channel, &attr_points[channel], false);
+    }
+    return ESP_OK;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t calibration_init(void)
+{
+    esp_err_t result = ESP_OK;
+
+    for (int c = 0; c < CALIBRATION_CHANNEL_COUNT; c++) {
+        calibration_table_t table = { 0 };
+        esp_err_t ret = load(c, &table);
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "%s: %u calibration points", channels[c].name, table.count);
+        } else if (ret != ESP_ERR_NOT_FOUND) {
+            ESP_LOGW(TAG, "%s: stored calibration unusable, not applied", channels[c].name);
+            table.count = 0;
+            result = ret;
+        }
+        state[c].table = table;
+        attr_points[c] = table.count;
+    }
+    return result;
+}
+
+int32_t calibration_apply(calibration_channel_t channel, int32_t raw)
+{
+    int32_t out = raw;
+
+    taskENTER_CRITICAL(&cal_lock);
+    channel_state_t *s = &state[channel];
+    s->last_raw = raw;
+    s->has_raw = true;
+    uint8_t count = s->table.count;
+    if (count > 0) {
+        out = calibration_eval(&s->table, raw);
+    }
+    taskEXIT_CRITICAL(&cal_lock);
+
+    if (count == 0 && channels[channel].temperature) {
+        out += app_config_offset_centi(channels[channel].endpoint);
+    }
+    return out;
+}
+
+esp_err_t calibration_capture(calibration_channel_t channel, int16_t reference)
+{
+    if (channel >= CALIBRATION_CHANNEL_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&cal_lock);
+    calibration_table_t table = state[channel].table;
+    int32_t raw = state[channel].last_raw;
+    bool has_raw = state[channel].has_raw;
+    taskEXIT_CRITICAL(&cal_lock);
+
+    if (!has_raw) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (raw < INT16_MIN || raw > INT16_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    calibration_point_t points[CALIBRATION_MAX_POINTS];
+    size_t count = table.count;
+    memcpy(points, table.points, sizeof(points));
+
+    esp_err_t ret = calibration_merge(points, &count, (int16_t)raw, reference);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = calibration_build(&table, points, count);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = install(channel, &table);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "%s: captured raw %ld -> reference %d (%u points)", channels[channel].name,
+             (long)raw, reference, table.count);
+    return ESP_OK;
+}
+
+esp_err_t calibration_clear(calibration_channel_t channel)
+{
+    if (channel >= CALIBRATION_CHANNEL_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    calibration_table_t table = { 0 };
+    esp_err_t ret = install(channel, &table);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%s: calibration cleared", channels[channel].name);
+    }
+    return ret;
+}
+
+size_t calibration_get_points(calibration_channel_t channel, calibration_point_t *points)
+{
+    if (channel >= CALIBRATION_CHANNEL_COUNT) {
+        return 0;
+    }
+
+    taskENTER_CRITICAL(&cal_lock);
+    size_t count = state[channel].table.count;
+    memcpy(points, state[channel].table.points, count * sizeof(points[0]));
+    taskEXIT_CRITICAL(&cal_lock);
+
+    return count;
+}
+
+const char *calibration_channel_name(calibration_channel_t channel)
+{
+    return channel < CALIBRATION_CHANNEL_COUNT ? channels[channel].name : NULL;
+}
+
+void calibration_add_cluster(esp_zb_cluster_list_t *cluster_list, uint8_t endpoint)
+{
+    esp_zb_attribute_list_t *attrs = esp_zb_zcl_attr_list_create(CALIBRATION_CLUSTER_ID);
+
+    for (int c = 0; c < CALIBRATION_CHANNEL_COUNT; c++) {
+        esp_zb_custom_cluster_add_custom_attr(attrs, c, ESP_ZB_ZCL_ATTR_TYPE_U8,
+                                              ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &attr_points[c]);
+    }
+
+    esp_zb_cluster_list_add_custom_cluster(cluster_list, attrs, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+    cluster_endpoint = endpoint;
+}
+
+esp_err_t calibration_handle_command(const esp_zb_zcl_custom_cluster_command_message_t *message)
+{
+    if (message->info.dst_endpoint != cluster_endpoint || message->info.cluster != CALIBRATION_CLUSTER_ID) {
+        return ESP_OK;
+    }
+
+    const uint8_t *data = message->data.value;
+    esp_err_t ret;
+
+    switch (message->info.command.id) {
+    case CALIBRATION_CMD_CAPTURE:
+        if (message->data.size < 3) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        ret = calibration_capture(data[0], (int16_t)(data[1] | (data[2] << 8)));
+        break;
+
+    case CALIBRATION_CMD_CLEAR:
+        if (message->data.size < 1) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        ret = calibration_clear(data[0]);
+        break;
+
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Command 0x%02x rejected: %s", message->info.command.id, esp_err_to_name(ret));
+    }
+    return ret;
+}
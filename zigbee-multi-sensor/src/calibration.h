@@ -0,0 +1,106 @@
+/*
+ * Multi-point Calibration
+ *
+ * Piecewise-linear correction per measurement channel, from up to
+ * CALIBRATION_MAX_POINTS (raw, reference) pairs kept in NVS. Values are in
+ * the channel's 0.01 units (°C, % RH), the fixed point of the ZCL
+ * MeasuredValue, so a driver converts its float reading once and the
+ * correction itself is integer only: a search over at most seven segments
+ * and one multiply by a precomputed Q16 slope.
+ *
+ * One point is an offset; two or more interpolate, with the end segments
+ * extended beyond the outer points. A channel without points falls back to
+ * its sensor's temperature offset from app_config.h (none for humidity).
+ *
+ * Points are captured against a reference probe over Zigbee: the
+ * CaptureReference command of CALIBRATION_CLUSTER_ID on EP14 carries the
+ * probe's reading, which is paired with the channel's latest raw sample
+ * and stored. A capture within CALIBRATION_MERGE_CENTI of an existing
+ * point replaces the nearest such point (calibration_merge()), so
+ * re-capturing at the same temperature corrects a point instead of adding
+ * a second one.
+ *
+ * Commands (client to server):
+ *   0x00  CaptureReference  channel (U8), reference (S16, 0.01 units)
+ *   0x01  ClearChannel      channel (U8)
+ * Attributes:
+ *   0x0000 + c  U8  points stored for channel c (read-only)
+ * with c a calibration_channel_t.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+#include "calibration_table.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CALIBRATION_CLUSTER_ID          0xFC01
+#define CALIBRATION_CMD_CAPTURE         0x00
+#define CALIBRATION_CMD_CLEAR           0x01
+
+typedef enum {
+    CALIBRATION_DHT11_TEMPERATURE = 0,
+    CALIBRATION_DHT11_HUMIDITY,
+    CALIBRATION_DS18B20_TEMPERATURE,
+    CALIBRATION_SHT4X_TEMPERATURE,
+    CALIBRATION_SHT4X_HUMIDITY,
+    CALIBRATION_BME280_TEMPERATURE,
+    CALIBRATION_BME280_HUMIDITY,
+    CALIBRATION_CHANNEL_COUNT,
+} calibration_channel_t;
+
+/**
+ * Load every channel's points. Call once in app_main(), after
+ * app_config_init().
+ */
+esp_err_t calibration_init(void);
+
+/**
+ * Correct one sample of `channel` (sensor task), and keep it as the raw
+ * value for the next capture.
+ */
+int32_t calibration_apply(calibration_channel_t channel, int32_t raw);
+
+/**
+ * Pair `reference` with the channel's latest raw sample and store the
+ * point. Returns ESP_ERR_INVALID_STATE before the first sample and
+ * ESP_ERR_NO_MEM with the table full.
+ */
+esp_err_t calibration_capture(calibration_channel_t channel, int16_t reference);
+
+/**
+ * Drop every point of `channel`.
+ */
+esp_err_t calibration_clear(calibration_channel_t channel);
+
+/**
+ * Copy the channel's points into `points` (CALIBRATION_MAX_POINTS
+ * entries); returns the count.
+ */
+size_t calibration_get_points(calibration_channel_t channel, calibration_point_t *points);
+
+/**
+ * Short channel name ("dht11_t"), also its NVS key; NULL when out of range.
+ */
+const char *calibration_channel_name(calibration_channel_t channel);
+
+/**
+ * Add the calibration cluster to the cluster list of `endpoint`.
+ */
+void calibration_add_cluster(esp_zb_cluster_list_t *cluster_list, uint8_t endpoint);
+
+/**
+ * Handle a custom cluster command (Zigbee task); ESP_OK for commands of
+ * other clusters.
+ */
+esp_err_t calibration_handle_command(const esp_zb_zcl_custom_cluster_command_message_t *message);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Calibration Tables
+ *
+ * Slopes are rounded to nearest in Q16, so the correction stays within one
+ * unit of exact interpolation over a segment; evaluation rounds the product
+ * and saturates instead of wrapping.
+ */
+
+#include <string.h>
+#include "calibration_table.h"
+
+// ========================================
+// Table Math
+// ========================================
+
+esp_err_t calibration_build(calibration_table_t *table, const calibration_point_t *points, size_t count)
+{
+    if (count > CALIBRATION_MAX_POINTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    calibration_table_t t = { .count = (uint8_t)count };
+    memcpy(t.points, points, count * sizeof(points[0]));
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        int32_t dx = points[i + 1].raw - points[i].raw;
+        int64_t dy_q16 = (int64_t)(points[i + 1].ref - points[i].ref) * 65536;
+        if (dx <= 0) {
+            return ESP_ERR_INVALID_ARG;  // Unsorted or duplicate raw value
+        }
+        // Rounded to nearest, so the error stays below one unit over the segment
+        int64_t slope = (dy_q16 + (dy_q16 >= 0 ? dx / 2 : -dx / 2)) / dx;
+        if (slope > INT32_MAX || slope < INT32_MIN) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        t.slope_q16[i] = (int32_t)slope;
+    }
+
+    *table = t;
+    return ESP_OK;
+}
+
+int32_t calibration_eval(const calibration_table_t *table, int32_t raw)
+{
+    const calibration_point_t *p = table->points;
+
+    if (table->count == 0) {
+        return raw;
+    }
+    if (table->count == 1) {
+        return raw + (p[0].ref - p[0].raw);
+    }
+
+    // Segment holding `raw`; the first and last also cover beyond the ends
+    size_t i = 0;
+    while (i + 2 < table->count && raw >= p[i + 1].raw) {
+        i++;
+    }
+
+    int64_t out = p[i].ref + (((int64_t)(raw - p[i].raw) * table->slope_q16[i] + 0x8000) >> 16);
+    if (out > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (out < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)out;
+}
+
+esp_err_t calibration_merge(calibration_point_t points[CALIBRATION_MAX_POINTS], size_t *count,
+                            int16_t raw, int16_t ref)
+{
+    size_t n = *count;
+
+    // Nearest point in the window, not the first: two points can end up
+    // closer than the window, and replacing the farther one could move it
+    // past its neighbour
+    size_t nearest = n;
+    int32_t best = CALIBRATION_MERGE_CENTI + 1;
+    for (size_t i = 0; i < n; i++) {
+        int32_t d = points[i].raw > raw ? points[i].raw - raw : raw - points[i].raw;
+        if (d < best) {
+            best = d;
+            nearest = i;
+        }
+    }
+
+    if (nearest < n) {
+        memmove(&points[nearest], &points[nearest + 1], (n - nearest - 1) * sizeof(points[0]));
+        n--;
+    } else if (n == CALIBRATION_MAX_POINTS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Reinsert in order, which also checks the replacement against both neighbours
+    size_t i = n;
+    while (i > 0 && points[i - 1].raw > raw) {
+        points[i] = points[i - 1];
+        i--;
+    }
+    points[i] = (calibration_point_t){ raw, ref };
+    *count = n + 1;
+    return ESP_OK;
+}
@@ -0,0 +1,62 @@
+/*
+ * Calibration Tables
+ *
+ * The piecewise-linear correction behind calibration.h, on its own: a
+ * table of up to CALIBRATION_MAX_POINTS (raw, reference) points in 0.01
+ * units with the segment slopes precomputed in Q16. One point is an
+ * offset; two or more interpolate, with the end segments extended beyond
+ * the outer points. No allocation and no ESP-IDF dependencies beyond
+ * esp_err_t, so it also builds for host tools.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CALIBRATION_MAX_POINTS          8
+#define CALIBRATION_MERGE_CENTI         50      // Captures closer than 0.5 units replace a point
+
+typedef struct {
+    int16_t raw;                        // Sensor reading, 0.01 units
+    int16_t ref;                        // Reference reading at the same time
+} calibration_point_t;
+
+/**
+ * Points with their segment slopes precomputed (calibration_build()).
+ */
+typedef struct {
+    uint8_t count;
+    calibration_point_t points[CALIBRATION_MAX_POINTS];
+    int32_t slope_q16[CALIBRATION_MAX_POINTS - 1];
+} calibration_table_t;
+
+/**
+ * Build a table from points sorted by strictly increasing raw value.
+ * Returns ESP_ERR_INVALID_ARG for unsorted or too many points, or a slope
+ * outside Q16 range.
+ */
+esp_err_t calibration_build(calibration_table_t *table, const calibration_point_t *points, size_t count);
+
+/**
+ * Corrected value of `raw` (0.01 units); `raw` itself for an empty table.
+ */
+int32_t calibration_eval(const calibration_table_t *table, int32_t raw);
+
+/**
+ * Add (raw, ref) to `count` sorted points. The nearest point within
+ * CALIBRATION_MERGE_CENTI is replaced rather than kept beside it; the
+ * result is sorted either way. Returns ESP_ERR_NO_MEM when a new point
+ * does not fit.
+ */
+esp_err_t calibration_merge(calibration_point_t points[CALIBRATION_MAX_POINTS], size_t *count,
+                            int16_t raw, int16_t ref);
+
+#ifdef __cplusplus
+}
+#endif
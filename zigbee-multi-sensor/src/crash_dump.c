@@ -0,0 +1,268 @@
+/*
+ * Crash Capture
+ *
+ * Everything the panic hook calls runs from IRAM and takes no locks: the
+ * crash may have happened with the flash cache disabled or inside a
+ * critical section. The record is sealed with a CRC so a cold boot (RTC
+ * memory holds garbage) or a second panic halfway through is ignored.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_private/freertos_debug.h"
+#include "esp_private/panic_internal.h"
+#include "riscv/rvruntime-frames.h"
+#include "esp_app_desc.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "tlog.h"
+#include "zb_diagnostics.h"
+#include "crash_dump.h"
+
+#define CRASH_DUMP_MAGIC                0x43524153      // "CRAS"
+#define CRASH_DUMP_SHA_OFFSET           6
+#define CRASH_DUMP_SHA_LEN              8
+
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;                   // Over len and data[0 .. len - 1]
+    uint16_t len;
+    uint8_t data[CRASH_DUMP_RECORD_MAX];
+} crash_blob_t;
+
+static const char *TAG = "CRASH_DUMP";
+
+// Written by the panic hook, read on the next boot
+static RTC_NOINIT_ATTR crash_blob_t retained;
+
+// Stored record (from the crashlog partition)
+static crash_blob_t stored;
+static bool stored_valid = false;
+
+// Guards against a second panic inside the hook
+static DRAM_ATTR bool capturing = false;
+
+void __real_esp_panic_handler(panic_info_t *info);
+
+// ========================================
+// Panic Hook (IRAM, no locks)
+// ========================================
+
+static IRAM_ATTR uint8_t *put_u32(uint8_t *p, uint32_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = value >> 24;
+    return p + 4;
+}
+
+static IRAM_ATTR uint32_t blob_crc(const crash_blob_t *blob)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&blob->len, sizeof(blob->len));
+    return esp_rom_crc32_le(crc, blob->data, blob->len);
+}
+
+/**
+ * Words above sp that point into executable memory: return addresses,
+ * plus some stale ones the host decoder filters out.
+ */
+static IRAM_ATTR uint8_t *put_backtrace(uint8_t *p, uint32_t sp, uint32_t mepc)
+{
+    uint8_t *count = p++;
+    *count = 0;
+
+    const uint32_t *word = (const uint32_t *)(uintptr_t)(sp & ~3u);
+    for (int i = 0; i < CRASH_DUMP_STACK_SCAN_WORDS && *count < CRASH_DUMP_BACKTRACE_MAX; i++, word++) {
+        if (!esp_ptr_in_dram(word)) {
+            break;
+        }
+        uint32_t value = *word;
+        if (value != mepc && esp_ptr_executable((const void *)(uintptr_t)value)) {
+            p = put_u32(p, value);
+            (*count)++;
+        }
+    }
+    return p;
+}
+
+static IRAM_ATTR uint8_t *put_tokens(uint8_t *p)
+{
+    uint32_t tokens[CRASH_DUMP_TOKENS];
+    size_t count = tlog_last_tokens(tokens, CRASH_DUMP_TOKENS);
+
+    *p++ = (uint8_t)count;
+    for (size_t i = 0; i < count; i++) {
+        p = put_u32(p, tokens[i]);
+    }
+    return p;
+}
+
+static IRAM_ATTR uint8_t *put_tasks(uint8_t *p, uint32_t crash_sp)
+{
+    TaskSnapshot_t snapshots[CRASH_DUMP_TASKS];
+    UBaseType_t tcb_size;
+    UBaseType_t count = uxTaskGetSnapshotAll(snapshots, CRASH_DUMP_TASKS, &tcb_size);
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+
+    *p++ = (uint8_t)count;
+    for (UBaseType_t i = 0; i < count; i++) {
+        TaskHandle_t task = (TaskHandle_t)snapshots[i].pxTCB;
+        bool crashed = task == current;
+        const char *name = pcTaskGetName(task);
+
+        // The running task's saved top of stack is stale; use the frame's sp
+        uint32_t top = crashed ? crash_sp : (uint32_t)(uintptr_t)snapshots[i].pxTopOfStack;
+        uint32_t start = (uint32_t)(uintptr_t)pxTaskGetStackStart(task);
+        uint32_t free_bytes = top > start ? top - start : 0;
+
+        bool end = name == NULL;
+        for (int c = 0; c < 4; c++) {
+            end = end || name[c] == '\0';
+            *p++ = end ? 0 : (uint8_t)name[c];
+        }
+        *p++ = crashed ? 0x01 : 0x00;
+        *p++ = free_bytes > UINT16_MAX ? 0xFF : free_bytes & 0xFF;
+        *p++ = free_bytes > UINT16_MAX ? 0xFF : (free_bytes >> 8) & 0xFF;
+    }
+    return p;
+}
+
+static IRAM_ATTR void capture(const panic_info_t *info)
+{
+    const RvExcFrame *frame = info->frame;
+    uint8_t *p = retained.data;
+
+    retained.magic = 0;
+
+    *p++ = CRASH_DUMP_FORMAT_VERSION;
+    *p++ = (uint8_t)info->exception;
+    p = put_u32(p, (uint32_t)(esp_timer_get_time() / 1000));
+    memset(p, 0, CRASH_DUMP_SHA_LEN);       // Filled on the next boot
+    p += CRASH_DUMP_SHA_LEN;
+    p = put_u32(p, frame ? frame->mepc : 0);
+    p = put_u32(p, frame ? frame->ra : 0);
+    p = put_u32(p, frame ? frame->sp : 0);
+    p = put_u32(p, frame ? frame->mcause : 0);
+    p = put_u32(p, frame ? frame->mtval : 0);
+    p = put_backtrace(p, frame ? frame->sp : 0, frame ? frame->mepc : 0);
+    p = put_tokens(p);
+    p = put_tasks(p, frame ? frame->sp : 0);
+
+    retained.len = (uint16_t)(p - retained.data);
+    retained.crc = blob_crc(&retained);
+    retained.magic = CRASH_DUMP_MAGIC;
+}
+
+IRAM_ATTR void __wrap_esp_panic_handler(panic_info_t *info)
+{
+    if (!capturing) {
+        capturing = true;
+        capture(info);
+    }
+    __real_esp_panic_handler(info);
+}
+
+// ========================================
+// Flash Storage
+// ========================================
+
+static bool blob_valid(const crash_blob_t *blob)
+{
+    return blob->magic == CRASH_DUMP_MAGIC && blob->len <= CRASH_DUMP_RECORD_MAX &&
+           blob->crc == blob_crc(blob);
+}
+
+static const esp_partition_t *find_partition(void)
+{
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, CRASH_DUMP_PARTITION_SUBTYPE,
+                                    CRASH_DUMP_PARTITION_LABEL);
+}
+
+static esp_err_t save_retained(const esp_partition_t *part)
+{
+    // The image that crashed is the one running now
+    memcpy(&retained.data[CRASH_DUMP_SHA_OFFSET], esp_app_get_description()->app_elf_sha256,
+           CRASH_DUMP_SHA_LEN);
+    retained.crc = blob_crc(&retained);
+
+    esp_err_t ret = esp_partition_erase_range(part, 0, part->erase_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return esp_partition_write(part, 0, &retained, sizeof(retained));
+}
+
+static void log_stored(void)
+{
+    const uint8_t *d = stored.data;
+    uint32_t uptime_ms = d[2] | (d[3] << 8) | (d[4] << 16) | ((uint32_t)d[5] << 24);
+    uint32_t mepc = d[14] | (d[15] << 8) | (d[16] << 16) | ((uint32_t)d[17] << 24);
+
+    ESP_LOGW(TAG, "Stored crash: exception %u, PC 0x%08lx, %lu s after boot (%u bytes, `crash` prints it)",
+             d[1], (unsigned long)mepc, (unsigned long)(uptime_ms / 1000), stored.len);
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t crash_dump_init(void)
+{
+    const esp_partition_t *part = find_partition();
+    if (part == NULL) {
+        ESP_LOGW(TAG, "No %s partition, crashes are not kept", CRASH_DUMP_PARTITION_LABEL);
+        retained.magic = 0;
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (blob_valid(&retained)) {
+        esp_err_t ret = save_retained(part);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to store crash record (%s)", esp_err_to_name(ret));
+        } else {
+            ESP_LOGW(TAG, "Crash record from the last run saved");
+        }
+    }
+    retained.magic = 0;
+
+    esp_err_t ret = esp_partition_read(part, 0, &stored, sizeof(stored));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    stored_valid = blob_valid(&stored);
+    if (stored_valid) {
+        log_stored();
+    }
+    return ESP_OK;
+}
+
+void crash_dump_publish(void)
+{
+    zb_diagnostics_set_octet_string(ZB_DIAG_ATTR_CRASH_RECORD, stored.data, stored_valid ? stored.len : 0);
+}
+
+size_t crash_dump_get(const uint8_t **record)
+{
+    *record = stored.data;
+    return stored_valid ? stored.len : 0;
+}
+
+esp_err_t crash_dump_clear(void)
+{
+    const esp_partition_t *part = find_partition();
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = esp_partition_erase_range(part, 0, part->erase_size);
+    if (ret == ESP_OK) {
+        stored_valid = false;
+    }
+    return ret;
+}
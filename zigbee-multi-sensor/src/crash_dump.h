@@ -0,0 +1,84 @@
+/*
+ * Crash Capture
+ *
+ * A panic hook (the firmware links with --wrap=esp_panic_handler) builds a
+ * compact record of the crash in RTC memory, which survives the panic reset,
+ * before the normal panic handler prints and resets. On the next boot,
+ * crash_dump_init() moves the record into the reserved `crashlog` flash
+ * partition (partitions.csv). It stays there until the next crash or
+ * crash_dump_clear(), is published on EP 15 and is printed by the `crash`
+ * console command. crash_decode.py symbolises it against the firmware ELF.
+ *
+ * Flash is not written from the panic handler itself: the crash may have
+ * happened in the middle of a flash operation.
+ *
+ * Crash record attribute (0xF013 on the EP 15 Diagnostics cluster), little-endian:
+ *   [0]      format version (1)
+ *   [1]      panic exception (0 debug, 1 interrupt WDT, 2 task WDT, 3 abort, 4 fault, 5 cache error)
+ *   [2..5]   uptime ms at the crash
+ *   [6..13]  first 8 bytes of the ELF SHA-256 of the image that crashed
+ *   [14..33] mepc, ra, sp, mcause, mtval (4 bytes each)
+ *   [34]     backtrace count B, then B return-address candidates (4 bytes
+ *            each, innermost first) from a scan of the crashed stack
+ *   [.]      token count T, then the last T TLOGx format tokens (4 bytes
+ *            each, oldest first; see tlog.h)
+ *   [.]      task count K, then K tasks of CRASH_DUMP_TASK_ENTRY_SIZE bytes:
+ *              name (4, truncated, zero-padded), flags (1, bit 0 = the task
+ *              that crashed), free stack bytes at the crash (2)
+ *
+ * RISC-V code is built without frame pointers, so the stack walk keeps
+ * every stack word that points into executable memory. crash_decode.py
+ * drops the candidates not preceded by a call instruction.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRASH_DUMP_FORMAT_VERSION       1
+#define CRASH_DUMP_RECORD_MAX           208
+#define CRASH_DUMP_HEADER_SIZE          34
+#define CRASH_DUMP_BACKTRACE_MAX        12
+#define CRASH_DUMP_STACK_SCAN_WORDS     256     // 1 KB above sp
+#define CRASH_DUMP_TOKENS               8
+#define CRASH_DUMP_TASKS                12
+#define CRASH_DUMP_TASK_ENTRY_SIZE      7
+
+#define CRASH_DUMP_PARTITION_LABEL      "crashlog"
+#define CRASH_DUMP_PARTITION_SUBTYPE    0x40    // Custom data subtype
+
+_Static_assert(CRASH_DUMP_HEADER_SIZE + 1 + CRASH_DUMP_BACKTRACE_MAX * 4 + 1 + CRASH_DUMP_TOKENS * 4 +
+               1 + CRASH_DUMP_TASKS * CRASH_DUMP_TASK_ENTRY_SIZE <= CRASH_DUMP_RECORD_MAX,
+               "raise CRASH_DUMP_RECORD_MAX");
+
+/**
+ * Save a record left by a panic to flash and load the stored one. Call
+ * once at boot, after nvs_flash_init().
+ */
+esp_err_t crash_dump_init(void);
+
+/**
+ * Publish the stored record on EP 15 (Zigbee task context, after the
+ * endpoints are registered). An empty attribute means no crash stored.
+ */
+void crash_dump_publish(void);
+
+/**
+ * Stored record, or 0 if there is none.
+ */
+size_t crash_dump_get(const uint8_t **record);
+
+/**
+ * Erase the stored record (once it has been collected).
+ */
+esp_err_t crash_dump_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
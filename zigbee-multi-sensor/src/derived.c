@@ -0,0 +1,226 @@
+/*
+ * Derived Metrics
+ */
+
+#include <stdbool.h>
+#include "sensor_codec.h"
+#include "zb_report.h"
+#include "derived.h"
+
+#define ES_TABLE_MIN_C                  -40
+#define ES_TABLE_COUNT                  126     // -40..85 °C
+
+// Q32 fixed point of a double constant, folded at compile time
+#define Q32(c)                          ((int64_t)((c) * 4294967296.0 + ((c) < 0 ? -0.5 : 0.5)))
+
+// Saturation vapour pressure over water, 0.1 Pa, at -40, -39, ... 85 °C:
+// 611.2 · exp(17.62 · T / (243.12 + T)) Pa
+static const uint32_t es_table[ES_TABLE_COUNT] = {
+    190, 211, 234, 259, 286, 316, 348, 384,
+    423, 465, 512, 562, 617, 676, 741, 811,
+    887, 970, 1059, 1155, 1260, 1372, 1494, 1625,
+    1766, 1919, 2083, 2259, 2448, 2652, 2870, 3105,
+    3356, 3625, 3913, 4222, 4552, 4904, 5281, 5683,
+    6112, 6569, 7057, 7576, 8129, 8717, 9343, 10008,
+    10714, 11464, 12260, 13105, 14000, 14948, 15953, 17017,
+    18142, 19333, 20591, 21921, 23326, 24809, 26374, 28025,
+    29766, 31601, 33533, 35569, 37711, 39966, 42337, 44830,
+    47450, 50203, 53094, 56128, 59313, 62653, 66156, 69827,
+    73675, 77704, 81924, 86341, 90963, 95797, 100852, 106137,
+    111659, 117427, 123452, 129741, 136304, 143152, 150294, 157742,
+    165504, 173593, 182020, 190796, 199933, 209443, 219338, 229632,
+    240337, 251467, 263035, 275056, 287543, 300512, 313977, 327954,
+    342458, 357506, 373114, 389299, 406077, 423468, 441487, 460155,
+    479489, 499508, 520232, 541681, 563875, 586834,
+};
+
+// Rothfusz regression, °F and %RH, grouped by monomial T^i · RH^j
+static const int64_t hi_c00 = Q32(-42.379);
+static const int64_t hi_c10 = Q32(2.04901523);
+static const int64_t hi_c01 = Q32(10.14333127);
+static const int64_t hi_c11 = Q32(-0.22475541);
+static const int64_t hi_c20 = Q32(-6.83783e-3);
+static const int64_t hi_c02 = Q32(-5.481717e-2);
+static const int64_t hi_c21 = Q32(1.22874e-3);
+static const int64_t hi_c12 = Q32(8.5282e-4);
+static const int64_t hi_c22 = Q32(-1.99e-6);
+
+// ========================================
+// Internal Helpers
+// ========================================
+
+static bool inputs_valid(int16_t temp, uint16_t humidity)
+{
+    return temp >= ES_TABLE_MIN_C * 100 && temp <= (ES_TABLE_MIN_C + ES_TABLE_COUNT - 1) * 100 &&
+           humidity <= ZB_HUMIDITY_MAX;
+}
+
+/**
+ * Saturation vapour pressure at `temp` (0.01 °C, inside the table), 0.1 Pa
+ */
+static uint32_t saturation_pressure(int16_t temp)
+{
+    int32_t offset = temp - ES_TABLE_MIN_C * 100;
+    int32_t i = offset / 100;
+    int32_t frac = offset % 100;
+
+    if (i == ES_TABLE_COUNT - 1) {
+        return es_table[i];
+    }
+    return es_table[i] + (uint32_t)(((es_table[i + 1] - es_table[i]) * (uint32_t)frac + 50) / 100);
+}
+
+/**
+ * Actual vapour pressure, 0.1 Pa
+ */
+static uint32_t vapour_pressure(int16_t temp, uint16_t humidity)
+{
+    return (uint32_t)(((uint64_t)saturation_pressure(temp) * humidity + 5000) / 10000);
+}
+
+static uint32_t isqrt64(uint64_t x)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+// ========================================
+// Metrics
+// ========================================
+
+int16_t derived_dew_point(int16_t temp, uint16_t humidity)
+{
+    if (!inputs_valid(temp, humidity) || humidity == 0) {
+        return DERIVED_INVALID_S16;
+    }
+
+    uint32_t e = vapour_pressure(temp, humidity);
+    if (e < es_table[0]) {
+        return DERIVED_INVALID_S16;  // Below -40 °C
+    }
+
+    // Last entry not above e; the dew point never exceeds the temperature
+    int32_t lo = 0;
+    int32_t hi = ES_TABLE_COUNT - 1;
+    while (lo < hi) {
+        int32_t mid = (lo + hi + 1) / 2;
+        if (es_table[mid] <= e) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    int32_t dew = (ES_TABLE_MIN_C + lo) * 100;
+    if (lo < ES_TABLE_COUNT - 1) {
+        uint32_t span = es_table[lo + 1] - es_table[lo];
+        dew += (int32_t)(((e - es_table[lo]) * 100 + span / 2) / span);
+    }
+    return (int16_t)(dew < temp ? dew : temp);
+}
+
+uint16_t derived_absolute_humidity(int16_t temp, uint16_t humidity)
+{
+    if (!inputs_valid(temp, humidity)) {
+        return DERIVED_INVALID_U16;
+    }
+
+    // 100 · e / (Rv · T) in g/m³, Rv = 461.5 J/(kg·K): 2166.8 · e[0.1 Pa] / T[0.01 K]
+    uint32_t kelvin = (uint32_t)(temp + 27315);
+    uint64_t e = vapour_pressure(temp, humidity);
+    return (uint16_t)((e * 21668 + kelvin * 5) / (kelvin * 10));
+}
+
+int16_t derived_heat_index(int16_t temp, uint16_t humidity)
+{
+    if (!inputs_valid(temp, humidity)) {
+        return DERIVED_INVALID_S16;
+    }
+
+    // 0.01 °F and 0.01 %RH
+    int64_t t = (int64_t)temp * 9 / 5 + 3200;
+    int64_t r = humidity;
+
+    if (t < 5000) {
+        return temp;  // Not defined in the cold; the temperature itself
+    }
+
+    // Steadman: 0.5 · (T + 61 + 1.2 · (T - 68) + 0.094 · RH)
+    int64_t hi = (t + 6100 + (t - 6800) * 6 / 5 + r * 94 / 1000) / 2;
+
+    if ((hi + t) / 2 >= 8000) {
+        // Monomials T^i · RH^j, each times 100
+        int64_t sum = hi_c00 * 100 + hi_c10 * t + hi_c01 * r
+                    + hi_c11 * (t * r / 100) + hi_c20 * (t * t / 100) + hi_c02 * (r * r / 100)
+                    + hi_c21 * (t * t / 100 * r / 100) + hi_c12 * (t * r / 100 * r / 100)
+                    + hi_c22 * (t * t / 100 * r / 100 * r / 100);
+        hi = (sum + (1LL << 31)) >> 32;
+
+        if (r < 1300 && t > 8000 && t < 11200) {
+            // Dry: - (13 - RH) / 4 · sqrt((17 - |T - 95|) / 17)
+            int64_t d = t > 9500 ? t - 9500 : 9500 - t;
+            uint32_t root_q16 = isqrt64((uint64_t)((1700 - d) << 32) / 1700);
+            hi -= ((1300 - r) * root_q16) / (4 * 65536);
+        } else if (r > 8500 && t > 8000 && t < 8700) {
+            // Humid: + (RH - 85) / 10 · (87 - T) / 5
+            hi += (r - 8500) * (8700 - t) / 5000;
+        }
+    }
+
+    int64_t celsius = (hi - 3200) * 5 / 9;
+    if (celsius <= INT16_MIN || celsius > INT16_MAX) {
+        return DERIVED_INVALID_S16;
+    }
+    return (int16_t)celsius;
+}
+
+// ========================================
+// Zigbee
+// ========================================
+
+void derived_add_cluster(esp_zb_cluster_list_t *clusters)
+{
+    // Initial attribute values (copied into the ZCL attribute table at creation)
+    int16_t s16_invalid = DERIVED_INVALID_S16;
+    uint16_t u16_invalid = DERIVED_INVALID_U16;
+    const uint8_t access = ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING;
+
+    esp_zb_attribute_list_t *attrs = esp_zb_zcl_attr_list_create(DERIVED_CLUSTER_ID);
+    esp_zb_custom_cluster_add_custom_attr(attrs, DERIVED_ATTR_DEW_POINT, ESP_ZB_ZCL_ATTR_TYPE_S16, access,
+                                          &s16_invalid);
+    esp_zb_custom_cluster_add_custom_attr(attrs, DERIVED_ATTR_ABSOLUTE_HUMIDITY, ESP_ZB_ZCL_ATTR_TYPE_U16, access,
+                                          &u16_invalid);
+    esp_zb_custom_cluster_add_custom_attr(attrs, DERIVED_ATTR_HEAT_INDEX, ESP_ZB_ZCL_ATTR_TYPE_S16, access,
+                                          &s16_invalid);
+    esp_zb_cluster_list_add_custom_cluster(clusters, attrs, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+void derived_report(uint8_t endpoint, int16_t temp, uint16_t humidity)
+{
+    int16_t dew_point = derived_dew_point(temp, humidity);
+    uint16_t absolute = derived_absolute_humidity(temp, humidity);
+    int16_t heat_index = derived_heat_index(temp, humidity);
+
+    zb_report_attribute(endpoint, DERIVED_CLUSTER_ID, DERIVED_ATTR_DEW_POINT, &dew_point);
+    zb_report_attribute(endpoint, DERIVED_CLUSTER_ID, DERIVED_ATTR_ABSOLUTE_HUMIDITY, &absolute);
+    zb_report_attribute(endpoint, DERIVED_CLUSTER_ID, DERIVED_ATTR_HEAT_INDEX, &heat_index);
+}
+
+void derived_report_invalid(uint8_t endpoint)
+{
+    derived_report(endpoint, (int16_t)ZB_TEMP_INVALID, ZB_HUMIDITY_INVALID);
+}
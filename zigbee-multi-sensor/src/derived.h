@@ -0,0 +1,73 @@
+/*
+ * Derived Metrics
+ *
+ * Dew point, absolute humidity and heat index from one temperature and
+ * humidity pair, computed on the device so every consumer sees the same
+ * values, taken from the same sample, instead of each one pairing up two
+ * separate reports itself.
+ *
+ * Integer only, in the MeasuredValue units (0.01 °C, 0.01 %RH):
+ *   saturation vapour pressure  Magnus (Sonntag 1990), tabulated per 1 °C
+ *                               from -40 to 85 °C, interpolated
+ *   dew point                   the same table searched in reverse
+ *   absolute humidity           ideal gas, e / (Rv · T)
+ *   heat index                  NWS: Steadman below 80 °F, the Rothfusz
+ *                               regression with its two adjustments above,
+ *                               in Q32 fixed point; the temperature itself
+ *                               below 50 °F
+ *
+ * Published as attributes of a manufacturer cluster (DERIVED_CLUSTER_ID) on
+ * every endpoint with both temperature and humidity, through
+ * zb_report_attribute() right after the humidity report, so they share its
+ * reporting mode and batch window:
+ *   0x0000  S16  dew point, 0.01 °C
+ *   0x0001  U16  absolute humidity, 0.01 g/m³
+ *   0x0002  S16  heat index, 0.01 °C
+ * Each starts, and returns to, the invalid value of its type (0x8000,
+ * 0xFFFF) as the measurement clusters do.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DERIVED_CLUSTER_ID              0xFC02
+#define DERIVED_ATTR_DEW_POINT          0x0000
+#define DERIVED_ATTR_ABSOLUTE_HUMIDITY  0x0001
+#define DERIVED_ATTR_HEAT_INDEX         0x0002
+
+#define DERIVED_INVALID_S16             ((int16_t)0x8000)
+#define DERIVED_INVALID_U16             0xFFFF
+
+/**
+ * Metrics from a temperature (0.01 °C) and relative humidity (0.01 %RH).
+ * Invalid outside the table's -40..85 °C, with either input invalid, and
+ * for the dew point at 0 %RH.
+ */
+int16_t derived_dew_point(int16_t temp, uint16_t humidity);
+uint16_t derived_absolute_humidity(int16_t temp, uint16_t humidity);
+int16_t derived_heat_index(int16_t temp, uint16_t humidity);
+
+/**
+ * Add the derived metrics cluster (values invalid).
+ */
+void derived_add_cluster(esp_zb_cluster_list_t *clusters);
+
+/**
+ * Compute and report all three for `endpoint` (sensor task).
+ */
+void derived_report(uint8_t endpoint, int16_t temp, uint16_t humidity);
+
+/**
+ * Report all three invalid (sensor entering FAILED).
+ */
+void derived_report_invalid(uint8_t endpoint);
+
+#ifdef __cplusplus
+}
+#endif
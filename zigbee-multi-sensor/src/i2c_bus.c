@@ -0,0 +1,492 @@
+/*
+ * Shared I2C Bus (port 0)
+ *
+ * Took over the driver install from sensors.c (was 100 kHz, BH1750 only).
+ * Recovery bit-bangs the two pins as open-drain GPIOs while the driver is
+ * removed; i2c_param_config() routes them back to the controller.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "rom/ets_sys.h"
+#include "sensors.h"
+#include "supervisor.h"
+#include "i2c_bus.h"
+
+#define I2C_BUS_SCAN_TIMEOUT_MS         10
+
+#define RECOVERY_TASK_STACK             2048
+#define RECOVERY_TASK_PRIORITY          2       // Below the sensor tasks
+#define RECOVERY_HALF_PERIOD_US         5       // 100 kHz pulses, slow enough for any slave
+#define RECOVERY_RETRY_BASE_MS          1000
+#define RECOVERY_RETRY_MAX_MS           60000
+
+typedef struct {
+    uint8_t addr;
+    uint8_t failures;               // Consecutive
+    uint32_t backoff_ms;
+    int64_t retry_at_us;
+} device_state_t;
+
+static const char *TAG = "I2C_BUS";
+
+static bool installed = false;
+static uint32_t present_map[4];         // One bit per 7-bit address
+
+static SemaphoreHandle_t bus_mutex = NULL;
+static TaskHandle_t recovery_task_handle = NULL;
+
+// Guards everything below; never held across a bus transaction
+static portMUX_TYPE health_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool recovering = false;
+static i2c_bus_stats_t stats;
+static device_state_t devices[I2C_BUS_MAX_DEVICES];
+static uint8_t device_count = 0;
+
+// ========================================
+// Internal Helpers
+// ========================================
+
+static esp_err_t install_driver(void)
+{
+    i2c_config_t conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = I2C_MASTER_SDA_IO,
+        .scl_io_num = I2C_MASTER_SCL_IO,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = I2C_BUS_FREQ_HZ,
+    };
+
+    esp_err_t ret = i2c_param_config(I2C_BUS_PORT, &conf);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return i2c_driver_install(I2C_BUS_PORT, conf.mode, 0, 0, 0);
+}
+
+static void mark_present(uint8_t addr, bool present)
+{
+    uint32_t bit = 1UL << (addr & 31);
+    if (present) {
+        present_map[addr >> 5] |= bit;
+    } else {
+        present_map[addr >> 5] &= ~bit;
+    }
+}
+
+/**
+ * Address-only write: START, addr+W, STOP. ESP_OK if the address ACKed.
+ */
+static esp_err_t probe_address(uint8_t addr)
+{
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_stop(cmd);
+
+    esp_err_t ret = i2c_master_cmd_begin(I2C_BUS_PORT, cmd, pdMS_TO_TICKS(I2C_BUS_SCAN_TIMEOUT_MS));
+    i2c_cmd_link_delete(cmd);
+
+    return ret;
+}
+
+/**
+ * Backoff state for `addr` (health_lock held). NULL if the table is full;
+ * that address then simply never backs off.
+ */
+static device_state_t *device_for(uint8_t addr)
+{
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i].addr == addr) {
+            return &devices[i];
+        }
+    }
+    if (device_count >= I2C_BUS_MAX_DEVICES) {
+        return NULL;
+    }
+
+    device_state_t *d = &devices[device_count++];
+    *d = (device_state_t){ .addr = addr };
+    return d;
+}
+
+static uint32_t backoff_for(uint8_t failures)
+{
+    uint32_t steps = failures - I2C_BUS_BACKOFF_AFTER;
+    if (steps > 16) {
+        steps = 16;
+    }
+    uint32_t ms = (uint32_t)I2C_BUS_BACKOFF_BASE_MS << steps;
+    return ms > I2C_BUS_BACKOFF_MAX_MS ? I2C_BUS_BACKOFF_MAX_MS : ms;
+}
+
+/**
+ * Idle bus with a line held low: a slave is stuck mid-transfer (SDA) or
+ * is stretching the clock forever (SCL). Bus mutex held.
+ */
+static bool lines_stuck(void)
+{
+    return gpio_get_level(I2C_MASTER_SDA_IO) == 0 || gpio_get_level(I2C_MASTER_SCL_IO) == 0;
+}
+
+/**
+ * Refuse at once while recovering or while `addr` backs off, otherwise
+ * take the bus.
+ */
+static esp_err_t begin_transfer(uint8_t addr)
+{
+    if (!installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    int64_t now_us = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&health_lock);
+    device_state_t *d = device_for(addr);
+    if (recovering) {
+        stats.busy_skips++;
+        ret = ESP_ERR_INVALID_STATE;
+    } else if (d && d->retry_at_us > now_us) {
+        stats.backoff_skips++;
+        ret = ESP_ERR_NOT_FINISHED;
+    }
+    taskEXIT_CRITICAL(&health_lock);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (xSemaphoreTake(bus_mutex, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS)) != pdTRUE) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else if (recovering) {
+        // Recovery was queued while this task waited for the bus
+        xSemaphoreGive(bus_mutex);
+        ret = ESP_ERR_INVALID_STATE;
+    }
+    if (ret != ESP_OK) {
+        taskENTER_CRITICAL(&health_lock);
+        stats.busy_skips++;
+        taskEXIT_CRITICAL(&health_lock);
+    }
+    return ret;
+}
+
+/**
+ * Release the bus and account the result. A timeout or bus error followed
+ * by a line held low hands the bus to the recovery task. The refusal codes
+ * are kept for begin_transfer(): a transaction that failed with one of them
+ * is returned as ESP_FAIL.
+ */
+static esp_err_t end_transfer(uint8_t addr, esp_err_t result)
+{
+    bool hang = (result == ESP_ERR_TIMEOUT || result == ESP_ERR_INVALID_STATE) && lines_stuck();
+    xSemaphoreGive(bus_mutex);
+
+    bool wake = false;
+    uint32_t backoff_ms = 0;
+
+    taskENTER_CRITICAL(&health_lock);
+    stats.transfers++;
+    device_state_t *d = device_for(addr);
+    if (result == ESP_OK) {
+        if (d) {
+            d->failures = 0;
+            d->backoff_ms = 0;
+            d->retry_at_us = 0;
+        }
+    } else {
+        stats.errors++;
+        if (d && d->failures < UINT8_MAX) {
+            d->failures++;
+        }
+        if (d && d->failures >= I2C_BUS_BACKOFF_AFTER) {
+            d->backoff_ms = backoff_for(d->failures);
+            d->retry_at_us = esp_timer_get_time() + d->backoff_ms * 1000LL;
+            backoff_ms = d->backoff_ms;
+        }
+        if (hang) {
+            stats.hangs++;
+            wake = !recovering;
+            recovering = true;
+        }
+    }
+    taskEXIT_CRITICAL(&health_lock);
+
+    if (wake) {
+        ESP_LOGW(TAG, "Line held low after %s from 0x%02X, recovering", esp_err_to_name(result), addr);
+        xTaskNotifyGive(recovery_task_handle);
+    } else if (backoff_ms) {
+        ESP_LOGD(TAG, "0x%02X: %s, backing off %lu ms", addr, esp_err_to_name(result), (unsigned long)backoff_ms);
+    }
+    return i2c_bus_refused(result) ? ESP_FAIL : result;
+}
+
+static void line_delay(void)
+{
+    ets_delay_us(RECOVERY_HALF_PERIOD_US);
+}
+
+/**
+ * Bus mutex held. Clock the stuck slave through the rest of its byte until
+ * it releases SDA, then send a STOP and reinstall the driver. Returns the
+ * line that is still stuck, or NULL if the bus is free.
+ */
+static const char *recover_bus(uint32_t *pulses)
+{
+    const char *stuck = NULL;
+    *pulses = 0;
+
+    i2c_driver_delete(I2C_BUS_PORT);
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << I2C_MASTER_SDA_IO) | (1ULL << I2C_MASTER_SCL_IO),
+        .mode = GPIO_MODE_INPUT_OUTPUT_OD,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io_conf);
+    gpio_set_level(I2C_MASTER_SDA_IO, 1);
+    gpio_set_level(I2C_MASTER_SCL_IO, 1);
+    line_delay();
+
+    if (gpio_get_level(I2C_MASTER_SCL_IO) == 0) {
+        // Nothing the master can clock: shorted line or a wedged slave
+        stuck = "SCL";
+    } else {
+        while (gpio_get_level(I2C_MASTER_SDA_IO) == 0 && *pulses < I2C_BUS_RECOVERY_PULSES) {
+            gpio_set_level(I2C_MASTER_SCL_IO, 0);
+            line_delay();
+            gpio_set_level(I2C_MASTER_SCL_IO, 1);
+            line_delay();
+            (*pulses)++;
+        }
+
+        // STOP: SDA rises while SCL is high
+        gpio_set_level(I2C_MASTER_SCL_IO, 0);
+        line_delay();
+        gpio_set_level(I2C_MASTER_SDA_IO, 0);
+        line_delay();
+        gpio_set_level(I2C_MASTER_SCL_IO, 1);
+        line_delay();
+        gpio_set_level(I2C_MASTER_SDA_IO, 1);
+        line_delay();
+
+        if (gpio_get_level(I2C_MASTER_SDA_IO) == 0) {
+            stuck = "SDA";
+        }
+    }
+
+    esp_err_t ret = install_driver();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Driver reinstall failed (%s)", esp_err_to_name(ret));
+        stuck = stuck ? stuck : "driver";
+    }
+    return stuck;
+}
+
+static void recovery_task(void *pvParameters)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t retry_ms = RECOVERY_RETRY_BASE_MS;
+        uint32_t attempts = 0;
+        while (1) {
+            // Waits out a transfer already on the bus (at most I2C_BUS_TIMEOUT_MS)
+            xSemaphoreTake(bus_mutex, portMAX_DELAY);
+            uint32_t pulses;
+            const char *stuck = recover_bus(&pulses);
+            xSemaphoreGive(bus_mutex);
+
+            taskENTER_CRITICAL(&health_lock);
+            stats.recovery_pulses += pulses;
+            if (stuck) {
+                stats.recovery_failures++;
+            } else {
+                stats.recoveries++;
+                recovering = false;
+                // Give every part a fresh start on the freed bus
+                for (int i = 0; i < device_count; i++) {
+                    devices[i].failures = 0;
+                    devices[i].backoff_ms = 0;
+                    devices[i].retry_at_us = 0;
+                }
+            }
+            taskEXIT_CRITICAL(&health_lock);
+
+            if (!stuck) {
+                ESP_LOGI(TAG, "Bus recovered (%lu SCL pulses)", (unsigned long)pulses);
+                break;
+            }
+
+            // One targeted restart per hang: if the bus is still stuck after it,
+            // keep running without I2C rather than reset-looping the other sensors
+            if (++attempts >= I2C_BUS_RESTART_AFTER &&
+                supervisor_last_cause(NULL) != SUPERVISOR_CAUSE_I2C_HUNG) {
+                uint8_t detail = strcmp(stuck, "SCL") == 0 ? 1 : strcmp(stuck, "SDA") == 0 ? 2 : 3;
+                supervisor_restart(SUPERVISOR_CAUSE_I2C_HUNG, detail);
+            }
+
+            ESP_LOGW(TAG, "Recovery failed, %s still low; retrying in %lu ms", stuck, (unsigned long)retry_ms);
+            vTaskDelay(pdMS_TO_TICKS(retry_ms));
+            retry_ms = retry_ms * 2 > RECOVERY_RETRY_MAX_MS ? RECOVERY_RETRY_MAX_MS : retry_ms * 2;
+        }
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t i2c_bus_init(void)
+{
+    if (installed) {
+        return ESP_OK;
+    }
+
+    bus_mutex = xSemaphoreCreateMutex();
+    if (bus_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = install_driver();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Driver install failed (%s)", esp_err_to_name(ret));
+        vSemaphoreDelete(bus_mutex);
+        bus_mutex = NULL;
+        return ret;
+    }
+
+    if (xTaskCreate(recovery_task, "i2c_recover", RECOVERY_TASK_STACK, NULL, RECOVERY_TASK_PRIORITY,
+                    &recovery_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create recovery task");
+        i2c_driver_delete(I2C_BUS_PORT);
+        vSemaphoreDelete(bus_mutex);
+        bus_mutex = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    installed = true;
+    ESP_LOGI(TAG, "Port %d up at %lu kHz (SDA GPIO%d, SCL GPIO%d)", I2C_BUS_PORT,
+             (unsigned long)(I2C_BUS_FREQ_HZ / 1000), I2C_MASTER_SDA_IO, I2C_MASTER_SCL_IO);
+    return ESP_OK;
+}
+
+size_t i2c_bus_scan(void)
+{
+    size_t found = 0;
+
+    if (!installed) {
+        return 0;
+    }
+
+    xSemaphoreTake(bus_mutex, portMAX_DELAY);
+    for (uint8_t addr = I2C_BUS_ADDR_FIRST; addr <= I2C_BUS_ADDR_LAST; addr++) {
+        bool ack = probe_address(addr) == ESP_OK;
+        mark_present(addr, ack);
+        if (ack) {
+            ESP_LOGI(TAG, "Device at 0x%02X", addr);
+            found++;
+        }
+    }
+    bool stuck = lines_stuck();
+    xSemaphoreGive(bus_mutex);
+
+    if (stuck) {
+        ESP_LOGW(TAG, "Scan: line held low, results unreliable");
+    }
+    ESP_LOGI(TAG, "Scan: %u device(s)", (unsigned)found);
+    return found;
+}
+
+esp_err_t i2c_bus_probe(uint8_t addr)
+{
+    esp_err_t ret = begin_transfer(addr);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = end_transfer(addr, probe_address(addr));
+    mark_present(addr, ret == ESP_OK);
+    return ret == ESP_FAIL ? ESP_ERR_NOT_FOUND : ret;
+}
+
+bool i2c_bus_present(uint8_t addr)
+{
+    return addr < 128 && (present_map[addr >> 5] & (1UL << (addr & 31))) != 0;
+}
+
+esp_err_t i2c_bus_write(uint8_t addr, const uint8_t *data, size_t len)
+{
+    esp_err_t ret = begin_transfer(addr);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = i2c_master_write_to_device(I2C_BUS_PORT, addr, data, len, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS));
+    return end_transfer(addr, ret);
+}
+
+esp_err_t i2c_bus_read(uint8_t addr, uint8_t *data, size_t len)
+{
+    esp_err_t ret = begin_transfer(addr);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = i2c_master_read_from_device(I2C_BUS_PORT, addr, data, len, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS));
+    return end_transfer(addr, ret);
+}
+
+esp_err_t i2c_bus_write_reg(uint8_t addr, uint8_t reg, uint8_t value)
+{
+    uint8_t frame[2] = { reg, value };
+    return i2c_bus_write(addr, frame, sizeof(frame));
+}
+
+esp_err_t i2c_bus_read_reg(uint8_t addr, uint8_t reg, uint8_t *data, size_t len)
+{
+    esp_err_t ret = begin_transfer(addr);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = i2c_master_write_read_device(I2C_BUS_PORT, addr, &reg, 1, data, len,
+                                       pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS));
+    return end_transfer(addr, ret);
+}
+
+bool i2c_bus_refused(esp_err_t ret)
+{
+    return ret == ESP_ERR_INVALID_STATE || ret == ESP_ERR_NOT_FINISHED;
+}
+
+bool i2c_bus_recovering(void)
+{
+    taskENTER_CRITICAL(&health_lock);
+    bool busy = recovering;
+    taskEXIT_CRITICAL(&health_lock);
+    return busy;
+}
+
+size_t i2c_bus_get_stats(i2c_bus_stats_t *out, i2c_bus_device_t *out_devices, size_t max)
+{
+    size_t n = 0;
+
+    taskENTER_CRITICAL(&health_lock);
+    *out = stats;
+    for (; n < device_count && n < max; n++) {
+        out_devices[n] = (i2c_bus_device_t){
+            .addr = devices[n].addr,
+            .failures = devices[n].failures,
+            .backoff_ms = devices[n].backoff_ms,
+        };
+    }
+    taskEXIT_CRITICAL(&health_lock);
+
+    return n;
+}
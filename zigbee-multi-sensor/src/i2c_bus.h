@@ -0,0 +1,130 @@
+/*
+ * Shared I2C Bus (port 0)
+ *
+ * One 400 kHz fast-mode master on I2C_MASTER_SDA_IO / I2C_MASTER_SCL_IO
+ * shared by every I2C part (BH1750, SHT4x, BME280). Transactions are
+ * serialised by a bus lock, so the sensor tasks can use the bus
+ * concurrently.
+ *
+ * i2c_bus_scan() runs once at boot and logs the bus. The drivers'
+ * init calls i2c_bus_probe() for their own address, so a part connected
+ * after boot is found by the next re-probe (sensor_registry.h).
+ *
+ * Bus health:
+ *   - A transaction that times out is followed by a look at the idle line
+ *     levels. SDA or SCL held low means a slave is stuck mid-byte (typically
+ *     after a brown-out or a reset during a read); the recovery task is woken.
+ *   - Recovery runs on its own low-priority task: delete the driver, clock
+ *     up to I2C_BUS_RECOVERY_PULSES SCL pulses until the slave lets go of
+ *     SDA, send a STOP, reinstall the driver. Failed attempts are retried
+ *     with exponential backoff. Meanwhile every transaction fails at once
+ *     with ESP_ERR_INVALID_STATE, so no caller ever waits for the recovery.
+ *   - After I2C_BUS_RESTART_AFTER failed recoveries in a row (about 2 min)
+ *     the board restarts once with cause SUPERVISOR_CAUSE_I2C_HUNG
+ *     (supervisor.h). If the bus is still stuck after that restart, recovery
+ *     keeps retrying without another one.
+ *   - Each address backs off on its own: after consecutive failures its
+ *     transactions are refused (ESP_ERR_NOT_FINISHED) for 1 s, 2 s, 4 s ...
+ *     up to I2C_BUS_BACKOFF_MAX_MS, so a dead part costs no bus time.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_BUS_PORT                    0
+#define I2C_BUS_FREQ_HZ                 400000  // Fast mode; all current parts support it
+#define I2C_BUS_TIMEOUT_MS              50
+
+// 7-bit addresses a scan probes (0x00-0x07 and 0x78-0x7F are reserved)
+#define I2C_BUS_ADDR_FIRST              0x08
+#define I2C_BUS_ADDR_LAST               0x77
+
+// Health
+#define I2C_BUS_RECOVERY_PULSES         9       // One byte plus the ACK bit
+#define I2C_BUS_MAX_DEVICES             8       // Addresses with backoff state
+#define I2C_BUS_BACKOFF_AFTER           2       // Consecutive failures before backing off
+#define I2C_BUS_BACKOFF_BASE_MS         1000
+#define I2C_BUS_BACKOFF_MAX_MS          300000  // 5 minutes
+#define I2C_BUS_RESTART_AFTER           8       // Failed recoveries in a row before a supervisor restart
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t errors;                // NACK or timeout, any address
+    uint32_t backoff_skips;         // Refused while the address backed off
+    uint32_t busy_skips;            // Refused while recovery ran
+    uint32_t hangs;                 // Timeouts with a line held low afterwards
+    uint32_t recoveries;            // Attempts that freed the bus
+    uint32_t recovery_failures;     // Attempts that did not (SCL held low, SDA never released)
+    uint32_t recovery_pulses;       // SCL pulses needed, summed over all recoveries
+} i2c_bus_stats_t;
+
+typedef struct {
+    uint8_t addr;
+    uint8_t failures;               // Consecutive
+    uint32_t backoff_ms;            // 0 = not backing off
+} i2c_bus_device_t;
+
+/**
+ * Install the master driver and start the recovery task. Safe to call more
+ * than once.
+ */
+esp_err_t i2c_bus_init(void);
+
+/**
+ * Address every 7-bit device and log the ones that ACK. Returns the count.
+ */
+size_t i2c_bus_scan(void);
+
+/**
+ * Address one device. ESP_OK if it ACKed, ESP_ERR_NOT_FOUND if not, or the
+ * usual refusal while recovering or backing off.
+ */
+esp_err_t i2c_bus_probe(uint8_t addr);
+
+/**
+ * True if `addr` ACKed during the last scan or probe.
+ */
+bool i2c_bus_present(uint8_t addr);
+
+/**
+ * Plain write / read transactions (command-style parts: BH1750, SHT4x).
+ */
+esp_err_t i2c_bus_write(uint8_t addr, const uint8_t *data, size_t len);
+esp_err_t i2c_bus_read(uint8_t addr, uint8_t *data, size_t len);
+
+/**
+ * Register access (BME280). read_reg is one burst transaction: register
+ * address, repeated start, `len` bytes with auto-increment.
+ */
+esp_err_t i2c_bus_write_reg(uint8_t addr, uint8_t reg, uint8_t value);
+esp_err_t i2c_bus_read_reg(uint8_t addr, uint8_t reg, uint8_t *data, size_t len);
+
+/**
+ * True if `ret` is a refusal (recovery running or address backing off)
+ * rather than a failed transaction. The part was not asked, so a caller
+ * skips the update instead of counting an error.
+ */
+bool i2c_bus_refused(esp_err_t ret);
+
+/**
+ * True while the recovery task owns the bus.
+ */
+bool i2c_bus_recovering(void);
+
+/**
+ * Snapshot of the counters and of up to `max` per-address backoff entries.
+ * Returns the number of entries written.
+ */
+size_t i2c_bus_get_stats(i2c_bus_stats_t *stats, i2c_bus_device_t *devices, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
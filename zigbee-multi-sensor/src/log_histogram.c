@@ -0,0 +1,97 @@
+/*
+ * Fixed-Size Log-Bucket Histogram
+ */
+
+#include <string.h>
+#include "log_histogram.h"
+
+// First octave that is split into sub-buckets (values 4-7)
+#define FIRST_SPLIT_OCTAVE      2
+
+void log_histogram_reset(log_histogram_t *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+uint8_t log_histogram_bucket(uint32_t value)
+{
+    if (value > LOG_HISTOGRAM_MAX_VALUE) {
+        return LOG_HISTOGRAM_BUCKETS - 1;
+    }
+    if (value < LOG_HISTOGRAM_SUB_BUCKETS) {
+        return (uint8_t)value;
+    }
+
+    int octave = 31 - __builtin_clz(value);
+    int sub = (value >> (octave - FIRST_SPLIT_OCTAVE)) & (LOG_HISTOGRAM_SUB_BUCKETS - 1);
+
+    return (uint8_t)(LOG_HISTOGRAM_SUB_BUCKETS +
+                     (octave - FIRST_SPLIT_OCTAVE) * LOG_HISTOGRAM_SUB_BUCKETS + sub);
+}
+
+uint32_t log_histogram_bucket_lower(uint8_t index)
+{
+    if (index < LOG_HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+
+    int octave = (index - LOG_HISTOGRAM_SUB_BUCKETS) / LOG_HISTOGRAM_SUB_BUCKETS + FIRST_SPLIT_OCTAVE;
+    int sub = (index - LOG_HISTOGRAM_SUB_BUCKETS) % LOG_HISTOGRAM_SUB_BUCKETS;
+
+    return (uint32_t)(LOG_HISTOGRAM_SUB_BUCKETS + sub) << (octave - FIRST_SPLIT_OCTAVE);
+}
+
+uint32_t log_histogram_bucket_upper(uint8_t index)
+{
+    if (index >= LOG_HISTOGRAM_BUCKETS - 1) {
+        return LOG_HISTOGRAM_MAX_VALUE;
+    }
+    return log_histogram_bucket_lower(index + 1) - 1;
+}
+
+void log_histogram_add(log_histogram_t *hist, uint32_t value)
+{
+    uint8_t index = log_histogram_bucket(value);
+
+    if (hist->buckets[index] == UINT16_MAX) {
+        // Halve everything rather than clip one bucket and skew percentiles
+        hist->count = 0;
+        for (int i = 0; i < LOG_HISTOGRAM_BUCKETS; i++) {
+            hist->buckets[i] >>= 1;
+            hist->count += hist->buckets[i];
+        }
+    }
+
+    hist->buckets[index]++;
+    hist->count++;
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+uint32_t log_histogram_percentile(const log_histogram_t *hist, uint8_t percentile)
+{
+    if (hist->count == 0) {
+        return 0;
+    }
+    if (percentile > 100) {
+        percentile = 100;
+    }
+
+    // Rank of the requested sample (1-based, rounded up)
+    uint32_t rank = (hist->count * percentile + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint32_t cumulative = 0;
+    for (int i = 0; i < LOG_HISTOGRAM_BUCKETS; i++) {
+        cumulative += hist->buckets[i];
+        if (cumulative >= rank) {
+            uint32_t upper = log_histogram_bucket_upper(i);
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+
+    return hist->max;
+}
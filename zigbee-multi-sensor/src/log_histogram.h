@@ -0,0 +1,51 @@
+/*
+ * Fixed-Size Log-Bucket Histogram
+ *
+ * Records non-negative integer samples (e.g. latency in ms) into 60 buckets:
+ * values 0-3 are exact, above that each power of two is split into 4
+ * sub-buckets (<= 25% relative error). Values >= 65536 land in the last
+ * bucket. Counts are uint16 and the whole histogram is halved when any
+ * bucket would saturate, which keeps the distribution shape while slowly
+ * aging out old samples.
+ *
+ * Pure C with no allocation, so it also builds for host tools.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_HISTOGRAM_SUB_BUCKETS   4
+#define LOG_HISTOGRAM_BUCKETS       60
+#define LOG_HISTOGRAM_MAX_VALUE     0xFFFFu
+
+typedef struct {
+    uint16_t buckets[LOG_HISTOGRAM_BUCKETS];
+    uint32_t count;         // Samples currently represented by the buckets
+    uint32_t max;           // Largest sample seen since reset
+} log_histogram_t;
+
+void log_histogram_reset(log_histogram_t *hist);
+
+void log_histogram_add(log_histogram_t *hist, uint32_t value);
+
+/**
+ * Approximate percentile (0-100), returned as the upper bound of the bucket
+ * containing it. Returns 0 for an empty histogram.
+ */
+uint32_t log_histogram_percentile(const log_histogram_t *hist, uint8_t percentile);
+
+/**
+ * Bucket index for a value, and the inclusive [lower, upper] range of a bucket.
+ */
+uint8_t log_histogram_bucket(uint32_t value);
+uint32_t log_histogram_bucket_lower(uint8_t index);
+uint32_t log_histogram_bucket_upper(uint8_t index);
+
+#ifdef __cplusplus
+}
+#endif
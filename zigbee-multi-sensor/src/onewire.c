@@ -0,0 +1,88 @@
+/*
+ * Bit-Banged 1-Wire Master
+ *
+ * Moved out of sensors.c unchanged so the benchmark suite can time it on a
+ * spare pin and the host build can run it against the simulated GPIO HAL.
+ */
+
+#include "rom/ets_sys.h"
+#include "onewire.h"
+
+// ========================================
+// Time Slots
+// ========================================
+
+static void onewire_delay_us(uint32_t us)
+{
+    ets_delay_us(us);
+}
+
+static void onewire_write_bit(gpio_num_t pin, int bit)
+{
+    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
+    gpio_set_level(pin, 0);
+
+    if (bit) {
+        onewire_delay_us(10);
+        gpio_set_level(pin, 1);
+        onewire_delay_us(55);
+    } else {
+        onewire_delay_us(65);
+        gpio_set_level(pin, 1);
+        onewire_delay_us(5);
+    }
+}
+
+static int onewire_read_bit(gpio_num_t pin)
+{
+    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
+    gpio_set_level(pin, 0);
+    onewire_delay_us(3);
+
+    gpio_set_direction(pin, GPIO_MODE_INPUT);
+    onewire_delay_us(10);
+
+    int bit = gpio_get_level(pin);
+    onewire_delay_us(53);
+
+    return bit;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t onewire_reset(gpio_num_t pin)
+{
+    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
+    gpio_set_level(pin, 0);
+    onewire_delay_us(480);
+
+    gpio_set_direction(pin, GPIO_MODE_INPUT);
+    onewire_delay_us(70);
+
+    int present = gpio_get_level(pin);
+    onewire_delay_us(410);
+
+    return (present == 0) ? ESP_OK : ESP_FAIL;
+}
+
+void onewire_write_byte(gpio_num_t pin, uint8_t byte)
+{
+    for (int i = 0; i < 8; i++) {
+        onewire_write_bit(pin, byte & 0x01);
+        byte >>= 1;
+    }
+}
+
+uint8_t onewire_read_byte(gpio_num_t pin)
+{
+    uint8_t byte = 0;
+    for (int i = 0; i < 8; i++) {
+        byte >>= 1;
+        if (onewire_read_bit(pin)) {
+            byte |= 0x80;
+        }
+    }
+    return byte;
+}
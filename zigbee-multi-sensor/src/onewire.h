@@ -0,0 +1,32 @@
+/*
+ * Bit-Banged 1-Wire Master
+ *
+ * Standard-speed reset and byte transfers on any open-drain capable GPIO
+ * with an external pull-up. Timing uses busy-wait delays, so one byte takes
+ * ~560 us of CPU on the calling task.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Reset pulse; ESP_OK if a device answered with a presence pulse.
+ */
+esp_err_t onewire_reset(gpio_num_t pin);
+
+/**
+ * LSB-first byte transfers.
+ */
+void onewire_write_byte(gpio_num_t pin, uint8_t byte);
+uint8_t onewire_read_byte(gpio_num_t pin);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,298 @@
+/*
+ * Delta OTA Images
+ *
+ * A byte-at-a-time state machine for the op headers; COPY, DIFF and INSERT
+ * runs are handled in blocks bounded by the input, the output and the
+ * source cache.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "ota_delta.h"
+
+#define DELTA_OP_END                    0x00
+#define DELTA_OP_ADD                    0x01
+#define DELTA_OP_INSERT                 0x02
+
+#define DELTA_DIGEST_SIZE               32
+#define DELTA_VARINT_MAX_SHIFT          28      // 32-bit values
+
+typedef enum {
+    PHASE_HEADER = 0,
+    PHASE_OP,
+    PHASE_ADD_LEN,
+    PHASE_ADD_SEEK,
+    PHASE_ZEROS,
+    PHASE_COPY,                         // Source bytes unchanged
+    PHASE_DIFFS,
+    PHASE_DIFF,                         // Source byte + patch byte
+    PHASE_INSERT_LEN,
+    PHASE_INSERT,                       // Patch bytes
+    PHASE_END,
+} delta_phase_t;
+
+static const char *TAG = "OTA_DELTA";
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static size_t min_size(size_t a, size_t b)
+{
+    return a < b ? a : b;
+}
+
+/**
+ * Source bytes from `pos` on: `*avail` of them at `*data`.
+ */
+static esp_err_t source_at(ota_delta_t *d, uint32_t pos, const uint8_t **data, size_t *avail)
+{
+    if (pos >= d->st.source_size) {
+        ESP_LOGE(TAG, "Source offset %lu out of range", (unsigned long)pos);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (pos < d->cache_pos || pos >= d->cache_pos + d->cache_len) {
+        size_t len = min_size(OTA_DELTA_SOURCE_CACHE, d->st.source_size - pos);
+        esp_err_t ret = esp_partition_read(d->source, pos, d->cache, len);
+        if (ret != ESP_OK) {
+            d->cache_len = 0;
+            return ret;
+        }
+        d->cache_pos = pos;
+        d->cache_len = len;
+    }
+
+    *data = &d->cache[pos - d->cache_pos];
+    *avail = d->cache_pos + d->cache_len - pos;
+    return ESP_OK;
+}
+
+/**
+ * The patch must have been made against the running image: compare the
+ * SHA-256 appended to it.
+ */
+static esp_err_t check_header(ota_delta_t *d)
+{
+    const uint8_t *h = d->header;
+    uint8_t digest[DELTA_DIGEST_SIZE];
+
+    if (h[0] != OTA_DELTA_FORMAT_VERSION) {
+        ESP_LOGE(TAG, "Unsupported delta format %u", h[0]);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    d->st.source_size = get_u32(&h[1]);
+    d->st.target_size = get_u32(&h[37]);
+    if (d->st.source_size <= DELTA_DIGEST_SIZE || d->st.source_size > d->source->size) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    esp_err_t ret = esp_partition_read(d->source, d->st.source_size - DELTA_DIGEST_SIZE, digest,
+                                       DELTA_DIGEST_SIZE);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (memcmp(digest, &h[5], DELTA_DIGEST_SIZE) != 0) {
+        ESP_LOGE(TAG, "Patch was made for another source image");
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    ESP_LOGI(TAG, "Patching %lu-byte image from the running %lu-byte one",
+             (unsigned long)d->st.target_size, (unsigned long)d->st.source_size);
+    return ESP_OK;
+}
+
+/**
+ * Feed one byte to the varint being read; true once it is complete.
+ */
+static bool varint_step(ota_delta_state_t *st, uint8_t byte, esp_err_t *ret)
+{
+    if (st->shift > DELTA_VARINT_MAX_SHIFT) {
+        *ret = ESP_ERR_INVALID_ARG;
+        return false;
+    }
+    st->value |= (uint32_t)(byte & 0x7F) << st->shift;
+    if (byte & 0x80) {
+        st->shift += 7;
+        return false;
+    }
+    st->shift = 0;
+    return true;
+}
+
+/**
+ * Next phase of an ADD after a zero or diff run.
+ */
+static uint8_t after_run(const ota_delta_state_t *st, uint8_t run_phase)
+{
+    if (run_phase == PHASE_COPY) {
+        return PHASE_DIFFS;
+    }
+    return st->op_left > 0 ? PHASE_ZEROS : PHASE_OP;
+}
+
+/**
+ * Phases that only read the patch.
+ */
+static esp_err_t parse_byte(ota_delta_t *d, uint8_t byte)
+{
+    ota_delta_state_t *st = &d->st;
+    esp_err_t ret = ESP_OK;
+
+    if (st->phase == PHASE_HEADER) {
+        d->header[st->header_len++] = byte;
+        if (st->header_len == OTA_DELTA_HEADER_SIZE) {
+            ret = check_header(d);
+            st->phase = PHASE_OP;
+        }
+        return ret;
+    }
+
+    if (st->phase == PHASE_OP) {
+        st->value = 0;
+        st->shift = 0;
+        switch (byte) {
+        case DELTA_OP_END:
+            st->phase = PHASE_END;
+            break;
+        case DELTA_OP_ADD:
+            st->phase = PHASE_ADD_LEN;
+            break;
+        case DELTA_OP_INSERT:
+            st->phase = PHASE_INSERT_LEN;
+            break;
+        default:
+            ESP_LOGE(TAG, "Bad op 0x%02x", byte);
+            return ESP_ERR_INVALID_ARG;
+        }
+        return ESP_OK;
+    }
+
+    if (!varint_step(st, byte, &ret)) {
+        return ret;
+    }
+    uint32_t value = st->value;
+    st->value = 0;
+
+    switch (st->phase) {
+    case PHASE_ADD_LEN:
+        st->op_left = value;
+        st->phase = PHASE_ADD_SEEK;
+        break;
+
+    case PHASE_ADD_SEEK:
+        st->src_pos += (value >> 1) ^ -(value & 1);     // Zigzag, wraps like int32
+        st->phase = st->op_left > 0 ? PHASE_ZEROS : PHASE_OP;
+        break;
+
+    case PHASE_ZEROS:
+    case PHASE_DIFFS:
+        if (value > st->op_left) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        st->run_left = value;
+        if (value > 0) {
+            st->phase = st->phase == PHASE_ZEROS ? PHASE_COPY : PHASE_DIFF;
+        } else {
+            st->phase = after_run(st, st->phase == PHASE_ZEROS ? PHASE_COPY : PHASE_DIFF);
+        }
+        break;
+
+    case PHASE_INSERT_LEN:
+        st->op_left = value;
+        st->run_left = value;
+        st->phase = value > 0 ? PHASE_INSERT : PHASE_OP;
+        break;
+
+    default:
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+void ota_delta_init(ota_delta_t *d, const esp_partition_t *source, const ota_delta_state_t *resume)
+{
+    memset(d, 0, sizeof(*d));
+    d->source = source;
+    if (resume != NULL) {
+        d->st = *resume;
+    }
+}
+
+esp_err_t ota_delta_decode(ota_delta_t *d, const uint8_t *in, size_t in_len, size_t *in_used,
+                           uint8_t *out, size_t out_len, size_t *out_used)
+{
+    ota_delta_state_t *st = &d->st;
+    esp_err_t ret = ESP_OK;
+    size_t i = 0;
+    size_t o = 0;
+
+    while (ret == ESP_OK && st->phase != PHASE_END) {
+        uint8_t phase = st->phase;
+
+        if (phase == PHASE_COPY || phase == PHASE_DIFF || phase == PHASE_INSERT) {
+            size_t n = min_size(st->run_left, out_len - o);
+            if (phase != PHASE_COPY) {
+                n = min_size(n, in_len - i);
+            }
+            if (n == 0) {
+                break;  // Output full or input used up
+            }
+
+            if (phase == PHASE_INSERT) {
+                memcpy(&out[o], &in[i], n);
+                i += n;
+            } else {
+                const uint8_t *src;
+                size_t avail;
+                ret = source_at(d, st->src_pos, &src, &avail);
+                if (ret != ESP_OK) {
+                    break;
+                }
+                n = min_size(n, avail);
+                if (phase == PHASE_COPY) {
+                    memcpy(&out[o], src, n);
+                } else {
+                    for (size_t k = 0; k < n; k++) {
+                        out[o + k] = src[k] + in[i + k];
+                    }
+                    i += n;
+                }
+                st->src_pos += n;
+            }
+
+            o += n;
+            st->run_left -= n;
+            st->op_left -= n;
+            if (st->run_left == 0) {
+                st->phase = phase == PHASE_INSERT ? PHASE_OP : after_run(st, phase);
+            }
+            continue;
+        }
+
+        if (i == in_len) {
+            break;
+        }
+        ret = parse_byte(d, in[i++]);
+    }
+
+    *in_used = i;
+    *out_used = o;
+    return ret;
+}
+
+uint32_t ota_delta_target_size(const ota_delta_t *d)
+{
+    return d->st.phase == PHASE_HEADER ? 0 : d->st.target_size;
+}
+
+bool ota_delta_done(const ota_delta_t *d)
+{
+    return d->st.phase == PHASE_END;
+}
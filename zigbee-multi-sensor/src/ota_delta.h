@@ -0,0 +1,100 @@
+/*
+ * Delta OTA Images
+ *
+ * A delta element (ZB_OTA_TAG_DELTA_IMAGE, built by ota_pack.py
+ * --delta-from) rebuilds the new app image from the running one, so only
+ * the changes go over the air. The decoder is a streaming stage between the
+ * OTA block queue and the sector writer (zb_ota.c): it takes patch bytes as
+ * they arrive, reads the source image from the running partition through a
+ * small cache and stops whenever the output buffer is full. RAM use is the
+ * decoder struct, whatever the image size.
+ *
+ * The patch follows bsdiff: an ADD op copies a stretch of the source and
+ * adds a difference to it, which is mostly zero after a code change shifts
+ * addresses, so the differences are stored as runs (zeros, then literal
+ * bytes). Code with no counterpart in the source is an INSERT.
+ *
+ * Element layout, little-endian:
+ *   [0]        format version (1)
+ *   [1..4]     source image size
+ *   [5..36]    SHA-256 appended to the source image (identifies it)
+ *   [37..40]   target image size
+ *   [41..]     ops until END; varints are LEB128, seek is zigzag-encoded
+ *     0x00 END
+ *     0x01 ADD     varint len, varint seek, then (zeros, n, diff) runs
+ *                  until len bytes are out: varint zeros (source bytes
+ *                  copied), varint n, n diff bytes (source byte + diff)
+ *     0x02 INSERT  varint len, len literal bytes
+ * The source position starts at 0, moves by seek at every ADD and advances
+ * with each source byte the ADD uses.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTA_DELTA_FORMAT_VERSION        1
+#define OTA_DELTA_HEADER_SIZE           41
+#define OTA_DELTA_SOURCE_CACHE          256     // Bytes of the source read at a time
+
+/**
+ * Decoder position, everything needed to continue after a reboot (stored
+ * in the OTA checkpoint).
+ */
+typedef struct {
+    uint8_t phase;
+    uint8_t shift;                      // Varint being read
+    uint16_t header_len;
+    uint32_t value;
+    uint32_t op_left;                   // Output bytes left in the current op
+    uint32_t run_left;                  // Bytes left in the current zero/diff run
+    uint32_t src_pos;
+    uint32_t source_size;
+    uint32_t target_size;
+} ota_delta_state_t;
+
+typedef struct {
+    ota_delta_state_t st;
+    const esp_partition_t *source;
+    uint8_t header[OTA_DELTA_HEADER_SIZE];
+    uint32_t cache_pos;
+    uint32_t cache_len;
+    uint8_t cache[OTA_DELTA_SOURCE_CACHE];
+} ota_delta_t;
+
+/**
+ * Start decoding against `source` (the running app partition), or continue
+ * from `resume` if not NULL.
+ */
+void ota_delta_init(ota_delta_t *d, const esp_partition_t *source, const ota_delta_state_t *resume);
+
+/**
+ * Take up to `in_len` patch bytes and produce up to `out_len` image bytes.
+ * Returns with `*in_used` < `in_len` only when the output is full or the
+ * patch has ended. A patch for another source image fails the header with
+ * ESP_ERR_INVALID_VERSION.
+ */
+esp_err_t ota_delta_decode(ota_delta_t *d, const uint8_t *in, size_t in_len, size_t *in_used,
+                           uint8_t *out, size_t out_len, size_t *out_used);
+
+/**
+ * Size of the image being rebuilt, 0 until the header is in.
+ */
+uint32_t ota_delta_target_size(const ota_delta_t *d);
+
+/**
+ * True once the END op has been read.
+ */
+bool ota_delta_done(const ota_delta_t *d);
+
+#ifdef __cplusplus
+}
+#endif
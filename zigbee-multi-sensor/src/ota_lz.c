@@ -0,0 +1,176 @@
+/*
+ * Compressed OTA Images
+ *
+ * Bit fields are read one bit at a time so the stream can stop at any byte;
+ * a literal is put at the window head and copied out like a one-byte
+ * back-reference, so only the copy phase needs output space.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "ota_lz.h"
+
+#define LZ_LOOKAHEAD_BITS_MIN           3
+#define LZ_WINDOW_BITS_MIN              8
+
+typedef enum {
+    PHASE_HEADER = 0,
+    PHASE_TAG,
+    PHASE_LITERAL,
+    PHASE_INDEX,
+    PHASE_COUNT,
+    PHASE_COPY,
+    PHASE_END,
+} lz_phase_t;
+
+static const char *TAG = "OTA_LZ";
+
+static esp_err_t check_header(ota_lz_t *lz)
+{
+    const uint8_t *h = lz->header;
+
+    lz->window_bits = h[0];
+    lz->lookahead_bits = h[1];
+    lz->out_size = h[2] | (h[3] << 8) | (h[4] << 16) | ((uint32_t)h[5] << 24);
+
+    if (lz->window_bits < LZ_WINDOW_BITS_MIN || lz->window_bits > OTA_LZ_WINDOW_BITS_MAX ||
+        lz->lookahead_bits < LZ_LOOKAHEAD_BITS_MIN || lz->lookahead_bits >= lz->window_bits) {
+        ESP_LOGE(TAG, "Unsupported window %u/%u bits", lz->window_bits, lz->lookahead_bits);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (lz->out_size == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGI(TAG, "Decompressing %lu bytes, window %u B", (unsigned long)lz->out_size,
+             1u << lz->window_bits);
+    return ESP_OK;
+}
+
+static void read_field(ota_lz_t *lz, uint8_t phase, uint8_t bits)
+{
+    lz->phase = phase;
+    lz->bits_left = bits;
+    lz->value = 0;
+}
+
+/**
+ * A complete bit field.
+ */
+static void field_done(ota_lz_t *lz)
+{
+    switch (lz->phase) {
+    case PHASE_TAG:
+        if (lz->value) {
+            read_field(lz, PHASE_LITERAL, 8);
+        } else {
+            read_field(lz, PHASE_INDEX, lz->window_bits);
+        }
+        break;
+
+    case PHASE_LITERAL:
+        lz->window[lz->head] = (uint8_t)lz->value;
+        lz->offset = 0;
+        lz->count = 1;
+        lz->phase = PHASE_COPY;
+        break;
+
+    case PHASE_INDEX:
+        lz->offset = lz->value + 1;
+        read_field(lz, PHASE_COUNT, lz->lookahead_bits);
+        break;
+
+    case PHASE_COUNT:
+        lz->count = lz->value + 1;
+        lz->phase = PHASE_COPY;
+        break;
+
+    default:
+        break;
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+void ota_lz_init(ota_lz_t *lz)
+{
+    memset(lz, 0, sizeof(*lz));
+}
+
+esp_err_t ota_lz_decode(ota_lz_t *lz, const uint8_t *in, size_t in_len, size_t *in_used,
+                        uint8_t *out, size_t out_len, size_t *out_used)
+{
+    esp_err_t ret = ESP_OK;
+    size_t i = 0;
+    size_t o = 0;
+
+    while (ret == ESP_OK && lz->phase != PHASE_END) {
+        if (lz->phase == PHASE_COPY) {
+            if (o == out_len) {
+                break;
+            }
+            if (lz->out_pos == lz->out_size) {
+                ESP_LOGE(TAG, "Stream longer than announced");
+                ret = ESP_ERR_INVALID_SIZE;
+                break;
+            }
+
+            uint16_t mask = (1u << lz->window_bits) - 1;
+            uint8_t c = lz->window[(lz->head - lz->offset) & mask];
+            lz->window[lz->head] = c;
+            lz->head = (lz->head + 1) & mask;
+            out[o++] = c;
+            lz->out_pos++;
+
+            if (--lz->count == 0) {
+                if (lz->out_pos == lz->out_size) {
+                    lz->phase = PHASE_END;
+                } else {
+                    read_field(lz, PHASE_TAG, 1);
+                }
+            }
+            continue;
+        }
+
+        if (lz->phase == PHASE_HEADER) {
+            if (i == in_len) {
+                break;
+            }
+            lz->header[lz->header_len++] = in[i++];
+            if (lz->header_len == OTA_LZ_HEADER_SIZE) {
+                ret = check_header(lz);
+                read_field(lz, PHASE_TAG, 1);
+            }
+            continue;
+        }
+
+        if (lz->bit_mask == 0) {
+            if (i == in_len) {
+                break;
+            }
+            lz->byte = in[i++];
+            lz->bit_mask = 0x80;
+        }
+        lz->value = (lz->value << 1) | ((lz->byte & lz->bit_mask) ? 1 : 0);
+        lz->bit_mask >>= 1;
+        if (--lz->bits_left == 0) {
+            field_done(lz);
+        }
+    }
+
+    *in_used = i;
+    *out_used = o;
+    return ret;
+}
+
+uint32_t ota_lz_output_size(const ota_lz_t *lz)
+{
+    return lz->phase == PHASE_HEADER ? 0 : lz->out_size;
+}
+
+bool ota_lz_done(const ota_lz_t *lz)
+{
+    return lz->phase == PHASE_END;
+}
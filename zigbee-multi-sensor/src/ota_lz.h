@@ -0,0 +1,81 @@
+/*
+ * Compressed OTA Images
+ *
+ * A compressed element (ZB_OTA_TAG_COMPRESSED_IMAGE or _DELTA, built by
+ * ota_pack.py --compress) carries an app image or a patch as an LZSS stream
+ * in the heatshrink format. The decoder is the first stage of the OTA
+ * pipeline (zb_ota.c): it takes element bytes as they arrive, feeds the copy
+ * or patch stage behind it and stops whenever its output buffer is full.
+ * Its only memory is the window of the last 2^window_bits output bytes, so
+ * RAM use is fixed at about OTA_LZ_WINDOW_MAX, whatever the image size.
+ *
+ * Element layout:
+ *   [0]        window bits W (8..OTA_LZ_WINDOW_BITS_MAX)
+ *   [1]        lookahead bits L (3..W - 1)
+ *   [2..5]     decompressed size, little-endian
+ *   [6..]      heatshrink bitstream, most significant bit first:
+ *                1, 8 bits              literal byte
+ *                0, W bits i, L bits n  copy n + 1 bytes from i + 1 back
+ *              padded with zero bits to a whole byte
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTA_LZ_HEADER_SIZE              6
+#define OTA_LZ_WINDOW_BITS_MAX          11
+#define OTA_LZ_WINDOW_MAX               (1 << OTA_LZ_WINDOW_BITS_MAX)
+
+/**
+ * Decoder state, window included; a copy of it continues the stream after
+ * a reboot (stored in the OTA checkpoint).
+ */
+typedef struct {
+    uint8_t phase;
+    uint8_t header_len;
+    uint8_t window_bits;
+    uint8_t lookahead_bits;
+    uint8_t header[OTA_LZ_HEADER_SIZE];
+    uint8_t byte;                       // Input byte being read
+    uint8_t bit_mask;                   // Its next bit, 0 once used up
+    uint8_t bits_left;                  // Of the field being read
+    uint16_t value;                     // Field being read
+    uint16_t offset;                    // Back-reference being copied
+    uint16_t count;
+    uint16_t head;                      // Next window position
+    uint32_t out_pos;
+    uint32_t out_size;
+    uint8_t window[OTA_LZ_WINDOW_MAX];
+} ota_lz_t;
+
+void ota_lz_init(ota_lz_t *lz);
+
+/**
+ * Take up to `in_len` compressed bytes and produce up to `out_len`
+ * decompressed ones. Returns with `*in_used` < `in_len` only when the
+ * output is full or the stream has ended.
+ */
+esp_err_t ota_lz_decode(ota_lz_t *lz, const uint8_t *in, size_t in_len, size_t *in_used,
+                        uint8_t *out, size_t out_len, size_t *out_used);
+
+/**
+ * Decompressed size, 0 until the header is in.
+ */
+uint32_t ota_lz_output_size(const ota_lz_t *lz);
+
+/**
+ * True once the whole decompressed size has been produced.
+ */
+bool ota_lz_done(const ota_lz_t *lz);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Burst Oversampling
+ */
+
+#include "oversample.h"
+
+// ========================================
+// Public API
+// ========================================
+
+void oversample_reset(oversample_t *acc)
+{
+    acc->sum = 0;
+    acc->min = INT32_MAX;
+    acc->max = INT32_MIN;
+    acc->count = 0;
+}
+
+void oversample_add(oversample_t *acc, int32_t value)
+{
+    if (acc->count >= OVERSAMPLE_MAX) {
+        return;
+    }
+    acc->sum += value;
+    if (value < acc->min) {
+        acc->min = value;
+    }
+    if (value > acc->max) {
+        acc->max = value;
+    }
+    acc->count++;
+}
+
+bool oversample_mean(const oversample_t *acc, int32_t *mean)
+{
+    if (acc->count == 0) {
+        return false;
+    }
+
+    int64_t sum = acc->sum;
+    int32_t n = acc->count;
+    if (n >= OVERSAMPLE_TRIM_FROM) {
+        sum -= (int64_t)acc->min + acc->max;
+        n -= 2;
+    }
+
+    // Round half away from zero
+    int64_t half = n / 2;
+    *mean = (int32_t)(sum >= 0 ? (sum + half) / n : (sum - half) / n);
+    return true;
+}
+
+bool oversample_dithered(const oversample_t *acc, int32_t quantum)
+{
+    return acc->count > 1 && (int64_t)acc->max - acc->min >= quantum;
+}
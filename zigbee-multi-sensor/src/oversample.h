@@ -0,0 +1,56 @@
+/*
+ * Burst Oversampling
+ *
+ * Accumulates K reads taken back to back (at the sensor's minimum read
+ * interval) and reduces them to one value per reporting period. Averaging
+ * only adds resolution when the input is dithered, i.e. noise moves the
+ * quantised reading across at least one step during the burst; a burst with
+ * no spread is reported as the plain quantised value and flagged, so a
+ * fractional digit is never claimed that the sensor did not provide.
+ *
+ * With OVERSAMPLE_TRIM_FROM or more samples the lowest and highest are
+ * dropped before averaging, so one bad read in a burst cannot pull the mean.
+ *
+ * Values are integers in the channel's own fixed-point unit (0.01 °C, 0.01
+ * lux, ...). No ESP-IDF dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OVERSAMPLE_MAX                  16
+#define OVERSAMPLE_TRIM_FROM            4
+
+typedef struct {
+    int64_t sum;
+    int32_t min, max;
+    uint8_t count;
+} oversample_t;
+
+void oversample_reset(oversample_t *acc);
+
+/**
+ * Add one read. Reads beyond OVERSAMPLE_MAX are ignored.
+ */
+void oversample_add(oversample_t *acc, int32_t value);
+
+/**
+ * Rounded (trimmed) mean of the burst. Returns false if the burst is empty.
+ */
+bool oversample_mean(const oversample_t *acc, int32_t *mean);
+
+/**
+ * True if the reads in the burst spread over at least one quantisation step
+ * (`quantum`, in the same unit), so the mean carries real sub-step detail.
+ */
+bool oversample_dithered(const oversample_t *acc, int32_t quantum);
+
+#ifdef __cplusplus
+}
+#endif
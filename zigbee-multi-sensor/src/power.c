@@ -0,0 +1,189 @@
+/*
+ * Power Management
+ *
+ * Each lock wraps one esp_pm lock and counts how often and how long it is
+ * held; light sleep is counted by the esp_pm exit callback, which gets the
+ * time actually slept.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "power.h"
+
+typedef struct {
+    esp_pm_lock_type_t type;
+    const char *name;
+} power_lock_def_t;
+
+typedef struct {
+    esp_pm_lock_handle_t handle;        // NULL without CONFIG_PM_ENABLE
+    uint16_t depth;
+    int64_t since_us;
+    uint32_t acquired;
+    uint64_t held_us;
+} power_lock_state_t;
+
+static const char *TAG = "POWER";
+
+static const power_lock_def_t lock_defs[POWER_LOCK_COUNT] = {
+    [POWER_LOCK_TIMING] = { ESP_PM_CPU_FREQ_MAX, "timing" },
+    [POWER_LOCK_RADIO] = { ESP_PM_NO_LIGHT_SLEEP, "radio" },
+};
+
+// Guards the lock states and sleep counters; taken in the sleep callback too
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static power_lock_state_t locks[POWER_LOCK_COUNT];
+static uint32_t sleeps = 0;
+static uint64_t sleep_us = 0;
+static bool pm_enabled = false;
+
+#if CONFIG_PM_ENABLE && CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+static esp_err_t IRAM_ATTR on_light_sleep_exit(int64_t slept_us, void *arg)
+{
+    taskENTER_CRITICAL_ISR(&stats_lock);
+    sleeps++;
+    sleep_us += slept_us;
+    taskEXIT_CRITICAL_ISR(&stats_lock);
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_PM_ENABLE
+static esp_err_t create_locks(void)
+{
+    for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+        esp_err_t ret = esp_pm_lock_create(lock_defs[i].type, 0, lock_defs[i].name, &locks[i].handle);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t configure(void)
+{
+    esp_pm_config_t config = {
+        .max_freq_mhz = POWER_MAX_FREQ_MHZ,
+        .min_freq_mhz = POWER_MIN_FREQ_MHZ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    esp_err_t ret = esp_pm_configure(&config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs = {
+        .exit_cb = on_light_sleep_exit,
+    };
+    ret = esp_pm_light_sleep_register_cbs(&cbs);
+#endif
+    return ret;
+}
+#endif
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t power_init(void)
+{
+    esp_err_t ret = ESP_OK;
+
+#if CONFIG_PM_ENABLE
+    ret = create_locks();
+#endif
+
+#if CONFIG_ZB_ZCZR
+    // Routers keep the receiver on (rx-on-when-idle): held for good, and
+    // taken before light sleep is allowed
+    power_lock(POWER_LOCK_RADIO);
+#endif
+
+#if CONFIG_PM_ENABLE
+    if (ret == ESP_OK) {
+        ret = configure();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Power management setup failed (%s)", esp_err_to_name(ret));
+        return ret;
+    }
+    pm_enabled = true;
+
+    power_stats_t stats;
+    power_get_stats(&stats);
+    ESP_LOGI(TAG, "DFS %d-%d MHz, light sleep %s", POWER_MIN_FREQ_MHZ, POWER_MAX_FREQ_MHZ,
+             stats.light_sleep ? "on" : "off (receiver stays on)");
+#else
+    ESP_LOGW(TAG, "CONFIG_PM_ENABLE not set, CPU stays at %d MHz", POWER_MAX_FREQ_MHZ);
+#endif
+    return ret;
+}
+
+void power_lock(power_lock_t lock)
+{
+    power_lock_state_t *l = &locks[lock];
+
+    if (l->handle != NULL) {
+        esp_pm_lock_acquire(l->handle);
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    if (l->depth++ == 0) {
+        l->since_us = esp_timer_get_time();
+        l->acquired++;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+void power_unlock(power_lock_t lock)
+{
+    power_lock_state_t *l = &locks[lock];
+    bool held;
+
+    taskENTER_CRITICAL(&stats_lock);
+    held = l->depth > 0;
+    if (held && --l->depth == 0) {
+        l->held_us += esp_timer_get_time() - l->since_us;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+
+    if (held && l->handle != NULL) {
+        esp_pm_lock_release(l->handle);
+    }
+}
+
+void power_get_stats(power_stats_t *stats)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats->enabled = pm_enabled;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    stats->light_sleep = pm_enabled && locks[POWER_LOCK_RADIO].depth == 0;
+#else
+    stats->light_sleep = false;
+#endif
+    stats->uptime_ms = (uint32_t)(now_us / 1000);
+    stats->sleeps = sleeps;
+    stats->sleep_ms = (uint32_t)(sleep_us / 1000);
+    for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+        const power_lock_state_t *l = &locks[i];
+        uint64_t held_us = l->held_us + (l->depth > 0 ? now_us - l->since_us : 0);
+        stats->locks[i].acquired = l->acquired;
+        stats->locks[i].held_ms = (uint32_t)(held_us / 1000);
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+const char *power_lock_name(power_lock_t lock)
+{
+    return lock < POWER_LOCK_COUNT ? lock_defs[lock].name : "?";
+}
@@ -0,0 +1,76 @@
+/*
+ * Power Management
+ *
+ * Configures esp_pm for dynamic frequency scaling (the CPU runs at
+ * POWER_MAX_FREQ_MHZ while a task is running and drops to the XTAL
+ * frequency when idle) and automatic light sleep (tickless idle sleeps
+ * until the next task deadline, which for this firmware is mostly the next
+ * sensor sample). Both need CONFIG_PM_ENABLE (sdkconfig.defaults); without
+ * it the locks below still keep their statistics.
+ *
+ * The rest of the firmware does not use esp_pm locks directly but takes
+ * these, so the time spent under each can be reported:
+ *   POWER_LOCK_TIMING   CPU at full speed, no light sleep: bit-banged
+ *                       1-Wire and DHT11 transactions (sensors.c), so no
+ *                       clock switch or sleep wake-up lands inside a slot
+ *   POWER_LOCK_RADIO    no light sleep: the receiver must stay on. A router
+ *                       (CONFIG_ZB_ZCZR) holds it from power_init() on,
+ *                       since neighbours may send at any time, so it only
+ *                       gets DFS
+ *
+ * The `power` console command prints the statistics and, with
+ * CONFIG_PM_PROFILING, esp_pm's time in each mode and every driver lock.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define POWER_MAX_FREQ_MHZ              160     // board_build.f_cpu
+#define POWER_MIN_FREQ_MHZ              40      // XTAL
+
+typedef enum {
+    POWER_LOCK_TIMING = 0,
+    POWER_LOCK_RADIO,
+    POWER_LOCK_COUNT,
+} power_lock_t;
+
+typedef struct {
+    uint32_t acquired;                  // Times taken while free
+    uint32_t held_ms;                   // Total, including a hold in progress
+} power_lock_stats_t;
+
+typedef struct {
+    bool enabled;                       // esp_pm configured
+    bool light_sleep;                   // Automatic light sleep allowed
+    uint32_t uptime_ms;
+    uint32_t sleeps;                    // Light sleep entries
+    uint32_t sleep_ms;                  // Time in light sleep
+    power_lock_stats_t locks[POWER_LOCK_COUNT];
+} power_stats_t;
+
+/**
+ * Configure DFS and light sleep and create the locks. Call early in
+ * app_main(), before any task that takes a lock.
+ */
+esp_err_t power_init(void);
+
+/**
+ * Take or release a lock; both nest and may be called from any task.
+ */
+void power_lock(power_lock_t lock);
+void power_unlock(power_lock_t lock);
+
+void power_get_stats(power_stats_t *stats);
+
+const char *power_lock_name(power_lock_t lock);
+
+#ifdef __cplusplus
+}
+#endif
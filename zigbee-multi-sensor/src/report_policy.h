@@ -0,0 +1,44 @@
+/*
+ * Sensor Schedule and Reporting Policy
+ *
+ * The constants that decide how much traffic one device puts on the
+ * network: sensor read intervals, the default reporting mode and the
+ * steering retry delay. Shared with the fleet simulator (fleet_sim/), which
+ * runs many copies of this policy against a shared channel model, so keep
+ * this header free of ESP-IDF includes.
+ */
+
+#pragma once
+
+// Reporting Mode Configuration
+// EXPLICIT: Immediate reports every sensor read (high traffic, instant updates)
+// AUTOMATIC: Reports based on HA intervals/thresholds (efficient, 30s-15min delay)
+// The EP14 switch changes the mode at runtime; this is the boot default.
+#define REPORTING_MODE_EXPLICIT         1
+#define REPORTING_MODE_AUTOMATIC        2
+#define ZIGBEE_REPORTING_MODE           REPORTING_MODE_EXPLICIT  // Change to REPORTING_MODE_AUTOMATIC for lower traffic
+
+// Sensor update intervals (milliseconds)
+#define BH1750_UPDATE_INTERVAL          30000   // 30 seconds
+#define DS18B20_UPDATE_INTERVAL         60000   // 60 seconds
+#define DHT11_UPDATE_INTERVAL           60000   // 60 seconds
+#define SHT4X_UPDATE_INTERVAL           60000   // 60 seconds
+#define BME280_UPDATE_INTERVAL          60000   // 60 seconds
+
+// Oversampling: reads per update, one sensor minimum interval apart and
+// averaged into a single report (1 = single-shot). The burst fits inside
+// the update interval, so the reporting rate does not change.
+#define BH1750_OVERSAMPLE               4
+#define DHT11_OVERSAMPLE                4
+
+// DHT11 settling time after power-on, before the first read
+#define DHT11_STARTUP_DELAY_MS          2000
+
+// Delay before retrying failed network steering (milliseconds)
+#define ZB_STEERING_RETRY_MS            3000
+
+// Sleepy end device build (CONFIG_ZB_ZED, see zb_sleep.h): reports are
+// queued and sent in one burst per window; the parent is polled for
+// commands every long poll in between
+#define ZB_SED_REPORT_WINDOW_MS         60000   // 60 seconds
+#define ZB_SED_LONG_POLL_MS             30000   // 30 seconds
@@ -0,0 +1,386 @@
+/*
+ * Report Delivery Tracker
+ *
+ * Pending reports are matched to APS confirms by source endpoint and TSN.
+ * The send-status message carries the TSN but not the cluster, so the
+ * sender records the TSN the stack is about to give the report. Confirms
+ * that match nothing (automatic reports, other commands) are only counted.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "zb_diagnostics.h"
+#include "report_tracker.h"
+
+#define ZCL_CMD_REPORT_ATTRIB       0x0A    // ZCL general "Report Attributes"
+#define RECENT_TSN_COUNT            8       // Acked reports awaiting a Default Response
+
+static const char *TAG = "REPORT_TRK";
+
+typedef struct {
+    bool in_use;
+    uint8_t endpoint;
+    uint8_t tsn;
+    uint16_t cluster_id;
+    int64_t enqueued_us;
+} pending_report_t;
+
+typedef struct {
+    uint8_t endpoint;
+    uint8_t tsn;
+} recent_tsn_t;
+
+static portMUX_TYPE tracker_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static pending_report_t pending[REPORT_TRACKER_MAX_PENDING];
+static report_tracker_stats_t stats[REPORT_TRACKER_MAX_ENDPOINTS];
+static uint8_t stats_count = 0;
+
+static recent_tsn_t recent[RECENT_TSN_COUNT];
+static uint8_t recent_next = 0;
+static uint8_t recent_count = 0;
+
+// Ring saved by report_tracker_save_tsns() for the benchmark
+static recent_tsn_t saved_recent[RECENT_TSN_COUNT];
+static uint8_t saved_next = 0;
+static uint8_t saved_count = 0;
+
+// Confirms that did not belong to a tracked report
+static uint32_t untracked_ok = 0;
+static uint32_t untracked_fail = 0;
+
+static int64_t last_publish_us = 0;
+
+// ========================================
+// Internal Helpers (tracker_lock held)
+// ========================================
+
+static report_tracker_stats_t *stats_for(uint8_t endpoint, bool create)
+{
+    for (int i = 0; i < stats_count; i++) {
+        if (stats[i].endpoint == endpoint) {
+            return &stats[i];
+        }
+    }
+    if (!create || stats_count >= REPORT_TRACKER_MAX_ENDPOINTS) {
+        return NULL;
+    }
+
+    report_tracker_stats_t *s = &stats[stats_count++];
+    memset(s, 0, sizeof(*s));
+    s->endpoint = endpoint;
+    return s;
+}
+
+static void expire_pending(int64_t now_us)
+{
+    for (int i = 0; i < REPORT_TRACKER_MAX_PENDING; i++) {
+        pending_report_t *p = &pending[i];
+        if (p->in_use && now_us - p->enqueued_us > REPORT_TRACKER_TIMEOUT_MS * 1000LL) {
+            report_tracker_stats_t *s = stats_for(p->endpoint, false);
+            if (s) {
+                s->lost++;
+            }
+            p->in_use = false;
+        }
+    }
+}
+
+static pending_report_t *find_pending(uint8_t endpoint, uint8_t tsn)
+{
+    for (int i = 0; i < REPORT_TRACKER_MAX_PENDING; i++) {
+        pending_report_t *p = &pending[i];
+        if (p->in_use && p->endpoint == endpoint && p->tsn == tsn) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static void remember_tsn(uint8_t endpoint, uint8_t tsn)
+{
+    recent[recent_next].endpoint = endpoint;
+    recent[recent_next].tsn = tsn;
+    recent_next = (recent_next + 1) % RECENT_TSN_COUNT;
+    if (recent_count < RECENT_TSN_COUNT) {
+        recent_count++;
+    }
+}
+
+static bool forget_tsn(uint8_t endpoint, uint8_t tsn)
+{
+    for (int i = 0; i < recent_count; i++) {
+        if (recent[i].endpoint == endpoint && recent[i].tsn == tsn) {
+            recent[i].endpoint = 0;     // Endpoint 0 is never a report source
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool has_tsn(const recent_tsn_t *ring, uint8_t count, uint8_t endpoint, uint8_t tsn)
+{
+    for (int i = 0; i < count; i++) {
+        if (ring[i].endpoint == endpoint && ring[i].tsn == tsn) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void put_u16(uint8_t **p, uint32_t value)
+{
+    if (value > UINT16_MAX) {
+        value = UINT16_MAX;
+    }
+    *(*p)++ = value & 0xFF;
+    *(*p)++ = value >> 8;
+}
+
+// ========================================
+// Publishing (Zigbee task context)
+// ========================================
+
+static void publish_stats(void)
+{
+    static uint8_t buf[2 + REPORT_TRACKER_MAX_ENDPOINTS * REPORT_TRACKER_ENTRY_SIZE];
+    uint8_t *p = buf;
+
+    portENTER_CRITICAL(&tracker_lock);
+    *p++ = REPORT_TRACKER_FORMAT_VERSION;
+    *p++ = stats_count;
+    for (int i = 0; i < stats_count; i++) {
+        const report_tracker_stats_t *s = &stats[i];
+        *p++ = s->endpoint;
+        put_u16(&p, s->sent);
+        put_u16(&p, s->acked);
+        put_u16(&p, s->failed);
+        put_u16(&p, s->lost);
+        put_u16(&p, s->rejected);
+        put_u16(&p, log_histogram_percentile(&s->latency_ms, 50));
+        put_u16(&p, log_histogram_percentile(&s->latency_ms, 95));
+        put_u16(&p, log_histogram_percentile(&s->latency_ms, 99));
+    }
+    portEXIT_CRITICAL(&tracker_lock);
+
+    zb_diagnostics_set_octet_string(ZB_DIAG_ATTR_REPORT_STATS, buf, (uint8_t)(p - buf));
+}
+
+static void send_status_handler(esp_zb_zcl_command_send_status_message_t message)
+{
+    report_tracker_confirm(message.src_endpoint, message.tsn, message.status);
+
+    int64_t now_us = esp_timer_get_time();
+    if (now_us - last_publish_us >= REPORT_TRACKER_PUBLISH_MS * 1000LL) {
+        last_publish_us = now_us;
+        publish_stats();
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+void report_tracker_init(void)
+{
+    memset(pending, 0, sizeof(pending));
+    esp_zb_zcl_command_send_status_handler_register(send_status_handler);
+}
+
+void report_tracker_enqueue(uint8_t endpoint, uint16_t cluster_id, uint8_t tsn)
+{
+    int64_t now_us = esp_timer_get_time();
+    bool dropped = false;
+
+    portENTER_CRITICAL(&tracker_lock);
+    expire_pending(now_us);
+
+    report_tracker_stats_t *s = stats_for(endpoint, true);
+    if (s) {
+        s->sent++;
+    }
+
+    pending_report_t *slot = NULL;
+    for (int i = 0; i < REPORT_TRACKER_MAX_PENDING; i++) {
+        if (!pending[i].in_use) {
+            slot = &pending[i];
+            break;
+        }
+    }
+    if (slot) {
+        slot->in_use = true;
+        slot->endpoint = endpoint;
+        slot->tsn = tsn;
+        slot->cluster_id = cluster_id;
+        slot->enqueued_us = now_us;
+    } else {
+        // Table full: the stack is not confirming, so this one is as good as lost
+        if (s) {
+            s->lost++;
+        }
+        dropped = true;
+    }
+    portEXIT_CRITICAL(&tracker_lock);
+
+    if (dropped) {
+        ESP_LOGW(TAG, "Pending table full, EP%u report 0x%04x untracked", endpoint, cluster_id);
+    }
+}
+
+void report_tracker_confirm(uint8_t endpoint, uint8_t tsn, esp_err_t status)
+{
+    int64_t now_us = esp_timer_get_time();
+    bool ok = (status == ESP_OK);
+
+    portENTER_CRITICAL(&tracker_lock);
+    expire_pending(now_us);
+
+    pending_report_t *p = find_pending(endpoint, tsn);
+    if (p) {
+        report_tracker_stats_t *s = stats_for(p->endpoint, false);
+        if (s && ok) {
+            s->acked++;
+            log_histogram_add(&s->latency_ms, (uint32_t)((now_us - p->enqueued_us) / 1000));
+            remember_tsn(p->endpoint, tsn);
+        } else if (s) {
+            s->failed++;
+        }
+        p->in_use = false;
+    } else if (ok) {
+        untracked_ok++;
+    } else {
+        untracked_fail++;
+    }
+    portEXIT_CRITICAL(&tracker_lock);
+
+    if (!ok) {
+        ESP_LOGW(TAG, "Report from EP%u (TSN %u) not delivered: %s",
+                 endpoint, tsn, esp_err_to_name(status));
+    }
+}
+
+void report_tracker_default_response(const esp_zb_zcl_cmd_default_resp_message_t *msg)
+{
+    if (msg->resp_to_cmd != ZCL_CMD_REPORT_ATTRIB) {
+        return;
+    }
+
+    bool tracked;
+    portENTER_CRITICAL(&tracker_lock);
+    tracked = forget_tsn(msg->info.dst_endpoint, msg->info.header.tsn);
+    if (tracked && msg->status_code != ESP_ZB_ZCL_STATUS_SUCCESS) {
+        report_tracker_stats_t *s = stats_for(msg->info.dst_endpoint, false);
+        if (s) {
+            s->rejected++;
+        }
+    }
+    portEXIT_CRITICAL(&tracker_lock);
+
+    if (tracked && msg->status_code != ESP_ZB_ZCL_STATUS_SUCCESS) {
+        ESP_LOGW(TAG, "Report from EP%u (TSN %u) rejected, status 0x%02x",
+                 msg->info.dst_endpoint, msg->info.header.tsn, msg->status_code);
+    }
+}
+
+void report_tracker_forget_endpoint(uint8_t endpoint)
+{
+    portENTER_CRITICAL(&tracker_lock);
+    for (int i = 0; i < REPORT_TRACKER_MAX_PENDING; i++) {
+        if (pending[i].endpoint == endpoint) {
+            pending[i].in_use = false;
+        }
+    }
+    for (int i = 0; i < recent_count; i++) {
+        if (recent[i].endpoint == endpoint) {
+            recent[i].endpoint = 0;
+        }
+    }
+    for (int i = 0; i < stats_count; i++) {
+        if (stats[i].endpoint == endpoint) {
+            memmove(&stats[i], &stats[i + 1], (stats_count - i - 1) * sizeof(stats[0]));
+            stats_count--;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&tracker_lock);
+}
+
+void report_tracker_save_tsns(void)
+{
+    portENTER_CRITICAL(&tracker_lock);
+    memcpy(saved_recent, recent, sizeof(saved_recent));
+    saved_next = recent_next;
+    saved_count = recent_count;
+    portEXIT_CRITICAL(&tracker_lock);
+}
+
+void report_tracker_restore_tsns(void)
+{
+    recent_tsn_t current[RECENT_TSN_COUNT];
+
+    portENTER_CRITICAL(&tracker_lock);
+    // Oldest first, so real reports acked during the run stay the newest
+    uint8_t count = recent_count;
+    uint8_t start = (recent_count < RECENT_TSN_COUNT) ? 0 : recent_next;
+    for (int i = 0; i < count; i++) {
+        current[i] = recent[(start + i) % RECENT_TSN_COUNT];
+    }
+
+    memcpy(recent, saved_recent, sizeof(recent));
+    recent_next = saved_next;
+    recent_count = saved_count;
+    for (int i = 0; i < count; i++) {
+        if (current[i].endpoint != 0 &&
+            !has_tsn(saved_recent, saved_count, current[i].endpoint, current[i].tsn)) {
+            remember_tsn(current[i].endpoint, current[i].tsn);
+        }
+    }
+    portEXIT_CRITICAL(&tracker_lock);
+}
+
+bool report_tracker_get_stats(uint8_t endpoint, report_tracker_stats_t *stats_out)
+{
+    portENTER_CRITICAL(&tracker_lock);
+    const report_tracker_stats_t *s = stats_for(endpoint, false);
+    if (s) {
+        *stats_out = *s;
+    }
+    portEXIT_CRITICAL(&tracker_lock);
+    return s != NULL;
+}
+
+void report_tracker_print_stats(void)
+{
+    report_tracker_stats_t copy[REPORT_TRACKER_MAX_ENDPOINTS];
+    uint8_t count;
+    uint32_t other_ok, other_fail;
+
+    portENTER_CRITICAL(&tracker_lock);
+    expire_pending(esp_timer_get_time());
+    count = stats_count;
+    memcpy(copy, stats, sizeof(copy));
+    other_ok = untracked_ok;
+    other_fail = untracked_fail;
+    portEXIT_CRITICAL(&tracker_lock);
+
+    ESP_LOGI(TAG, "Report delivery (explicit reports):");
+    for (int i = 0; i < count; i++) {
+        const report_tracker_stats_t *s = &copy[i];
+        uint32_t done = s->acked + s->failed + s->lost;
+        uint32_t pct10 = done ? (s->acked * 1000) / done : 0;
+
+        ESP_LOGI(TAG, "  EP%-2u sent %lu  ack %lu (%lu.%lu%%)  fail %lu  lost %lu  rej %lu  "
+                 "latency p50/p95/p99: %lu/%lu/%lu ms (max %lu)",
+                 s->endpoint, (unsigned long)s->sent, (unsigned long)s->acked,
+                 (unsigned long)(pct10 / 10), (unsigned long)(pct10 % 10),
+                 (unsigned long)s->failed, (unsigned long)s->lost, (unsigned long)s->rejected,
+                 (unsigned long)log_histogram_percentile(&s->latency_ms, 50),
+                 (unsigned long)log_histogram_percentile(&s->latency_ms, 95),
+                 (unsigned long)log_histogram_percentile(&s->latency_ms, 99),
+                 (unsigned long)s->latency_ms.max);
+    }
+    ESP_LOGI(TAG, "  Other ZCL frames: %lu ok, %lu failed",
+             (unsigned long)other_ok, (unsigned long)other_fail);
+}
@@ -0,0 +1,102 @@
+/*
+ * Report Delivery Tracker
+ *
+ * Follows every explicit attribute report from enqueue to delivery:
+ *   1. report_tracker_enqueue() stamps the report and the TSN it will get
+ *      just before it is handed to the stack (esp_zb_zcl_report_attr_cmd_req()).
+ *   2. The ZCL send-status callback (APS confirm) with that endpoint and TSN
+ *      records enqueue→ack latency, or counts the report as failed.
+ *   3. A Default Response from the coordinator carrying a non-success status
+ *      for a tracked TSN counts the report as rejected.
+ *   4. Reports with no confirm after REPORT_TRACKER_TIMEOUT_MS are lost.
+ *
+ * Latency is kept per endpoint in a log-bucket histogram (log_histogram.h).
+ * Summaries are published on the Diagnostics endpoint (attribute 0xF010).
+ *
+ * Report stats attribute (0xF010) layout, little-endian:
+ *   [0]    format version (1)
+ *   [1]    endpoint count
+ *   [2..]  entries, REPORT_TRACKER_ENTRY_SIZE bytes each:
+ *            endpoint (1), sent (2), acked (2), failed (2), lost (2),
+ *            rejected (2), p50 ms (2), p95 ms (2), p99 ms (2)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_zigbee_core.h"
+#include "log_histogram.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REPORT_TRACKER_MAX_PENDING      24      // Reports awaiting APS confirm (one burst of every attribute)
+#define REPORT_TRACKER_MAX_ENDPOINTS    6       // Endpoints with their own stats
+#define REPORT_TRACKER_TIMEOUT_MS       10000   // No confirm after this → lost
+#define REPORT_TRACKER_PUBLISH_MS       60000   // Min interval between attribute updates
+#define REPORT_TRACKER_FORMAT_VERSION   1
+#define REPORT_TRACKER_ENTRY_SIZE       17
+
+typedef struct {
+    uint8_t endpoint;
+    uint32_t sent;          // Reports handed to the stack
+    uint32_t acked;         // APS confirm with success
+    uint32_t failed;        // APS confirm with error (no ack, no route, ...)
+    uint32_t lost;          // No confirm within REPORT_TRACKER_TIMEOUT_MS
+    uint32_t rejected;      // Default Response with non-success status
+    log_histogram_t latency_ms;
+} report_tracker_stats_t;
+
+/**
+ * Register the ZCL send-status handler. Call before esp_zb_start().
+ */
+void report_tracker_init(void);
+
+/**
+ * Record a report about to be sent from `endpoint` with ZCL sequence number
+ * `tsn`. Safe from any task.
+ */
+void report_tracker_enqueue(uint8_t endpoint, uint16_t cluster_id, uint8_t tsn);
+
+/**
+ * Match an APS confirm to the pending report from `endpoint` with `tsn`.
+ * Called by the ZCL send-status handler; exposed for the benchmark suite.
+ */
+void report_tracker_confirm(uint8_t endpoint, uint8_t tsn, esp_err_t status);
+
+/**
+ * Feed a Default Response (ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID) from the
+ * core action handler.
+ */
+void report_tracker_default_response(const esp_zb_zcl_cmd_default_resp_message_t *msg);
+
+/**
+ * Drop all pending reports and statistics for `endpoint` (benchmark cleanup).
+ */
+void report_tracker_forget_endpoint(uint8_t endpoint);
+
+/**
+ * Save the ring of acked TSNs awaiting a Default Response, and put it back
+ * after a benchmark run so the run's fake TSNs do not evict real ones.
+ * Reports acked during the run are kept, as the newest entries. Call
+ * report_tracker_forget_endpoint() for the benchmark endpoint first.
+ */
+void report_tracker_save_tsns(void);
+void report_tracker_restore_tsns(void);
+
+/**
+ * Copy the statistics of `endpoint` into `stats`. Returns false if it has
+ * not sent anything.
+ */
+bool report_tracker_get_stats(uint8_t endpoint, report_tracker_stats_t *stats);
+
+/**
+ * Print per-endpoint delivery and latency summary.
+ */
+void report_tracker_print_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
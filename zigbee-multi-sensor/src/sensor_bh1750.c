@@ -0,0 +1,156 @@
+/*
+ * BH1750 Illuminance Driver (EP12)
+ *
+ * Probe is the I2C address ACK during bh1750_init(). Each update wakes the
+ * part, takes a burst of BH1750_OVERSAMPLE reads one measurement apart and
+ * powers it down again until the next burst.
+ */
+
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "sensors.h"
+#include "sensor_codec.h"
+#include "sensor_filter.h"
+#include "oversample.h"
+#include "report_policy.h"
+#include "app_config.h"
+#include "telemetry.h"
+#include "tlog.h"
+#include "zb_report.h"
+#include "sensor_registry.h"
+
+#define BH1750_QUANTUM                  83      // One count = 1/1.2 lux, in 0.01 units
+
+// Time a burst spends between its reads; taken off the update interval so
+// the reporting period does not change (shortest configurable one included)
+#define BH1750_BURST_SPACING_MS         ((BH1750_OVERSAMPLE - 1) * BH1750_MEASUREMENT_MS)
+
+_Static_assert(BH1750_OVERSAMPLE >= 1 && BH1750_OVERSAMPLE <= OVERSAMPLE_MAX, "BH1750_OVERSAMPLE out of range");
+_Static_assert(BH1750_BURST_SPACING_MS < APP_CONFIG_INTERVAL_MIN_S * 1000, "BH1750 burst longer than its interval");
+
+static const char *TAG = "BH1750";
+
+// Lux in 0.1 units
+static const sensor_filter_config_t light_filter_cfg = {
+    .median_window = 1,                 // Light steps are real; report them at once
+    .ema_shift = 0,
+    .min = 0, .max = 655350,            // 65535 lux
+};
+
+static sensor_filter_t light_filter;
+
+// ========================================
+// Internal Helpers
+// ========================================
+
+/**
+ * Wake, take BH1750_OVERSAMPLE reads one measurement apart and power down
+ * again. Succeeds if any read did.
+ */
+static esp_err_t read_burst(float *lux)
+{
+    oversample_t acc;
+    oversample_reset(&acc);
+
+    esp_err_t ret = bh1750_wake();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    for (int k = 0; k < BH1750_OVERSAMPLE; k++) {
+        if (k > 0) {
+            vTaskDelay(pdMS_TO_TICKS(BH1750_MEASUREMENT_MS));
+        }
+        float sample;
+        ret = bh1750_read_light(&sample);
+        if (ret == ESP_OK) {
+            oversample_add(&acc, (int32_t)lroundf(sample * 100.0f));
+        }
+    }
+    bh1750_sleep();
+
+    int32_t mean;
+    if (!oversample_mean(&acc, &mean)) {
+        return ret;
+    }
+    if (acc.count > 1 && !oversample_dithered(&acc, BH1750_QUANTUM)) {
+        ESP_LOGD(TAG, "Burst without dither, resolution stays 1 count");
+    }
+    *lux = mean / 100.0f;
+    return ESP_OK;
+}
+
+// ========================================
+// Driver
+// ========================================
+
+static esp_err_t probe(void)
+{
+    esp_err_t ret = bh1750_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    sensor_filter_init(&light_filter, &light_filter_cfg);
+    // Powered down until the first burst
+    return bh1750_sleep();
+}
+
+static void add_clusters(esp_zb_cluster_list_t *clusters)
+{
+    esp_zb_illuminance_meas_cluster_cfg_t illum_cfg = {
+        .measured_value = ZB_ILLUM_INVALID,
+        .min_value = ZB_ILLUM_MIN,
+        .max_value = ZB_ILLUM_MAX,
+    };
+    esp_zb_cluster_list_add_illuminance_meas_cluster(clusters, esp_zb_illuminance_meas_cluster_create(&illum_cfg),
+                                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+static esp_err_t sample(void)
+{
+    float lux_float;
+    esp_err_t ret = read_burst(&lux_float);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Read failed (%s)", esp_err_to_name(ret));
+        sensor_registry_flash_failed();
+        return ret;
+    }
+
+    if (!sensor_registry_filter(&light_filter, "BH1750", lux_float, 10.0f, &lux_float)) {
+        return ESP_OK;
+    }
+
+    // ZCL MeasuredValue = 10000 × log10(lux) + 1
+    uint16_t lux_value = sensor_codec_lux_to_zcl(lux_float);
+
+    zb_report_attribute(EP_BH1750_LIGHT, ESP_ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT,
+                        ESP_ZB_ZCL_ATTR_ILLUMINANCE_MEASUREMENT_MEASURED_VALUE_ID, &lux_value);
+
+    // monitor.py decodes the telemetry record; the log line is tokenised (no formatting here)
+    telemetry_send_light((uint32_t)(lux_float * 10.0f + 0.5f), lux_value);
+    TLOGI(TAG, "Light: %8.2f lux (ZCL: %u)", lux_float, lux_value);
+
+    sensor_registry_flash_reported();
+    return ESP_OK;
+}
+
+static void report_invalid(void)
+{
+    sensor_registry_report_invalid(EP_BH1750_LIGHT, ESP_ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT);
+}
+
+const sensor_driver_t sensor_driver_bh1750 = {
+    .name = "bh1750",
+    .endpoint = EP_BH1750_LIGHT,
+    .device_id = ESP_ZB_HA_SIMPLE_SENSOR_DEVICE_ID,
+    .location = NULL,
+    .probe = probe,
+    .add_clusters = add_clusters,
+    .sample = sample,
+    .report_invalid = report_invalid,
+    .interval_ms = BH1750_UPDATE_INTERVAL,
+    .burst_ms = BH1750_BURST_SPACING_MS,
+    .stack_size = 4096,
+};
@@ -0,0 +1,136 @@
+/*
+ * BME280 Temperature/Humidity/Pressure Driver (EP17)
+ *
+ * Probe is the boot I2C scan plus the chip ID. Each update is one forced
+ * conversion and one 8-byte burst read of all three results, compensated
+ * with the calibration read at probe time. The part sleeps (~0.1 µA)
+ * between conversions.
+ */
+
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "sensors.h"
+#include "sensor_codec.h"
+#include "sensor_filter.h"
+#include "report_policy.h"
+#include "telemetry.h"
+#include "tlog.h"
+#include "zb_report.h"
+#include "sensor_registry.h"
+
+static const char *TAG = "BME280";
+
+static const sensor_filter_config_t temp_filter_cfg = {
+    .median_window = 3,
+    .ema_shift = 0,
+    .min = -4000, .max = 8500,          // Datasheet range
+    .max_slew_per_s = 5,                // 3 °C/min
+};
+
+static const sensor_filter_config_t humidity_filter_cfg = {
+    .median_window = 3,
+    .ema_shift = 1,                     // ±3 %RH part, noisier than the SHT4x
+    .min = 0, .max = 10000,
+    .max_slew_per_s = 10,               // 6 %/min
+};
+
+// Pa
+static const sensor_filter_config_t pressure_filter_cfg = {
+    .median_window = 3,
+    .ema_shift = 1,
+    .min = 30000, .max = 110000,        // Datasheet range
+    .max_slew_per_s = 10,               // 6 hPa/min; weather moves ~1 hPa/h
+};
+
+static sensor_filter_t temp_filter;
+static sensor_filter_t humidity_filter;
+static sensor_filter_t pressure_filter;
+
+static const sensor_climate_t climate = {
+    .endpoint = EP_BME280_INDOOR,
+    .tag = "BME280",
+    .temp_name = "BME280 temp",
+    .humidity_name = "BME280 humidity",
+    .temp_filter = &temp_filter,
+    .humidity_filter = &humidity_filter,
+    .temp_channel = CALIBRATION_BME280_TEMPERATURE,
+    .humidity_channel = CALIBRATION_BME280_HUMIDITY,
+    .telemetry_sensor = TELEM_SENSOR_BME280,
+};
+
+// ========================================
+// Driver
+// ========================================
+
+static esp_err_t probe(void)
+{
+    esp_err_t ret = bme280_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    sensor_filter_init(&temp_filter, &temp_filter_cfg);
+    sensor_filter_init(&humidity_filter, &humidity_filter_cfg);
+    sensor_filter_init(&pressure_filter, &pressure_filter_cfg);
+    return ESP_OK;
+}
+
+static void add_clusters(esp_zb_cluster_list_t *clusters)
+{
+    sensor_registry_add_climate_clusters(clusters);
+
+    esp_zb_pressure_meas_cluster_cfg_t pressure_cfg = {
+        .measured_value = (int16_t)ZB_PRESSURE_INVALID,
+        .min_value = ZB_PRESSURE_MIN,
+        .max_value = ZB_PRESSURE_MAX,
+    };
+    esp_zb_cluster_list_add_pressure_meas_cluster(clusters, esp_zb_pressure_meas_cluster_create(&pressure_cfg),
+                                                  ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+static esp_err_t sample(void)
+{
+    float temp_celsius, humidity_percent, pressure_pa;
+    esp_err_t ret = bme280_read(&temp_celsius, &humidity_percent, &pressure_pa);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Read failed (%s)", esp_err_to_name(ret));
+        sensor_registry_flash_failed();
+        return ret;
+    }
+
+    sensor_registry_report_climate(&climate, temp_celsius, humidity_percent);
+
+    if (sensor_registry_filter(&pressure_filter, "BME280 pressure", pressure_pa, 1.0f, &pressure_pa)) {
+        // hPa (10 × kPa), clamped to valid range
+        int16_t pressure_value = sensor_codec_pa_to_zcl(pressure_pa);
+
+        zb_report_attribute(EP_BME280_INDOOR, ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT,
+                            ESP_ZB_ZCL_ATTR_PRESSURE_MEASUREMENT_VALUE_ID, &pressure_value);
+
+        telemetry_send_pressure(TELEM_SENSOR_BME280, (uint32_t)lroundf(pressure_pa));
+        TLOGI(TAG, "Press: %7.1f hPa", pressure_pa / 100.0f);
+    }
+
+    sensor_registry_flash_reported();
+    return ESP_OK;
+}
+
+static void report_invalid(void)
+{
+    sensor_registry_report_climate_invalid(EP_BME280_INDOOR);
+    sensor_registry_report_invalid(EP_BME280_INDOOR, ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT);
+}
+
+const sensor_driver_t sensor_driver_bme280 = {
+    .name = "bme280",
+    .endpoint = EP_BME280_INDOOR,
+    .device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
+    .location = "Indoor",
+    .probe = probe,
+    .add_clusters = add_clusters,
+    .sample = sample,
+    .report_invalid = report_invalid,
+    .interval_ms = BME280_UPDATE_INTERVAL,
+    .stack_size = 4096,
+};
@@ -0,0 +1,237 @@
+/*
+ * Sensor Data Codecs
+ *
+ * Conversions moved out of sensors.c and the main.c sensor tasks. Range
+ * clamping happens before the float to integer cast, so out-of-range inputs
+ * saturate instead of wrapping. The DHT11 decode includes the tenths bytes.
+ * The BME280 compensation is the datasheet's integer reference code, so
+ * results match Bosch's to the LSB.
+ */
+
+#include <math.h>
+#include "sensor_codec.h"
+
+// ========================================
+// Raw Frames
+// ========================================
+
+esp_err_t sensor_codec_dht11_decode(const uint8_t frame[DHT11_FRAME_SIZE],
+                                    float *temperature, float *humidity)
+{
+    uint8_t checksum = frame[0] + frame[1] + frame[2] + frame[3];
+    if (checksum != frame[4]) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // Integral parts in frame[0] (humidity) and frame[2] (temperature), tenths
+    // in frame[1] and frame[3]. Older parts always send zero tenths; newer
+    // ones flag sub-zero temperatures with bit 7 of frame[3].
+    *humidity = frame[0] + (frame[1] % 10) / 10.0f;
+    *temperature = frame[2] + ((frame[3] & 0x7F) % 10) / 10.0f;
+    if (frame[3] & 0x80) {
+        *temperature = -*temperature;
+    }
+    return ESP_OK;
+}
+
+uint8_t sensor_codec_sht4x_crc(const uint8_t *word)
+{
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < 2; i++) {
+        crc ^= word[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+esp_err_t sensor_codec_sht4x_decode(const uint8_t frame[SHT4X_FRAME_SIZE],
+                                    float *temperature, float *humidity)
+{
+    if (sensor_codec_sht4x_crc(&frame[0]) != frame[2] || sensor_codec_sht4x_crc(&frame[3]) != frame[5]) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    uint16_t raw_t = (frame[0] << 8) | frame[1];
+    uint16_t raw_rh = (frame[3] << 8) | frame[4];
+
+    *temperature = -45.0f + 175.0f * raw_t / 65535.0f;
+    float rh = -6.0f + 125.0f * raw_rh / 65535.0f;
+    *humidity = rh < 0.0f ? 0.0f : (rh > 100.0f ? 100.0f : rh);
+    return ESP_OK;
+}
+
+void sensor_codec_bme280_calib(const uint8_t tp[BME280_CALIB_TP_SIZE],
+                               const uint8_t h[BME280_CALIB_H_SIZE], bme280_calib_t *calib)
+{
+    // Little-endian words from 0x88; 0xA0 is unused, 0xA1 is dig_H1
+    calib->dig_T1 = (uint16_t)(tp[1] << 8 | tp[0]);
+    calib->dig_T2 = (int16_t)(tp[3] << 8 | tp[2]);
+    calib->dig_T3 = (int16_t)(tp[5] << 8 | tp[4]);
+    calib->dig_P1 = (uint16_t)(tp[7] << 8 | tp[6]);
+    calib->dig_P2 = (int16_t)(tp[9] << 8 | tp[8]);
+    calib->dig_P3 = (int16_t)(tp[11] << 8 | tp[10]);
+    calib->dig_P4 = (int16_t)(tp[13] << 8 | tp[12]);
+    calib->dig_P5 = (int16_t)(tp[15] << 8 | tp[14]);
+    calib->dig_P6 = (int16_t)(tp[17] << 8 | tp[16]);
+    calib->dig_P7 = (int16_t)(tp[19] << 8 | tp[18]);
+    calib->dig_P8 = (int16_t)(tp[21] << 8 | tp[20]);
+    calib->dig_P9 = (int16_t)(tp[23] << 8 | tp[22]);
+    calib->dig_H1 = tp[25];
+
+    // From 0xE1; H4 and H5 are 12-bit and share the nibbles of 0xE5
+    calib->dig_H2 = (int16_t)(h[1] << 8 | h[0]);
+    calib->dig_H3 = h[2];
+    calib->dig_H4 = (int16_t)((int8_t)h[3] * 16 | (h[4] & 0x0F));
+    calib->dig_H5 = (int16_t)((int8_t)h[5] * 16 | (h[4] >> 4));
+    calib->dig_H6 = (int8_t)h[6];
+}
+
+esp_err_t sensor_codec_bme280_compensate(const bme280_calib_t *c,
+                                         const uint8_t data[BME280_DATA_SIZE],
+                                         float *temperature, float *humidity, float *pressure_pa)
+{
+    int32_t adc_p = (int32_t)data[0] << 12 | data[1] << 4 | data[2] >> 4;
+    int32_t adc_t = (int32_t)data[3] << 12 | data[4] << 4 | data[5] >> 4;
+    int32_t adc_h = (int32_t)data[6] << 8 | data[7];
+    if (adc_t == 0x80000 || adc_p == 0x80000 || adc_h == 0x8000) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    // Temperature, 0.01 °C; t_fine feeds the other two
+    int32_t v1 = ((((adc_t >> 3) - ((int32_t)c->dig_T1 << 1))) * c->dig_T2) >> 11;
+    int32_t v2 = (((((adc_t >> 4) - (int32_t)c->dig_T1) * ((adc_t >> 4) - (int32_t)c->dig_T1)) >> 12) *
+                  c->dig_T3) >> 14;
+    int32_t t_fine = v1 + v2;
+    *temperature = ((t_fine * 5 + 128) >> 8) / 100.0f;
+
+    // Pressure, Q24.8 Pa
+    int64_t p1 = (int64_t)t_fine - 128000;
+    int64_t p2 = p1 * p1 * c->dig_P6;
+    p2 += (p1 * c->dig_P5) * ((int64_t)1 << 17);
+    p2 += (int64_t)c->dig_P4 * ((int64_t)1 << 35);
+    p1 = ((p1 * p1 * c->dig_P3) >> 8) + (p1 * c->dig_P2) * ((int64_t)1 << 12);
+    p1 = ((((int64_t)1 << 47) + p1) * c->dig_P1) >> 33;
+    if (p1 == 0) {
+        return ESP_ERR_INVALID_RESPONSE;    // Blank calibration; avoids dividing by zero
+    }
+    int64_t p = 1048576 - adc_p;
+    p = ((p * ((int64_t)1 << 31) - p2) * 3125) / p1;
+    int64_t p9 = ((int64_t)c->dig_P9 * (p >> 13) * (p >> 13)) >> 25;
+    int64_t p8 = ((int64_t)c->dig_P8 * p) >> 19;
+    p = ((p + p9 + p8) >> 8) + ((int64_t)c->dig_P7 << 4);
+    *pressure_pa = (float)p / 256.0f;
+
+    // Humidity, Q22.10 %RH
+    int32_t h = t_fine - 76800;
+    h = (((adc_h << 14) - ((int32_t)c->dig_H4 << 20) - ((int32_t)c->dig_H5 * h) + 16384) >> 15) *
+        (((((((h * c->dig_H6) >> 10) * (((h * (int32_t)c->dig_H3) >> 11) + 32768)) >> 10) + 2097152) *
+          c->dig_H2 + 8192) >> 14);
+    h -= ((((h >> 15) * (h >> 15)) >> 7) * (int32_t)c->dig_H1) >> 4;
+    h = h < 0 ? 0 : (h > 419430400 ? 419430400 : h);
+    *humidity = (h >> 12) / 1024.0f;
+
+    return ESP_OK;
+}
+
+float sensor_codec_ds18b20_celsius(int16_t raw)
+{
+    return (float)(raw / 16.0);
+}
+
+float sensor_codec_bh1750_lux(uint16_t raw)
+{
+    return (float)(raw / 1.2);
+}
+
+// ========================================
+// ZCL Encodings
+// ========================================
+
+uint16_t sensor_codec_lux_to_zcl(float lux)
+{
+    if (lux < 1.0f) {
+        // For very low light, use minimum valid value
+        return ZB_ILLUM_MIN;
+    }
+
+    float value = 10000.0f * log10f(lux) + 1.0f;
+    if (value > ZB_ILLUM_MAX) {
+        return ZB_ILLUM_MAX;
+    }
+    return value < ZB_ILLUM_MIN ? ZB_ILLUM_MIN : (uint16_t)value;
+}
+
+int16_t sensor_codec_celsius_to_zcl(float celsius)
+{
+    float value = celsius * 100;
+
+    if (value <= ZB_TEMP_MIN) {
+        return ZB_TEMP_MIN;
+    }
+    if (value >= ZB_TEMP_MAX) {
+        return ZB_TEMP_MAX;
+    }
+    return (int16_t)value;
+}
+
+uint16_t sensor_codec_percent_to_zcl(float percent)
+{
+    float value = percent * 100;
+
+    if (value <= ZB_HUMIDITY_MIN) {
+        return ZB_HUMIDITY_MIN;
+    }
+    if (value >= ZB_HUMIDITY_MAX) {
+        return ZB_HUMIDITY_MAX;
+    }
+    return (uint16_t)value;
+}
+
+int32_t sensor_codec_to_centi(float value)
+{
+    // Far outside every ZCL range; keeps the conversion defined
+    if (value >= 1e7f) {
+        return 1000000000;
+    }
+    if (value <= -1e7f) {
+        return -1000000000;
+    }
+    return (int32_t)lroundf(value * 100);
+}
+
+int16_t sensor_codec_centi_to_temp_zcl(int32_t centi)
+{
+    if (centi <= ZB_TEMP_MIN) {
+        return ZB_TEMP_MIN;
+    }
+    if (centi >= ZB_TEMP_MAX) {
+        return ZB_TEMP_MAX;
+    }
+    return (int16_t)centi;
+}
+
+uint16_t sensor_codec_centi_to_humidity_zcl(int32_t centi)
+{
+    if (centi <= ZB_HUMIDITY_MIN) {
+        return ZB_HUMIDITY_MIN;
+    }
+    if (centi >= ZB_HUMIDITY_MAX) {
+        return ZB_HUMIDITY_MAX;
+    }
+    return (uint16_t)centi;
+}
+
+int16_t sensor_codec_pa_to_zcl(float pascal)
+{
+    float value = pascal / 100.0f + 0.5f;
+
+    if (value <= ZB_PRESSURE_MIN) {
+        return ZB_PRESSURE_MIN;
+    }
+    if (value >= ZB_PRESSURE_MAX) {
+        return ZB_PRESSURE_MAX;
+    }
+    return (int16_t)value;
+}
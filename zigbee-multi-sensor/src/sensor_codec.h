@@ -0,0 +1,125 @@
+/*
+ * Sensor Data Codecs
+ *
+ * Pure conversions between raw sensor frames, engineering units and the
+ * ZCL MeasuredValue encodings. No hardware access and no allocation, so the
+ * drivers, the sensor tasks, the host simulator and the benchmark suite
+ * (bench.h) all share one implementation.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ZCL MeasuredValue ranges advertised by the measurement clusters
+#define ZB_TEMP_MIN                     -5000   // -50.00°C
+#define ZB_TEMP_MAX                     12500   // 125.00°C
+#define ZB_HUMIDITY_MIN                 0       // 0% RH
+#define ZB_HUMIDITY_MAX                 10000   // 100.00% RH
+#define ZB_ILLUM_MIN                    1       // 1 lux
+#define ZB_ILLUM_MAX                    0xFFFE  // 65534 lux
+#define ZB_PRESSURE_MIN                 300     // 300 hPa (BME280 range)
+#define ZB_PRESSURE_MAX                 1100    // 1100 hPa
+
+// Initial MeasuredValue before the first read
+#define ZB_TEMP_INVALID                 0x8000  // Invalid temperature
+#define ZB_HUMIDITY_INVALID             0xFFFF  // Invalid humidity
+#define ZB_ILLUM_INVALID                0xFFFF  // Invalid illuminance
+#define ZB_PRESSURE_INVALID             0x8000  // Invalid pressure
+
+#define DHT11_FRAME_SIZE                5
+#define SHT4X_FRAME_SIZE                6       // T msb, lsb, CRC, RH msb, lsb, CRC
+#define BME280_CALIB_TP_SIZE            26      // 0x88-0xA1
+#define BME280_CALIB_H_SIZE             7       // 0xE1-0xE7
+#define BME280_DATA_SIZE                8       // 0xF7-0xFE: press, temp, hum
+
+/**
+ * BME280 factory trimming (datasheet 4.2.2 names).
+ */
+typedef struct {
+    uint16_t dig_T1;
+    int16_t dig_T2, dig_T3;
+    uint16_t dig_P1;
+    int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+    uint8_t dig_H1;
+    int16_t dig_H2;
+    uint8_t dig_H3;
+    int16_t dig_H4, dig_H5;
+    int8_t dig_H6;
+} bme280_calib_t;
+
+/**
+ * Decode a 40-bit DHT11 frame (humidity, humidity tenths, temperature,
+ * temperature tenths, checksum) to 0.1 resolution.
+ * Returns ESP_ERR_INVALID_CRC if the checksum does not match.
+ */
+esp_err_t sensor_codec_dht11_decode(const uint8_t frame[DHT11_FRAME_SIZE],
+                                    float *temperature, float *humidity);
+
+/**
+ * Sensirion CRC-8 (poly 0x31, init 0xFF) over one 16-bit word.
+ */
+uint8_t sensor_codec_sht4x_crc(const uint8_t *word);
+
+/**
+ * Decode an SHT4x measurement frame. Humidity is clamped to 0-100 %
+ * (the transfer function reaches -6 and 119). Returns ESP_ERR_INVALID_CRC
+ * if either word's CRC does not match.
+ */
+esp_err_t sensor_codec_sht4x_decode(const uint8_t frame[SHT4X_FRAME_SIZE],
+                                    float *temperature, float *humidity);
+
+/**
+ * Unpack the two BME280 calibration blocks.
+ */
+void sensor_codec_bme280_calib(const uint8_t tp[BME280_CALIB_TP_SIZE],
+                               const uint8_t h[BME280_CALIB_H_SIZE], bme280_calib_t *calib);
+
+/**
+ * Datasheet integer compensation of one burst-read data block (8.2).
+ * Returns ESP_ERR_INVALID_RESPONSE for the "skipped" pattern a part sends
+ * before its first conversion.
+ */
+esp_err_t sensor_codec_bme280_compensate(const bme280_calib_t *calib,
+                                         const uint8_t data[BME280_DATA_SIZE],
+                                         float *temperature, float *humidity, float *pressure_pa);
+
+/**
+ * DS18B20 scratchpad temperature (signed, 1/16 °C) to °C.
+ */
+float sensor_codec_ds18b20_celsius(int16_t raw);
+
+/**
+ * BH1750 high-resolution count to lux.
+ */
+float sensor_codec_bh1750_lux(uint16_t raw);
+
+/**
+ * ZCL encodings, clamped to the ranges above:
+ *   illuminance  10000 × log10(lux) + 1  (lux < 1 → ZB_ILLUM_MIN)
+ *   temperature  0.01 °C
+ *   humidity     0.01 %RH
+ *   pressure     hPa (10 × kPa)
+ */
+uint16_t sensor_codec_lux_to_zcl(float lux);
+int16_t sensor_codec_celsius_to_zcl(float celsius);
+uint16_t sensor_codec_percent_to_zcl(float percent);
+int16_t sensor_codec_pa_to_zcl(float pascal);
+
+/**
+ * The same temperature and humidity encodings split around calibration
+ * (calibration.h): a reading to rounded 0.01 units, then the corrected
+ * fixed-point value clamped into the ZCL range.
+ */
+int32_t sensor_codec_to_centi(float value);
+int16_t sensor_codec_centi_to_temp_zcl(int32_t centi);
+uint16_t sensor_codec_centi_to_humidity_zcl(int32_t centi);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,173 @@
+/*
+ * DHT11 Indoor Temperature/Humidity Driver (EP10)
+ *
+ * Probe waits out the part's power-on settling time, then needs one good
+ * frame in two tries. Each update is a burst of DHT11_OVERSAMPLE reads;
+ * temperature and humidity are filtered independently, so a bad byte in
+ * one does not cost the other its report.
+ */
+
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sensors.h"
+#include "sensor_filter.h"
+#include "oversample.h"
+#include "report_policy.h"
+#include "app_config.h"
+#include "telemetry.h"
+#include "sensor_registry.h"
+
+#define DHT11_PROBE_ATTEMPTS            2
+#define DHT11_QUANTUM                   10      // Tenths byte, in 0.01 units
+
+// Time a burst spends between its reads; taken off the update interval so
+// the reporting period does not change (shortest configurable one included)
+#define DHT11_BURST_SPACING_MS          ((DHT11_OVERSAMPLE - 1) * DHT11_MIN_INTERVAL_MS)
+
+_Static_assert(DHT11_OVERSAMPLE >= 1 && DHT11_OVERSAMPLE <= OVERSAMPLE_MAX, "DHT11_OVERSAMPLE out of range");
+_Static_assert(DHT11_BURST_SPACING_MS < APP_CONFIG_INTERVAL_MIN_S * 1000, "DHT11 burst longer than its interval");
+
+static const char *TAG = "DHT11";
+
+// Raw values in 0.01 units, before calibration (see sensor_filter.h)
+static const sensor_filter_config_t temp_filter_cfg = {
+    .median_window = 3,
+    .ema_shift = 1,
+    .min = 0, .max = 5000,              // DHT11 range 0-50 °C
+    .max_slew_per_s = 5,                // 3 °C/min
+};
+
+static const sensor_filter_config_t humidity_filter_cfg = {
+    .median_window = 3,
+    .ema_shift = 1,
+    .min = 100, .max = 9900,            // 0 % and 100 % are checksum-valid garbage
+    .max_slew_per_s = 10,               // 6 %/min (shower, open window)
+};
+
+static sensor_filter_t temp_filter;
+static sensor_filter_t humidity_filter;
+
+static const sensor_climate_t climate = {
+    .endpoint = EP_DHT11_INDOOR,
+    .tag = "DHT11",
+    .temp_name = "DHT11 temp",
+    .humidity_name = "DHT11 humidity",
+    .temp_filter = &temp_filter,
+    .humidity_filter = &humidity_filter,
+    .temp_channel = CALIBRATION_DHT11_TEMPERATURE,
+    .humidity_channel = CALIBRATION_DHT11_HUMIDITY,
+    .telemetry_sensor = TELEM_SENSOR_DHT11,
+};
+
+// ========================================
+// Internal Helpers
+// ========================================
+
+/**
+ * DHT11_OVERSAMPLE reads DHT11_MIN_INTERVAL_MS apart, averaged per channel.
+ * Succeeds if any read did.
+ */
+static esp_err_t read_burst(float *temperature, float *humidity)
+{
+    oversample_t temp_acc, humidity_acc;
+    oversample_reset(&temp_acc);
+    oversample_reset(&humidity_acc);
+    esp_err_t ret = ESP_FAIL;
+
+    for (int k = 0; k < DHT11_OVERSAMPLE; k++) {
+        if (k > 0) {
+            vTaskDelay(pdMS_TO_TICKS(DHT11_MIN_INTERVAL_MS));
+        }
+        float t, h;
+        ret = dht11_read_data(&t, &h);
+        if (ret == ESP_OK) {
+            oversample_add(&temp_acc, (int32_t)lroundf(t * 100.0f));
+            oversample_add(&humidity_acc, (int32_t)lroundf(h * 100.0f));
+        }
+    }
+
+    int32_t temp_mean, humidity_mean;
+    if (!oversample_mean(&temp_acc, &temp_mean) || !oversample_mean(&humidity_acc, &humidity_mean)) {
+        return ret;
+    }
+    if (temp_acc.count > 1 && !oversample_dithered(&temp_acc, DHT11_QUANTUM)) {
+        ESP_LOGD(TAG, "Temperature burst without dither, resolution stays 0.1 °C");
+    }
+    *temperature = temp_mean / 100.0f;
+    *humidity = humidity_mean / 100.0f;
+    return ESP_OK;
+}
+
+// ========================================
+// Driver
+// ========================================
+
+static esp_err_t probe(void)
+{
+    esp_err_t ret = dht11_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // DHT11 needs time to stabilize after power-on
+    int64_t since_boot_ms = esp_timer_get_time() / 1000;
+    if (since_boot_ms < DHT11_STARTUP_DELAY_MS) {
+        vTaskDelay(pdMS_TO_TICKS(DHT11_STARTUP_DELAY_MS - since_boot_ms));
+    }
+
+    for (int attempt = 0; attempt < DHT11_PROBE_ATTEMPTS; attempt++) {
+        if (attempt > 0) {
+            vTaskDelay(pdMS_TO_TICKS(DHT11_MIN_INTERVAL_MS));
+        }
+        float t, h;
+        if (dht11_read_data(&t, &h) == ESP_OK) {
+            sensor_filter_init(&temp_filter, &temp_filter_cfg);
+            sensor_filter_init(&humidity_filter, &humidity_filter_cfg);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static void add_clusters(esp_zb_cluster_list_t *clusters)
+{
+    sensor_registry_add_climate_clusters(clusters);
+}
+
+static esp_err_t sample(void)
+{
+    float temp_celsius, humidity_percent;
+    esp_err_t ret = read_burst(&temp_celsius, &humidity_percent);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Read failed (%s)", esp_err_to_name(ret));
+        sensor_registry_flash_failed();
+        return ret;
+    }
+
+    sensor_registry_report_climate(&climate, temp_celsius, humidity_percent);
+
+    sensor_registry_flash_reported();
+    return ESP_OK;
+}
+
+static void report_invalid(void)
+{
+    sensor_registry_report_climate_invalid(EP_DHT11_INDOOR);
+}
+
+const sensor_driver_t sensor_driver_dht11 = {
+    .name = "dht11",
+    .endpoint = EP_DHT11_INDOOR,
+    .device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
+    .location = "Indoor",
+    .probe = probe,
+    .add_clusters = add_clusters,
+    .sample = sample,
+    .report_invalid = report_invalid,
+    .interval_ms = DHT11_UPDATE_INTERVAL,
+    .burst_ms = DHT11_BURST_SPACING_MS,
+    .stack_size = 4096,
+};
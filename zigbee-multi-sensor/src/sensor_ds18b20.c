@@ -0,0 +1,115 @@
+/*
+ * DS18B20 Outdoor Temperature Driver (EP11)
+ *
+ * Probe is the 1-Wire presence pulse. Already 12-bit (1/16 °C), so no
+ * oversampling; the filter drops the 85 °C power-on value.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "sensors.h"
+#include "sensor_codec.h"
+#include "sensor_filter.h"
+#include "report_policy.h"
+#include "calibration.h"
+#include "telemetry.h"
+#include "tlog.h"
+#include "zb_report.h"
+#include "sensor_registry.h"
+
+static const char *TAG = "DS18B20";
+
+static const sensor_filter_config_t temp_filter_cfg = {
+    .median_window = 3,
+    .ema_shift = 0,                     // 12-bit reads are already quiet
+    .min = -5500, .max = 12500,         // Datasheet range
+    .reject_sentinel = true,
+    .sentinel = 8500,                   // Power-on value of the scratchpad
+    .max_slew_per_s = 10,               // 6 °C/min
+};
+
+static sensor_filter_t temp_filter;
+
+// ========================================
+// Driver
+// ========================================
+
+static esp_err_t probe(void)
+{
+    esp_err_t ret = ds18b20_init();
+    if (ret != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    sensor_filter_init(&temp_filter, &temp_filter_cfg);
+    return ESP_OK;
+}
+
+static void add_clusters(esp_zb_cluster_list_t *clusters)
+{
+    esp_zb_temperature_meas_cluster_cfg_t temp_cfg = {
+        .measured_value = ZB_TEMP_INVALID,
+        .min_value = ZB_TEMP_MIN,
+        .max_value = ZB_TEMP_MAX,
+    };
+    esp_zb_cluster_list_add_temperature_meas_cluster(clusters, esp_zb_temperature_meas_cluster_create(&temp_cfg),
+                                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+static esp_err_t sample(void)
+{
+    esp_err_t ret = ds18b20_start_conversion();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Conversion start failed (%s)", esp_err_to_name(ret));
+        sensor_registry_flash_failed();
+        return ret;
+    }
+
+    // Wait for conversion to complete (750ms for 12-bit resolution)
+    vTaskDelay(pdMS_TO_TICKS(DS18B20_CONVERSION_MS));
+
+    float temp_celsius;
+    ret = ds18b20_read_temperature(&temp_celsius);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Read failed (%s)", esp_err_to_name(ret));
+        sensor_registry_flash_failed();
+        return ret;
+    }
+
+    // Drops implausible samples (e.g. the 85 °C power-on value) before reporting
+    if (!sensor_registry_filter(&temp_filter, "DS18B20", temp_celsius, 100.0f, &temp_celsius)) {
+        return ESP_OK;
+    }
+
+    // Calibrate in 0.01°C units, then clamp to the valid range
+    int32_t temp_centi = calibration_apply(CALIBRATION_DS18B20_TEMPERATURE, sensor_codec_to_centi(temp_celsius));
+    int16_t temp_value = sensor_codec_centi_to_temp_zcl(temp_centi);
+
+    zb_report_attribute(EP_DS18B20_OUTDOOR, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+                        ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, &temp_value);
+
+    // monitor.py decodes the telemetry record; the log line is tokenised (no formatting here)
+    telemetry_send_temperature(TELEM_SENSOR_DS18B20, temp_value);
+    TLOGI(TAG, "Temp:  %6.2f °C  [Outdoor]", temp_value / 100.0f);
+
+    sensor_registry_flash_reported();
+    return ESP_OK;
+}
+
+static void report_invalid(void)
+{
+    sensor_registry_report_invalid(EP_DS18B20_OUTDOOR, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT);
+}
+
+const sensor_driver_t sensor_driver_ds18b20 = {
+    .name = "ds18b20",
+    .endpoint = EP_DS18B20_OUTDOOR,
+    .device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
+    .location = "Outdoor",
+    .probe = probe,
+    .add_clusters = add_clusters,
+    .sample = sample,
+    .report_invalid = report_invalid,
+    .interval_ms = DS18B20_UPDATE_INTERVAL,
+    .stack_size = 4096,
+};
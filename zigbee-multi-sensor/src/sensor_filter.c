@@ -0,0 +1,172 @@
+/*
+ * Per-Channel Sensor Filter
+ *
+ * A step is only re-seeded when the rejected samples agree with each other
+ * (each within the slew limit of the previous rejected one); independent
+ * glitches reset the count instead of adding up to a false step.
+ */
+
+#include <string.h>
+#include "sensor_filter.h"
+
+// ========================================
+// Internal Helpers
+// ========================================
+
+static uint32_t abs_diff(int32_t a, int32_t b)
+{
+    return a > b ? (uint32_t)((int64_t)a - b) : (uint32_t)((int64_t)b - a);
+}
+
+/**
+ * Largest change allowed over `dt_ms`; never less than one second's worth,
+ * so back-to-back reads are not held to a near-zero limit.
+ */
+static uint32_t slew_allowance(const sensor_filter_config_t *config, uint32_t dt_ms)
+{
+    if (dt_ms < 1000) {
+        dt_ms = 1000;
+    }
+    uint64_t allowed = (uint64_t)config->max_slew_per_s * dt_ms / 1000;
+    return allowed > UINT32_MAX ? UINT32_MAX : (uint32_t)allowed;
+}
+
+static int32_t window_median(const sensor_filter_t *filter)
+{
+    int32_t sorted[SENSOR_FILTER_MAX_WINDOW];
+    uint8_t n = filter->window_count;
+
+    for (uint8_t i = 0; i < n; i++) {
+        int32_t v = filter->window[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+
+    if (n & 1) {
+        return sorted[n / 2];
+    }
+    // Window still filling with an even count: mean of the middle pair
+    return (int32_t)(((int64_t)sorted[n / 2 - 1] + sorted[n / 2]) / 2);
+}
+
+/**
+ * Slew gate. Returns true if the sample may pass (possibly after re-seeding).
+ */
+static bool slew_check(sensor_filter_t *filter, int32_t value, uint32_t now_ms)
+{
+    const sensor_filter_config_t *config = filter->config;
+
+    if (!filter->primed || config->max_slew_per_s == 0) {
+        return true;
+    }
+    if (abs_diff(value, filter->last_accepted) <=
+        slew_allowance(config, now_ms - filter->last_accepted_ms)) {
+        filter->slew_rejects = 0;
+        return true;
+    }
+
+    // Out of line with the accepted history: is it consistent with the previous rejects?
+    if (filter->slew_rejects > 0 &&
+        abs_diff(value, filter->slew_candidate) <=
+        slew_allowance(config, now_ms - filter->slew_candidate_ms)) {
+        filter->slew_rejects++;
+    } else {
+        filter->slew_rejects = 1;
+    }
+    filter->slew_candidate = value;
+    filter->slew_candidate_ms = now_ms;
+
+    if (filter->slew_rejects < SENSOR_FILTER_RESEED_AFTER) {
+        return false;
+    }
+
+    sensor_filter_reset(filter);
+    filter->stats.reseeds++;
+    return true;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+void sensor_filter_init(sensor_filter_t *filter, const sensor_filter_config_t *config)
+{
+    memset(filter, 0, sizeof(*filter));
+    filter->config = config;
+}
+
+void sensor_filter_reset(sensor_filter_t *filter)
+{
+    filter->window_next = 0;
+    filter->window_count = 0;
+    filter->ema_q = 0;
+    filter->slew_rejects = 0;
+    filter->primed = false;
+}
+
+sensor_filter_verdict_t sensor_filter_push(sensor_filter_t *filter, int32_t value,
+                                           uint32_t now_ms, int32_t *out)
+{
+    const sensor_filter_config_t *config = filter->config;
+
+    if (value < config->min || value > config->max) {
+        filter->stats.rejected_range++;
+        return SENSOR_FILTER_REJECT_RANGE;
+    }
+    if (config->reject_sentinel && value == config->sentinel) {
+        filter->stats.rejected_sentinel++;
+        return SENSOR_FILTER_REJECT_SENTINEL;
+    }
+    if (!slew_check(filter, value, now_ms)) {
+        filter->stats.rejected_slew++;
+        return SENSOR_FILTER_REJECT_SLEW;
+    }
+
+    bool first = !filter->primed;
+    filter->primed = true;
+    filter->last_accepted = value;
+    filter->last_accepted_ms = now_ms;
+
+    uint8_t window = config->median_window;
+    if (window < 1) {
+        window = 1;
+    } else if (window > SENSOR_FILTER_MAX_WINDOW) {
+        window = SENSOR_FILTER_MAX_WINDOW;
+    }
+    filter->window[filter->window_next] = value;
+    filter->window_next = (filter->window_next + 1) % window;
+    if (filter->window_count < window) {
+        filter->window_count++;
+    }
+    int32_t median = window_median(filter);
+
+    if (config->ema_shift == 0) {
+        *out = median;
+    } else {
+        int32_t target = median * (1 << SENSOR_FILTER_EMA_FRAC_BITS);
+        if (first) {
+            filter->ema_q = target;
+        } else {
+            filter->ema_q += (target - filter->ema_q) >> config->ema_shift;
+        }
+        *out = (filter->ema_q + (1 << (SENSOR_FILTER_EMA_FRAC_BITS - 1))) >> SENSOR_FILTER_EMA_FRAC_BITS;
+    }
+
+    filter->stats.accepted++;
+    return SENSOR_FILTER_ACCEPTED;
+}
+
+const char *sensor_filter_verdict_name(sensor_filter_verdict_t verdict)
+{
+    switch (verdict) {
+    case SENSOR_FILTER_ACCEPTED:        return "accepted";
+    case SENSOR_FILTER_REJECT_RANGE:    return "out of range";
+    case SENSOR_FILTER_REJECT_SENTINEL: return "sentinel value";
+    case SENSOR_FILTER_REJECT_SLEW:     return "slew limit";
+    }
+    return "unknown";
+}
@@ -0,0 +1,94 @@
+/*
+ * Per-Channel Sensor Filter
+ *
+ * Sits between a driver read and the report. Each sample passes, in order:
+ *   1. Plausibility gates: range, sentinel value (DS18B20 85.00 °C power-on
+ *      reading), and maximum slew per second against the last accepted
+ *      sample. Rejected samples are not reported at all.
+ *   2. Median of the last `median_window` accepted samples (spike removal).
+ *   3. Exponential moving average, alpha = 1 / 2^ema_shift, in Q8 fixed
+ *      point (noise smoothing).
+ *
+ * After SENSOR_FILTER_RESEED_AFTER consecutive slew rejections the filter
+ * accepts the new level and restarts from it, so a genuine step (probe
+ * moved, heater switched on) is not locked out forever.
+ *
+ * Values are integers in the channel's own fixed-point unit (e.g. 0.01 °C).
+ * No allocation and no ESP-IDF dependencies, so it also builds for host
+ * tools.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SENSOR_FILTER_MAX_WINDOW        7
+#define SENSOR_FILTER_EMA_FRAC_BITS     8       // |values| must stay below 2^23
+#define SENSOR_FILTER_RESEED_AFTER      3
+
+typedef struct {
+    uint8_t median_window;          // 1 (off) .. SENSOR_FILTER_MAX_WINDOW
+    uint8_t ema_shift;              // 0 = off
+    int32_t min, max;               // Plausible range, inclusive
+    bool reject_sentinel;
+    int32_t sentinel;
+    uint32_t max_slew_per_s;        // 0 = off; units per second
+} sensor_filter_config_t;
+
+typedef enum {
+    SENSOR_FILTER_ACCEPTED = 0,
+    SENSOR_FILTER_REJECT_RANGE,
+    SENSOR_FILTER_REJECT_SENTINEL,
+    SENSOR_FILTER_REJECT_SLEW,
+} sensor_filter_verdict_t;
+
+typedef struct {
+    uint32_t accepted;
+    uint32_t rejected_range;
+    uint32_t rejected_sentinel;
+    uint32_t rejected_slew;
+    uint32_t reseeds;
+} sensor_filter_stats_t;
+
+typedef struct {
+    const sensor_filter_config_t *config;
+    int32_t window[SENSOR_FILTER_MAX_WINDOW];
+    uint8_t window_next;
+    uint8_t window_count;
+    int32_t ema_q;                  // Q(SENSOR_FILTER_EMA_FRAC_BITS)
+    int32_t last_accepted;
+    uint32_t last_accepted_ms;
+    int32_t slew_candidate;         // Last slew-rejected sample
+    uint32_t slew_candidate_ms;
+    uint8_t slew_rejects;           // Consecutive, mutually consistent
+    bool primed;
+    sensor_filter_stats_t stats;
+} sensor_filter_t;
+
+/**
+ * Bind a filter to its configuration (kept by reference) and clear it.
+ */
+void sensor_filter_init(sensor_filter_t *filter, const sensor_filter_config_t *config);
+
+/**
+ * Drop the history; the next sample starts the filter afresh.
+ */
+void sensor_filter_reset(sensor_filter_t *filter);
+
+/**
+ * Feed one sample taken at `now_ms`. On SENSOR_FILTER_ACCEPTED `*out`
+ * holds the filtered value; otherwise it is left untouched.
+ */
+sensor_filter_verdict_t sensor_filter_push(sensor_filter_t *filter, int32_t value,
+                                           uint32_t now_ms, int32_t *out);
+
+const char *sensor_filter_verdict_name(sensor_filter_verdict_t verdict);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,542 @@
+/*
+ * Sensor Driver Registry
+ */
+
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "status_led.h"
+#include "sensors.h"
+#include "sensor_codec.h"
+#include "derived.h"
+#include "telemetry.h"
+#include "tlog.h"
+#include "zb_report.h"
+#include "supervisor.h"
+#include "app_config.h"
+#include "i2c_bus.h"
+#include "sensor_registry.h"
+
+static const char *TAG = "SENSOR_REG";
+
+// Probe order is also endpoint creation order
+static const sensor_driver_t *const drivers[] = {
+    &sensor_driver_dht11,
+    &sensor_driver_ds18b20,
+    &sensor_driver_bh1750,
+    &sensor_driver_sht4x,
+    &sensor_driver_bme280,
+};
+
+#define DRIVER_COUNT  (sizeof(drivers) / sizeof(drivers[0]))
+
+_Static_assert(DRIVER_COUNT <= SENSOR_REGISTRY_MAX_DRIVERS, "raise SENSOR_REGISTRY_MAX_DRIVERS");
+
+// Endpoints ever detected on this board, one bit per endpoint number
+#define SENSOR_REGISTRY_NVS_NAMESPACE   "sensor_reg"
+#define SENSOR_REGISTRY_NVS_KEY_SEEN    "seen_eps"
+
+typedef struct {
+    const sensor_driver_t *driver;
+    sensor_health_t health;
+    int64_t state_since_us;
+    int64_t up_us, down_us;         // Time in OK/DEGRADED vs FAILED/PROBING
+    int supervisor_client;
+} sensor_slot_t;
+
+static const char *state_names[SENSOR_HEALTH_STATE_COUNT] = {
+    "INIT",
+    "OK",
+    "DEGRADED",
+    "FAILED",
+    "PROBING",
+};
+
+// Guards the health fields; the console reads them from its own task
+static portMUX_TYPE health_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static sensor_slot_t slots[SENSOR_REGISTRY_MAX_DRIVERS];
+static size_t slot_count = 0;
+static size_t detected_count = 0;
+
+// ========================================
+// NVS Persistence
+// ========================================
+
+static uint32_t load_seen(void)
+{
+    nvs_handle_t handle;
+    uint32_t seen = 0;
+
+    if (nvs_open(SENSOR_REGISTRY_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return 0;  // Namespace not created yet (first boot)
+    }
+    if (nvs_get_u32(handle, SENSOR_REGISTRY_NVS_KEY_SEEN, &seen) != ESP_OK) {
+        seen = 0;
+    }
+    nvs_close(handle);
+
+    return seen;
+}
+
+static esp_err_t store_seen(uint32_t seen)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(SENSOR_REGISTRY_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = nvs_set_u32(handle, SENSOR_REGISTRY_NVS_KEY_SEEN, seen);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
+
+// ========================================
+// Health State Machine
+// ========================================
+
+static bool state_is_up(sensor_health_state_t state)
+{
+    return state == SENSOR_HEALTH_OK || state == SENSOR_HEALTH_DEGRADED;
+}
+
+/**
+ * Book the time spent in the current state (health_lock held).
+ */
+static void account_time(sensor_slot_t *slot, int64_t now_us)
+{
+    if (slot->state_since_us == 0) {
+        return;     // Not started yet (boot probe)
+    }
+    int64_t elapsed = now_us - slot->state_since_us;
+    if (state_is_up(slot->health.state)) {
+        slot->up_us += elapsed;
+    } else {
+        slot->down_us += elapsed;
+    }
+    slot->state_since_us = now_us;
+}
+
+static void set_state(sensor_slot_t *slot, sensor_health_state_t state)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&health_lock);
+    sensor_health_state_t old = slot->health.state;
+    account_time(slot, now_us);
+    slot->health.state = state;
+    taskEXIT_CRITICAL(&health_lock);
+
+    if (old != state) {
+        ESP_LOGI(TAG, "%s: %s -> %s", slot->driver->name, state_names[old], state_names[state]);
+    }
+}
+
+/**
+ * Enter FAILED: report invalid, and set the delay before the next probe
+ * (first failure: the base delay; each failed re-probe doubles it).
+ */
+static void enter_failed(sensor_slot_t *slot, bool from_probe)
+{
+    taskENTER_CRITICAL(&health_lock);
+    sensor_health_t *h = &slot->health;
+    if (!from_probe || h->backoff_ms == 0) {
+        h->failures++;
+        h->backoff_ms = SENSOR_REPROBE_BASE_MS;
+    } else {
+        h->backoff_ms = h->backoff_ms * 2 > SENSOR_REPROBE_MAX_MS ? SENSOR_REPROBE_MAX_MS : h->backoff_ms * 2;
+    }
+    taskEXIT_CRITICAL(&health_lock);
+
+    set_state(slot, SENSOR_HEALTH_FAILED);
+    if (!from_probe) {
+        slot->driver->report_invalid();
+        ESP_LOGW(TAG, "%s: failed after %u errors, EP%u invalid; re-probing in %lu ms", slot->driver->name,
+                 SENSOR_FAILED_AFTER, slot->driver->endpoint, (unsigned long)slot->health.backoff_ms);
+    }
+}
+
+static void run_sample(sensor_slot_t *slot)
+{
+    esp_err_t ret = slot->driver->sample();
+
+    taskENTER_CRITICAL(&health_lock);
+    sensor_health_t *h = &slot->health;
+    if (i2c_bus_refused(ret)) {
+        // The bus refused without asking the part: no verdict on its health
+        h->skipped++;
+        taskEXIT_CRITICAL(&health_lock);
+        return;
+    }
+    h->samples++;
+    if (ret == ESP_OK) {
+        h->consecutive_errors = 0;
+    } else {
+        h->errors++;
+        if (h->consecutive_errors < UINT8_MAX) {
+            h->consecutive_errors++;
+        }
+    }
+    uint8_t consecutive = h->consecutive_errors;
+    taskEXIT_CRITICAL(&health_lock);
+
+    if (ret == ESP_OK) {
+        set_state(slot, SENSOR_HEALTH_OK);
+    } else if (consecutive >= SENSOR_FAILED_AFTER) {
+        enter_failed(slot, false);
+    } else {
+        set_state(slot, SENSOR_HEALTH_DEGRADED);
+    }
+}
+
+static void run_probe(sensor_slot_t *slot)
+{
+    set_state(slot, SENSOR_HEALTH_PROBING);
+
+    esp_err_t ret = slot->driver->probe();
+
+    taskENTER_CRITICAL(&health_lock);
+    slot->health.reprobes++;
+    if (ret == ESP_OK) {
+        slot->health.recoveries++;
+        slot->health.consecutive_errors = 0;
+        slot->health.backoff_ms = 0;
+    }
+    taskEXIT_CRITICAL(&health_lock);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%s: ✓ back on EP%u", slot->driver->name, slot->driver->endpoint);
+        set_state(slot, SENSOR_HEALTH_OK);
+    } else {
+        enter_failed(slot, true);
+        ESP_LOGD(TAG, "%s: re-probe failed (%s), next in %lu ms", slot->driver->name,
+                 esp_err_to_name(ret), (unsigned long)slot->health.backoff_ms);
+    }
+}
+
+// ========================================
+// Sampling Task
+// ========================================
+
+static void sensor_task(void *pvParameters)
+{
+    sensor_slot_t *slot = pvParameters;
+    const sensor_driver_t *driver = slot->driver;
+
+    ESP_LOGI(TAG, "%s: sampling every %lu ms on EP%u", driver->name,
+             (unsigned long)app_config_interval_ms(driver->endpoint, driver->interval_ms), driver->endpoint);
+
+    while (1) {
+        switch (slot->health.state) {
+        case SENSOR_HEALTH_FAILED:
+            // The backoff has elapsed (delay below)
+            run_probe(slot);
+            break;
+        default:
+            run_sample(slot);
+            break;
+        }
+
+        // Read every update, so a new interval applies from the next one
+        uint32_t delay_ms = slot->health.state == SENSOR_HEALTH_FAILED
+                                ? slot->health.backoff_ms
+                                : app_config_interval_ms(driver->endpoint, driver->interval_ms) - driver->burst_ms;
+        supervisor_checkin(slot->supervisor_client, delay_ms + SENSOR_STALL_MS);
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+size_t sensor_registry_probe(void)
+{
+    slot_count = 0;
+    detected_count = 0;
+
+    // I2C drivers address their part directly; the scan logs the whole bus
+    esp_err_t bus_ret = sensors_i2c_scan();
+    if (bus_ret != ESP_OK) {
+        ESP_LOGW(TAG, "I2C bus unavailable (%s), I2C sensors skipped", esp_err_to_name(bus_ret));
+    }
+
+    uint32_t seen = load_seen();
+    uint32_t seen_now = seen;
+
+    for (size_t i = 0; i < DRIVER_COUNT; i++) {
+        const sensor_driver_t *driver = drivers[i];
+        uint32_t ep_bit = 1UL << driver->endpoint;
+
+        // Yellow flash while probing
+        status_led_show(STATUS_LED_SENSOR_INIT);
+
+        sensor_slot_t *slot = &slots[slot_count];
+        *slot = (sensor_slot_t){ .driver = driver };
+
+        esp_err_t ret = driver->probe();
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "%s: ✓ detected (EP%u)", driver->name, driver->endpoint);
+            status_led_show(STATUS_LED_SENSOR_OK);
+            slot->health.state = SENSOR_HEALTH_OK;
+            seen_now |= ep_bit;
+            detected_count++;
+            slot_count++;
+            continue;
+        }
+
+        status_led_show(STATUS_LED_SENSOR_ERROR);
+        if (!(seen & ep_bit)) {
+            ESP_LOGW(TAG, "%s: not detected (%s), EP%u not registered", driver->name,
+                     esp_err_to_name(ret), driver->endpoint);
+            continue;
+        }
+
+        // Fitted on this board before: keep the endpoint and keep trying
+        ESP_LOGW(TAG, "%s: not detected (%s), keeping EP%u (seen before), re-probing", driver->name,
+                 esp_err_to_name(ret), driver->endpoint);
+        slot->health.state = SENSOR_HEALTH_FAILED;
+        slot->health.failures = 1;
+        slot->health.backoff_ms = SENSOR_REPROBE_BASE_MS;
+        slot_count++;
+    }
+
+    if (seen_now != seen) {
+        esp_err_t ret = store_seen(seen_now);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to store detected sensors (%s)", esp_err_to_name(ret));
+        }
+    }
+
+    ESP_LOGI(TAG, "%u of %u sensor drivers detected, %u registered", (unsigned)detected_count,
+             (unsigned)DRIVER_COUNT, (unsigned)slot_count);
+    return detected_count;
+}
+
+void sensor_registry_add_endpoints(esp_zb_ep_list_t *ep_list, const char *manufacturer, const char *model)
+{
+    for (size_t i = 0; i < slot_count; i++) {
+        const sensor_driver_t *driver = slots[i].driver;
+        esp_zb_cluster_list_t *cluster_list = esp_zb_zcl_cluster_list_create();
+
+        if (driver->location) {
+            // Basic cluster with location description
+            esp_zb_attribute_list_t *basic_cluster = esp_zb_basic_cluster_create(NULL);
+            esp_zb_basic_cluster_add_attr(basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID,
+                                          (void *)manufacturer);
+            esp_zb_basic_cluster_add_attr(basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID,
+                                          (void *)model);
+            esp_zb_basic_cluster_add_attr(basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_LOCATION_DESCRIPTION_ID,
+                                          (void *)driver->location);
+            esp_zb_cluster_list_add_basic_cluster(cluster_list, basic_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+        }
+
+        driver->add_clusters(cluster_list);
+
+        esp_zb_ep_list_add_ep(ep_list, cluster_list, driver->endpoint,
+                              ESP_ZB_AF_HA_PROFILE_ID, driver->device_id);
+    }
+}
+
+void sensor_registry_start(void)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    for (size_t i = 0; i < slot_count; i++) {
+        sensor_slot_t *slot = &slots[i];
+        slot->state_since_us = now_us;
+        slot->supervisor_client = supervisor_register(slot->driver->name, SUPERVISOR_CAUSE_SENSOR_STALL,
+                                                      slot->driver->endpoint, SENSOR_STALL_MS);
+        xTaskCreate(sensor_task, slot->driver->name, slot->driver->stack_size, slot,
+                    SENSOR_TASK_PRIORITY, NULL);
+    }
+}
+
+const sensor_driver_t *sensor_registry_get(size_t index)
+{
+    return index < slot_count ? slots[index].driver : NULL;
+}
+
+size_t sensor_registry_count(void)
+{
+    return slot_count;
+}
+
+bool sensor_registry_health(size_t index, sensor_health_t *health)
+{
+    if (index >= slot_count) {
+        return false;
+    }
+
+    sensor_slot_t *slot = &slots[index];
+    int64_t now_us = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&health_lock);
+    account_time(slot, now_us);
+    *health = slot->health;
+    int64_t total_us = slot->up_us + slot->down_us;
+    health->availability_permille = total_us > 0 ? (uint16_t)(slot->up_us * 1000 / total_us)
+                                                 : (state_is_up(slot->health.state) ? 1000 : 0);
+    taskEXIT_CRITICAL(&health_lock);
+
+    return true;
+}
+
+const char *sensor_registry_state_name(sensor_health_state_t state)
+{
+    return state < SENSOR_HEALTH_STATE_COUNT ? state_names[state] : "?";
+}
+
+esp_err_t sensor_registry_forget(void)
+{
+    uint32_t seen = 0;
+    for (size_t i = 0; i < slot_count; i++) {
+        if (state_is_up(slots[i].health.state)) {
+            seen |= 1UL << slots[i].driver->endpoint;
+        }
+    }
+    return store_seen(seen);
+}
+
+bool sensor_registry_filter(sensor_filter_t *filter, const char *name, float value,
+                            float units, float *filtered)
+{
+    int32_t out;
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    sensor_filter_verdict_t verdict = sensor_filter_push(filter, (int32_t)lroundf(value * units),
+                                                         now_ms, &out);
+    if (verdict != SENSOR_FILTER_ACCEPTED) {
+        const sensor_filter_stats_t *stats = &filter->stats;
+        ESP_LOGW(TAG, "%s: %.2f rejected (%s; %lu range, %lu sentinel, %lu slew so far)",
+                 name, value, sensor_filter_verdict_name(verdict),
+                 (unsigned long)stats->rejected_range, (unsigned long)stats->rejected_sentinel,
+                 (unsigned long)stats->rejected_slew);
+        return false;
+    }
+    *filtered = out / units;
+    return true;
+}
+
+void sensor_registry_report_invalid(uint8_t endpoint, uint16_t cluster_id)
+{
+    // MeasuredValue is attribute 0x0000 in all four clusters
+    int16_t s16;
+    uint16_t u16;
+    void *value;
+
+    switch (cluster_id) {
+    case ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT:
+        s16 = (int16_t)ZB_TEMP_INVALID;
+        value = &s16;
+        break;
+    case ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT:
+        s16 = (int16_t)ZB_PRESSURE_INVALID;
+        value = &s16;
+        break;
+    case ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT:
+        u16 = ZB_HUMIDITY_INVALID;
+        value = &u16;
+        break;
+    case ESP_ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT:
+        u16 = ZB_ILLUM_INVALID;
+        value = &u16;
+        break;
+    default:
+        return;
+    }
+
+    zb_report_attribute(endpoint, cluster_id, 0x0000, value);
+}
+
+void sensor_registry_add_climate_clusters(esp_zb_cluster_list_t *clusters)
+{
+    esp_zb_temperature_meas_cluster_cfg_t temp_cfg = {
+        .measured_value = ZB_TEMP_INVALID,
+        .min_value = ZB_TEMP_MIN,
+        .max_value = ZB_TEMP_MAX,
+    };
+    esp_zb_cluster_list_add_temperature_meas_cluster(clusters, esp_zb_temperature_meas_cluster_create(&temp_cfg),
+                                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+
+    esp_zb_humidity_meas_cluster_cfg_t humidity_cfg = {
+        .measured_value = ZB_HUMIDITY_INVALID,
+        .min_value = ZB_HUMIDITY_MIN,
+        .max_value = ZB_HUMIDITY_MAX,
+    };
+    esp_zb_cluster_list_add_humidity_meas_cluster(clusters, esp_zb_humidity_meas_cluster_create(&humidity_cfg),
+                                                  ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+
+    // Dew point, absolute humidity, heat index
+    derived_add_cluster(clusters);
+}
+
+void sensor_registry_report_climate(const sensor_climate_t *climate, float temp_celsius, float humidity_percent)
+{
+    int16_t temp_value = (int16_t)ZB_TEMP_INVALID;
+    uint16_t humidity_value = ZB_HUMIDITY_INVALID;
+
+    if (sensor_registry_filter(climate->temp_filter, climate->temp_name, temp_celsius, 100.0f, &temp_celsius)) {
+        // Calibrate in 0.01°C units, then clamp to the valid range
+        int32_t temp_centi = calibration_apply(climate->temp_channel, sensor_codec_to_centi(temp_celsius));
+        temp_value = sensor_codec_centi_to_temp_zcl(temp_centi);
+
+        zb_report_attribute(climate->endpoint, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+                            ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, &temp_value);
+
+        // monitor.py decodes the telemetry record; the log line is tokenised (no formatting here)
+        telemetry_send_temperature(climate->telemetry_sensor, temp_value);
+        TLOGI(climate->tag, "Temp:  %6.2f °C  [Indoor]", temp_value / 100.0f);
+    }
+
+    if (sensor_registry_filter(climate->humidity_filter, climate->humidity_name, humidity_percent, 100.0f,
+                               &humidity_percent)) {
+        // Calibrate in 0.01% units, then clamp to the valid range
+        int32_t humidity_centi = calibration_apply(climate->humidity_channel, sensor_codec_to_centi(humidity_percent));
+        humidity_value = sensor_codec_centi_to_humidity_zcl(humidity_centi);
+
+        zb_report_attribute(climate->endpoint, ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT,
+                            ESP_ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID, &humidity_value);
+
+        telemetry_send_humidity(climate->telemetry_sensor, humidity_value);
+        TLOGI(climate->tag, "Humid: %6.2f %%", humidity_value / 100.0f);
+    }
+
+    // Dew point etc. only from a pair taken together
+    if (temp_value != (int16_t)ZB_TEMP_INVALID && humidity_value != ZB_HUMIDITY_INVALID) {
+        derived_report(climate->endpoint, temp_value, humidity_value);
+    }
+}
+
+void sensor_registry_report_climate_invalid(uint8_t endpoint)
+{
+    sensor_registry_report_invalid(endpoint, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT);
+    sensor_registry_report_invalid(endpoint, ESP_ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT);
+    derived_report_invalid(endpoint);
+}
+
+void sensor_registry_flash_reported(void)
+{
+#if CONFIG_ZB_ZED
+    // On battery the LED would cost more than the whole report cycle
+#else
+    // Green flash for successful read
+    status_led_show(STATUS_LED_SENSOR_OK);
+
+    // Blue flash indicates Zigbee attribute update sent
+    vTaskDelay(pdMS_TO_TICKS(50));
+    status_led_show(STATUS_LED_ZIGBEE_TX);
+#endif
+}
+
+void sensor_registry_flash_failed(void)
+{
+    status_led_show(STATUS_LED_SENSOR_ERROR);
+}
@@ -0,0 +1,229 @@
+/*
+ * Sensor Driver Registry
+ *
+ * Each sensor is a driver descriptor (sensor_driver_t) in its own
+ * sensor_<part>.c, listed once in sensor_registry.c. At boot, before the
+ * Zigbee stack starts:
+ *   1. sensor_registry_probe() scans the I2C bus, then runs every driver's
+ *      probe(): I2C address ACK, 1-Wire presence pulse, DHT11 response.
+ *   2. sensor_registry_add_endpoints() creates an endpoint (Basic + the
+ *      driver's measurement clusters) for each registered driver: the ones
+ *      detected now plus the ones ever detected on this board (kept in
+ *      NVS), so a board without a part has no dead endpoint, but a part
+ *      that glitches at boot keeps its endpoint.
+ *   3. sensor_registry_start() runs one task per registered driver.
+ *
+ * Each task runs a health state machine:
+ *   INIT      boot probe; ok → OK, error → FAILED
+ *   OK        sample() every interval_ms; error → DEGRADED. A refusal by
+ *             the I2C bus (recovery or address backoff) is a skipped
+ *             update, not an error, and changes no state.
+ *   DEGRADED  still sampling; ok → OK, SENSOR_FAILED_AFTER consecutive
+ *             errors → FAILED
+ *   FAILED    MeasuredValue set invalid; after the backoff → PROBING
+ *   PROBING   probe() again; ok → OK, error → FAILED with the backoff
+ *             doubled (SENSOR_REPROBE_BASE_MS up to SENSOR_REPROBE_MAX_MS)
+ *
+ * A driver that missed the boot probe starts in FAILED. Nothing ever
+ * deletes a sensor task, so a part that comes back is picked up again
+ * without a reboot. Each task is a supervisor client: a sample() or probe()
+ * that never returns resets the board with the endpoint as cause detail.
+ *
+ * Adding a sensor: write probe/add_clusters/sample/report_invalid in a new
+ * file, give it a free endpoint below, add it to the driver table and to
+ * CMakeLists.txt.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+#include "calibration.h"
+#include "sensor_filter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Endpoint allocation (EP14 mode switch and EP15 diagnostics are in main.c)
+#define EP_DHT11_INDOOR                 10
+#define EP_DS18B20_OUTDOOR              11
+#define EP_BH1750_LIGHT                 12
+#define EP_LD2450_PRESENCE              13      // Reserved for future (UART presence probe)
+#define EP_SHT4X_INDOOR                 16
+#define EP_BME280_INDOOR                17
+
+#define SENSOR_REGISTRY_MAX_DRIVERS     8
+#define SENSOR_TASK_PRIORITY            5
+
+// Health state machine
+#define SENSOR_FAILED_AFTER             3       // Consecutive sample() errors
+#define SENSOR_REPROBE_BASE_MS          10000
+#define SENSOR_REPROBE_MAX_MS           600000  // 10 minutes
+
+// Longest one sample() or probe() may run before the task counts as hung
+// and the supervisor resets the board (supervisor.h)
+#define SENSOR_STALL_MS                 90000
+
+typedef enum {
+    SENSOR_HEALTH_INIT = 0,
+    SENSOR_HEALTH_OK,
+    SENSOR_HEALTH_DEGRADED,         // Recent errors, still reporting
+    SENSOR_HEALTH_FAILED,           // Reporting invalid, waiting to re-probe
+    SENSOR_HEALTH_PROBING,
+    SENSOR_HEALTH_STATE_COUNT,
+} sensor_health_state_t;
+
+typedef struct {
+    sensor_health_state_t state;
+    uint32_t samples;               // sample() calls the part answered or failed
+    uint32_t errors;                // sample() errors, total
+    uint32_t skipped;               // sample() calls the I2C bus refused (i2c_bus_refused)
+    uint8_t consecutive_errors;
+    uint32_t failures;              // Entries into FAILED
+    uint32_t reprobes;              // Probe attempts from FAILED
+    uint32_t recoveries;            // Re-probes that brought the part back
+    uint32_t backoff_ms;            // Current re-probe delay
+    uint16_t availability_permille; // Time in OK/DEGRADED since start
+} sensor_health_t;
+
+typedef struct {
+    const char *name;               // Log prefix and task name
+    uint8_t endpoint;
+    uint16_t device_id;             // HA device ID for the simple descriptor
+    const char *location;           // Basic cluster LocationDescription; NULL = no Basic cluster
+
+    /**
+     * Detect and initialise the part. Also the re-probe from FAILED, so it
+     * must be safe to call again. At boot an error leaves the driver out
+     * unless the part was seen on this board before.
+     */
+    esp_err_t (*probe)(void);
+
+    /**
+     * Add the measurement clusters (MeasuredValue starts invalid).
+     */
+    void (*add_clusters)(esp_zb_cluster_list_t *clusters);
+
+    /**
+     * Read, filter and report one update. Runs on the driver's own task.
+     * Returns an error only if the part did not answer; a filter rejection
+     * is still ESP_OK.
+     */
+    esp_err_t (*sample)(void);
+
+    /**
+     * Set every MeasuredValue to its invalid value (entering FAILED), with
+     * sensor_registry_report_invalid().
+     */
+    void (*report_invalid)(void);
+
+    uint32_t interval_ms;           // Update period without a stored one (app_config.h)
+    uint32_t burst_ms;              // Spent inside sample() between oversampled reads
+    uint32_t stack_size;
+} sensor_driver_t;
+
+// Built-in drivers
+extern const sensor_driver_t sensor_driver_dht11;
+extern const sensor_driver_t sensor_driver_ds18b20;
+extern const sensor_driver_t sensor_driver_bh1750;
+extern const sensor_driver_t sensor_driver_sht4x;
+extern const sensor_driver_t sensor_driver_bme280;
+
+/**
+ * Probe every driver and work out the registered set. Returns the number
+ * detected now.
+ */
+size_t sensor_registry_probe(void);
+
+/**
+ * Create the endpoints of the registered drivers. Manufacturer and model go
+ * into each endpoint's Basic cluster.
+ */
+void sensor_registry_add_endpoints(esp_zb_ep_list_t *ep_list, const char *manufacturer, const char *model);
+
+/**
+ * Start one sampling task per registered driver.
+ */
+void sensor_registry_start(void);
+
+/**
+ * Registered driver by index (0 .. count - 1), or NULL.
+ */
+const sensor_driver_t *sensor_registry_get(size_t index);
+size_t sensor_registry_count(void);
+
+/**
+ * Health snapshot of a registered driver. Returns false for a bad index.
+ */
+bool sensor_registry_health(size_t index, sensor_health_t *health);
+const char *sensor_registry_state_name(sensor_health_state_t state);
+
+/**
+ * Forget the parts seen on this board; from the next boot only the
+ * detected ones get an endpoint again (after removing a part for good).
+ */
+esp_err_t sensor_registry_forget(void);
+
+// ========================================
+// Helpers for driver sample() functions
+// ========================================
+
+/**
+ * Push one raw reading (in `units` per 1.0) through a channel filter.
+ * Returns false if the sample was rejected (logged); skip the report then.
+ */
+bool sensor_registry_filter(sensor_filter_t *filter, const char *name, float value,
+                            float units, float *filtered);
+
+/**
+ * Report the invalid MeasuredValue of a temperature, humidity, illuminance
+ * or pressure cluster (ZB_*_INVALID, sensor_codec.h).
+ */
+void sensor_registry_report_invalid(uint8_t endpoint, uint16_t cluster_id);
+
+/**
+ * One temperature/humidity pair (DHT11, SHT4x, BME280): where it is
+ * reported and what it is filtered and calibrated with.
+ */
+typedef struct {
+    uint8_t endpoint;
+    const char *tag;                    // Driver log tag
+    const char *temp_name;              // Filter rejection log prefix
+    const char *humidity_name;
+    sensor_filter_t *temp_filter;
+    sensor_filter_t *humidity_filter;
+    calibration_channel_t temp_channel;
+    calibration_channel_t humidity_channel;
+    uint8_t telemetry_sensor;           // TELEM_SENSOR_* (telemetry.h)
+} sensor_climate_t;
+
+/**
+ * Temperature and Relative Humidity Measurement clusters (MeasuredValue
+ * invalid) plus the derived cluster (derived.h).
+ */
+void sensor_registry_add_climate_clusters(esp_zb_cluster_list_t *clusters);
+
+/**
+ * Filter, calibrate and report one temperature/humidity read, then the
+ * derived values if both channels passed the filter.
+ */
+void sensor_registry_report_climate(const sensor_climate_t *climate, float temp_celsius, float humidity_percent);
+
+/**
+ * Report all three clusters invalid (entering FAILED).
+ */
+void sensor_registry_report_climate_invalid(uint8_t endpoint);
+
+/**
+ * Status LED: green then blue flash after a reported read, red on failure.
+ */
+void sensor_registry_flash_reported(void);
+void sensor_registry_flash_failed(void);
+
+#ifdef __cplusplus
+}
+#endif
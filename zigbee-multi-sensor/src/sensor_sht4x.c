@@ -0,0 +1,104 @@
+/*
+ * SHT4x Indoor Temperature/Humidity Driver (EP16)
+ *
+ * Probe is the boot I2C scan plus a CRC-checked serial number read. Each
+ * update is one single-shot measurement: a command byte, a 10 ms wait and
+ * one 6-byte read for both channels. The part is factory calibrated to
+ * ±0.2 °C / ±1.8 %RH at 0.01 resolution, so there is no oversampling.
+ * Placement is still corrected at run time: temperature by its offset
+ * (app_config.h), both channels by calibration points (calibration.h).
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "sensors.h"
+#include "sensor_filter.h"
+#include "report_policy.h"
+#include "telemetry.h"
+#include "sensor_registry.h"
+
+static const char *TAG = "SHT4X";
+
+static const sensor_filter_config_t temp_filter_cfg = {
+    .median_window = 3,
+    .ema_shift = 0,                     // Already quiet; keep the response fast
+    .min = -4000, .max = 12500,         // Datasheet range
+    .max_slew_per_s = 5,                // 3 °C/min
+};
+
+static const sensor_filter_config_t humidity_filter_cfg = {
+    .median_window = 3,
+    .ema_shift = 0,
+    .min = 0, .max = 10000,
+    .max_slew_per_s = 10,               // 6 %/min (shower, open window)
+};
+
+static sensor_filter_t temp_filter;
+static sensor_filter_t humidity_filter;
+
+static const sensor_climate_t climate = {
+    .endpoint = EP_SHT4X_INDOOR,
+    .tag = "SHT4X",
+    .temp_name = "SHT4x temp",
+    .humidity_name = "SHT4x humidity",
+    .temp_filter = &temp_filter,
+    .humidity_filter = &humidity_filter,
+    .temp_channel = CALIBRATION_SHT4X_TEMPERATURE,
+    .humidity_channel = CALIBRATION_SHT4X_HUMIDITY,
+    .telemetry_sensor = TELEM_SENSOR_SHT4X,
+};
+
+// ========================================
+// Driver
+// ========================================
+
+static esp_err_t probe(void)
+{
+    esp_err_t ret = sht4x_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    sensor_filter_init(&temp_filter, &temp_filter_cfg);
+    sensor_filter_init(&humidity_filter, &humidity_filter_cfg);
+    return ESP_OK;
+}
+
+static void add_clusters(esp_zb_cluster_list_t *clusters)
+{
+    sensor_registry_add_climate_clusters(clusters);
+}
+
+static esp_err_t sample(void)
+{
+    float temp_celsius, humidity_percent;
+    esp_err_t ret = sht4x_read(&temp_celsius, &humidity_percent);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Read failed (%s)", esp_err_to_name(ret));
+        sensor_registry_flash_failed();
+        return ret;
+    }
+
+    sensor_registry_report_climate(&climate, temp_celsius, humidity_percent);
+
+    sensor_registry_flash_reported();
+    return ESP_OK;
+}
+
+static void report_invalid(void)
+{
+    sensor_registry_report_climate_invalid(EP_SHT4X_INDOOR);
+}
+
+const sensor_driver_t sensor_driver_sht4x = {
+    .name = "sht4x",
+    .endpoint = EP_SHT4X_INDOOR,
+    .device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
+    .location = "Indoor",
+    .probe = probe,
+    .add_clusters = add_clusters,
+    .sample = sample,
+    .report_invalid = report_invalid,
+    .interval_ms = SHT4X_UPDATE_INTERVAL,
+    .stack_size = 4096,
+};
@@ -0,0 +1,450 @@
+/*
+ * Sensor Drivers
+ *
+ * Moved out of main.c unchanged apart from the pins, which now come from
+ * sensors.h instead of being passed in. The sensor drivers
+ * (sensor_<part>.c) own timing, calibration and reporting. The 1-Wire
+ * bit-banging lives in onewire.c, the shared I2C bus in i2c_bus.c and frame
+ * decoding in sensor_codec.c.
+ *
+ * 1-Wire and DHT11 transactions run under POWER_LOCK_TIMING (power.h), so
+ * DFS and light sleep stay out of their time slots.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "rom/ets_sys.h"
+#include "i2c_bus.h"
+#include "onewire.h"
+#include "power.h"
+#include "sensor_codec.h"
+#include "sensors.h"
+
+// BH1750 Device Address and Commands
+#define BH1750_ADDR                 0x23
+#define BH1750_POWER_DOWN           0x00
+#define BH1750_POWER_ON             0x01
+#define BH1750_RESET                0x07
+#define BH1750_CONTINUOUS_HIGH_RES  0x10
+
+// SHT4x Address and Commands
+#define SHT4X_ADDR                  0x44
+#define SHT4X_CMD_MEASURE_HIGH      0xFD
+#define SHT4X_CMD_READ_SERIAL       0x89
+#define SHT4X_CMD_SOFT_RESET        0x94
+
+// BME280 Address and Registers (SDO low)
+#define BME280_ADDR                 0x76
+#define BME280_CHIP_ID              0x60
+#define BME280_REG_CALIB_TP         0x88
+#define BME280_REG_CHIP_ID          0xD0
+#define BME280_REG_RESET            0xE0
+#define BME280_REG_CALIB_H          0xE1
+#define BME280_REG_CTRL_HUM         0xF2
+#define BME280_REG_CTRL_MEAS        0xF4
+#define BME280_REG_CONFIG           0xF5
+#define BME280_REG_DATA             0xF7
+#define BME280_RESET_WORD           0xB6
+#define BME280_OSRS_H_X1            0x01
+#define BME280_CTRL_MEAS_FORCED     0x25    // osrs_t ×1, osrs_p ×1, forced mode
+
+// DS18B20 Commands
+#define DS18B20_CMD_CONVERT_T       0x44
+#define DS18B20_CMD_READ_SCRATCHPAD 0xBE
+#define DS18B20_CMD_SKIP_ROM        0xCC
+
+// DHT11 Configuration
+#define DHT11_TIMEOUT_US            1000    // Timeout for bit reads
+
+static const char *TAG = "SENSORS";
+
+static bme280_calib_t bme280_calib;
+
+// ========================================
+// I2C Bus
+// ========================================
+
+esp_err_t sensors_i2c_scan(void)
+{
+    esp_err_t ret = i2c_bus_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    i2c_bus_scan();
+    return ESP_OK;
+}
+
+// ========================================
+// BH1750 Functions
+// ========================================
+
+static esp_err_t bh1750_write_command(uint8_t command)
+{
+    return i2c_bus_write(BH1750_ADDR, &command, 1);
+}
+
+esp_err_t bh1750_read_light(float *lux)
+{
+    uint8_t data[2];
+
+    esp_err_t ret = i2c_bus_read(BH1750_ADDR, data, sizeof(data));
+    if (ret == ESP_OK) {
+        *lux = sensor_codec_bh1750_lux((data[0] << 8) | data[1]);
+    }
+
+    return ret;
+}
+
+esp_err_t bh1750_wake(void)
+{
+    esp_err_t ret = bh1750_write_command(BH1750_POWER_ON);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = bh1750_write_command(BH1750_CONTINUOUS_HIGH_RES);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(BH1750_MEASUREMENT_MS));
+    return ESP_OK;
+}
+
+esp_err_t bh1750_sleep(void)
+{
+    return bh1750_write_command(BH1750_POWER_DOWN);
+}
+
+esp_err_t bh1750_init(void)
+{
+    esp_err_t ret = i2c_bus_probe(BH1750_ADDR);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = bh1750_write_command(BH1750_POWER_ON);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "BH1750: Failed to power on");
+        return ret;
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    ret = bh1750_write_command(BH1750_RESET);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "BH1750: Failed to reset");
+        return ret;
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    ret = bh1750_write_command(BH1750_CONTINUOUS_HIGH_RES);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "BH1750: Failed to set measurement mode");
+        return ret;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(120));
+
+    return ESP_OK;
+}
+
+// ========================================
+// DS18B20 Functions
+// ========================================
+
+esp_err_t ds18b20_init(void)
+{
+    gpio_num_t pin = DS18B20_GPIO;
+
+    gpio_reset_pin(pin);
+    gpio_set_direction(pin, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+
+    power_lock(POWER_LOCK_TIMING);
+    esp_err_t ret = onewire_reset(pin);
+    power_unlock(POWER_LOCK_TIMING);
+    return ret;
+}
+
+esp_err_t ds18b20_start_conversion(void)
+{
+    gpio_num_t pin = DS18B20_GPIO;
+
+    power_lock(POWER_LOCK_TIMING);
+    esp_err_t ret = onewire_reset(pin);
+    if (ret == ESP_OK) {
+        onewire_write_byte(pin, DS18B20_CMD_SKIP_ROM);
+        onewire_write_byte(pin, DS18B20_CMD_CONVERT_T);
+    }
+    power_unlock(POWER_LOCK_TIMING);
+
+    return ret;
+}
+
+esp_err_t ds18b20_read_temperature(float *temperature)
+{
+    gpio_num_t pin = DS18B20_GPIO;
+    uint8_t data[9];
+
+    power_lock(POWER_LOCK_TIMING);
+    esp_err_t ret = onewire_reset(pin);
+    if (ret == ESP_OK) {
+        onewire_write_byte(pin, DS18B20_CMD_SKIP_ROM);
+        onewire_write_byte(pin, DS18B20_CMD_READ_SCRATCHPAD);
+        for (int i = 0; i < 9; i++) {
+            data[i] = onewire_read_byte(pin);
+        }
+    }
+    power_unlock(POWER_LOCK_TIMING);
+
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    *temperature = sensor_codec_ds18b20_celsius((int16_t)((data[1] << 8) | data[0]));
+
+    return ESP_OK;
+}
+
+// ========================================
+// DHT11 Functions
+// ========================================
+
+static esp_err_t dht11_wait_for_level(gpio_num_t pin, int level, uint32_t timeout_us)
+{
+    uint32_t start = esp_timer_get_time();
+    while (gpio_get_level(pin) != level) {
+        if ((esp_timer_get_time() - start) > timeout_us) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t dht11_read_bit(gpio_num_t pin, uint8_t *bit)
+{
+    // Wait for low phase (start of bit)
+    if (dht11_wait_for_level(pin, 0, DHT11_TIMEOUT_US) != ESP_OK) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // Wait for high phase
+    if (dht11_wait_for_level(pin, 1, DHT11_TIMEOUT_US) != ESP_OK) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // Measure high pulse duration
+    uint32_t start = esp_timer_get_time();
+    if (dht11_wait_for_level(pin, 0, DHT11_TIMEOUT_US) != ESP_OK) {
+        return ESP_ERR_TIMEOUT;
+    }
+    uint32_t duration = esp_timer_get_time() - start;
+
+    // Bit is 1 if high phase > 40us, otherwise 0
+    *bit = (duration > 40) ? 1 : 0;
+
+    return ESP_OK;
+}
+
+static esp_err_t dht11_read_frame(float *temperature, float *humidity)
+{
+    gpio_num_t pin = DHT11_GPIO;
+    uint8_t data[DHT11_FRAME_SIZE] = {0};
+
+    // Send start signal: pull low for 18ms
+    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
+    gpio_set_level(pin, 0);
+    vTaskDelay(pdMS_TO_TICKS(18));
+
+    // Release and wait 20-40us
+    gpio_set_level(pin, 1);
+    ets_delay_us(30);
+
+    // Switch to input mode
+    gpio_set_direction(pin, GPIO_MODE_INPUT);
+
+    // Wait for DHT11 response: low (80us) then high (80us)
+    if (dht11_wait_for_level(pin, 0, 100) != ESP_OK) {
+        ESP_LOGE(TAG, "DHT11: No response (timeout waiting for low)");
+        return ESP_FAIL;
+    }
+
+    if (dht11_wait_for_level(pin, 1, 100) != ESP_OK) {
+        ESP_LOGE(TAG, "DHT11: No response (timeout waiting for high)");
+        return ESP_FAIL;
+    }
+
+    if (dht11_wait_for_level(pin, 0, 100) != ESP_OK) {
+        ESP_LOGE(TAG, "DHT11: No response (timeout after high)");
+        return ESP_FAIL;
+    }
+
+    // Read 40 bits (5 bytes)
+    for (int i = 0; i < 40; i++) {
+        uint8_t bit;
+        if (dht11_read_bit(pin, &bit) != ESP_OK) {
+            ESP_LOGE(TAG, "DHT11: Timeout reading bit %d", i);
+            return ESP_FAIL;
+        }
+        data[i / 8] <<= 1;
+        data[i / 8] |= bit;
+    }
+
+    if (sensor_codec_dht11_decode(data, temperature, humidity) != ESP_OK) {
+        ESP_LOGE(TAG, "DHT11: Checksum error: calc=0x%02X, recv=0x%02X",
+                 (uint8_t)(data[0] + data[1] + data[2] + data[3]), data[4]);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t dht11_read_data(float *temperature, float *humidity)
+{
+    // From the start pulse to the last bit: the pulse sleeps in vTaskDelay,
+    // where the CPU would otherwise drop to XTAL or into light sleep
+    power_lock(POWER_LOCK_TIMING);
+    esp_err_t ret = dht11_read_frame(temperature, humidity);
+    power_unlock(POWER_LOCK_TIMING);
+    return ret;
+}
+
+esp_err_t dht11_init(void)
+{
+    gpio_num_t pin = DHT11_GPIO;
+
+    gpio_reset_pin(pin);
+    gpio_set_direction(pin, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+
+    return ESP_OK;
+}
+
+// ========================================
+// SHT4x Functions
+// ========================================
+
+static esp_err_t sht4x_command(uint8_t command, uint32_t wait_ms, uint8_t frame[SHT4X_FRAME_SIZE])
+{
+    esp_err_t ret = i2c_bus_write(SHT4X_ADDR, &command, 1);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    vTaskDelay(pdMS_TO_TICKS(wait_ms));
+    return i2c_bus_read(SHT4X_ADDR, frame, SHT4X_FRAME_SIZE);
+}
+
+esp_err_t sht4x_init(void)
+{
+    esp_err_t ret = i2c_bus_probe(SHT4X_ADDR);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    uint8_t command = SHT4X_CMD_SOFT_RESET;
+    ret = i2c_bus_write(SHT4X_ADDR, &command, 1);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SHT4x: Failed to reset");
+        return ret;
+    }
+    vTaskDelay(pdMS_TO_TICKS(2));
+
+    uint8_t frame[SHT4X_FRAME_SIZE];
+    ret = sht4x_command(SHT4X_CMD_READ_SERIAL, 2, frame);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SHT4x: Failed to read serial");
+        return ret;
+    }
+    if (sensor_codec_sht4x_crc(&frame[0]) != frame[2] || sensor_codec_sht4x_crc(&frame[3]) != frame[5]) {
+        ESP_LOGE(TAG, "SHT4x: Serial CRC error");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    ESP_LOGI(TAG, "SHT4x: serial %02X%02X%02X%02X", frame[0], frame[1], frame[3], frame[4]);
+    return ESP_OK;
+}
+
+esp_err_t sht4x_read(float *temperature, float *humidity)
+{
+    uint8_t frame[SHT4X_FRAME_SIZE];
+    esp_err_t ret = sht4x_command(SHT4X_CMD_MEASURE_HIGH, SHT4X_MEASUREMENT_MS, frame);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = sensor_codec_sht4x_decode(frame, temperature, humidity);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SHT4x: CRC error");
+    }
+    return ret;
+}
+
+// ========================================
+// BME280 Functions
+// ========================================
+
+esp_err_t bme280_init(void)
+{
+    esp_err_t ret = i2c_bus_probe(BME280_ADDR);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    uint8_t chip_id;
+    ret = i2c_bus_read_reg(BME280_ADDR, BME280_REG_CHIP_ID, &chip_id, 1);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (chip_id != BME280_CHIP_ID) {
+        ESP_LOGE(TAG, "BME280: Unexpected chip ID 0x%02X", chip_id);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ret = i2c_bus_write_reg(BME280_ADDR, BME280_REG_RESET, BME280_RESET_WORD);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "BME280: Failed to reset");
+        return ret;
+    }
+    vTaskDelay(pdMS_TO_TICKS(5));      // NVM copy after reset, 2 ms typical
+
+    uint8_t calib_tp[BME280_CALIB_TP_SIZE];
+    uint8_t calib_h[BME280_CALIB_H_SIZE];
+    ret = i2c_bus_read_reg(BME280_ADDR, BME280_REG_CALIB_TP, calib_tp, sizeof(calib_tp));
+    if (ret == ESP_OK) {
+        ret = i2c_bus_read_reg(BME280_ADDR, BME280_REG_CALIB_H, calib_h, sizeof(calib_h));
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "BME280: Failed to read calibration");
+        return ret;
+    }
+    sensor_codec_bme280_calib(calib_tp, calib_h, &bme280_calib);
+
+    // IIR filter off: the part sleeps between forced conversions and
+    // sensor_filter.c does the smoothing
+    ret = i2c_bus_write_reg(BME280_ADDR, BME280_REG_CONFIG, 0x00);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return i2c_bus_write_reg(BME280_ADDR, BME280_REG_CTRL_HUM, BME280_OSRS_H_X1);
+}
+
+esp_err_t bme280_read(float *temperature, float *humidity, float *pressure_pa)
+{
+    // ctrl_hum (set at init) only latches on a ctrl_meas write
+    esp_err_t ret = i2c_bus_write_reg(BME280_ADDR, BME280_REG_CTRL_MEAS, BME280_CTRL_MEAS_FORCED);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    vTaskDelay(pdMS_TO_TICKS(BME280_MEASUREMENT_MS));
+
+    uint8_t data[BME280_DATA_SIZE];
+    ret = i2c_bus_read_reg(BME280_ADDR, BME280_REG_DATA, data, sizeof(data));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    return sensor_codec_bme280_compensate(&bme280_calib, data, temperature, humidity, pressure_pa);
+}
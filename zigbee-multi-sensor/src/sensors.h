@@ -0,0 +1,106 @@
+/*
+ * Sensor Drivers
+ *
+ * BH1750 (I2C light), SHT4x and BME280 (I2C temperature/humidity[/pressure]),
+ * DS18B20 (1-Wire temperature) and DHT11 (single-wire temperature/humidity)
+ * on the Waveshare ESP32-C6-Zero wiring below. The I2C parts share bus 0.
+ *
+ * sensors.c (with onewire.c and i2c_bus.c) is the only code that touches
+ * sensor hardware.
+ * The host simulator (host_sim/) links its own implementation of this API
+ * that plays back scripted waveforms instead.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// GPIO Pins (Waveshare ESP32-C6-Zero)
+#define I2C_MASTER_SDA_IO               1
+#define I2C_MASTER_SCL_IO               2
+#define DS18B20_GPIO                    5
+#define DHT11_GPIO                      4
+
+// DS18B20 conversion time at 12-bit resolution
+#define DS18B20_CONVERSION_MS           750
+
+// Minimum spacing between reads (burst oversampling)
+#define BH1750_MEASUREMENT_MS           180     // H-resolution mode, worst case
+#define DHT11_MIN_INTERVAL_MS           2000    // Shorter intervals return the previous frame
+
+// Single-shot conversion times (worst case, datasheet)
+#define SHT4X_MEASUREMENT_MS            10      // High repeatability, 8.3 ms max
+#define BME280_MEASUREMENT_MS           10      // 1× oversampling on T, P and H, 9.3 ms max
+
+/**
+ * Bring up the shared I2C bus (400 kHz) and log every address that ACKs.
+ * Runs once before the I2C parts are probed. Their init addresses the part
+ * again (ESP_ERR_NOT_FOUND without an ACK), so it also works as a re-probe.
+ */
+esp_err_t sensors_i2c_scan(void);
+
+/**
+ * Configure the BH1750 for continuous high-resolution measurement.
+ */
+esp_err_t bh1750_init(void);
+esp_err_t bh1750_read_light(float *lux);
+
+/**
+ * Power up and restart continuous measurement; blocks for the first
+ * measurement (BH1750_MEASUREMENT_MS).
+ */
+esp_err_t bh1750_wake(void);
+
+/**
+ * Power down between bursts (~1 µA instead of ~120 µA).
+ */
+esp_err_t bh1750_sleep(void);
+
+/**
+ * Configure the 1-Wire pin and check for a presence pulse.
+ */
+esp_err_t ds18b20_init(void);
+
+/**
+ * Start a conversion; read the result DS18B20_CONVERSION_MS later.
+ */
+esp_err_t ds18b20_start_conversion(void);
+esp_err_t ds18b20_read_temperature(float *temperature);
+
+esp_err_t dht11_init(void);
+
+/**
+ * Bit-banged read (~25 ms, blocks the calling task). Fails on missing
+ * response, bit timeout or checksum mismatch.
+ */
+esp_err_t dht11_read_data(float *temperature, float *humidity);
+
+/**
+ * Soft reset and read the serial number (logged).
+ */
+esp_err_t sht4x_init(void);
+
+/**
+ * High-repeatability single shot: command, SHT4X_MEASUREMENT_MS wait, one
+ * 6-byte read. Fails on NACK or CRC mismatch.
+ */
+esp_err_t sht4x_read(float *temperature, float *humidity);
+
+/**
+ * Check the chip ID (0x60; a BMP280 has no humidity and is rejected),
+ * soft reset and burst-read the calibration.
+ */
+esp_err_t bme280_init(void);
+
+/**
+ * Forced-mode conversion, then one 8-byte burst read of all three results.
+ */
+esp_err_t bme280_read(float *temperature, float *humidity, float *pressure_pa);
+
+#ifdef __cplusplus
+}
+#endif
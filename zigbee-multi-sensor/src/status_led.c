@@ -0,0 +1,91 @@
+/*
+ * WS2812 Status LED
+ *
+ * Moved out of main.c: the per-indicator helpers became one pattern table,
+ * so every indicator goes through the same dispatch path.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "led_strip.h"
+#include "status_led.h"
+
+#define WS2812_LED_COUNT                1       // Single RGB LED
+
+static const char *TAG = "STATUS_LED";
+
+typedef struct {
+    uint8_t r, g, b;
+    uint16_t flash_ms;          // 0 = solid
+} led_pattern_t;
+
+static const led_pattern_t patterns[STATUS_LED_PATTERN_COUNT] = {
+    [STATUS_LED_OFF]              = {  0,  0,  0,   0 },
+    [STATUS_LED_SENSOR_OK]        = {  0, 50,  0, 100 },    // Green
+    [STATUS_LED_SENSOR_ERROR]     = { 50,  0,  0, 200 },    // Red
+    [STATUS_LED_SENSOR_INIT]      = { 50, 25,  0, 150 },    // Yellow/Orange
+    [STATUS_LED_ZIGBEE_TX]        = {  0,  0, 50, 100 },    // Blue
+    [STATUS_LED_ZIGBEE_SEARCHING] = { 40,  0, 20,   0 },    // Purple/Magenta (more red than blue)
+    [STATUS_LED_ZIGBEE_CONNECTED] = {  0, 50, 50, 200 },    // Cyan
+    [STATUS_LED_SYSTEM_OK]        = { 20, 20, 20, 100 },    // White
+};
+
+static led_strip_handle_t led_strip = NULL;
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t status_led_init(void)
+{
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = WS2812_GPIO,
+        .max_leds = WS2812_LED_COUNT,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+        .flags.invert_out = false,
+    };
+
+    led_strip_rmt_config_t rmt_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = 10 * 1000 * 1000, // 10MHz
+        .flags.with_dma = false,
+    };
+
+    esp_err_t ret = led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create LED strip: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Clear LED on init
+    led_strip_clear(led_strip);
+    ESP_LOGI(TAG, "WS2812 RGB LED initialized on GPIO%d", WS2812_GPIO);
+    return ESP_OK;
+}
+
+void status_led_set(status_led_pattern_t pattern)
+{
+    if (led_strip == NULL || pattern >= STATUS_LED_PATTERN_COUNT) return;
+
+    const led_pattern_t *p = &patterns[pattern];
+    if (pattern == STATUS_LED_OFF) {
+        led_strip_clear(led_strip);
+        return;
+    }
+    led_strip_set_pixel(led_strip, 0, p->r, p->g, p->b);
+    led_strip_refresh(led_strip);
+}
+
+void status_led_show(status_led_pattern_t pattern)
+{
+    if (led_strip == NULL || pattern >= STATUS_LED_PATTERN_COUNT) return;
+
+    status_led_set(pattern);
+
+    if (patterns[pattern].flash_ms > 0) {
+        vTaskDelay(pdMS_TO_TICKS(patterns[pattern].flash_ms));
+        led_strip_clear(led_strip);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * WS2812 Status LED
+ *
+ * Visual Indicators:
+ * - Green flash: Sensor read successful
+ * - Red flash: Sensor read failed
+ * - Blue flash: Zigbee message sent successfully
+ * - Purple: Zigbee searching for network
+ * - Yellow: Sensor initializing
+ * - White flash: System operational check
+ * - Cyan flash: Joined network
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RGB LED data pin (Waveshare ESP32-C6-Zero)
+#define WS2812_GPIO                     8
+
+typedef enum {
+    STATUS_LED_OFF = 0,
+    STATUS_LED_SENSOR_OK,
+    STATUS_LED_SENSOR_ERROR,
+    STATUS_LED_SENSOR_INIT,
+    STATUS_LED_ZIGBEE_TX,
+    STATUS_LED_ZIGBEE_SEARCHING,
+    STATUS_LED_ZIGBEE_CONNECTED,
+    STATUS_LED_SYSTEM_OK,
+    STATUS_LED_PATTERN_COUNT,
+} status_led_pattern_t;
+
+esp_err_t status_led_init(void);
+
+/**
+ * Show a pattern. Flashes block the calling task for their duration and
+ * then clear the LED; solid patterns return immediately.
+ */
+void status_led_show(status_led_pattern_t pattern);
+
+/**
+ * Set the pattern's colour without holding or clearing it.
+ */
+void status_led_set(status_led_pattern_t pattern);
+
+#ifdef __cplusplus
+}
+#endif
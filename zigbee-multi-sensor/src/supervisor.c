@@ -0,0 +1,321 @@
+/*
+ * Heartbeat Supervisor and Reset Counters
+ *
+ * The cause of a supervisor reset is written to NVS before the reset and
+ * cleared on the next boot, so it is only trusted after a reset the
+ * supervisor can have caused (software, panic or watchdog); after a power
+ * loss a stale cause is dropped.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_task_wdt.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "esp_zigbee_core.h"
+#include "zb_diagnostics.h"
+#include "supervisor.h"
+
+#define SUPERVISOR_TASK_STACK           2560
+#define SUPERVISOR_TASK_PRIORITY        (configMAX_PRIORITIES - 2)  // Must not be starved by what it watches
+
+#define SUPERVISOR_NVS_NAMESPACE        "supervisor"
+#define SUPERVISOR_NVS_KEY_COUNTS       "reset_cnt"     // uint16 blob, one per reset reason
+#define SUPERVISOR_NVS_KEY_CAUSE        "cause"         // uint16: cause << 8 | detail
+
+typedef struct {
+    const char *name;
+    supervisor_cause_t cause;
+    uint8_t detail;
+    int64_t deadline_us;
+} client_t;
+
+static const char *TAG = "SUPERVISOR";
+
+static const char *cause_names[SUPERVISOR_CAUSE_COUNT] = {
+    "none",
+    "zigbee stall",
+    "sensor stall",
+    "i2c hung",
+};
+
+// Guards the client table; check-ins come from every supervised task
+static portMUX_TYPE client_lock = portMUX_INITIALIZER_UNLOCKED;
+static client_t clients[SUPERVISOR_MAX_CLIENTS];
+static int client_count = 0;
+static int zigbee_client = -1;
+
+// This boot
+static esp_reset_reason_t boot_reason = ESP_RST_UNKNOWN;
+static supervisor_cause_t boot_cause = SUPERVISOR_CAUSE_NONE;
+static uint8_t boot_detail = 0;
+static uint16_t reset_counts[SUPERVISOR_RESET_REASONS];
+static uint16_t reset_total = 0;
+
+// ========================================
+// NVS Persistence
+// ========================================
+
+static void load_counts(void)
+{
+    nvs_handle_t handle;
+    size_t len = sizeof(reset_counts);
+
+    memset(reset_counts, 0, sizeof(reset_counts));
+    if (nvs_open(SUPERVISOR_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;  // Namespace not created yet (first boot)
+    }
+    if (nvs_get_blob(handle, SUPERVISOR_NVS_KEY_COUNTS, reset_counts, &len) != ESP_OK ||
+        len != sizeof(reset_counts)) {
+        memset(reset_counts, 0, sizeof(reset_counts));
+    }
+    nvs_close(handle);
+}
+
+/**
+ * Store the counters and take the pending cause out of NVS (read and
+ * erased in one open).
+ */
+static esp_err_t store_counts_take_cause(uint16_t *cause)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(SUPERVISOR_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (nvs_get_u16(handle, SUPERVISOR_NVS_KEY_CAUSE, cause) == ESP_OK) {
+        nvs_erase_key(handle, SUPERVISOR_NVS_KEY_CAUSE);
+    } else {
+        *cause = 0;
+    }
+    ret = nvs_set_blob(handle, SUPERVISOR_NVS_KEY_COUNTS, reset_counts, sizeof(reset_counts));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
+
+static esp_err_t store_cause(supervisor_cause_t cause, uint8_t detail)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(SUPERVISOR_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = nvs_set_u16(handle, SUPERVISOR_NVS_KEY_CAUSE, (uint16_t)((cause << 8) | detail));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
+
+// ========================================
+// Boot Accounting
+// ========================================
+
+static bool reason_can_be_ours(esp_reset_reason_t reason)
+{
+    return reason == ESP_RST_SW || reason == ESP_RST_PANIC || reason == ESP_RST_TASK_WDT ||
+           reason == ESP_RST_INT_WDT || reason == ESP_RST_WDT;
+}
+
+static void count_boot(void)
+{
+    boot_reason = esp_reset_reason();
+    load_counts();
+
+    size_t index = (size_t)boot_reason < SUPERVISOR_RESET_REASONS ? (size_t)boot_reason : ESP_RST_UNKNOWN;
+    if (reset_counts[index] < UINT16_MAX) {
+        reset_counts[index]++;
+    }
+
+    uint32_t total = 0;
+    for (int i = 0; i < SUPERVISOR_RESET_REASONS; i++) {
+        total += reset_counts[i];
+    }
+    reset_total = total > UINT16_MAX ? UINT16_MAX : (uint16_t)total;
+
+    uint16_t cause = 0;
+    esp_err_t ret = store_counts_take_cause(&cause);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to store reset counters (%s)", esp_err_to_name(ret));
+    }
+    if (cause >> 8 < SUPERVISOR_CAUSE_COUNT && reason_can_be_ours(boot_reason)) {
+        boot_cause = (supervisor_cause_t)(cause >> 8);
+        boot_detail = cause & 0xFF;
+    }
+
+    if (boot_cause != SUPERVISOR_CAUSE_NONE) {
+        ESP_LOGW(TAG, "Boot #%u after supervisor reset: %s (detail %u), reset reason %d",
+                 reset_total, cause_names[boot_cause], boot_detail, boot_reason);
+    } else {
+        ESP_LOGI(TAG, "Boot #%u, reset reason %d", reset_total, boot_reason);
+    }
+}
+
+static void publish_boot(void)
+{
+    static uint8_t buf[SUPERVISOR_HEADER_SIZE + SUPERVISOR_RESET_REASONS * 2];
+    uint8_t *p = buf;
+
+    *p++ = SUPERVISOR_FORMAT_VERSION;
+    *p++ = (uint8_t)boot_reason;
+    *p++ = (uint8_t)boot_cause;
+    *p++ = boot_detail;
+    *p++ = reset_total & 0xFF;
+    *p++ = reset_total >> 8;
+    *p++ = SUPERVISOR_RESET_REASONS;
+    for (int i = 0; i < SUPERVISOR_RESET_REASONS; i++) {
+        *p++ = reset_counts[i] & 0xFF;
+        *p++ = reset_counts[i] >> 8;
+    }
+
+    zb_diagnostics_set_attr(ZB_DIAG_ATTR_NUMBER_OF_RESETS, &reset_total);
+    zb_diagnostics_set_octet_string(ZB_DIAG_ATTR_RESET_STATS, buf, (uint8_t)(p - buf));
+}
+
+// ========================================
+// Supervision
+// ========================================
+
+static void zigbee_heartbeat(uint8_t param)
+{
+    supervisor_checkin(zigbee_client, SUPERVISOR_ZIGBEE_DEADLINE_MS);
+    esp_zb_scheduler_alarm(zigbee_heartbeat, 0, SUPERVISOR_ZIGBEE_PERIOD_MS);
+}
+
+/**
+ * First client past its deadline, or -1.
+ */
+static int find_overdue(int64_t now_us)
+{
+    int overdue = -1;
+
+    taskENTER_CRITICAL(&client_lock);
+    for (int i = 0; i < client_count; i++) {
+        if (now_us > clients[i].deadline_us) {
+            overdue = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&client_lock);
+
+    return overdue;
+}
+
+static void supervisor_task(void *pvParameters)
+{
+    esp_err_t ret = esp_task_wdt_add(NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Not on the task watchdog (%s), supervising without it", esp_err_to_name(ret));
+    }
+
+    while (1) {
+        int overdue = find_overdue(esp_timer_get_time());
+        if (overdue < 0) {
+            esp_task_wdt_reset();
+            vTaskDelay(pdMS_TO_TICKS(SUPERVISOR_PERIOD_MS));
+            continue;
+        }
+
+        // Stop feeding: the TWDT resets the chip within its timeout
+        const client_t *c = &clients[overdue];
+        ESP_LOGE(TAG, "%s missed its check-in by %lld ms, stopping the watchdog feed", c->name,
+                 (long long)((esp_timer_get_time() - c->deadline_us) / 1000));
+        store_cause(c->cause, c->detail);
+        if (ret != ESP_OK) {
+            supervisor_restart(c->cause, c->detail);
+        }
+        while (1) {
+            vTaskDelay(portMAX_DELAY);
+        }
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+int supervisor_register(const char *name, supervisor_cause_t cause, uint8_t detail, uint32_t first_within_ms)
+{
+    int id = -1;
+    int64_t deadline_us = esp_timer_get_time() + first_within_ms * 1000LL;
+
+    taskENTER_CRITICAL(&client_lock);
+    if (client_count < SUPERVISOR_MAX_CLIENTS) {
+        id = client_count++;
+        clients[id] = (client_t){
+            .name = name,
+            .cause = cause,
+            .detail = detail,
+            .deadline_us = deadline_us,
+        };
+    }
+    taskEXIT_CRITICAL(&client_lock);
+
+    if (id < 0) {
+        ESP_LOGW(TAG, "Client table full, %s not supervised", name);
+    }
+    return id;
+}
+
+void supervisor_checkin(int client, uint32_t next_within_ms)
+{
+    if (client < 0) {
+        return;
+    }
+
+    int64_t deadline_us = esp_timer_get_time() + next_within_ms * 1000LL;
+
+    taskENTER_CRITICAL(&client_lock);
+    clients[client].deadline_us = deadline_us;
+    taskEXIT_CRITICAL(&client_lock);
+}
+
+esp_err_t supervisor_start(void)
+{
+    count_boot();
+    publish_boot();
+
+    zigbee_client = supervisor_register("zigbee", SUPERVISOR_CAUSE_ZIGBEE_STALL, 0, SUPERVISOR_ZIGBEE_DEADLINE_MS);
+    esp_zb_scheduler_alarm(zigbee_heartbeat, 0, SUPERVISOR_ZIGBEE_PERIOD_MS);
+
+    BaseType_t ret = xTaskCreate(supervisor_task, "supervisor", SUPERVISOR_TASK_STACK, NULL,
+                                 SUPERVISOR_TASK_PRIORITY, NULL);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create supervisor task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Supervising %d client(s), TWDT fed every %d ms", client_count, SUPERVISOR_PERIOD_MS);
+    return ESP_OK;
+}
+
+void supervisor_restart(supervisor_cause_t cause, uint8_t detail)
+{
+    ESP_LOGE(TAG, "Restarting: %s (detail %u)", supervisor_cause_name(cause), detail);
+    store_cause(cause, detail);
+    esp_restart();
+}
+
+supervisor_cause_t supervisor_last_cause(uint8_t *detail)
+{
+    if (detail) {
+        *detail = boot_detail;
+    }
+    return boot_cause;
+}
+
+const char *supervisor_cause_name(supervisor_cause_t cause)
+{
+    return cause < SUPERVISOR_CAUSE_COUNT ? cause_names[cause] : "unknown";
+}
@@ -0,0 +1,95 @@
+/*
+ * Heartbeat Supervisor and Reset Counters
+ *
+ * Subsystems that can hang register as clients and check in with
+ * supervisor_checkin(), each time saying how long until their next check-in
+ * at the latest. The supervisor task is the only task subscribed to the task
+ * watchdog (TWDT) and feeds it every SUPERVISOR_PERIOD_MS, but only while
+ * every client is within its deadline. A client that overruns gets its
+ * cause code stored in NVS; the feed stops and the TWDT resets the chip
+ * (CONFIG_ESP_TASK_WDT_PANIC, sdkconfig.defaults).
+ *
+ * Clients:
+ *   Zigbee    a scheduler alarm in the Zigbee task, so a stalled main loop
+ *             stops checking in
+ *   Sensors   one per registered sensor task (sensor_registry.c); a hung
+ *             sample() or probe() (1-Wire, DHT11, I2C) misses its deadline
+ *
+ * A fault that is detected rather than hung (the I2C bus still stuck after
+ * repeated recovery, i2c_bus.h) restarts at once with supervisor_restart().
+ *
+ * Every boot counts its reset reason (esp_reset_reason_t) in NVS. The total
+ * is the Diagnostics NumberOfResets attribute; the details are in the reset
+ * stats attribute (0xF012 on the EP 15 Diagnostics cluster), little-endian:
+ *   [0]      format version (1)
+ *   [1]      reset reason of this boot (esp_reset_reason_t)
+ *   [2]      supervisor cause of this boot (supervisor_cause_t, 0 = none)
+ *   [3]      cause detail (sensor endpoint, stuck I2C line)
+ *   [4..5]   total resets
+ *   [6]      reason count N
+ *   [7..]    resets per reason 0 .. N - 1, 2 bytes each
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SUPERVISOR_PERIOD_MS            1000    // Deadline check and TWDT feed
+#define SUPERVISOR_MAX_CLIENTS          12
+#define SUPERVISOR_RESET_REASONS        16      // esp_reset_reason_t values counted
+#define SUPERVISOR_FORMAT_VERSION       1
+#define SUPERVISOR_HEADER_SIZE          7
+
+// Zigbee main loop heartbeat
+#define SUPERVISOR_ZIGBEE_PERIOD_MS     2000
+#define SUPERVISOR_ZIGBEE_DEADLINE_MS   15000
+
+typedef enum {
+    SUPERVISOR_CAUSE_NONE = 0,
+    SUPERVISOR_CAUSE_ZIGBEE_STALL,      // Zigbee main loop stopped running alarms
+    SUPERVISOR_CAUSE_SENSOR_STALL,      // Detail: sensor endpoint
+    SUPERVISOR_CAUSE_I2C_HUNG,          // Detail: 1 = SCL, 2 = SDA held low, 3 = driver
+    SUPERVISOR_CAUSE_COUNT,
+} supervisor_cause_t;
+
+/**
+ * Register a client. Its first check-in is due within `first_within_ms`.
+ * Returns the client id, or -1 if the table is full (the client is then
+ * not supervised).
+ */
+int supervisor_register(const char *name, supervisor_cause_t cause, uint8_t detail, uint32_t first_within_ms);
+
+/**
+ * Check in; the next check-in is due within `next_within_ms`. Ignores -1.
+ */
+void supervisor_checkin(int client, uint32_t next_within_ms);
+
+/**
+ * Count this boot's reset reason, pick up the cause of a supervisor reset,
+ * publish both on EP 15 and start the supervisor task and the Zigbee
+ * heartbeat. Call from the Zigbee task after the endpoints are registered
+ * and after the other clients have registered.
+ */
+esp_err_t supervisor_start(void);
+
+/**
+ * Store `cause` and restart now.
+ */
+void supervisor_restart(supervisor_cause_t cause, uint8_t detail);
+
+/**
+ * Cause of the reset that started this boot (SUPERVISOR_CAUSE_NONE if it
+ * was not the supervisor's). `detail` may be NULL.
+ */
+supervisor_cause_t supervisor_last_cause(uint8_t *detail);
+
+const char *supervisor_cause_name(supervisor_cause_t cause);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,335 @@
+/*
+ * Runtime System Profiler
+ *
+ * The profiler task only reads counters the kernel and allocator already
+ * maintain; one uxTaskGetSystemState() call per period suspends the
+ * scheduler briefly, everything else is arithmetic on static buffers.
+ *
+ * The attribute table belongs to the Zigbee task, so the profiler task
+ * only builds the system stats payload; an alarm on the Zigbee task
+ * publishes the latest one.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_zigbee_core.h"
+#include "zb_diagnostics.h"
+#include "telemetry.h"
+#include "sys_profiler.h"
+
+#if !CONFIG_FREERTOS_USE_TRACE_FACILITY || !CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#error "sys_profiler.c needs CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS"
+#endif
+
+#define PROFILER_TASK_STACK     3072
+#define PROFILER_TASK_PRIORITY  1       // Just above idle
+#define STATS_MAX_LEN           (SYS_PROFILER_HEADER_SIZE + SYS_PROFILER_MAX_TASKS * SYS_PROFILER_TASK_ENTRY_SIZE)
+
+static const char *TAG = "SYS_PROF";
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t number;             // xTaskNumber, stable for the task's lifetime
+    configRUN_TIME_COUNTER_TYPE last_counter;
+    uint8_t cpu_pct;
+    uint32_t stack_hwm;             // Bytes (IDF stacks are byte-addressed)
+    bool seen;                      // Present in the latest sample
+} task_profile_t;
+
+static portMUX_TYPE profile_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskStatus_t task_status[SYS_PROFILER_MAX_TASKS];
+static task_profile_t tasks[SYS_PROFILER_MAX_TASKS];
+static uint8_t task_count = 0;
+static configRUN_TIME_COUNTER_TYPE last_total = 0;
+
+// Rolling heap window
+static uint32_t window_free[SYS_PROFILER_WINDOW];
+static uint8_t window_next = 0;
+static uint8_t window_count = 0;
+
+static sys_profiler_summary_t summary;
+
+// Latest system stats payload: the profiler task writes, the Zigbee task publishes
+static uint8_t pending_stats[STATS_MAX_LEN];
+static uint8_t pending_len = 0;
+
+// ========================================
+// Sampling
+// ========================================
+
+static task_profile_t *find_profile(UBaseType_t number)
+{
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].seen && tasks[i].number == number) {
+            return &tasks[i];
+        }
+    }
+    return NULL;
+}
+
+static task_profile_t *alloc_profile(void)
+{
+    // Reuse the slot of a task that has been deleted
+    for (int i = 0; i < task_count; i++) {
+        if (!tasks[i].seen) {
+            return &tasks[i];
+        }
+    }
+    if (task_count < SYS_PROFILER_MAX_TASKS) {
+        return &tasks[task_count++];
+    }
+    return NULL;
+}
+
+static void sample_tasks(void)
+{
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(task_status, SYS_PROFILER_MAX_TASKS, &total);
+    bool matched[SYS_PROFILER_MAX_TASKS] = { false };
+
+    // Counters wrap; unsigned deltas stay correct while the period is short
+    configRUN_TIME_COUNTER_TYPE total_delta = (total - last_total) * portNUM_PROCESSORS;
+    last_total = total;
+
+    uint32_t idle_pct = 0;
+
+    portENTER_CRITICAL(&profile_lock);
+
+    // Known tasks: CPU share since the previous sample
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *st = &task_status[i];
+        task_profile_t *t = find_profile(st->xTaskNumber);
+        if (!t) {
+            continue;
+        }
+
+        configRUN_TIME_COUNTER_TYPE delta = st->ulRunTimeCounter - t->last_counter;
+        t->last_counter = st->ulRunTimeCounter;
+        t->cpu_pct = total_delta ? (uint8_t)(((uint64_t)delta * 100) / total_delta) : 0;
+        t->stack_hwm = st->usStackHighWaterMark;
+        matched[t - tasks] = true;
+
+        if (strncmp(st->pcTaskName, "IDLE", 4) == 0) {
+            idle_pct += t->cpu_pct;
+        }
+    }
+
+    // Drop tasks that no longer exist, then add new ones (CPU share from the next sample)
+    for (int i = 0; i < task_count; i++) {
+        tasks[i].seen = matched[i];
+    }
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *st = &task_status[i];
+        if (find_profile(st->xTaskNumber)) {
+            continue;
+        }
+        task_profile_t *t = alloc_profile();
+        if (!t) {
+            break;
+        }
+        memset(t, 0, sizeof(*t));
+        strncpy(t->name, st->pcTaskName, sizeof(t->name) - 1);
+        t->number = st->xTaskNumber;
+        t->last_counter = st->ulRunTimeCounter;
+        t->stack_hwm = st->usStackHighWaterMark;
+        t->seen = true;
+    }
+
+    portEXIT_CRITICAL(&profile_lock);
+
+    summary.task_count = (uint8_t)n;
+    summary.cpu_load_pct = idle_pct >= 100 ? 0 : (uint8_t)(100 - idle_pct);
+}
+
+static void sample_heap(void)
+{
+    uint32_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+
+    window_free[window_next] = free_bytes;
+    window_next = (window_next + 1) % SYS_PROFILER_WINDOW;
+    if (window_count < SYS_PROFILER_WINDOW) {
+        window_count++;
+    }
+
+    uint32_t min = UINT32_MAX, max = 0;
+    uint64_t sum = 0;
+    for (int i = 0; i < window_count; i++) {
+        if (window_free[i] < min) {
+            min = window_free[i];
+        }
+        if (window_free[i] > max) {
+            max = window_free[i];
+        }
+        sum += window_free[i];
+    }
+    uint32_t mean = (uint32_t)(sum / window_count);
+
+    summary.heap_free = free_bytes;
+    summary.heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    summary.heap_largest_block = largest;
+    summary.heap_frag_pct = free_bytes ? (uint8_t)(100 - (uint64_t)largest * 100 / free_bytes) : 0;
+    summary.heap_variance_permille = mean ? (uint16_t)(((uint64_t)(max - min) * 1000) / mean) : 0;
+}
+
+// ========================================
+// Output
+// ========================================
+
+static void put_u32(uint8_t **p, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        *(*p)++ = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+/**
+ * Build the system stats payload for the Zigbee task and send the
+ * telemetry record (profiler task)
+ */
+static void publish_summary(void)
+{
+    uint8_t buf[STATS_MAX_LEN];
+    uint8_t *p = buf;
+    uint8_t *count = NULL;
+
+    *p++ = SYS_PROFILER_FORMAT_VERSION;
+    *p++ = summary.cpu_load_pct;
+    put_u32(&p, summary.heap_free);
+    put_u32(&p, summary.heap_min_free);
+    put_u32(&p, summary.heap_largest_block);
+    *p++ = summary.heap_frag_pct;
+    *p++ = summary.heap_variance_permille & 0xFF;
+    *p++ = summary.heap_variance_permille >> 8;
+    count = p++;
+    *count = 0;
+
+    portENTER_CRITICAL(&profile_lock);
+    for (int i = 0; i < task_count; i++) {
+        const task_profile_t *t = &tasks[i];
+        if (!t->seen) {
+            continue;
+        }
+        uint16_t hwm = t->stack_hwm > UINT16_MAX ? UINT16_MAX : (uint16_t)t->stack_hwm;
+
+        strncpy((char *)p, t->name, 4);     // Zero-padded, not terminated
+        p += 4;
+        *p++ = t->cpu_pct;
+        *p++ = hwm & 0xFF;
+        *p++ = hwm >> 8;
+        (*count)++;
+    }
+    pending_len = (uint8_t)(p - buf);
+    memcpy(pending_stats, buf, pending_len);
+    portEXIT_CRITICAL(&profile_lock);
+
+    // Header fields up to fragmentation are shared with the telemetry SYSTEM record
+    telemetry_send(TELEM_REC_SYSTEM, &buf[1], 14);
+}
+
+/**
+ * Copy the latest payload into the attribute table (Zigbee task)
+ */
+static void publish_alarm(uint8_t param)
+{
+    uint8_t buf[STATS_MAX_LEN];
+    uint8_t len;
+
+    portENTER_CRITICAL(&profile_lock);
+    len = pending_len;
+    memcpy(buf, pending_stats, len);
+    pending_len = 0;
+    portEXIT_CRITICAL(&profile_lock);
+
+    if (len > 0) {
+        zb_diagnostics_set_octet_string(ZB_DIAG_ATTR_SYSTEM_STATS, buf, len);
+    }
+    esp_zb_scheduler_alarm(publish_alarm, 0, SYS_PROFILER_PERIOD_MS);
+}
+
+static void log_summary(void)
+{
+    const char *low_name = "-";
+    uint32_t low_hwm = UINT32_MAX;
+
+    portENTER_CRITICAL(&profile_lock);
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].seen && tasks[i].stack_hwm < low_hwm) {
+            low_hwm = tasks[i].stack_hwm;
+            low_name = tasks[i].name;
+        }
+    }
+    portEXIT_CRITICAL(&profile_lock);
+
+    ESP_LOGI(TAG, "CPU %u%% | heap %lu (min %lu, blk %lu, frag %u%%, var %u.%u%%) | stack low: %s %lu B",
+             summary.cpu_load_pct,
+             (unsigned long)summary.heap_free, (unsigned long)summary.heap_min_free,
+             (unsigned long)summary.heap_largest_block, summary.heap_frag_pct,
+             summary.heap_variance_permille / 10, summary.heap_variance_permille % 10,
+             low_name, (unsigned long)low_hwm);
+
+    if (low_hwm < SYS_PROFILER_STACK_WARN_BYTES) {
+        ESP_LOGW(TAG, "⚠️  Task %s has only %lu bytes of stack headroom", low_name, (unsigned long)low_hwm);
+        sys_profiler_print_tasks();
+    }
+}
+
+static void sys_profiler_task(void *pvParameters)
+{
+    // Prime the run-time counters so the first CPU figures cover a full period
+    sample_tasks();
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(SYS_PROFILER_PERIOD_MS));
+
+        sample_tasks();
+        sample_heap();
+        log_summary();
+        publish_summary();
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t sys_profiler_start(void)
+{
+    esp_zb_scheduler_alarm(publish_alarm, 0, SYS_PROFILER_PERIOD_MS);
+
+    BaseType_t ret = xTaskCreate(sys_profiler_task, "sys_prof", PROFILER_TASK_STACK, NULL,
+                                 PROFILER_TASK_PRIORITY, NULL);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create profiler task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+const sys_profiler_summary_t *sys_profiler_get_summary(void)
+{
+    return &summary;
+}
+
+void sys_profiler_print_tasks(void)
+{
+    task_profile_t copy[SYS_PROFILER_MAX_TASKS];
+    uint8_t count;
+
+    portENTER_CRITICAL(&profile_lock);
+    count = task_count;
+    memcpy(copy, tasks, sizeof(copy));
+    portEXIT_CRITICAL(&profile_lock);
+
+    ESP_LOGI(TAG, "%-16s %5s %10s", "Task", "CPU%", "Stack free");
+    for (int i = 0; i < count; i++) {
+        if (copy[i].seen) {
+            ESP_LOGI(TAG, "%-16s %4u%% %8lu B", copy[i].name, copy[i].cpu_pct,
+                     (unsigned long)copy[i].stack_hwm);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * Runtime System Profiler
+ *
+ * Low-priority task that samples, every SYS_PROFILER_PERIOD_MS:
+ *   - per-task CPU share from FreeRTOS run-time counters (uxTaskGetSystemState)
+ *   - per-task stack high-water marks (bytes never used since boot)
+ *   - heap free / minimum-ever / largest free block (heap_caps)
+ * Heap figures go into a rolling window to expose drift and fragmentation.
+ *
+ * Needs CONFIG_FREERTOS_USE_TRACE_FACILITY and
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS (see sdkconfig.defaults).
+ *
+ * System stats attribute (0xF011 on the EP 15 Diagnostics cluster), little-endian:
+ *   [0]      format version (1)
+ *   [1]      CPU load % (non-idle share over the last period)
+ *   [2..5]   heap free bytes
+ *   [6..9]   heap minimum-ever free bytes
+ *   [10..13] largest free block bytes
+ *   [14]     fragmentation % (100 - largest * 100 / free)
+ *   [15..16] heap variance over the window, per-mille ((max - min) * 1000 / mean)
+ *   [17]     task count
+ *   [18..]   tasks, SYS_PROFILER_TASK_ENTRY_SIZE bytes each:
+ *              name (4, truncated, zero-padded), CPU % (1), stack high-water bytes (2)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SYS_PROFILER_PERIOD_MS          10000   // Sample interval
+#define SYS_PROFILER_WINDOW             60      // Heap samples kept (10 min)
+#define SYS_PROFILER_MAX_TASKS          20
+#define SYS_PROFILER_STACK_WARN_BYTES   512     // Warn when a task has less headroom
+#define SYS_PROFILER_FORMAT_VERSION     1
+#define SYS_PROFILER_HEADER_SIZE        18
+#define SYS_PROFILER_TASK_ENTRY_SIZE    7
+
+typedef struct {
+    uint32_t heap_free;
+    uint32_t heap_min_free;
+    uint32_t heap_largest_block;
+    uint8_t heap_frag_pct;
+    uint16_t heap_variance_permille;
+    uint8_t cpu_load_pct;
+    uint8_t task_count;
+} sys_profiler_summary_t;
+
+/**
+ * Start the profiler task and the Zigbee alarm that publishes its stats
+ * (Zigbee task, once, after the application tasks exist).
+ */
+esp_err_t sys_profiler_start(void);
+
+/**
+ * Latest summary (all zero before the first sample).
+ */
+const sys_profiler_summary_t *sys_profiler_get_summary(void);
+
+/**
+ * Print the full per-task table from the last sample.
+ */
+void sys_profiler_print_tasks(void);
+
+#ifdef __cplusplus
+}
+#endif
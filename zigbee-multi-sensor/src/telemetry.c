@@ -0,0 +1,165 @@
+/*
+ * Binary Telemetry Stream
+ *
+ * Records are built on the caller's stack, then encoded into one shared TX
+ * buffer under a mutex and handed to stdout with a single fwrite(), which
+ * newlib serialises against concurrent ESP_LOGx output.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "telemetry.h"
+
+#define FRAME_HEADER_SIZE   7
+#define FRAME_CRC_SIZE      2
+#define FRAME_MAX           (FRAME_HEADER_SIZE + TELEM_MAX_PAYLOAD + FRAME_CRC_SIZE)
+// COBS adds one byte per 254 plus one; two delimiters around it
+#define WIRE_MAX            (FRAME_MAX + FRAME_MAX / 254 + 1 + 2)
+
+static const char *TAG = "TELEMETRY";
+
+static SemaphoreHandle_t tx_mutex = NULL;
+static uint8_t tx_buf[WIRE_MAX];
+static uint16_t tx_seq = 0;
+
+// ========================================
+// Encoding
+// ========================================
+
+static uint16_t crc16_ccitt(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/**
+ * COBS-encode `len` bytes into `out` (no delimiter). Returns encoded length.
+ */
+static size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t code_pos = 0;
+    size_t out_pos = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = out_pos++;
+            code = 1;
+            continue;
+        }
+        out[out_pos++] = in[i];
+        if (++code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = out_pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return out_pos;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t telemetry_init(void)
+{
+    if (tx_mutex == NULL) {
+        tx_mutex = xSemaphoreCreateMutex();
+        if (tx_mutex == NULL) {
+            ESP_LOGE(TAG, "Failed to create TX mutex");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    uint8_t boot[2] = { TELEM_PROTOCOL_VERSION, (uint8_t)esp_reset_reason() };
+    return telemetry_send(TELEM_REC_BOOT, boot, sizeof(boot));
+}
+
+esp_err_t telemetry_send(uint8_t type, const void *payload, size_t len)
+{
+    if (len > TELEM_MAX_PAYLOAD) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (tx_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t frame[FRAME_MAX];
+    uint32_t timestamp = esp_log_timestamp();
+
+    xSemaphoreTake(tx_mutex, portMAX_DELAY);
+
+    frame[0] = type;
+    frame[1] = tx_seq & 0xFF;
+    frame[2] = tx_seq >> 8;
+    frame[3] = timestamp & 0xFF;
+    frame[4] = (timestamp >> 8) & 0xFF;
+    frame[5] = (timestamp >> 16) & 0xFF;
+    frame[6] = timestamp >> 24;
+    memcpy(&frame[FRAME_HEADER_SIZE], payload, len);
+
+    size_t frame_len = FRAME_HEADER_SIZE + len;
+    uint16_t crc = crc16_ccitt(frame, frame_len);
+    frame[frame_len++] = crc & 0xFF;
+    frame[frame_len++] = crc >> 8;
+
+    tx_buf[0] = 0x00;
+    size_t wire_len = 1 + cobs_encode(frame, frame_len, &tx_buf[1]);
+    tx_buf[wire_len++] = 0x00;
+
+    fwrite(tx_buf, 1, wire_len, stdout);
+    fflush(stdout);
+    tx_seq++;
+
+    xSemaphoreGive(tx_mutex);
+    return ESP_OK;
+}
+
+void telemetry_send_light(uint32_t lux_x10, uint16_t zcl_value)
+{
+    uint8_t p[6] = {
+        lux_x10 & 0xFF, (lux_x10 >> 8) & 0xFF, (lux_x10 >> 16) & 0xFF, lux_x10 >> 24,
+        zcl_value & 0xFF, zcl_value >> 8,
+    };
+    telemetry_send(TELEM_REC_LIGHT, p, sizeof(p));
+}
+
+void telemetry_send_temperature(uint8_t sensor, int16_t centi_celsius)
+{
+    uint16_t raw = (uint16_t)centi_celsius;
+    uint8_t p[3] = { sensor, raw & 0xFF, raw >> 8 };
+    telemetry_send(TELEM_REC_TEMPERATURE, p, sizeof(p));
+}
+
+void telemetry_send_humidity(uint8_t sensor, uint16_t centi_percent)
+{
+    uint8_t p[3] = { sensor, centi_percent & 0xFF, centi_percent >> 8 };
+    telemetry_send(TELEM_REC_HUMIDITY, p, sizeof(p));
+}
+
+void telemetry_send_pressure(uint8_t sensor, uint32_t pascal)
+{
+    uint8_t p[5] = { sensor, pascal & 0xFF, (pascal >> 8) & 0xFF, (pascal >> 16) & 0xFF, pascal >> 24 };
+    telemetry_send(TELEM_REC_PRESSURE, p, sizeof(p));
+}
+
+void telemetry_send_zb_status(bool connected, uint8_t channel, uint16_t short_addr,
+                              const uint8_t ext_pan_id[8])
+{
+    uint8_t p[12] = { connected ? 1 : 0, channel, short_addr & 0xFF, short_addr >> 8 };
+    memcpy(&p[4], ext_pan_id, 8);
+    telemetry_send(TELEM_REC_ZB_STATUS, p, sizeof(p));
+}
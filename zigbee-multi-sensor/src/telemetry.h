@@ -0,0 +1,74 @@
+/*
+ * Binary Telemetry Stream
+ *
+ * Typed, sequence-numbered records sent over the console UART/USB-serial,
+ * interleaved with normal log text. Each record is COBS-encoded and wrapped
+ * in 0x00 delimiters, so it can never contain a byte that looks like the
+ * end of a frame, and log text (which never contains 0x00) stays readable.
+ *
+ * Wire format:  0x00 | COBS(frame) | 0x00
+ * Frame (little-endian, before COBS):
+ *   [0]      record type (TELEM_REC_*)
+ *   [1..2]   sequence number (increments per record, gaps = dropped frames)
+ *   [3..6]   timestamp, ms since boot
+ *   [7..n-3] payload
+ *   [n-2..]  CRC-16/CCITT-FALSE over bytes 0..n-3
+ *
+ * Decoder: telemetry_decode.py (used by monitor.py).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEM_PROTOCOL_VERSION      1
+#define TELEM_MAX_PAYLOAD           64
+
+// Record types
+#define TELEM_REC_BOOT              0x01    // u8 protocol version, u8 reset reason
+#define TELEM_REC_LOG               0x02    // Tokenised log entry, see tlog.h
+#define TELEM_REC_LOG_DROPPED       0x03    // u32 total tokenised log entries dropped
+#define TELEM_REC_LIGHT             0x10    // u32 lux x10, u16 ZCL MeasuredValue
+#define TELEM_REC_TEMPERATURE       0x11    // u8 sensor, s16 0.01 °C
+#define TELEM_REC_HUMIDITY          0x12    // u8 sensor, u16 0.01 %RH
+#define TELEM_REC_PRESSURE          0x13    // u8 sensor, u32 Pa
+#define TELEM_REC_ZB_STATUS         0x20    // u8 connected, u8 channel, u16 short addr, u8[8] ext PAN ID
+#define TELEM_REC_SYSTEM            0x30    // u8 CPU %, u32 heap free, u32 heap min, u32 largest block, u8 frag %
+#define TELEM_REC_BENCH             0x31    // u8 index, u8 count, u32 calls, u32 min/median/max cycles,
+                                            // u16 ticks per us, char[16] name (zero-padded), see bench.h
+
+// Sensor identifiers used in TEMPERATURE / HUMIDITY / PRESSURE records
+#define TELEM_SENSOR_BH1750         1
+#define TELEM_SENSOR_DS18B20        2       // Outdoor
+#define TELEM_SENSOR_DHT11          3       // Indoor
+#define TELEM_SENSOR_SHT4X          4
+#define TELEM_SENSOR_BME280         5
+
+/**
+ * Create the TX lock and emit a BOOT record. Call once, early in app_main().
+ */
+esp_err_t telemetry_init(void);
+
+/**
+ * Send one record. Safe from any task; frames are written atomically with
+ * respect to log output.
+ */
+esp_err_t telemetry_send(uint8_t type, const void *payload, size_t len);
+
+void telemetry_send_light(uint32_t lux_x10, uint16_t zcl_value);
+void telemetry_send_temperature(uint8_t sensor, int16_t centi_celsius);
+void telemetry_send_humidity(uint8_t sensor, uint16_t centi_percent);
+void telemetry_send_pressure(uint8_t sensor, uint32_t pascal);
+void telemetry_send_zb_status(bool connected, uint8_t channel, uint16_t short_addr,
+                              const uint8_t ext_pan_id[8]);
+
+#ifdef __cplusplus
+}
+#endif
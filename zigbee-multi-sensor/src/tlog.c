@@ -0,0 +1,182 @@
+/*
+ * Tokenised Deferred Logging
+ *
+ * The ring is a bounded multi-producer / single-consumer queue: producers
+ * claim a slot index with a CAS on `head`, fill the slot and publish it by
+ * storing index + 1 in the slot's sequence word; the drain task consumes in
+ * order and only advances `tail` past published slots. No locks, no
+ * allocation, and a full ring drops the new entry instead of blocking.
+ *
+ * The drain task sleeps on its task notification until an entry is
+ * published at `tail`, i.e. into an empty ring, so an idle log costs no
+ * wake-ups. Producer (store seq, load tail) and consumer (store tail, load
+ * seq) use sequentially consistent order, so at least one of them sees
+ * the other's store: either the producer notifies or the drain finds the
+ * entry before it blocks.
+ */
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "telemetry.h"
+#include "tlog.h"
+
+#define TLOG_TASK_STACK         2560
+#define TLOG_TASK_PRIORITY      1
+
+static const char *TAG = "TLOG";
+
+typedef struct {
+    atomic_uint seq;                // index + 1 once published
+    uint32_t fmt;
+    uint32_t tag;
+    uint32_t timestamp;
+    uint8_t level;
+    uint8_t nargs;
+    uint32_t args[TLOG_MAX_ARGS];
+} tlog_entry_t;
+
+static tlog_entry_t ring[TLOG_RING_SIZE];
+static atomic_uint head = 0;        // Next index to claim
+static atomic_uint tail = 0;        // Next index to drain
+static atomic_uint dropped = 0;
+
+static TaskHandle_t drain_task = NULL;
+
+_Static_assert((TLOG_RING_SIZE & (TLOG_RING_SIZE - 1)) == 0, "TLOG_RING_SIZE must be a power of two");
+
+// ========================================
+// Producer
+// ========================================
+
+void tlog_write(esp_log_level_t level, const char *tag, const char *fmt, int nargs, ...)
+{
+    unsigned int idx = atomic_load_explicit(&head, memory_order_relaxed);
+
+    do {
+        if (idx - atomic_load_explicit(&tail, memory_order_acquire) >= TLOG_RING_SIZE) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&head, &idx, idx + 1,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+
+    tlog_entry_t *e = &ring[idx & (TLOG_RING_SIZE - 1)];
+    e->fmt = (uint32_t)(uintptr_t)fmt;
+    e->tag = (uint32_t)(uintptr_t)tag;
+    e->timestamp = esp_log_timestamp();
+    e->level = (uint8_t)level;
+    e->nargs = nargs > TLOG_MAX_ARGS ? TLOG_MAX_ARGS : (uint8_t)nargs;
+
+    va_list ap;
+    va_start(ap, nargs);
+    for (int i = 0; i < e->nargs; i++) {
+        e->args[i] = va_arg(ap, uint32_t);
+    }
+    va_end(ap);
+
+    atomic_store_explicit(&e->seq, idx + 1, memory_order_seq_cst);
+
+    // First entry after the ring ran empty: wake the drain task
+    if (drain_task != NULL && atomic_load_explicit(&tail, memory_order_seq_cst) == idx) {
+        if (xPortInIsrContext()) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(drain_task, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            xTaskNotifyGive(drain_task);
+        }
+    }
+}
+
+// ========================================
+// Drain Task
+// ========================================
+
+static void put_u32(uint8_t *p, uint32_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = value >> 24;
+}
+
+static void tlog_task(void *pvParameters)
+{
+    uint8_t payload[14 + TLOG_MAX_ARGS * 4];
+    uint32_t reported_dropped = 0;
+
+    while (1) {
+        unsigned int idx = atomic_load_explicit(&tail, memory_order_relaxed);
+        tlog_entry_t *e = &ring[idx & (TLOG_RING_SIZE - 1)];
+
+        while (atomic_load_explicit(&e->seq, memory_order_seq_cst) == idx + 1) {
+            // Payload: fmt u32, tag u32, timestamp u32, level u8, nargs u8, args u32[nargs]
+            put_u32(&payload[0], e->fmt);
+            put_u32(&payload[4], e->tag);
+            put_u32(&payload[8], e->timestamp);
+            payload[12] = e->level;
+            payload[13] = e->nargs;
+            for (int i = 0; i < e->nargs; i++) {
+                put_u32(&payload[14 + i * 4], e->args[i]);
+            }
+            size_t len = 14 + e->nargs * 4;
+
+            // Release the slot before the (slow) UART write
+            atomic_store_explicit(&tail, idx + 1, memory_order_seq_cst);
+            telemetry_send(TELEM_REC_LOG, payload, len);
+
+            idx++;
+            e = &ring[idx & (TLOG_RING_SIZE - 1)];
+        }
+
+        uint32_t now_dropped = atomic_load_explicit(&dropped, memory_order_relaxed);
+        if (now_dropped != reported_dropped) {
+            uint8_t count[4];
+            put_u32(count, now_dropped);
+            telemetry_send(TELEM_REC_LOG_DROPPED, count, sizeof(count));
+            reported_dropped = now_dropped;
+        }
+
+        // Until a producer publishes into the empty ring
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t tlog_init(void)
+{
+    if (xTaskCreate(tlog_task, "tlog", TLOG_TASK_STACK, NULL, TLOG_TASK_PRIORITY, &drain_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create drain task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+uint32_t tlog_get_dropped(void)
+{
+    return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
+
+IRAM_ATTR size_t tlog_last_tokens(uint32_t *tokens, size_t max)
+{
+    unsigned int end = atomic_load_explicit(&head, memory_order_acquire);
+    unsigned int span = max < TLOG_RING_SIZE ? max : TLOG_RING_SIZE;
+    unsigned int idx = end > span ? end - span : 0;
+    size_t count = 0;
+
+    // A slot still being filled carries an older sequence number: skip it
+    for (; idx != end && count < max; idx++) {
+        const tlog_entry_t *e = &ring[idx & (TLOG_RING_SIZE - 1)];
+        if (atomic_load_explicit(&e->seq, memory_order_acquire) == idx + 1) {
+            tokens[count++] = e->fmt;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,127 @@
+/*
+ * Tokenised Deferred Logging
+ *
+ * TLOGI/TLOGW/TLOGE take printf-style arguments like ESP_LOGx, but never
+ * format on the device. The call site records:
+ *   - a token: the address of its format string, placed in .rodata.tlog
+ *   - the tag pointer
+ *   - up to TLOG_MAX_ARGS arguments, each widened to 32 bits
+ *     (floats/doubles as float32 bit patterns, pointers as addresses)
+ * into a lock-free ring. A priority-1 task drains the ring and sends each
+ * entry as a TELEM_REC_LOG telemetry record. detokenize.py resolves tokens,
+ * tags and %s arguments against the firmware ELF and does the formatting.
+ *
+ * Limits: 64-bit integers are truncated, and %s arguments must point at
+ * constant strings in flash (literals, esp_err_to_name()), not RAM buffers.
+ *
+ * The level filter is LOG_LOCAL_LEVEL only, at compile time: a TLOGx above
+ * it compiles out. esp_log_level_set() does not apply, since the per-tag
+ * lookup behind it takes a lock and could not run from an ISR.
+ *
+ * Build with -DTLOG_TOKENIZED=0 to turn every TLOGx back into ESP_LOGx.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TLOG_TOKENIZED
+#define TLOG_TOKENIZED          1
+#endif
+
+#define TLOG_MAX_ARGS           8
+#define TLOG_RING_SIZE          64      // Entries (power of two)
+
+/**
+ * Start the drain task. Entries logged before this are kept (up to
+ * TLOG_RING_SIZE) and sent once it runs.
+ */
+esp_err_t tlog_init(void);
+
+/**
+ * Entries lost because the ring was full.
+ */
+uint32_t tlog_get_dropped(void);
+
+/**
+ * Format tokens of the last (up to) `max` entries, oldest first, drained or
+ * not. Lock-free and in IRAM, so the panic hook can call it (crash_dump.h).
+ */
+size_t tlog_last_tokens(uint32_t *tokens, size_t max);
+
+// Used by the macros below
+void tlog_write(esp_log_level_t level, const char *tag, const char *fmt, int nargs, ...);
+
+static inline uint32_t tlog_arg_u(uint32_t value)
+{
+    return value;
+}
+
+static inline uint32_t tlog_arg_f(double value)
+{
+    union { float f; uint32_t u; } bits = { .f = (float)value };
+    return bits.u;
+}
+
+static inline uint32_t tlog_arg_p(const void *ptr)
+{
+    return (uint32_t)(uintptr_t)ptr;
+}
+
+#define TLOG_ARG(x) _Generic((x),       \
+    float: tlog_arg_f,                  \
+    double: tlog_arg_f,                 \
+    char *: tlog_arg_p,                 \
+    const char *: tlog_arg_p,           \
+    void *: tlog_arg_p,                 \
+    const void *: tlog_arg_p,           \
+    default: tlog_arg_u)(x)
+
+// Argument counting / mapping (0 to TLOG_MAX_ARGS arguments)
+#define TLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define TLOG_NARGS(...) TLOG_NARGS_(_0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define TLOG_MAP_0()
+#define TLOG_MAP_1(a)                   , TLOG_ARG(a)
+#define TLOG_MAP_2(a, b)                , TLOG_ARG(a), TLOG_ARG(b)
+#define TLOG_MAP_3(a, b, c)             TLOG_MAP_2(a, b), TLOG_ARG(c)
+#define TLOG_MAP_4(a, b, c, d)          TLOG_MAP_3(a, b, c), TLOG_ARG(d)
+#define TLOG_MAP_5(a, b, c, d, e)       TLOG_MAP_4(a, b, c, d), TLOG_ARG(e)
+#define TLOG_MAP_6(a, b, c, d, e, f)    TLOG_MAP_5(a, b, c, d, e), TLOG_ARG(f)
+#define TLOG_MAP_7(a, b, c, d, e, f, g) TLOG_MAP_6(a, b, c, d, e, f), TLOG_ARG(g)
+#define TLOG_MAP_8(a, b, c, d, e, f, g, h) TLOG_MAP_7(a, b, c, d, e, f, g), TLOG_ARG(h)
+#define TLOG_MAP__(n, ...) TLOG_MAP_##n(__VA_ARGS__)
+#define TLOG_MAP_(n, ...) TLOG_MAP__(n, ##__VA_ARGS__)
+
+#if TLOG_TOKENIZED
+
+#define TLOG_LEVEL(level, tag, fmt, ...) do {                                           \
+        static const char tlog_fmt_[] __attribute__((section(".rodata.tlog"))) = fmt;   \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                               \
+            tlog_write((level), (tag), tlog_fmt_, TLOG_NARGS(__VA_ARGS__)              \
+                       TLOG_MAP_(TLOG_NARGS(__VA_ARGS__), ##__VA_ARGS__));              \
+        }                                                                               \
+    } while (0)
+
+#define TLOGE(tag, fmt, ...) TLOG_LEVEL(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define TLOGW(tag, fmt, ...) TLOG_LEVEL(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define TLOGI(tag, fmt, ...) TLOG_LEVEL(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+
+#else
+
+#define TLOGE(tag, fmt, ...) ESP_LOGE(tag, fmt, ##__VA_ARGS__)
+#define TLOGW(tag, fmt, ...) ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#define TLOGI(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,292 @@
+/*
+ * Zigbee Commissioning Channel Policy
+ *
+ * See zb_commissioning.h for the stage order. All functions except the
+ * getters run in the Zigbee task context (signal handler / scheduler
+ * alarms); the getters serve the console, so the stage and the counters
+ * they read are updated under stats_lock.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "esp_zigbee_core.h"
+#include "zb_commissioning.h"
+
+// NVS storage for the last-known channel (separate from the stack's zb_storage)
+#define ZB_COMMISSIONING_NVS_NAMESPACE          "zb_comm"
+#define ZB_COMMISSIONING_NVS_KEY_CHANNEL        "last_chan"
+
+#define CHANNEL_VALID(ch)   ((ch) >= ZB_COMMISSIONING_FIRST_CHANNEL && (ch) <= ZB_COMMISSIONING_LAST_CHANNEL)
+
+static const char *TAG = "ZB_COMMISSION";
+
+static const char *stage_names[ZB_COMMISSIONING_STAGE_COUNT] = {
+    "last-known",
+    "preferred",
+    "all-channels",
+};
+
+static uint32_t preferred_channel_mask = 0;
+static uint32_t fallback_channel_mask = ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK;
+static uint8_t last_known_channel = 0;      // 0 = none stored
+
+static zb_commissioning_stage_t current_stage = ZB_COMMISSIONING_STAGE_PREFERRED;
+static uint8_t stage_attempts = 0;
+static int64_t steering_start_us = 0;
+static uint32_t last_join_ms = 0;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static zb_channel_stats_t channel_stats[ZB_COMMISSIONING_NUM_CHANNELS];
+
+// ========================================
+// NVS Persistence
+// ========================================
+
+static uint8_t load_last_known_channel(void)
+{
+    nvs_handle_t handle;
+    uint8_t channel = 0;
+
+    if (nvs_open(ZB_COMMISSIONING_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return 0;  // Namespace not created yet (first boot)
+    }
+    if (nvs_get_u8(handle, ZB_COMMISSIONING_NVS_KEY_CHANNEL, &channel) != ESP_OK) {
+        channel = 0;
+    }
+    nvs_close(handle);
+
+    return CHANNEL_VALID(channel) ? channel : 0;
+}
+
+static esp_err_t store_last_known_channel(uint8_t channel)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(ZB_COMMISSIONING_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = nvs_set_u8(handle, ZB_COMMISSIONING_NVS_KEY_CHANNEL, channel);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return ret;
+}
+
+// ========================================
+// Stage Selection
+// ========================================
+
+static uint32_t stage_mask(zb_commissioning_stage_t stage)
+{
+    switch (stage) {
+    case ZB_COMMISSIONING_STAGE_LAST_KNOWN:
+        return last_known_channel ? (1UL << last_known_channel) : 0;
+
+    case ZB_COMMISSIONING_STAGE_PREFERRED:
+        // Skip if it would just repeat the last-known stage
+        if (preferred_channel_mask == stage_mask(ZB_COMMISSIONING_STAGE_LAST_KNOWN)) {
+            return 0;
+        }
+        return preferred_channel_mask;
+
+    case ZB_COMMISSIONING_STAGE_ALL:
+    default:
+        return fallback_channel_mask;
+    }
+}
+
+/**
+ * Advance to the next stage with a usable mask, wrapping back to the
+ * narrowest stage after the full sweep so retries stay cheap.
+ */
+static void advance_stage_from(zb_commissioning_stage_t stage)
+{
+    for (int i = 0; i < ZB_COMMISSIONING_STAGE_COUNT; i++) {
+        stage = (stage + 1) % ZB_COMMISSIONING_STAGE_COUNT;
+        if (stage_mask(stage) != 0) {
+            break;
+        }
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    current_stage = stage;
+    taskEXIT_CRITICAL(&stats_lock);
+    stage_attempts = 0;
+}
+
+static void advance_stage(void)
+{
+    advance_stage_from(current_stage);
+}
+
+static void reset_to_first_stage(void)
+{
+    advance_stage_from(ZB_COMMISSIONING_STAGE_COUNT - 1);
+}
+
+static int mask_channel_count(uint32_t mask)
+{
+    return __builtin_popcount(mask & ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK);
+}
+
+static void apply_stage_mask(void)
+{
+    uint32_t mask = stage_mask(current_stage);
+
+    esp_zb_set_primary_network_channel_set(mask);
+
+    // Without this BDB falls through to its default secondary set (all channels)
+    // inside the same attempt, which defeats the narrow stages. Escalation is
+    // handled here instead.
+    if (esp_zb_set_secondary_network_channel_set(0) != ESP_OK) {
+        esp_zb_set_secondary_network_channel_set(mask);
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+esp_err_t zb_commissioning_init(uint32_t preferred_mask, uint32_t fallback_mask)
+{
+    preferred_channel_mask = preferred_mask & ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK;
+    fallback_channel_mask = fallback_mask & ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK;
+    if (fallback_channel_mask == 0) {
+        fallback_channel_mask = ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK;
+    }
+
+    memset(channel_stats, 0, sizeof(channel_stats));
+    last_known_channel = load_last_known_channel();
+    reset_to_first_stage();
+
+    if (last_known_channel) {
+        ESP_LOGI(TAG, "Last-known channel: %u (single-channel scan first)", last_known_channel);
+    } else {
+        ESP_LOGI(TAG, "No stored channel, starting with %s stage (mask 0x%08lx)",
+                 stage_names[current_stage], (unsigned long)stage_mask(current_stage));
+    }
+
+    apply_stage_mask();
+    return ESP_OK;
+}
+
+void zb_commissioning_start_steering(uint8_t param)
+{
+    (void)param;
+    uint32_t mask = stage_mask(current_stage);
+
+    // BDB reads the channel sets when steering starts, so re-apply per attempt
+    apply_stage_mask();
+
+    ESP_LOGI(TAG, "Steering: stage=%s attempt=%u/%u mask=0x%08lx (%d ch)",
+             stage_names[current_stage], stage_attempts + 1,
+             ZB_COMMISSIONING_ATTEMPTS_PER_STAGE,
+             (unsigned long)mask, mask_channel_count(mask));
+
+    steering_start_us = esp_timer_get_time();
+    esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
+}
+
+void zb_commissioning_steering_done(bool success)
+{
+    uint32_t mask = stage_mask(current_stage);
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - steering_start_us) / 1000);
+    int channel_count = mask_channel_count(mask);
+
+    uint8_t channel = success ? esp_zb_get_current_channel() : 0;
+
+    // Attribute the dwell time evenly to the channels that were scanned
+    taskENTER_CRITICAL(&stats_lock);
+    for (int ch = ZB_COMMISSIONING_FIRST_CHANNEL; ch <= ZB_COMMISSIONING_LAST_CHANNEL; ch++) {
+        if (mask & (1UL << ch)) {
+            zb_channel_stats_t *stats = &channel_stats[ch - ZB_COMMISSIONING_FIRST_CHANNEL];
+            stats->attempts++;
+            stats->scan_ms += channel_count ? elapsed_ms / channel_count : 0;
+        }
+    }
+    if (success) {
+        last_join_ms = elapsed_ms;
+        if (CHANNEL_VALID(channel)) {
+            channel_stats[channel - ZB_COMMISSIONING_FIRST_CHANNEL].successes++;
+        }
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+
+    if (success) {
+        if (CHANNEL_VALID(channel)) {
+
+            if (channel != last_known_channel) {
+                esp_err_t ret = store_last_known_channel(channel);
+                if (ret == ESP_OK) {
+                    ESP_LOGI(TAG, "Stored channel %u as last-known", channel);
+                } else {
+                    ESP_LOGW(TAG, "Failed to store last-known channel (%s)", esp_err_to_name(ret));
+                }
+                taskENTER_CRITICAL(&stats_lock);
+                last_known_channel = channel;
+                taskEXIT_CRITICAL(&stats_lock);
+            }
+        }
+
+        ESP_LOGI(TAG, "Joined on channel %u in %lu ms (stage=%s)",
+                 channel, (unsigned long)elapsed_ms, stage_names[current_stage]);
+
+        // Next (re)join starts from the single stored channel
+        reset_to_first_stage();
+        return;
+    }
+
+    stage_attempts++;
+    ESP_LOGW(TAG, "Steering failed after %lu ms (stage=%s attempt=%u)",
+             (unsigned long)elapsed_ms, stage_names[current_stage], stage_attempts);
+
+    if (stage_attempts >= ZB_COMMISSIONING_ATTEMPTS_PER_STAGE) {
+        advance_stage();
+        ESP_LOGI(TAG, "Escalating to %s stage (mask 0x%08lx)",
+                 stage_names[current_stage], (unsigned long)stage_mask(current_stage));
+    }
+}
+
+zb_commissioning_stage_t zb_commissioning_get_stage(uint32_t *mask)
+{
+    // Mask from the same snapshot as the stage (last_known_channel changes on a join)
+    taskENTER_CRITICAL(&stats_lock);
+    zb_commissioning_stage_t stage = current_stage;
+    if (mask != NULL) {
+        *mask = stage_mask(stage);
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+
+    return stage;
+}
+
+const char *zb_commissioning_stage_name(zb_commissioning_stage_t stage)
+{
+    return stage < ZB_COMMISSIONING_STAGE_COUNT ? stage_names[stage] : "unknown";
+}
+
+bool zb_commissioning_get_channel_stats(uint8_t channel, zb_channel_stats_t *stats)
+{
+    if (!CHANNEL_VALID(channel)) {
+        return false;
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    *stats = channel_stats[channel - ZB_COMMISSIONING_FIRST_CHANNEL];
+    taskEXIT_CRITICAL(&stats_lock);
+    return true;
+}
+
+uint32_t zb_commissioning_get_last_join_ms(void)
+{
+    taskENTER_CRITICAL(&stats_lock);
+    uint32_t ms = last_join_ms;
+    taskEXIT_CRITICAL(&stats_lock);
+    return ms;
+}
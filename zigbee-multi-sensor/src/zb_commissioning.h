@@ -0,0 +1,85 @@
+/*
+ * Zigbee Commissioning Channel Policy
+ *
+ * Narrows the BDB network steering scan instead of sweeping all 16 channels
+ * on every join:
+ *   1. Last-known channel (persisted in NVS after a successful join)
+ *   2. Preferred channel set (board configuration, e.g. CONFIG_ZB_CHANNEL)
+ *   3. All channels (11-26)
+ *
+ * Each stage gets a fixed number of steering attempts before escalating.
+ * Per-channel scan time and join success counters are kept for diagnostics
+ * (console command `join`, app_console.h).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ZB_COMMISSIONING_FIRST_CHANNEL  11
+#define ZB_COMMISSIONING_LAST_CHANNEL   26
+#define ZB_COMMISSIONING_NUM_CHANNELS   (ZB_COMMISSIONING_LAST_CHANNEL - ZB_COMMISSIONING_FIRST_CHANNEL + 1)
+
+// Steering attempts per stage before escalating to the next (wider) stage
+#define ZB_COMMISSIONING_ATTEMPTS_PER_STAGE     2
+
+typedef enum {
+    ZB_COMMISSIONING_STAGE_LAST_KNOWN = 0,  // Single channel from NVS
+    ZB_COMMISSIONING_STAGE_PREFERRED,       // Configured preferred set
+    ZB_COMMISSIONING_STAGE_ALL,             // Full 11-26 sweep
+    ZB_COMMISSIONING_STAGE_COUNT,
+} zb_commissioning_stage_t;
+
+typedef struct {
+    uint16_t attempts;      // Steering attempts that included this channel
+    uint16_t successes;     // Joins that landed on this channel
+    uint32_t scan_ms;       // Accumulated scan time attributed to this channel
+} zb_channel_stats_t;
+
+/**
+ * Load the last-known channel from NVS and apply the initial channel mask.
+ * Must be called after esp_zb_init() and before esp_zb_start().
+ *
+ * @param preferred_mask  Preferred channel set (bit N = channel N)
+ * @param fallback_mask   Channel set used once the narrow stages are exhausted
+ */
+esp_err_t zb_commissioning_init(uint32_t preferred_mask, uint32_t fallback_mask);
+
+/**
+ * Apply the current stage's channel mask and start BDB network steering.
+ * Signature matches esp_zb_callback_t so it can be used with esp_zb_scheduler_alarm().
+ */
+void zb_commissioning_start_steering(uint8_t param);
+
+/**
+ * Record the outcome of a steering attempt (call from ESP_ZB_BDB_SIGNAL_STEERING).
+ * On success the joined channel is persisted; on failure the policy escalates.
+ */
+void zb_commissioning_steering_done(bool success);
+
+/**
+ * Current policy stage, and the channel mask it scans in `mask` (may be NULL).
+ */
+zb_commissioning_stage_t zb_commissioning_get_stage(uint32_t *mask);
+
+const char *zb_commissioning_stage_name(zb_commissioning_stage_t stage);
+
+/**
+ * Copy one channel's counters; false if channel is outside 11-26.
+ */
+bool zb_commissioning_get_channel_stats(uint8_t channel, zb_channel_stats_t *stats);
+
+/**
+ * Duration of the most recent successful join in milliseconds (0 if none yet).
+ */
+uint32_t zb_commissioning_get_last_join_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Zigbee Diagnostics Endpoint
+ *
+ * See zb_diagnostics.h for the attribute map.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "zb_diagnostics.h"
+#include "zb_ota.h"
+
+// Shared with main.c Basic clusters
+#define DIAG_MANUFACTURER_NAME          "\x0f""UnmannedSystems"
+#define DIAG_MODEL_IDENTIFIER           "\x14""ESP32-C6-MultiSensor"
+#define DIAG_LOCATION                   "\x0b""Diagnostics"
+
+static const char *TAG = "ZB_DIAG";
+
+// Initial attribute values (copied into the ZCL attribute table at creation)
+static uint16_t diag_number_of_resets = 0;
+static uint16_t diag_neighbor_added = 0;
+static uint16_t diag_neighbor_removed = 0;
+static uint16_t diag_neighbor_stale = 0;
+static uint8_t diag_last_lqi = 0;
+static int8_t diag_last_rssi = 0;
+static uint8_t diag_child_count = 0;
+static uint8_t diag_route_count = 0;
+
+// Octet-string attributes get their storage sized from the initial value, so
+// create them at full length. A zero version byte marks "no data yet".
+static uint8_t diag_octet_init[ZB_DIAG_OCTET_STRING_MAX + 1] = { ZB_DIAG_OCTET_STRING_MAX };
+
+// Scratch buffer for length-prefixed updates
+static uint8_t diag_octet_buf[ZB_DIAG_OCTET_STRING_MAX + 1];
+
+esp_err_t zb_diagnostics_create_endpoint(esp_zb_ep_list_t *ep_list)
+{
+    esp_zb_cluster_list_t *cluster_list = esp_zb_zcl_cluster_list_create();
+
+    // Basic cluster
+    esp_zb_attribute_list_t *basic_cluster = esp_zb_basic_cluster_create(NULL);
+    esp_zb_basic_cluster_add_attr(basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID,
+                                  DIAG_MANUFACTURER_NAME);
+    esp_zb_basic_cluster_add_attr(basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID,
+                                  DIAG_MODEL_IDENTIFIER);
+    esp_zb_basic_cluster_add_attr(basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_LOCATION_DESCRIPTION_ID,
+                                  DIAG_LOCATION);
+    esp_zb_cluster_list_add_basic_cluster(cluster_list, basic_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+
+    // Diagnostics cluster
+    esp_zb_attribute_list_t *diag_cluster = esp_zb_zcl_attr_list_create(ZB_ZCL_CLUSTER_ID_DIAGNOSTICS_SRV);
+
+    const uint8_t ro = ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY;
+    const uint8_t ro_manuf = ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_MANUF_SPEC;
+
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_NUMBER_OF_RESETS,
+                                          ESP_ZB_ZCL_ATTR_TYPE_U16, ro, &diag_number_of_resets);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_NEIGHBOR_ADDED,
+                                          ESP_ZB_ZCL_ATTR_TYPE_U16, ro, &diag_neighbor_added);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_NEIGHBOR_REMOVED,
+                                          ESP_ZB_ZCL_ATTR_TYPE_U16, ro, &diag_neighbor_removed);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_NEIGHBOR_STALE,
+                                          ESP_ZB_ZCL_ATTR_TYPE_U16, ro, &diag_neighbor_stale);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_LAST_MESSAGE_LQI,
+                                          ESP_ZB_ZCL_ATTR_TYPE_U8, ro, &diag_last_lqi);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_LAST_MESSAGE_RSSI,
+                                          ESP_ZB_ZCL_ATTR_TYPE_S8, ro, &diag_last_rssi);
+
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_NEIGHBOR_TABLE,
+                                          ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ro_manuf, diag_octet_init);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_CHILD_COUNT,
+                                          ESP_ZB_ZCL_ATTR_TYPE_U8, ro_manuf, &diag_child_count);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_ROUTE_COUNT,
+                                          ESP_ZB_ZCL_ATTR_TYPE_U8, ro_manuf, &diag_route_count);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_REPORT_STATS,
+                                          ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ro_manuf, diag_octet_init);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_SYSTEM_STATS,
+                                          ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ro_manuf, diag_octet_init);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_RESET_STATS,
+                                          ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ro_manuf, diag_octet_init);
+    esp_zb_custom_cluster_add_custom_attr(diag_cluster, ZB_DIAG_ATTR_CRASH_RECORD,
+                                          ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ro_manuf, diag_octet_init);
+
+    esp_zb_cluster_list_add_custom_cluster(cluster_list, diag_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+
+    // OTA Upgrade cluster (client role)
+    zb_ota_add_client_cluster(cluster_list);
+
+    esp_err_t ret = esp_zb_ep_list_add_ep(ep_list, cluster_list,
+                                          EP_DIAGNOSTICS,
+                                          ESP_ZB_AF_HA_PROFILE_ID,
+                                          ESP_ZB_HA_CUSTOM_ATTR_DEVICE_ID);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add diagnostics endpoint (%s)", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+void zb_diagnostics_set_attr(uint16_t attr_id, void *value)
+{
+    esp_zb_zcl_set_attribute_val(EP_DIAGNOSTICS,
+                                 ZB_ZCL_CLUSTER_ID_DIAGNOSTICS_SRV,
+                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 attr_id, value, false);
+}
+
+void zb_diagnostics_set_octet_string(uint16_t attr_id, const uint8_t *data, uint8_t len)
+{
+    if (len > ZB_DIAG_OCTET_STRING_MAX) {
+        len = ZB_DIAG_OCTET_STRING_MAX;
+    }
+    diag_octet_buf[0] = len;
+    memcpy(&diag_octet_buf[1], data, len);
+    zb_diagnostics_set_attr(attr_id, diag_octet_buf);
+}
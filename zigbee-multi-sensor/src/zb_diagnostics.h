@@ -0,0 +1,68 @@
+/*
+ * Zigbee Diagnostics Endpoint
+ *
+ * EP 15 hosts the ZCL Diagnostics cluster (0x0B05, server role). Standard
+ * attributes are filled from firmware-side counters; device-specific data
+ * (neighbour table, etc.) is exposed as manufacturer-specific attributes in
+ * the 0xF000 range of the same cluster. The OTA Upgrade client (zb_ota.h)
+ * lives on the same endpoint.
+ *
+ * Attribute values live in the ZCL attribute table, so updates must be made
+ * from the Zigbee task context (scheduler alarms, signal/action handlers).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EP_DIAGNOSTICS                          15
+
+// ZCL Diagnostics cluster (not enumerated by esp-zigbee-lib 1.0.9)
+#define ZB_ZCL_CLUSTER_ID_DIAGNOSTICS_SRV       0x0B05
+
+// Standard Diagnostics attributes (ZCL 3.15)
+#define ZB_DIAG_ATTR_NUMBER_OF_RESETS           0x0000  // uint16, see supervisor.h
+#define ZB_DIAG_ATTR_NEIGHBOR_ADDED             0x010D  // uint16
+#define ZB_DIAG_ATTR_NEIGHBOR_REMOVED           0x010E  // uint16
+#define ZB_DIAG_ATTR_NEIGHBOR_STALE             0x010F  // uint16
+#define ZB_DIAG_ATTR_LAST_MESSAGE_LQI           0x011C  // uint8
+#define ZB_DIAG_ATTR_LAST_MESSAGE_RSSI          0x011D  // int8
+
+// Manufacturer-specific attributes
+#define ZB_DIAG_ATTR_NEIGHBOR_TABLE             0xF000  // octet string, see zb_nwk_monitor.h
+#define ZB_DIAG_ATTR_CHILD_COUNT                0xF001  // uint8
+#define ZB_DIAG_ATTR_ROUTE_COUNT                0xF002  // uint8 (active routes)
+#define ZB_DIAG_ATTR_REPORT_STATS               0xF010  // octet string, see report_tracker.h
+#define ZB_DIAG_ATTR_SYSTEM_STATS               0xF011  // octet string, see sys_profiler.h
+#define ZB_DIAG_ATTR_RESET_STATS                0xF012  // octet string, see supervisor.h
+#define ZB_DIAG_ATTR_CRASH_RECORD               0xF013  // octet string, see crash_dump.h
+
+// Largest octet-string attribute payload (ZCL length prefix excluded)
+#define ZB_DIAG_OCTET_STRING_MAX                254
+
+/**
+ * Create EP 15 (Basic + Diagnostics + OTA Upgrade client) and add it to the endpoint list.
+ * Call from esp_zb_create_device_clusters() before esp_zb_device_register().
+ */
+esp_err_t zb_diagnostics_create_endpoint(esp_zb_ep_list_t *ep_list);
+
+/**
+ * Update a scalar Diagnostics attribute (Zigbee task context only).
+ */
+void zb_diagnostics_set_attr(uint16_t attr_id, void *value);
+
+/**
+ * Update an octet-string attribute from a raw buffer (len <= ZB_DIAG_OCTET_STRING_MAX).
+ * The ZCL length prefix is added here.
+ */
+void zb_diagnostics_set_octet_string(uint16_t attr_id, const uint8_t *data, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
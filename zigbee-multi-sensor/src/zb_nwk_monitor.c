@@ -0,0 +1,292 @@
+/*
+ * Zigbee Router Network Monitor
+ *
+ * Collection runs entirely in the Zigbee task: a scheduler alarm kicks off
+ * an asynchronous neighbour-table walk (zb_nwk_nbr_iterator_next), which
+ * chains into a paged local Mgmt_Rtg_req, and the result is published when
+ * the last page arrives. One ZBOSS buffer is reused for the whole walk.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_zigbee_core.h"
+#include "zboss_api.h"
+#include "zb_diagnostics.h"
+#include "zb_nwk_monitor.h"
+
+#define ROUTE_STATUS_MASK       0x07
+#define ROUTE_STATUS_ACTIVE     0x00
+
+static const char *TAG = "ZB_NWK_MON";
+
+static bool monitor_running = false;
+static bool walk_in_progress = false;
+
+static zb_nwk_snapshot_t work;          // Snapshot being collected
+static zb_nwk_snapshot_t snapshot;      // Last published snapshot
+
+// Standard Diagnostics counters derived from snapshot deltas
+static uint16_t neighbor_added = 0;
+static uint16_t neighbor_removed = 0;
+static uint16_t neighbor_stale = 0;
+
+static void collect_start(uint8_t param);
+static void neighbor_walk_cb(zb_uint8_t bufid);
+static void route_request(zb_uint8_t bufid, uint8_t start_index);
+
+// ========================================
+// Publishing
+// ========================================
+
+static bool snapshot_contains(const zb_nwk_snapshot_t *snap, uint16_t short_addr)
+{
+    for (int i = 0; i < snap->neighbor_count; i++) {
+        if (snap->neighbors[i].short_addr == short_addr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void update_churn_counters(void)
+{
+    for (int i = 0; i < work.neighbor_count; i++) {
+        if (!snapshot_contains(&snapshot, work.neighbors[i].short_addr)) {
+            neighbor_added++;
+        }
+        // Router links that missed several link-status periods are on the way out
+        if (work.neighbors[i].device_type != ZB_NWK_DEVICE_TYPE_ED && work.neighbors[i].age > 3) {
+            neighbor_stale++;
+        }
+    }
+    for (int i = 0; i < snapshot.neighbor_count; i++) {
+        if (!snapshot_contains(&work, snapshot.neighbors[i].short_addr)) {
+            neighbor_removed++;
+        }
+    }
+}
+
+static uint8_t encode_neighbor_table(uint8_t *out)
+{
+    uint8_t *p = out;
+
+    *p++ = ZB_NWK_MONITOR_FORMAT_VERSION;
+    *p++ = work.neighbor_count;
+    *p++ = work.neighbor_total;
+    *p++ = work.child_count;
+    *p++ = work.route_active;
+    *p++ = work.route_total;
+
+    for (int i = 0; i < work.neighbor_count; i++) {
+        const zb_nwk_neighbor_t *n = &work.neighbors[i];
+        uint8_t age = n->age > 31 ? 31 : n->age;
+
+        *p++ = n->short_addr & 0xFF;
+        *p++ = n->short_addr >> 8;
+        *p++ = n->lqi;
+        *p++ = (uint8_t)n->rssi;
+        *p++ = (n->device_type & 0x03) | ((n->relationship & 0x07) << 2) | (n->rx_on_when_idle ? 0x20 : 0);
+        *p++ = (n->outgoing_cost & 0x07) | (age << 3);
+    }
+
+    return (uint8_t)(p - out);
+}
+
+static void publish_snapshot(void)
+{
+    static uint8_t table[ZB_NWK_MONITOR_HEADER_SIZE + ZB_NWK_MONITOR_MAX_NEIGHBORS * ZB_NWK_MONITOR_ENTRY_SIZE];
+    uint8_t len = encode_neighbor_table(table);
+
+    zb_diagnostics_set_octet_string(ZB_DIAG_ATTR_NEIGHBOR_TABLE, table, len);
+    zb_diagnostics_set_attr(ZB_DIAG_ATTR_CHILD_COUNT, &work.child_count);
+    zb_diagnostics_set_attr(ZB_DIAG_ATTR_ROUTE_COUNT, &work.route_active);
+    zb_diagnostics_set_attr(ZB_DIAG_ATTR_NEIGHBOR_ADDED, &neighbor_added);
+    zb_diagnostics_set_attr(ZB_DIAG_ATTR_NEIGHBOR_REMOVED, &neighbor_removed);
+    zb_diagnostics_set_attr(ZB_DIAG_ATTR_NEIGHBOR_STALE, &neighbor_stale);
+
+    // Link towards the coordinator, which is where all reports go
+    zb_uint8_t lqi = 0;
+    zb_int8_t rssi = 0;
+    zb_zdo_get_diag_data(0x0000, &lqi, &rssi);
+    zb_diagnostics_set_attr(ZB_DIAG_ATTR_LAST_MESSAGE_LQI, &lqi);
+    zb_diagnostics_set_attr(ZB_DIAG_ATTR_LAST_MESSAGE_RSSI, &rssi);
+}
+
+static void collect_finish(void)
+{
+    uint32_t lqi_sum = 0;
+
+    work.min_lqi = work.neighbor_count ? 0xFF : 0;
+    for (int i = 0; i < work.neighbor_count; i++) {
+        const zb_nwk_neighbor_t *n = &work.neighbors[i];
+        lqi_sum += n->lqi;
+        if (n->lqi < work.min_lqi) {
+            work.min_lqi = n->lqi;
+        }
+    }
+    work.avg_lqi = work.neighbor_count ? (uint8_t)(lqi_sum / work.neighbor_count) : 0;
+    work.timestamp_ms = esp_log_timestamp();
+
+    update_churn_counters();
+    publish_snapshot();
+    memcpy(&snapshot, &work, sizeof(snapshot));
+
+    ESP_LOGI(TAG, "Neighbours: %u (routers %u, children %u)  LQI min/avg: %u/%u  Routes: %u/%u active",
+             snapshot.neighbor_total, snapshot.router_count, snapshot.child_count,
+             snapshot.min_lqi, snapshot.avg_lqi, snapshot.route_active, snapshot.route_total);
+    for (int i = 0; i < snapshot.neighbor_count; i++) {
+        const zb_nwk_neighbor_t *n = &snapshot.neighbors[i];
+        ESP_LOGD(TAG, "  0x%04x type=%u rel=%u lqi=%u rssi=%d cost=%u age=%u",
+                 n->short_addr, n->device_type, n->relationship, n->lqi, n->rssi,
+                 n->outgoing_cost, n->age);
+    }
+
+    walk_in_progress = false;
+    if (monitor_running) {
+        esp_zb_scheduler_alarm(collect_start, 0, ZB_NWK_MONITOR_PERIOD_MS);
+    }
+}
+
+// ========================================
+// Routing Table (local Mgmt_Rtg_req, paged)
+// ========================================
+
+static void route_response_cb(zb_uint8_t bufid)
+{
+    zb_zdo_mgmt_rtg_resp_t *resp = (zb_zdo_mgmt_rtg_resp_t *)zb_buf_begin(bufid);
+
+    if (resp->status != ZB_ZDP_STATUS_SUCCESS) {
+        ESP_LOGD(TAG, "Mgmt_Rtg_rsp status 0x%02x", resp->status);
+        zb_buf_free(bufid);
+        collect_finish();
+        return;
+    }
+
+    zb_zdo_routing_table_record_t *records = (zb_zdo_routing_table_record_t *)(resp + 1);
+    for (int i = 0; i < resp->routing_table_list_count; i++) {
+        if ((records[i].flags & ROUTE_STATUS_MASK) == ROUTE_STATUS_ACTIVE) {
+            work.route_active++;
+        }
+    }
+    work.route_total = resp->routing_table_entries;
+
+    uint8_t next_index = resp->start_index + resp->routing_table_list_count;
+    if (resp->routing_table_list_count > 0 && next_index < resp->routing_table_entries) {
+        zb_buf_reuse(bufid);
+        route_request(bufid, next_index);
+        return;
+    }
+
+    zb_buf_free(bufid);
+    collect_finish();
+}
+
+static void route_request(zb_uint8_t bufid, uint8_t start_index)
+{
+    zb_zdo_mgmt_rtg_param_t *req = ZB_BUF_GET_PARAM(bufid, zb_zdo_mgmt_rtg_param_t);
+    req->start_index = start_index;
+    req->dst_addr = esp_zb_get_short_address();
+
+    if (zb_zdo_mgmt_rtg_req(bufid, route_response_cb) == ZB_ZDO_INVALID_TSN) {
+        ESP_LOGW(TAG, "Mgmt_Rtg_req failed");
+        zb_buf_free(bufid);
+        collect_finish();
+    }
+}
+
+// ========================================
+// Neighbour Table Walk
+// ========================================
+
+static void record_neighbor(const zb_nwk_nbr_iterator_entry_t *entry)
+{
+    work.neighbor_total++;
+
+    if (entry->relationship == ZB_NWK_MONITOR_REL_CHILD ||
+        entry->relationship == ZB_NWK_MONITOR_REL_UNAUTH_CHILD) {
+        work.child_count++;
+    }
+    if (entry->device_type == ZB_NWK_DEVICE_TYPE_COORDINATOR ||
+        entry->device_type == ZB_NWK_DEVICE_TYPE_ROUTER) {
+        work.router_count++;
+    }
+
+    if (work.neighbor_count >= ZB_NWK_MONITOR_MAX_NEIGHBORS) {
+        return;
+    }
+
+    zb_nwk_neighbor_t *n = &work.neighbors[work.neighbor_count++];
+    n->short_addr = entry->short_addr;
+    n->lqi = entry->lqi;
+    n->rssi = entry->rssi;
+    n->device_type = entry->device_type;
+    n->relationship = entry->relationship;
+    n->outgoing_cost = entry->outgoing_cost;
+    n->age = entry->age;
+    n->rx_on_when_idle = entry->rx_on_when_idle;
+}
+
+static void neighbor_walk_cb(zb_uint8_t bufid)
+{
+    zb_nwk_nbr_iterator_params_t *params = ZB_BUF_GET_PARAM(bufid, zb_nwk_nbr_iterator_params_t);
+
+    if (params->index != ZB_NWK_NBR_ITERATOR_INDEX_EOT) {
+        record_neighbor((const zb_nwk_nbr_iterator_entry_t *)zb_buf_begin(bufid));
+        params->index++;
+        zb_nwk_nbr_iterator_next(bufid, neighbor_walk_cb);
+        return;
+    }
+
+    // Neighbour table done, continue with the routing table
+    zb_buf_reuse(bufid);
+    route_request(bufid, 0);
+}
+
+static void neighbor_walk_start(zb_uint8_t bufid)
+{
+    zb_nwk_nbr_iterator_params_t *params = ZB_BUF_GET_PARAM(bufid, zb_nwk_nbr_iterator_params_t);
+    params->index = 0;
+    zb_nwk_nbr_iterator_next(bufid, neighbor_walk_cb);
+}
+
+static void collect_start(uint8_t param)
+{
+    (void)param;
+
+    if (!monitor_running || walk_in_progress) {
+        return;
+    }
+
+    memset(&work, 0, sizeof(work));
+    walk_in_progress = true;
+
+    if (zb_buf_get_out_delayed(neighbor_walk_start) != RET_OK) {
+        ESP_LOGW(TAG, "No buffer for neighbour walk, retrying next period");
+        walk_in_progress = false;
+        esp_zb_scheduler_alarm(collect_start, 0, ZB_NWK_MONITOR_PERIOD_MS);
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+void zb_nwk_monitor_start(void)
+{
+    esp_zb_scheduler_alarm_cancel(collect_start, 0);
+    monitor_running = true;
+
+    // First snapshot shortly after joining, once link status has been exchanged
+    esp_zb_scheduler_alarm(collect_start, 0, 5000);
+}
+
+void zb_nwk_monitor_stop(void)
+{
+    monitor_running = false;
+    esp_zb_scheduler_alarm_cancel(collect_start, 0);
+}
+
+const zb_nwk_snapshot_t *zb_nwk_monitor_get_snapshot(void)
+{
+    return &snapshot;
+}
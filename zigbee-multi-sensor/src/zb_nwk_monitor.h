@@ -0,0 +1,86 @@
+/*
+ * Zigbee Router Network Monitor
+ *
+ * Periodically walks the NWK neighbour table and the routing table (via a
+ * local Mgmt_Rtg_req) into a compact snapshot, then publishes it through the
+ * Diagnostics cluster on EP 15 (see zb_diagnostics.h).
+ *
+ * Neighbour table attribute (0xF000) layout, little-endian:
+ *   [0]    format version (1)
+ *   [1]    entries in this attribute
+ *   [2]    total neighbours seen (may exceed capacity)
+ *   [3]    child count
+ *   [4]    active routes
+ *   [5]    routing table entries
+ *   [6..]  entries, ZB_NWK_MONITOR_ENTRY_SIZE bytes each:
+ *            short_addr (2), lqi (1), rssi (1),
+ *            flags (1): bits 0-1 device type, bits 2-4 relationship, bit 5 rx_on_when_idle
+ *            link (1):  bits 0-2 outgoing cost, bits 3-7 age (saturates at 31)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ZB_NWK_MONITOR_PERIOD_MS        60000   // Snapshot interval
+#define ZB_NWK_MONITOR_MAX_NEIGHBORS    32      // Entries kept per snapshot
+#define ZB_NWK_MONITOR_FORMAT_VERSION   1
+#define ZB_NWK_MONITOR_HEADER_SIZE      6
+#define ZB_NWK_MONITOR_ENTRY_SIZE       6
+
+// Neighbour relationship (Zigbee spec 3.6.1.5)
+#define ZB_NWK_MONITOR_REL_PARENT       0
+#define ZB_NWK_MONITOR_REL_CHILD        1
+#define ZB_NWK_MONITOR_REL_SIBLING      2
+#define ZB_NWK_MONITOR_REL_NONE         3
+#define ZB_NWK_MONITOR_REL_PREV_CHILD   4
+#define ZB_NWK_MONITOR_REL_UNAUTH_CHILD 5
+
+typedef struct {
+    uint16_t short_addr;
+    uint8_t lqi;
+    int8_t rssi;
+    uint8_t device_type;        // ZB_NWK_DEVICE_TYPE_*
+    uint8_t relationship;       // ZB_NWK_MONITOR_REL_*
+    uint8_t outgoing_cost;
+    uint8_t age;
+    bool rx_on_when_idle;
+} zb_nwk_neighbor_t;
+
+typedef struct {
+    zb_nwk_neighbor_t neighbors[ZB_NWK_MONITOR_MAX_NEIGHBORS];
+    uint8_t neighbor_count;     // Entries stored above
+    uint8_t neighbor_total;     // Entries reported by the stack
+    uint8_t child_count;
+    uint8_t router_count;       // Neighbours that are routers/coordinator
+    uint8_t route_active;       // Routing table entries with ACTIVE status
+    uint8_t route_total;        // Routing table entries reported
+    uint8_t min_lqi;
+    uint8_t avg_lqi;
+    uint32_t timestamp_ms;      // Uptime when the snapshot completed
+} zb_nwk_snapshot_t;
+
+/**
+ * Start periodic collection (call once the device has joined).
+ * Safe to call again on rejoin; the previous schedule is replaced.
+ */
+void zb_nwk_monitor_start(void);
+
+/**
+ * Stop periodic collection (e.g. after leaving the network).
+ */
+void zb_nwk_monitor_stop(void);
+
+/**
+ * Most recent complete snapshot (neighbor_count == 0 before the first walk).
+ */
+const zb_nwk_snapshot_t *zb_nwk_monitor_get_snapshot(void);
+
+#ifdef __cplusplus
+}
+#endif
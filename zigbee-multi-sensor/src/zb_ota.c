@@ -0,0 +1,917 @@
+/*
+ * Zigbee OTA Upgrade Client
+ *
+ * The Zigbee task only queues block payloads; everything that touches flash
+ * or hashes runs in the writer task, which lives for one download attempt.
+ * The writer sees the download as a byte stream: the element header, then
+ * the element data, which goes through up to two stages into the sector
+ * buffer and is flashed from offset 0 of the slot:
+ *   compressed elements   LZ decoder -> mid[] -> copy or patch decoder
+ *   others                copy or patch decoder
+ *
+ * The LZ stage is too big for the NVS checkpoint; at each checkpoint it is
+ * written to the last sector of the slot being downloaded into, which a
+ * compressed image must leave free.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "nvs.h"
+#include "ota_delta.h"
+#include "ota_lz.h"
+#include "zb_diagnostics.h"
+#include "zb_ota.h"
+
+#define OTA_WRITER_STACK                3072
+#define OTA_WRITER_PRIORITY             4       // Below the Zigbee task
+#define OTA_WRITER_POLL_MS              500     // Stop-flag check while the queue is empty
+#define OTA_WRITER_CHUNK                256     // Bytes taken from the queue at a time
+#define OTA_FINISH_POLL_MS              50      // Wait for esp_ota_end() before booting the image
+
+#define OTA_NVS_NAMESPACE               "zb_ota"
+#define OTA_NVS_KEY_CHECKPOINT          "ckpt"
+
+#define OTA_DIGEST_SIZE                 32
+#define OTA_IMAGE_MAGIC                 0xE9    // esp_image_header_t.magic
+#define OTA_IMAGE_HASH_APPENDED         23      // Offset of esp_image_header_t.hash_appended
+
+typedef struct {
+    uint32_t file_version;
+    uint32_t image_size;
+    uint32_t consumed;                  // Stream bytes that produced `written`
+    uint32_t written;                   // Flashed app bytes, sector-aligned
+    uint32_t app_size;
+    uint16_t tag;                       // Element being decoded
+    uint32_t slot_address;              // Slot the prefix was flashed into
+    uint8_t prefix_digest[OTA_DIGEST_SIZE];  // SHA-256 of the hashed part of the prefix
+    ota_delta_state_t delta;
+} ota_checkpoint_t;
+
+/**
+ * LZ stage of a compressed element, stored whole at each checkpoint.
+ */
+typedef struct {
+    uint16_t mid_pos;
+    uint16_t mid_len;
+    uint8_t mid[OTA_WRITER_CHUNK];      // Decompressed, not yet taken by the next stage
+    ota_lz_t dec;
+    uint32_t written;                   // Checkpoint it belongs to; last, so a torn write never matches
+} ota_lz_stage_t;
+
+typedef struct {
+    const esp_partition_t *partition;
+    esp_ota_handle_t handle;
+    mbedtls_sha256_context sha;
+    uint32_t file_version;
+    uint32_t image_size;                // Element header + element data
+    uint32_t app_size;                  // Image being flashed, 0 until known
+    uint32_t consumed;                  // Stream bytes taken from the queue
+    uint32_t written;                   // Flashed app bytes
+    uint32_t fill;                      // Bytes in sector[]
+    uint16_t tag;
+    uint8_t element_header[ZB_OTA_ELEMENT_HEADER_SIZE];
+    uint8_t digest[OTA_DIGEST_SIZE];    // SHA-256 appended to the image
+    uint8_t prefix_digest[OTA_DIGEST_SIZE];  // Resumed prefix, from the checkpoint
+    ota_delta_t delta;
+    ota_lz_stage_t lz;
+    uint8_t in[OTA_WRITER_CHUNK];
+    uint8_t sector[ZB_OTA_SECTOR_SIZE];
+} ota_session_t;
+
+static const char *TAG = "ZB_OTA";
+
+// Zigbee task -> writer
+static StreamBufferHandle_t queue = NULL;
+static SemaphoreHandle_t hash_done = NULL;
+static SemaphoreHandle_t writer_done = NULL;
+static bool writer_active = false;
+static volatile bool writer_stop = false;
+
+// Writer -> Zigbee task (valid after hash_done and writer_done)
+static esp_err_t hash_result = ESP_OK;
+static esp_err_t writer_result = ESP_OK;
+static const esp_partition_t *verified_partition = NULL;
+
+static int64_t start_us = 0;
+static int64_t finish_deadline_us = 0;
+
+// Guards status; read by the console
+static portMUX_TYPE status_lock = portMUX_INITIALIZER_UNLOCKED;
+static zb_ota_status_t status;
+
+static bool is_delta(uint16_t tag)
+{
+    return tag == ZB_OTA_TAG_DELTA_IMAGE || tag == ZB_OTA_TAG_COMPRESSED_DELTA;
+}
+
+static bool is_compressed(uint16_t tag)
+{
+    return tag == ZB_OTA_TAG_COMPRESSED_IMAGE || tag == ZB_OTA_TAG_COMPRESSED_DELTA;
+}
+
+static void set_state(zb_ota_state_t state)
+{
+    taskENTER_CRITICAL(&status_lock);
+    status.state = state;
+    status.elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    taskEXIT_CRITICAL(&status_lock);
+}
+
+// ========================================
+// NVS Checkpoint
+// ========================================
+
+static uint32_t lz_stage_offset(const esp_partition_t *partition)
+{
+    return partition->size - ZB_OTA_SECTOR_SIZE;
+}
+
+/**
+ * SHA-256 of the app bytes hashed so far, leaving the running hash open.
+ */
+static void hash_so_far(const ota_session_t *s, uint8_t digest[OTA_DIGEST_SIZE])
+{
+    mbedtls_sha256_context copy;
+
+    mbedtls_sha256_init(&copy);
+    mbedtls_sha256_clone(&copy, &s->sha);
+    mbedtls_sha256_finish(&copy, digest);
+    mbedtls_sha256_free(&copy);
+}
+
+static void save_checkpoint(ota_session_t *s, uint32_t consumed)
+{
+    ota_checkpoint_t cp = {
+        .file_version = s->file_version,
+        .image_size = s->image_size,
+        .consumed = consumed,
+        .written = s->written,
+        .app_size = s->app_size,
+        .tag = s->tag,
+        .slot_address = s->partition->address,
+        .delta = s->delta.st,
+    };
+    nvs_handle_t handle;
+
+    hash_so_far(s, cp.prefix_digest);
+
+    if (is_compressed(s->tag)) {
+        s->lz.written = s->written;
+        uint32_t offset = lz_stage_offset(s->partition);
+        if (esp_partition_erase_range(s->partition, offset, ZB_OTA_SECTOR_SIZE) != ESP_OK ||
+            esp_partition_write(s->partition, offset, &s->lz, sizeof(s->lz)) != ESP_OK) {
+            return;  // Keep the previous checkpoint
+        }
+    }
+
+    if (nvs_open(OTA_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_blob(handle, OTA_NVS_KEY_CHECKPOINT, &cp, sizeof(cp)) == ESP_OK) {
+        nvs_commit(handle);
+    }
+    nvs_close(handle);
+}
+
+static void clear_checkpoint(void)
+{
+    nvs_handle_t handle;
+
+    if (nvs_open(OTA_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_erase_key(handle, OTA_NVS_KEY_CHECKPOINT) == ESP_OK) {
+        nvs_commit(handle);
+    }
+    nvs_close(handle);
+}
+
+/**
+ * Checkpoint of a partial download of this file into `partition`, if there
+ * is one.
+ */
+static bool load_checkpoint(const esp_partition_t *partition, const esp_zb_ota_file_header_t *header,
+                            ota_checkpoint_t *cp)
+{
+    size_t len = sizeof(*cp);
+    nvs_handle_t handle;
+
+    if (nvs_open(OTA_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;  // Namespace not created yet
+    }
+    esp_err_t ret = nvs_get_blob(handle, OTA_NVS_KEY_CHECKPOINT, cp, &len);
+    nvs_close(handle);
+    if (ret != ESP_OK || len != sizeof(*cp)) {
+        return false;
+    }
+
+    if (cp->file_version != header->file_version || cp->image_size != header->image_size ||
+        cp->slot_address != partition->address || cp->written % ZB_OTA_SECTOR_SIZE != 0 || cp->written == 0 || cp->written >= cp->app_size ||
+        cp->consumed > cp->image_size) {
+        // Another file or slot: its partial download is overwritten from here on
+        clear_checkpoint();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * LZ stage saved with checkpoint `cp`, read back from the slot tail.
+ */
+static bool load_lz_stage(ota_session_t *s, const ota_checkpoint_t *cp)
+{
+    if (esp_partition_read(s->partition, lz_stage_offset(s->partition), &s->lz, sizeof(s->lz)) != ESP_OK ||
+        s->lz.written != cp->written || s->lz.mid_pos > s->lz.mid_len || s->lz.mid_len > sizeof(s->lz.mid)) {
+        clear_checkpoint();
+        return false;
+    }
+    return true;
+}
+
+// ========================================
+// Writer Task
+// ========================================
+
+/**
+ * Hash app bytes [offset, offset + len); the last OTA_DIGEST_SIZE bytes of
+ * the app are the expected digest and are collected instead.
+ */
+static esp_err_t hash_range(ota_session_t *s, const uint8_t *data, uint32_t len, uint32_t offset)
+{
+    if (offset == 0 && (data[0] != OTA_IMAGE_MAGIC || data[OTA_IMAGE_HASH_APPENDED] != 1)) {
+        ESP_LOGE(TAG, "Not an app image with an appended SHA-256");
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    uint32_t hashed_end = s->app_size - OTA_DIGEST_SIZE;
+    if (offset < hashed_end) {
+        uint32_t n = len < hashed_end - offset ? len : hashed_end - offset;
+        mbedtls_sha256_update(&s->sha, data, n);
+    }
+
+    uint32_t tail = offset > hashed_end ? offset : hashed_end;
+    if (tail < offset + len) {
+        memcpy(&s->digest[tail - hashed_end], &data[tail - offset], offset + len - tail);
+    }
+    return ESP_OK;
+}
+
+/**
+ * Resumed download: hash the prefix already in the slot and compare it with
+ * the checkpoint's digest. A mismatch drops the checkpoint.
+ */
+static esp_err_t rehash_flashed(ota_session_t *s)
+{
+    uint8_t computed[OTA_DIGEST_SIZE];
+
+    for (uint32_t offset = 0; offset < s->written; offset += ZB_OTA_SECTOR_SIZE) {
+        esp_err_t ret = esp_partition_read(s->partition, offset, s->sector, ZB_OTA_SECTOR_SIZE);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        ret = hash_range(s, s->sector, ZB_OTA_SECTOR_SIZE, offset);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    hash_so_far(s, computed);
+    if (memcmp(computed, s->prefix_digest, OTA_DIGEST_SIZE) != 0) {
+        ESP_LOGE(TAG, "Flashed prefix does not match the checkpoint, starting over");
+        clear_checkpoint();
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t set_app_size(ota_session_t *s, uint32_t size)
+{
+    uint32_t room = is_compressed(s->tag) ? lz_stage_offset(s->partition) : s->partition->size;
+
+    if (size <= OTA_DIGEST_SIZE || size > room) {
+        ESP_LOGE(TAG, "Image size %lu does not fit %s", (unsigned long)size, s->partition->label);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    s->app_size = size;
+
+    taskENTER_CRITICAL(&status_lock);
+    status.app_size = size;
+    taskEXIT_CRITICAL(&status_lock);
+    return ESP_OK;
+}
+
+static esp_err_t check_element_header(ota_session_t *s)
+{
+    const uint8_t *h = s->element_header;
+    uint16_t tag = h[0] | (h[1] << 8);
+    uint32_t length = h[2] | (h[3] << 8) | (h[4] << 16) | ((uint32_t)h[5] << 24);
+
+    if (length != s->image_size - ZB_OTA_ELEMENT_HEADER_SIZE ||
+        (!is_delta(tag) && !is_compressed(tag) && tag != ZB_OTA_TAG_UPGRADE_IMAGE)) {
+        ESP_LOGE(TAG, "Unexpected element: tag 0x%04x, %lu bytes", tag, (unsigned long)length);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s->tag = tag;
+    if (is_delta(tag)) {
+        ota_delta_init(&s->delta, esp_ota_get_running_partition(), NULL);
+    }
+    if (is_compressed(tag)) {
+        memset(&s->lz, 0, sizeof(s->lz));
+        ota_lz_init(&s->lz.dec);
+    }
+
+    taskENTER_CRITICAL(&status_lock);
+    status.delta = is_delta(tag);
+    status.compressed = is_compressed(tag);
+    taskEXIT_CRITICAL(&status_lock);
+
+    if (tag != ZB_OTA_TAG_UPGRADE_IMAGE) {
+        return ESP_OK;  // Image size comes with the patch or LZ header
+    }
+    return set_app_size(s, length);
+}
+
+/**
+ * Image data in, app image out (appended to the sector buffer): a copy for
+ * a full image, the patch decoder for a delta.
+ */
+static esp_err_t expand(ota_session_t *s, const uint8_t *in, size_t len, size_t *used)
+{
+    uint8_t *out = &s->sector[s->fill];
+    size_t space = ZB_OTA_SECTOR_SIZE - s->fill;
+    size_t produced;
+    esp_err_t ret = ESP_OK;
+
+    if (!is_delta(s->tag)) {
+        produced = len < space ? len : space;
+        memcpy(out, in, produced);
+        *used = produced;
+    } else {
+        ret = ota_delta_decode(&s->delta, in, len, used, out, space, &produced);
+        if (ret == ESP_OK && s->app_size == 0 && ota_delta_target_size(&s->delta) > 0) {
+            ret = set_app_size(s, ota_delta_target_size(&s->delta));
+        }
+    }
+    s->fill += produced;
+    return ret;
+}
+
+/**
+ * Element data in: a compressed element is decompressed into mid[] and
+ * expanded from there. Returns with input left only when the sector buffer
+ * is full or the element has ended.
+ */
+static esp_err_t decode(ota_session_t *s, const uint8_t *in, size_t len, size_t *used)
+{
+    ota_lz_stage_t *lz = &s->lz;
+    esp_err_t ret = ESP_OK;
+
+    if (!is_compressed(s->tag)) {
+        return expand(s, in, len, used);
+    }
+
+    *used = 0;
+    while (ret == ESP_OK && s->fill < ZB_OTA_SECTOR_SIZE) {
+        size_t n;
+
+        if (lz->mid_pos == lz->mid_len) {
+            size_t produced;
+            ret = ota_lz_decode(&lz->dec, &in[*used], len - *used, &n, lz->mid, sizeof(lz->mid), &produced);
+            *used += n;
+            lz->mid_pos = 0;
+            lz->mid_len = produced;
+            if (ret == ESP_OK && s->tag == ZB_OTA_TAG_COMPRESSED_IMAGE && s->app_size == 0 &&
+                ota_lz_output_size(&lz->dec) > 0) {
+                ret = set_app_size(s, ota_lz_output_size(&lz->dec));
+            }
+            if (produced == 0) {
+                break;  // Input used up or stream ended
+            }
+            continue;
+        }
+
+        ret = expand(s, &lz->mid[lz->mid_pos], lz->mid_len - lz->mid_pos, &n);
+        lz->mid_pos += n;
+        if (lz->mid_pos < lz->mid_len && s->fill < ZB_OTA_SECTOR_SIZE) {
+            break;  // Patch ended
+        }
+    }
+    return ret;
+}
+
+/**
+ * Every stage has seen the end of its stream.
+ */
+static bool stages_done(const ota_session_t *s)
+{
+    if (is_delta(s->tag) && !ota_delta_done(&s->delta)) {
+        return false;
+    }
+    if (is_compressed(s->tag) && (!ota_lz_done(&s->lz.dec) || s->lz.mid_pos < s->lz.mid_len)) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Write the sector buffer. `consumed` is the stream position its last byte
+ * came from, where a resumed download continues.
+ */
+static esp_err_t flush_sector(ota_session_t *s, uint32_t consumed)
+{
+    esp_err_t ret = hash_range(s, s->sector, s->fill, s->written);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = esp_partition_erase_range(s->partition, s->written, ZB_OTA_SECTOR_SIZE);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = esp_ota_write_with_offset(s->handle, s->sector, s->fill, s->written);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s->written += s->fill;
+    s->fill = 0;
+
+    taskENTER_CRITICAL(&status_lock);
+    status.written = s->written;
+    taskEXIT_CRITICAL(&status_lock);
+
+    if (s->written % ZB_OTA_CHECKPOINT_BYTES == 0 && s->written < s->app_size) {
+        save_checkpoint(s, consumed);
+    }
+    return ESP_OK;
+}
+
+/**
+ * Run `len` bytes of element data through the decoder, flushing full
+ * sectors. Called with s->consumed already past them.
+ */
+static esp_err_t feed(ota_session_t *s, const uint8_t *in, size_t len)
+{
+    while (1) {
+        size_t used;
+        esp_err_t ret = decode(s, in, len, &used);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        in += used;
+        len -= used;
+
+        if (s->written + s->fill > s->app_size) {
+            ESP_LOGE(TAG, "Image longer than announced");
+            return ESP_ERR_INVALID_SIZE;
+        }
+        bool last = s->fill > 0 && s->written + s->fill == s->app_size;
+        if (s->fill < ZB_OTA_SECTOR_SIZE && !last) {
+            break;  // Decoder wants more input
+        }
+        ret = flush_sector(s, s->consumed - len);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    if (len > 0) {
+        ESP_LOGE(TAG, "%u bytes after the end of the element", (unsigned)len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t check_digest(ota_session_t *s)
+{
+    uint8_t computed[OTA_DIGEST_SIZE];
+
+    mbedtls_sha256_finish(&s->sha, computed);
+    if (memcmp(computed, s->digest, OTA_DIGEST_SIZE) != 0) {
+        ESP_LOGE(TAG, "Image SHA-256 mismatch, dropping the download");
+        clear_checkpoint();
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+static void ota_writer_task(void *pvParameters)
+{
+    ota_session_t *s = pvParameters;
+
+    esp_err_t ret = esp_ota_begin(s->partition, OTA_WITH_SEQUENTIAL_WRITES, &s->handle);
+    if (ret == ESP_OK && s->written > 0) {
+        ret = rehash_flashed(s);
+    }
+
+    while (ret == ESP_OK && s->consumed < s->image_size && !writer_stop) {
+        if (s->consumed < ZB_OTA_ELEMENT_HEADER_SIZE) {
+            size_t n = xStreamBufferReceive(queue, &s->element_header[s->consumed],
+                                            ZB_OTA_ELEMENT_HEADER_SIZE - s->consumed,
+                                            pdMS_TO_TICKS(OTA_WRITER_POLL_MS));
+            s->consumed += n;
+            if (s->consumed == ZB_OTA_ELEMENT_HEADER_SIZE) {
+                ret = check_element_header(s);
+            }
+            continue;
+        }
+
+        size_t want = s->image_size - s->consumed;
+        if (want > sizeof(s->in)) {
+            want = sizeof(s->in);
+        }
+        size_t n = xStreamBufferReceive(queue, s->in, want, pdMS_TO_TICKS(OTA_WRITER_POLL_MS));
+        s->consumed += n;
+        if (n > 0) {
+            ret = feed(s, s->in, n);
+        }
+    }
+
+    if (ret == ESP_OK && s->consumed < s->image_size) {
+        ret = ESP_ERR_INVALID_STATE;  // Stopped
+    }
+    if (ret == ESP_OK && (s->written != s->app_size || !stages_done(s))) {
+        ESP_LOGE(TAG, "Image incomplete: %lu of %lu bytes", (unsigned long)s->written,
+                 (unsigned long)s->app_size);
+        clear_checkpoint();
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret == ESP_OK) {
+        ret = check_digest(s);
+    }
+
+    // The hash decides the Upgrade End Request; esp_ota_end() reads the
+    // whole image again and finishes before the server's go (ota_finish())
+    hash_result = ret;
+    xSemaphoreGive(hash_done);
+
+    if (ret == ESP_OK) {
+        ret = esp_ota_end(s->handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Image validation failed (%s)", esp_err_to_name(ret));
+            clear_checkpoint();
+        }
+    } else if (s->handle != 0) {
+        esp_ota_abort(s->handle);
+    }
+
+    if (ret != ESP_OK && !writer_stop) {
+        ESP_LOGE(TAG, "Download failed at %lu/%lu (%s)", (unsigned long)s->consumed,
+                 (unsigned long)s->image_size, esp_err_to_name(ret));
+    }
+
+    writer_result = ret;
+    verified_partition = (ret == ESP_OK && !writer_stop) ? s->partition : NULL;
+    set_state(verified_partition != NULL ? ZB_OTA_DONE : ZB_OTA_FAILED);
+
+    mbedtls_sha256_free(&s->sha);
+    free(s);
+    xSemaphoreGive(writer_done);
+    vTaskDelete(NULL);
+}
+
+static void finish_alarm(uint8_t param);
+
+/**
+ * Stop an unfinished writer (Zigbee task context).
+ */
+static void stop_writer(void)
+{
+    if (!writer_active) {
+        return;
+    }
+    esp_zb_scheduler_alarm_cancel(finish_alarm, 0);
+    writer_stop = true;
+    if (xSemaphoreTake(writer_done, pdMS_TO_TICKS(ZB_OTA_VERIFY_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Writer did not stop");
+    }
+    writer_active = false;
+}
+
+/**
+ * Give up on a writer without waiting for it (Zigbee task context). It
+ * ends on its own; the next ota_start() collects it.
+ */
+static void abandon_writer(void)
+{
+    esp_zb_scheduler_alarm_cancel(finish_alarm, 0);
+    writer_stop = true;
+}
+
+// ========================================
+// Upgrade Events (Zigbee task)
+// ========================================
+
+static esp_err_t ota_start(const esp_zb_ota_file_header_t *header)
+{
+    stop_writer();  // An earlier attempt that never reached the check
+
+    const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+    if (part == NULL) {
+        ESP_LOGE(TAG, "No OTA slot to download into");
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (header->image_size <= ZB_OTA_ELEMENT_HEADER_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (queue == NULL) {
+        queue = xStreamBufferCreate(ZB_OTA_QUEUE_SIZE, 1);
+        hash_done = xSemaphoreCreateBinary();
+        writer_done = xSemaphoreCreateBinary();
+        if (queue == NULL || hash_done == NULL || writer_done == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    xStreamBufferReset(queue);
+    xSemaphoreTake(hash_done, 0);       // Left by a writer stopped before the check
+
+    ota_session_t *s = calloc(1, sizeof(*s));
+    if (s == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s->partition = part;
+    s->file_version = header->file_version;
+    s->image_size = header->image_size;
+    mbedtls_sha256_init(&s->sha);
+    mbedtls_sha256_starts(&s->sha, 0);
+
+    ota_checkpoint_t cp;
+    bool resume = load_checkpoint(part, header, &cp);
+    if (resume && is_compressed(cp.tag)) {
+        resume = load_lz_stage(s, &cp);
+    }
+    if (resume) {
+        s->consumed = cp.consumed;
+        s->written = cp.written;
+        s->app_size = cp.app_size;
+        s->tag = cp.tag;
+        memcpy(s->prefix_digest, cp.prefix_digest, OTA_DIGEST_SIZE);
+        if (is_delta(s->tag)) {
+            ota_delta_init(&s->delta, esp_ota_get_running_partition(), &cp.delta);
+        }
+
+        // The stack's next Image Block Request asks from FileOffset
+        uint32_t file_offset = ZB_OTA_FILE_HEADER_SIZE + s->consumed;
+        esp_zb_zcl_set_attribute_val(EP_DIAGNOSTICS, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+                                     ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE,
+                                     ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID, &file_offset, false);
+    }
+
+    start_us = esp_timer_get_time();
+    taskENTER_CRITICAL(&status_lock);
+    status = (zb_ota_status_t){
+        .state = ZB_OTA_DOWNLOADING,
+        .file_version = s->file_version,
+        .image_size = s->image_size,
+        .app_size = s->app_size,
+        .received = s->consumed,
+        .written = s->written,
+        .resumed_from = s->consumed,
+        .delta = resume && is_delta(s->tag),
+        .compressed = resume && is_compressed(s->tag),
+    };
+    taskEXIT_CRITICAL(&status_lock);
+
+    writer_stop = false;
+    if (xTaskCreate(ota_writer_task, "ota_writer", OTA_WRITER_STACK, s, OTA_WRITER_PRIORITY, NULL) != pdPASS) {
+        mbedtls_sha256_free(&s->sha);
+        free(s);
+        set_state(ZB_OTA_FAILED);
+        return ESP_ERR_NO_MEM;
+    }
+    writer_active = true;
+
+    if (resume) {
+        ESP_LOGI(TAG, "Resuming file 0x%08lx into %s at %lu/%lu bytes", (unsigned long)header->file_version,
+                 part->label, (unsigned long)s->consumed, (unsigned long)header->image_size);
+    } else {
+        ESP_LOGI(TAG, "Downloading file 0x%08lx (%lu bytes) into %s", (unsigned long)header->file_version,
+                 (unsigned long)header->image_size, part->label);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ota_receive(const uint8_t *payload, uint16_t size)
+{
+    taskENTER_CRITICAL(&status_lock);
+    bool downloading = status.state == ZB_OTA_DOWNLOADING;
+    taskEXIT_CRITICAL(&status_lock);
+
+    if (!writer_active || !downloading) {
+        return ESP_ERR_INVALID_STATE;  // Writer failed; its error is logged
+    }
+
+    if (xStreamBufferSend(queue, payload, size, pdMS_TO_TICKS(ZB_OTA_QUEUE_WAIT_MS)) != size) {
+        ESP_LOGE(TAG, "Writer fell behind, aborting");
+        stop_writer();
+        return ESP_ERR_TIMEOUT;
+    }
+    size_t queued = xStreamBufferBytesAvailable(queue);
+
+    taskENTER_CRITICAL(&status_lock);
+    status.received += size;
+    status.blocks++;
+    if (size > status.block_size) {
+        status.block_size = size;
+    }
+    if (queued > status.peak_queued) {
+        status.peak_queued = (uint16_t)queued;
+    }
+    taskEXIT_CRITICAL(&status_lock);
+
+    return ESP_OK;
+}
+
+/**
+ * Download complete: wait for the writer to flush the queue and compare the
+ * hash. The stack cannot be told to hold the Upgrade End Request (the
+ * library turns ESP_ERR_NOT_FINISHED into an error for this event), so
+ * this waits, but only for at most ZB_OTA_QUEUE_SIZE bytes of flash
+ * writes; esp_ota_end() runs after the answer.
+ */
+static esp_err_t ota_check(void)
+{
+    if (!writer_active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    taskENTER_CRITICAL(&status_lock);
+    if (status.state == ZB_OTA_DOWNLOADING) {
+        status.state = ZB_OTA_VERIFYING;    // Unless the writer has already ended
+    }
+    taskEXIT_CRITICAL(&status_lock);
+
+    if (xSemaphoreTake(hash_done, pdMS_TO_TICKS(ZB_OTA_HASH_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Verification timed out");
+        abandon_writer();
+        return ESP_ERR_TIMEOUT;
+    }
+
+    if (hash_result == ESP_OK) {
+        zb_ota_status_t s;
+        zb_ota_get_status(&s);
+        uint32_t sent = s.received - s.resumed_from;
+        ESP_LOGI(TAG, "Image verified: %lu bytes in %lu s (%lu B/s), %lu blocks of up to %u B, "
+                 "peak queue %u B", (unsigned long)sent, (unsigned long)(s.elapsed_ms / 1000),
+                 (unsigned long)(s.elapsed_ms ? sent * 1000ULL / s.elapsed_ms : 0),
+                 (unsigned long)s.blocks, s.block_size, s.peak_queued);
+    }
+    return hash_result;
+}
+
+static void apply_image(void)
+{
+    if (verified_partition == NULL) {
+        ESP_LOGE(TAG, "No verified image to boot");
+        return;
+    }
+
+    esp_err_t ret = esp_ota_set_boot_partition(verified_partition);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to select %s for boot (%s)", verified_partition->label, esp_err_to_name(ret));
+        return;
+    }
+    clear_checkpoint();
+
+    ESP_LOGW(TAG, "Upgrade complete, restarting into %s", verified_partition->label);
+    esp_restart();
+}
+
+/**
+ * The server's go came before esp_ota_end() finished: poll the writer from
+ * the Zigbee task, then boot the image.
+ */
+static void finish_alarm(uint8_t param)
+{
+    if (xSemaphoreTake(writer_done, 0) == pdTRUE) {
+        writer_active = false;
+        apply_image();
+    } else if (esp_timer_get_time() < finish_deadline_us) {
+        esp_zb_scheduler_alarm(finish_alarm, 0, OTA_FINISH_POLL_MS);
+    } else {
+        ESP_LOGE(TAG, "Image validation timed out");
+        abandon_writer();
+        set_state(ZB_OTA_FAILED);
+    }
+}
+
+static esp_err_t ota_finish(void)
+{
+    if (writer_active) {
+        if (xSemaphoreTake(writer_done, 0) != pdTRUE) {
+            finish_deadline_us = esp_timer_get_time() + ZB_OTA_VERIFY_TIMEOUT_MS * 1000LL;
+            esp_zb_scheduler_alarm(finish_alarm, 0, OTA_FINISH_POLL_MS);
+            return ESP_OK;
+        }
+        writer_active = false;
+    }
+    if (verified_partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    apply_image();
+    return ESP_OK;
+}
+
+// ========================================
+// Public API
+// ========================================
+
+void zb_ota_add_client_cluster(esp_zb_cluster_list_t *cluster_list)
+{
+    esp_zb_ota_cluster_cfg_t ota_cfg = {
+        .ota_upgrade_file_version = ZB_OTA_FILE_VERSION,
+        .ota_upgrade_manufacturer = ZB_OTA_MANUFACTURER_CODE,
+        .ota_upgrade_image_type = ZB_OTA_IMAGE_TYPE,
+        .ota_min_block_reque = 0,       // No pause between block requests
+        .ota_upgrade_file_offset = ESP_ZB_ZCL_OTA_UPGRADE_FILE_OFFSET_DEF_VALUE,
+        .ota_upgrade_downloaded_file_ver = ESP_ZB_ZCL_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_DEF_VALUE,
+        .ota_upgrade_server_id = ESP_ZB_ZCL_OTA_UPGRADE_SERVER_DEF_VALUE,
+        .ota_image_upgrade_status = ESP_ZB_ZCL_OTA_UPGRADE_IMAGE_STATUS_DEF_VALUE,
+    };
+    esp_zb_attribute_list_t *ota_cluster = esp_zb_ota_cluster_create(&ota_cfg);
+
+    esp_zb_zcl_ota_upgrade_client_variable_t client_vars = {
+        .timer_query = ESP_ZB_ZCL_OTA_UPGRADE_QUERY_TIMER_COUNT_DEF,
+        .hw_version = ZB_OTA_HW_VERSION,
+        .max_data_size = ZB_OTA_MAX_DATA_SIZE,
+    };
+    // Server found by discovery after joining
+    uint16_t server_addr = ESP_ZB_ZCL_OTA_UPGRADE_SERVER_ADDR_DEF_VALUE;
+    uint8_t server_ep = ESP_ZB_ZCL_OTA_UPGRADE_SERVER_ENDPOINT_DEF_VALUE;
+
+    esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID, &client_vars);
+    esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID, &server_addr);
+    esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID, &server_ep);
+    esp_zb_cluster_list_add_ota_cluster(cluster_list, ota_cluster, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE);
+}
+
+esp_err_t zb_ota_handle_upgrade(const esp_zb_zcl_ota_upgrade_value_message_t *message)
+{
+    if (message->info.status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = ESP_OK;
+
+    switch (message->upgrade_status) {
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START:
+        ret = ota_start(&message->ota_header);
+        break;
+
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE:
+        if (message->payload_size > 0 && message->payload != NULL) {
+            ret = ota_receive(message->payload, message->payload_size);
+        }
+        break;
+
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+        ret = ota_check();
+        break;
+
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+        ESP_LOGI(TAG, "Server confirmed the upgrade");
+        break;
+
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
+        ret = ota_finish();
+        break;
+
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT:
+        stop_writer();
+        set_state(ZB_OTA_FAILED);
+        zb_ota_status_t st;
+        zb_ota_get_status(&st);
+        ESP_LOGW(TAG, "Download aborted at %lu/%lu bytes (flashed prefix kept for resume)",
+                 (unsigned long)st.received, (unsigned long)st.image_size);
+        break;
+
+    default:
+        ESP_LOGD(TAG, "Upgrade status %d", message->upgrade_status);
+        break;
+    }
+
+    if (ret != ESP_OK) {
+        set_state(ZB_OTA_FAILED);
+    }
+    return ret;
+}
+
+void zb_ota_get_status(zb_ota_status_t *out)
+{
+    taskENTER_CRITICAL(&status_lock);
+    *out = status;
+    if (status.state == ZB_OTA_DOWNLOADING) {
+        out->elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    }
+    taskEXIT_CRITICAL(&status_lock);
+}
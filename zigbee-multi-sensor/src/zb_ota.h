@@ -0,0 +1,125 @@
+/*
+ * Zigbee OTA Upgrade Client
+ *
+ * The OTA Upgrade cluster (client role) on EP 15 downloads images from the
+ * network's OTA server into the inactive ota_0/ota_1 slot (partitions.csv)
+ * and boots them. Images are built with ota_pack.py: a Zigbee OTA file with
+ * one element, either
+ *   Upgrade Image (tag 0x0000)       the app binary
+ *   Delta Image (tag 0xF000)         a patch against the running app binary,
+ *                                    rebuilt on the fly (ota_delta.h)
+ *   Compressed Image/Delta (0xF001/0xF002)
+ *                                    either of the above, LZ-compressed and
+ *                                    decompressed on the fly (ota_lz.h)
+ *
+ * Pipeline:
+ *   Zigbee task   each Image Block Response payload is queued in a stream
+ *                 buffer and the handler returns at once, so the stack sends
+ *                 the next Image Block Request without waiting for flash
+ *   writer task   runs the element through its decoders (LZ, then a copy
+ *                 or the patch decoder) into a 4 KB sector buffer, erases
+ *                 and writes one sector at a time, and hashes the image as
+ *                 it goes through
+ *
+ * The stack keeps one Image Block Request outstanding; the queue is what
+ * keeps radio and flash busy at the same time. Blocks are requested at
+ * ZB_OTA_MAX_DATA_SIZE; the server may answer with less (a block that does
+ * not fit one APS frame needs APS fragmentation on both ends).
+ *
+ * Integrity: ESP-IDF appends the SHA-256 of the app image to its end. The
+ * writer hashes everything before it on the fly and compares at the end of
+ * the download, so a corrupt image is refused before Upgrade End Request,
+ * without another pass over the slot. esp_ota_end() then validates the
+ * image structure in the writer while the server decides when to upgrade;
+ * the image boots once both have passed.
+ *
+ * Resume: every ZB_OTA_CHECKPOINT_BYTES the flashed length, the stream
+ * position it came from, the patch decoder state and the SHA-256 of the
+ * flashed prefix are stored in NVS with the file version, file size and
+ * slot address; the LZ decoder state, window included, goes to the last
+ * sector of the slot, which compressed images leave free. When a download
+ * of the same file into the same slot starts again (after an abort, a lost
+ * parent or a reboot), the flashed prefix is re-hashed from the slot and
+ * the FileOffset attribute, which the stack's block requests follow, is
+ * moved past it. A prefix that does not match the stored digest fails the
+ * attempt and drops the checkpoint, so the next attempt starts from zero.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Image identity (must match ota_pack.py --manufacturer/--image-type)
+#define ZB_OTA_MANUFACTURER_CODE        0x131B  // Espressif
+#define ZB_OTA_IMAGE_TYPE               0x0001
+#ifndef ZB_OTA_FILE_VERSION
+#define ZB_OTA_FILE_VERSION             0x00000001  // Running image; the server offers higher ones
+#endif
+#define ZB_OTA_HW_VERSION               1
+
+// Largest block the client asks for (the attribute is 8-bit)
+#define ZB_OTA_MAX_DATA_SIZE            223
+
+// OTA file layout produced by ota_pack.py
+#define ZB_OTA_FILE_HEADER_SIZE         56      // No optional header fields
+#define ZB_OTA_ELEMENT_HEADER_SIZE      6       // Tag id (2) + length (4)
+#define ZB_OTA_TAG_UPGRADE_IMAGE        0x0000
+#define ZB_OTA_TAG_DELTA_IMAGE          0xF000  // Manufacturer-specific tag range
+#define ZB_OTA_TAG_COMPRESSED_IMAGE     0xF001
+#define ZB_OTA_TAG_COMPRESSED_DELTA     0xF002
+
+// Pipeline
+#define ZB_OTA_QUEUE_SIZE               8192    // Blocks waiting for the writer
+#define ZB_OTA_QUEUE_WAIT_MS            200     // Longest the Zigbee task waits for room
+#define ZB_OTA_SECTOR_SIZE              4096
+#define ZB_OTA_CHECKPOINT_BYTES         (64 * 1024)
+#define ZB_OTA_HASH_TIMEOUT_MS          2000    // Queue drain + hash check, Zigbee task waits
+#define ZB_OTA_VERIFY_TIMEOUT_MS        10000   // esp_ota_end(), polled from an alarm
+
+typedef enum {
+    ZB_OTA_IDLE = 0,
+    ZB_OTA_DOWNLOADING,
+    ZB_OTA_VERIFYING,
+    ZB_OTA_DONE,                        // Verified, waiting for the server's go
+    ZB_OTA_FAILED,
+} zb_ota_state_t;
+
+typedef struct {
+    zb_ota_state_t state;
+    uint32_t file_version;
+    uint32_t image_size;                // Bytes after the OTA file header
+    uint32_t app_size;                  // App image being flashed, 0 until known
+    uint32_t received;                  // Of image_size, including resumed_from
+    uint32_t written;                   // Flashed bytes of the app image
+    uint32_t resumed_from;
+    uint32_t elapsed_ms;                // This attempt
+    uint32_t blocks;
+    uint16_t block_size;                // Largest block seen
+    uint16_t peak_queued;               // Bytes waiting for the writer, high-water mark
+    bool delta;                         // Rebuilt from a patch
+    bool compressed;                    // Sent LZ-compressed
+} zb_ota_status_t;
+
+/**
+ * Add the OTA Upgrade client cluster to the EP 15 cluster list.
+ */
+void zb_ota_add_client_cluster(esp_zb_cluster_list_t *cluster_list);
+
+/**
+ * Handle ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID (Zigbee task context). A
+ * non-OK return makes the stack abort the download.
+ */
+esp_err_t zb_ota_handle_upgrade(const esp_zb_zcl_ota_upgrade_value_message_t *message);
+
+void zb_ota_get_status(zb_ota_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,364 @@
+/*
+ * Attribute Reporting
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "zboss_api.h"
+#include "report_policy.h"
+#include "app_config.h"
+#include "report_tracker.h"
+#include "zb_report.h"
+
+#define COORDINATOR_SHORT_ADDR          0x0000
+#define COORDINATOR_ENDPOINT            1
+#define DEADBAND_MAX                    16      // MeasuredValues tracked
+
+static const char *TAG = "ZB_REPORT";
+
+// true = EXPLICIT (instant reports), false = AUTOMATIC (efficient)
+static bool use_explicit_reporting = (ZIGBEE_REPORTING_MODE == REPORTING_MODE_EXPLICIT);
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+} queued_report_t;
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint16_t value;
+} pending_value_t;
+
+// Sensor tasks write, the apply alarm (Zigbee task) hands to the stack
+static portMUX_TYPE pending_lock = portMUX_INITIALIZER_UNLOCKED;
+static pending_value_t pending[ZB_REPORT_BATCH_MAX];
+static size_t pending_count = 0;
+
+// Queued by the apply alarm, the window alarm (both Zigbee task) drains
+static portMUX_TYPE batch_lock = portMUX_INITIALIZER_UNLOCKED;
+static queued_report_t batch[ZB_REPORT_BATCH_MAX];
+static size_t batch_count = 0;
+static uint32_t batch_window_ms = 0;
+static zb_report_batch_stats_t batch_stats;
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    int32_t value;
+    int64_t sent_us;
+} sent_value_t;
+
+// Last MeasuredValue sent per endpoint and cluster (EXPLICIT mode)
+static portMUX_TYPE deadband_lock = portMUX_INITIALIZER_UNLOCKED;
+static sent_value_t sent[DEADBAND_MAX];
+static size_t sent_count = 0;
+static uint32_t suppressed = 0;
+
+// ========================================
+// Internal Helpers
+// ========================================
+
+/**
+ * Report attribute using AUTOMATIC mode (passive)
+ * Marks attribute as changed; reports sent based on HA's configured intervals
+ */
+static void report_attribute_automatic(uint8_t endpoint, uint16_t cluster_id,
+                                       uint16_t attr_id, void *value)
+{
+    esp_zb_zcl_set_attribute_val(
+        endpoint,
+        cluster_id,
+        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        attr_id,
+        value,
+        true  // Mark as changed for automatic reporting
+    );
+}
+
+/**
+ * Send a Report Attributes command with the attribute's current value
+ */
+static void send_report(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id)
+{
+    // Delivery tracked until APS confirm. The stack numbers the frame from
+    // the ZCL sequence counter while building it in the call below, on this
+    // (the Zigbee) task, so the counter now is the report's TSN.
+    report_tracker_enqueue(endpoint, cluster_id, ZCL_CTX().seq_number);
+    esp_zb_zcl_report_attr_cmd_t report_cmd = {
+        .zcl_basic_cmd = {
+            .src_endpoint = endpoint,
+            .dst_endpoint = COORDINATOR_ENDPOINT,
+            .dst_addr_u = {
+                .addr_short = COORDINATOR_SHORT_ADDR,
+            },
+        },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .clusterID = cluster_id,
+        .cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        .attributeID = attr_id,
+    };
+    esp_zb_zcl_report_attr_cmd_req(&report_cmd);
+}
+
+/**
+ * Queue a report for the next window. The value is already in the
+ * attribute table, so a queued entry only names the attribute. Returns
+ * false if not batching or the queue is full.
+ */
+static bool queue_report(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id)
+{
+    bool queued = false;
+
+    taskENTER_CRITICAL(&batch_lock);
+    if (batch_window_ms > 0) {
+        for (size_t i = 0; i < batch_count; i++) {
+            if (batch[i].endpoint == endpoint && batch[i].cluster_id == cluster_id &&
+                batch[i].attr_id == attr_id) {
+                batch_stats.merged++;
+                queued = true;
+                break;
+            }
+        }
+        if (!queued && batch_count < ZB_REPORT_BATCH_MAX) {
+            batch[batch_count++] = (queued_report_t){ endpoint, cluster_id, attr_id };
+            queued = true;
+        } else if (!queued) {
+            batch_stats.overflows++;
+        }
+    }
+    taskEXIT_CRITICAL(&batch_lock);
+
+    return queued;
+}
+
+/**
+ * Whether a MeasuredValue moved less than the cluster's threshold since
+ * the last one sent, with the heartbeat not yet due. Records the value as
+ * sent otherwise.
+ */
+static bool below_threshold(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, const void *value)
+{
+    int32_t v;
+
+    uint16_t threshold = app_config_threshold(cluster_id);
+    if (attr_id != 0x0000 || threshold == 0) {
+        return false;  // Not a MeasuredValue, or every change is sent
+    }
+    if (cluster_id == ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT ||
+        cluster_id == ESP_ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT) {
+        int16_t s16;
+        memcpy(&s16, value, sizeof(s16));
+        v = s16;
+    } else {
+        uint16_t u16;
+        memcpy(&u16, value, sizeof(u16));
+        v = u16;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    int64_t heartbeat_us = (int64_t)app_config_heartbeat_ms() * 1000;
+    bool below = false;
+
+    taskENTER_CRITICAL(&deadband_lock);
+    sent_value_t *entry = NULL;
+    for (size_t i = 0; i < sent_count; i++) {
+        if (sent[i].endpoint == endpoint && sent[i].cluster_id == cluster_id) {
+            entry = &sent[i];
+            break;
+        }
+    }
+    if (entry == NULL && sent_count < DEADBAND_MAX) {
+        entry = &sent[sent_count++];
+        *entry = (sent_value_t){ endpoint, cluster_id, v, now_us };
+    } else if (entry != NULL) {
+        int32_t delta = v > entry->value ? v - entry->value : entry->value - v;
+        if (delta < threshold && now_us - entry->sent_us < heartbeat_us) {
+            below = true;
+            suppressed++;
+        } else {
+            entry->value = v;
+            entry->sent_us = now_us;
+        }
+    }
+    taskEXIT_CRITICAL(&deadband_lock);
+
+    return below;
+}
+
+/**
+ * Report attribute using EXPLICIT mode (active)
+ * Sends report command to coordinator now, or with the next batch
+ */
+static void report_attribute_explicit(uint8_t endpoint, uint16_t cluster_id,
+                                      uint16_t attr_id, void *value)
+{
+    // First, update the local attribute value
+    esp_zb_zcl_set_attribute_val(
+        endpoint,
+        cluster_id,
+        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        attr_id,
+        value,
+        false  // Don't auto-report
+    );
+
+    // Then explicitly send report to coordinator, unless the change is too small
+    if (below_threshold(endpoint, cluster_id, attr_id, value)) {
+        return;
+    }
+    if (!queue_report(endpoint, cluster_id, attr_id)) {
+        send_report(endpoint, cluster_id, attr_id);
+    }
+}
+
+/**
+ * Hand every pending value to the stack in the current mode
+ */
+static void apply_values(void)
+{
+    pending_value_t values[ZB_REPORT_BATCH_MAX];
+
+    taskENTER_CRITICAL(&pending_lock);
+    size_t count = pending_count;
+    memcpy(values, pending, count * sizeof(values[0]));
+    pending_count = 0;
+    taskEXIT_CRITICAL(&pending_lock);
+
+    for (size_t i = 0; i < count; i++) {
+        pending_value_t *v = &values[i];
+        if (use_explicit_reporting) {
+            report_attribute_explicit(v->endpoint, v->cluster_id, v->attr_id, &v->value);
+        } else {
+            report_attribute_automatic(v->endpoint, v->cluster_id, v->attr_id, &v->value);
+        }
+    }
+}
+
+/**
+ * Apply alarm, while not batching (the window alarm applies otherwise, so a
+ * sleepy end device is not woken every ZB_REPORT_APPLY_MS)
+ */
+static void apply_pending(uint8_t param)
+{
+    apply_values();
+
+    if (batch_window_ms == 0) {
+        esp_zb_scheduler_alarm(apply_pending, 0, ZB_REPORT_APPLY_MS);
+    }
+}
+
+/**
+ * Window alarm: apply the pending values, send everything queued in one
+ * burst, then re-arm
+ */
+static void send_batch(uint8_t param)
+{
+    queued_report_t burst[ZB_REPORT_BATCH_MAX];
+
+    apply_values();
+
+    taskENTER_CRITICAL(&batch_lock);
+    size_t count = batch_count;
+    memcpy(burst, batch, count * sizeof(burst[0]));
+    batch_count = 0;
+    if (count > 0) {
+        batch_stats.windows++;
+        batch_stats.reports += count;
+    }
+    taskEXIT_CRITICAL(&batch_lock);
+
+    for (size_t i = 0; i < count; i++) {
+        send_report(burst[i].endpoint, burst[i].cluster_id, burst[i].attr_id);
+    }
+
+    if (batch_window_ms > 0) {
+        esp_zb_scheduler_alarm(send_batch, 0, batch_window_ms);
+    }
+}
+
+// ========================================
+// Public API
+// ========================================
+
+void zb_report_start(void)
+{
+    esp_zb_scheduler_alarm(apply_pending, 0, ZB_REPORT_APPLY_MS);
+}
+
+void zb_report_attribute(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, void *value)
+{
+    bool dropped = false;
+    uint16_t v;
+    memcpy(&v, value, sizeof(v));
+
+    taskENTER_CRITICAL(&pending_lock);
+    pending_value_t *entry = NULL;
+    for (size_t i = 0; i < pending_count; i++) {
+        if (pending[i].endpoint == endpoint && pending[i].cluster_id == cluster_id &&
+            pending[i].attr_id == attr_id) {
+            entry = &pending[i];
+            break;
+        }
+    }
+    if (entry == NULL && pending_count < ZB_REPORT_BATCH_MAX) {
+        entry = &pending[pending_count++];
+    }
+    if (entry != NULL) {
+        *entry = (pending_value_t){ endpoint, cluster_id, attr_id, v };
+    } else {
+        dropped = true;
+    }
+    taskEXIT_CRITICAL(&pending_lock);
+
+    if (dropped) {
+        ESP_LOGW(TAG, "EP%u cluster 0x%04X: pending values full, update dropped", endpoint, cluster_id);
+    }
+}
+
+void zb_report_set_explicit(bool explicit_mode)
+{
+    use_explicit_reporting = explicit_mode;
+}
+
+bool zb_report_is_explicit(void)
+{
+    return use_explicit_reporting;
+}
+
+void zb_report_set_batch_window(uint32_t window_ms)
+{
+    esp_zb_scheduler_alarm_cancel(send_batch, 0);
+    esp_zb_scheduler_alarm_cancel(apply_pending, 0);
+
+    taskENTER_CRITICAL(&batch_lock);
+    batch_window_ms = window_ms;
+    taskEXIT_CRITICAL(&batch_lock);
+
+    if (window_ms > 0) {
+        esp_zb_scheduler_alarm(send_batch, 0, window_ms);
+    } else {
+        send_batch(0);
+        esp_zb_scheduler_alarm(apply_pending, 0, ZB_REPORT_APPLY_MS);
+    }
+}
+
+void zb_report_get_batch_stats(zb_report_batch_stats_t *stats)
+{
+    taskENTER_CRITICAL(&batch_lock);
+    *stats = batch_stats;
+    taskEXIT_CRITICAL(&batch_lock);
+}
+
+uint32_t zb_report_get_suppressed(void)
+{
+    taskENTER_CRITICAL(&deadband_lock);
+    uint32_t count = suppressed;
+    taskEXIT_CRITICAL(&deadband_lock);
+    return count;
+}
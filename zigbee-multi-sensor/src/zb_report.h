@@ -0,0 +1,79 @@
+/*
+ * Attribute Reporting
+ *
+ * The one call sensor code uses to publish a new measured value. The mode
+ * is runtime-switchable (EP14 On/Off cluster, see main.c):
+ *   EXPLICIT:  set the attribute and send a Report Attributes command to the
+ *              coordinator now; delivery is tracked by report_tracker.c
+ *   AUTOMATIC: set the attribute and mark it changed; the ZBOSS reporting
+ *              engine sends it per the coordinator's min/max/change config
+ *
+ * With a batch window set (sleepy end device, zb_sleep.h), EXPLICIT reports
+ * are queued instead, one entry per attribute carrying its newest value,
+ * and all of them go out together once per window, so the radio wakes once
+ * per window instead of once per sample.
+ *
+ * Sensor tasks never call into the stack: zb_report_attribute() only
+ * stores the newest value per attribute, and an alarm on the Zigbee task
+ * applies the stored values every ZB_REPORT_APPLY_MS, or once per batch
+ * window when batching.
+ *
+ * In EXPLICIT mode a MeasuredValue that moved less than its change
+ * threshold (app_config.h) since the last one sent only updates the
+ * attribute, until the heartbeat makes it due anyway.
+ *
+ * Moved out of main.c so sensor drivers (sensor_registry.h) can report
+ * without reaching into the application.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ZB_REPORT_BATCH_MAX             24      // Distinct attributes per window (18 with every sensor)
+#define ZB_REPORT_APPLY_MS              100     // Pending values handed to the stack this often
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start applying reported values. Call once from the Zigbee task before
+ * the sensor tasks start.
+ */
+void zb_report_start(void);
+
+/**
+ * Report a 16-bit server attribute on `endpoint` in the current mode. Any
+ * task; the value is copied and applied on the Zigbee task, a newer value
+ * for the same attribute replacing one not applied yet.
+ */
+void zb_report_attribute(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, void *value);
+
+void zb_report_set_explicit(bool explicit_mode);
+bool zb_report_is_explicit(void);
+
+typedef struct {
+    uint32_t windows;                   // Bursts sent
+    uint32_t reports;                   // Reports sent in them
+    uint32_t merged;                    // Newer values replacing a queued one
+    uint32_t overflows;                 // Sent at once, queue full
+} zb_report_batch_stats_t;
+
+/**
+ * Queue EXPLICIT reports and send them every `window_ms` (0: send at once,
+ * flushing the queue). Call from the Zigbee task.
+ */
+void zb_report_set_batch_window(uint32_t window_ms);
+
+void zb_report_get_batch_stats(zb_report_batch_stats_t *stats);
+
+/**
+ * EXPLICIT reports not sent for a change below threshold.
+ */
+uint32_t zb_report_get_suppressed(void);
+
+#ifdef __cplusplus
+}
+#endif
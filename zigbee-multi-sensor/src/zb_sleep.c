@@ -0,0 +1,52 @@
+/*
+ * Sleepy End Device
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "zboss_api.h"
+#include "report_policy.h"
+#include "zb_sleep.h"
+
+static const char *TAG = "ZB_SLEEP";
+
+// Only the Zigbee task sleeps; the console reads the counters
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static zb_sleep_stats_t stats;
+
+// ========================================
+// Public API
+// ========================================
+
+void zb_sleep_init(void)
+{
+    esp_zb_sleep_enable(true);
+}
+
+void zb_sleep_joined(void)
+{
+    zb_zdo_pim_set_long_poll_interval(ZB_SED_LONG_POLL_MS);
+    ESP_LOGI(TAG, "Sleepy end device: long poll %lu ms, reports every %lu ms",
+             (unsigned long)ZB_SED_LONG_POLL_MS, (unsigned long)ZB_SED_REPORT_WINDOW_MS);
+}
+
+void zb_sleep_now(void)
+{
+    int64_t start_us = esp_timer_get_time();
+
+    esp_zb_sleep_now();
+
+    uint32_t slept_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    taskENTER_CRITICAL(&stats_lock);
+    stats.sleeps++;
+    stats.sleep_ms += slept_ms;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+void zb_sleep_get_stats(zb_sleep_stats_t *out)
+{
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    taskEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,54 @@
+/*
+ * Sleepy End Device
+ *
+ * The battery build (CONFIG_ZB_ZED, env esp32-c6-devkitc-1-sed) joins as a
+ * sleepy end device: the receiver is off except while it transmits or
+ * polls its parent, and the stack asks the application to sleep whenever
+ * its scheduler is idle (ESP_ZB_COMMON_SIGNAL_CAN_SLEEP). The CPU then
+ * enters light sleep until the next stack alarm or sensor task deadline
+ * (power.c; the radio lock is not held in this build).
+ *
+ * One report cycle, every ZB_SED_REPORT_WINDOW_MS:
+ *   - sensor tasks sample on their own intervals with the radio off; their
+ *     reports are queued (zb_report.c), newest value per attribute
+ *   - the window alarm sends every queued report in one burst, then the
+ *     stack polls the parent for the acknowledgements
+ * Between windows the parent is polled every ZB_SED_LONG_POLL_MS, so
+ * commands reach the device within that time.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t sleeps;                    // esp_zb_sleep_now() calls
+    uint32_t sleep_ms;                  // Time spent in them
+} zb_sleep_stats_t;
+
+/**
+ * Allow the stack to sleep. Call before esp_zb_init().
+ */
+void zb_sleep_init(void);
+
+/**
+ * Set the long poll interval once joined (Zigbee task).
+ */
+void zb_sleep_joined(void);
+
+/**
+ * Handle ESP_ZB_COMMON_SIGNAL_CAN_SLEEP: sleep until the next stack event.
+ */
+void zb_sleep_now(void);
+
+void zb_sleep_get_stats(zb_sleep_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
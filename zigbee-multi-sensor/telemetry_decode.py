@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+"""
+Binary telemetry decoder for the ESP32 Multi-Sensor firmware
+
+Splits the serial byte stream into log text lines and COBS-framed telemetry
+records (see src/telemetry.h for the wire format). Usable as a module by
+monitor.py, or standalone to dump records:
+
+    python3 telemetry_decode.py /dev/ttyACM0
+"""
+
+import struct
+import sys
+
+PROTOCOL_VERSION = 1
+
+REC_BOOT = 0x01
+REC_LOG = 0x02
+REC_LOG_DROPPED = 0x03
+REC_LIGHT = 0x10
+REC_TEMPERATURE = 0x11
+REC_HUMIDITY = 0x12
+REC_PRESSURE = 0x13
+REC_ZB_STATUS = 0x20
+REC_SYSTEM = 0x30
+REC_BENCH = 0x31
+
+SENSOR_NAMES = {1: "BH1750", 2: "DS18B20", 3: "DHT11", 4: "SHT4x", 5: "BME280"}
+
+RESET_REASONS = {
+    0: "unknown", 1: "power-on", 2: "external", 3: "software", 4: "panic",
+    5: "interrupt WDT", 6: "task WDT", 7: "other WDT", 8: "deep sleep",
+    9: "brownout", 10: "SDIO",
+}
+
+HEADER = struct.Struct("<BHI")      # type, seq, timestamp_ms
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0:
+            raise ValueError("zero byte inside COBS block")
+        end = i + code
+        if end > len(data):
+            raise ValueError("truncated COBS block")
+        out += data[i + 1:end]
+        if code < 0xFF and end < len(data):
+            out.append(0)
+        i = end
+    return bytes(out)
+
+
+def decode_payload(rec_type, payload):
+    """Turn a record payload into a dict of named fields."""
+    if rec_type == REC_BOOT:
+        version, reason = struct.unpack_from("<BB", payload)
+        return {"protocol": version, "reset_reason": RESET_REASONS.get(reason, str(reason))}
+    if rec_type == REC_LOG:
+        fmt, tag, timestamp, level, nargs = struct.unpack_from("<IIIBB", payload)
+        args = struct.unpack_from(f"<{nargs}I", payload, 14)
+        return {"fmt": fmt, "tag": tag, "timestamp_ms": timestamp, "level": level, "args": args}
+    if rec_type == REC_LOG_DROPPED:
+        dropped, = struct.unpack_from("<I", payload)
+        return {"dropped": dropped}
+    if rec_type == REC_LIGHT:
+        lux_x10, zcl = struct.unpack_from("<IH", payload)
+        return {"lux": lux_x10 / 10.0, "zcl": zcl}
+    if rec_type == REC_TEMPERATURE:
+        sensor, centi = struct.unpack_from("<Bh", payload)
+        return {"sensor": SENSOR_NAMES.get(sensor, str(sensor)), "celsius": centi / 100.0}
+    if rec_type == REC_HUMIDITY:
+        sensor, centi = struct.unpack_from("<BH", payload)
+        return {"sensor": SENSOR_NAMES.get(sensor, str(sensor)), "percent": centi / 100.0}
+    if rec_type == REC_PRESSURE:
+        sensor, pascal = struct.unpack_from("<BI", payload)
+        return {"sensor": SENSOR_NAMES.get(sensor, str(sensor)), "hpa": pascal / 100.0}
+    if rec_type == REC_ZB_STATUS:
+        connected, channel, short_addr = struct.unpack_from("<BBH", payload)
+        pan = ":".join(f"{b:02x}" for b in reversed(payload[4:12]))
+        return {"connected": bool(connected), "channel": channel,
+                "short_addr": short_addr, "ext_pan_id": pan}
+    if rec_type == REC_SYSTEM:
+        cpu, heap_free, heap_min, largest, frag = struct.unpack_from("<BIIIB", payload)
+        return {"cpu_pct": cpu, "heap_free": heap_free, "heap_min": heap_min,
+                "largest_block": largest, "frag_pct": frag}
+    if rec_type == REC_BENCH:
+        index, count, calls, cmin, cmed, cmax, ticks_per_us = struct.unpack_from("<BBIIIIH", payload)
+        name = payload[20:36].rstrip(b"\0").decode("ascii", errors="replace")
+        return {"index": index, "count": count, "name": name, "calls": calls, "cycles_min": cmin,
+                "cycles_median": cmed, "cycles_max": cmax, "ticks_per_us": ticks_per_us}
+    return {"raw": payload.hex()}
+
+
+class Record:
+    __slots__ = ("type", "seq", "timestamp_ms", "fields")
+
+    def __init__(self, rec_type, seq, timestamp_ms, fields):
+        self.type = rec_type
+        self.seq = seq
+        self.timestamp_ms = timestamp_ms
+        self.fields = fields
+
+    def __repr__(self):
+        return f"Record(type=0x{self.type:02x}, seq={self.seq}, t={self.timestamp_ms}, {self.fields})"
+
+
+def parse_frame(chunk):
+    """Decode one delimiter-stripped frame, or return None if it is not valid."""
+    try:
+        frame = cobs_decode(chunk)
+    except ValueError:
+        return None
+    if len(frame) < HEADER.size + 2:
+        return None
+    body, crc = frame[:-2], struct.unpack("<H", frame[-2:])[0]
+    if crc16_ccitt(body) != crc:
+        return None
+    rec_type, seq, timestamp = HEADER.unpack_from(body)
+    try:
+        fields = decode_payload(rec_type, body[HEADER.size:])
+    except struct.error:
+        return None
+    return Record(rec_type, seq, timestamp, fields)
+
+
+class StreamDecoder:
+    """
+    Incremental decoder. feed() bytes as they arrive; it returns a list of
+    items, each either a str (one log line) or a Record.
+
+    Frames are wrapped as 00 <cobs> 00. Text never contains 0x00, so a zero
+    byte always means "frame boundary". A chunk between zeros that fails to
+    decode is treated as text, which also resynchronises after a lost byte.
+    """
+
+    def __init__(self):
+        self.text = bytearray()
+        self.frame = bytearray()
+        self.in_frame = False
+        self.last_seq = None
+        self.frames_ok = 0
+        self.frames_bad = 0
+        self.frames_dropped = 0     # Sequence gaps
+
+    def _flush_text(self, items):
+        while b"\n" in self.text:
+            line, _, rest = bytes(self.text).partition(b"\n")
+            self.text = bytearray(rest)
+            line = line.decode("utf-8", errors="ignore").rstrip("\r")
+            if line:
+                items.append(line)
+
+    def _finish_frame(self, items):
+        chunk = bytes(self.frame)
+        self.frame.clear()
+        if not chunk:
+            return False
+        record = parse_frame(chunk)
+        if record is None:
+            self.frames_bad += 1
+            self.text += chunk
+            self._flush_text(items)
+            return False
+        if self.last_seq is not None:
+            gap = (record.seq - self.last_seq - 1) & 0xFFFF
+            if record.type == REC_BOOT:
+                gap = 0
+            self.frames_dropped += gap
+        self.last_seq = record.seq
+        self.frames_ok += 1
+        items.append(record)
+        return True
+
+    def feed(self, data):
+        items = []
+        for byte in data:
+            if byte != 0:
+                (self.frame if self.in_frame else self.text).append(byte)
+                continue
+
+            if not self.in_frame:
+                # Opening delimiter
+                self._flush_text(items)
+                self.in_frame = True
+            elif self.frame and self._finish_frame(items):
+                # Closing delimiter of a valid frame
+                self.in_frame = False
+            # Otherwise (empty or undecodable chunk) this zero may open the next frame
+        self._flush_text(items)
+        return items
+
+
+def main():
+    import serial
+
+    port = sys.argv[1] if len(sys.argv) > 1 else "/dev/ttyACM0"
+    decoder = StreamDecoder()
+    with serial.Serial(port, 115200, timeout=0.2) as ser:
+        while True:
+            for item in decoder.feed(ser.read(256)):
+                if isinstance(item, Record):
+                    print(f"[{item.timestamp_ms:>9} #{item.seq:<5}] 0x{item.type:02x} {item.fields}")
+                else:
+                    print(item)
+
+
+if __name__ == "__main__":
+    main()